@@ -39,23 +39,81 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <sys/random.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <errno.h>
 #include <semaphore.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
 
 
 #include "auth_hal_if.h"
 
+/**
+ * Counting semaphore.  A condition variable instead of a sem_t, so a wait
+ * timeout wakes the waiting thread itself and never changes the count.
+ */
 typedef struct
 {
-    sem_t *semaphore;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned count;
     unsigned max_sem_value;
 } sem_instance_t;
 
+/**
+ * A timed wait in progress, set by its timer on expiry.
+ */
+typedef struct
+{
+    sem_instance_t *sem_inst;
+    bool expired;
+} sem_wait_t;
+
+
+/**
+ * Timer wheel, HAL_TIMER_WHEEL_LEVELS levels of HAL_TIMER_WHEEL_SLOTS slots.
+ * Level 0 holds the timers expiring in the next 64 ticks, one slot per
+ * tick, level n the timers expiring within 64^(n+1) ticks.  When level 0
+ * wraps the next level slot is cascaded down.  With 10 msec ticks the wheel
+ * covers about 46 hours, longer timeouts are clamped.
+ */
+#define HAL_TIMER_WHEEL_BITS        (6u)
+#define HAL_TIMER_WHEEL_SLOTS       (1u << HAL_TIMER_WHEEL_BITS)
+#define HAL_TIMER_WHEEL_MASK        (HAL_TIMER_WHEEL_SLOTS - 1u)
+#define HAL_TIMER_WHEEL_LEVELS      (4u)
+#define HAL_TIMER_MAX_TICKS         ((1ull << (HAL_TIMER_WHEEL_BITS * HAL_TIMER_WHEEL_LEVELS)) - 1u)
+
+typedef struct timer_instance
+{
+    struct timer_instance *next;
+    struct timer_instance **pprev;  /* NULL if not pending */
+    uint64_t expires;               /* tick */
+    hal_timer_func_t timer_func;
+    void *arg;
+} timer_instance_t;
 
-static pthread_mutex_t sem_count_mutex = PTHREAD_MUTEX_INITIALIZER;
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    uint64_t curr_tick;     /* next tick to process */
+    unsigned num_pending;
+    timer_instance_t *slots[HAL_TIMER_WHEEL_LEVELS][HAL_TIMER_WHEEL_SLOTS];
+} timer_wheel_t;
+
+static timer_wheel_t timer_wheel = {
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static pthread_once_t timer_wheel_once = PTHREAD_ONCE_INIT;
+static bool timer_wheel_ok;
+
+static bool hal_timer_start(timer_instance_t *timer, unsigned timeout_msec);
+static bool hal_timer_cancel(timer_instance_t *timer);
 
 
 /**
@@ -164,10 +222,6 @@ ATCA_STATUS hal_unlock_mutex(void * pMutex)
 
 ATCA_STATUS hal_create_sem(void **sem, unsigned init_value, unsigned max_value)
 {
-    sem_t * semaphore;
-    static int sem_cnt;
-    char temp_name[40];
-
     if (!sem)
     {
         return ATCA_BAD_PARAM;
@@ -180,16 +234,20 @@ ATCA_STATUS hal_create_sem(void **sem, unsigned init_value, unsigned max_value)
         return ATCA_FUNC_FAIL;
     }
 
-    sprintf(temp_name, "sem_%d", sem_cnt++);
+    if (pthread_mutex_init(&sem_inst->lock, NULL) != 0)
+    {
+        free(sem_inst);
+        return ATCA_GEN_FAIL;
+    }
 
-    sem_inst->semaphore = sem_open(temp_name,
-                                   (O_CREAT | O_RDWR), (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP), init_value);
-    if (SEM_FAILED == semaphore)
+    if (pthread_cond_init(&sem_inst->cond, NULL) != 0)
     {
+        pthread_mutex_destroy(&sem_inst->lock);
         free(sem_inst);
         return ATCA_GEN_FAIL;
     }
 
+    sem_inst->count = init_value;
     sem_inst->max_sem_value = max_value;
 
     *sem = sem_inst;
@@ -206,15 +264,15 @@ ATCA_STATUS hel_destroy_sem(void *sem)
         return ATCA_BAD_PARAM;
     }
 
-    if (-1 == sem_close(sem_inst->semaphore))
+    if ((pthread_cond_destroy(&sem_inst->cond) != 0) ||
+        (pthread_mutex_destroy(&sem_inst->lock) != 0))
     {
         return ATCA_GEN_FAIL;
     }
-    else
-    {
-        free(sem_inst);
-        return ATCA_SUCCESS;
-    }
+
+    free(sem_inst);
+
+    return ATCA_SUCCESS;
 }
 
 
@@ -227,41 +285,108 @@ ATCA_STATUS hal_wait_sem(void *sem)
         return ATCA_BAD_PARAM;
     }
 
-    int ret = sem_wait(sem_inst->semaphore);
+    pthread_mutex_lock(&sem_inst->lock);
+
+    while (sem_inst->count == 0)
+    {
+        pthread_cond_wait(&sem_inst->cond, &sem_inst->lock);
+    }
+
+    sem_inst->count--;
 
-    return ret == 0 ? ATCA_SUCCESS : ATCA_GEN_FAIL;
+    pthread_mutex_unlock(&sem_inst->lock);
+
+    return ATCA_SUCCESS;
+}
+
+/**
+ * Semaphore wait with a timeout on the timer wheel.  Runs with the wheel
+ * locked, so the waiter never holds the semaphore lock while starting or
+ * canceling its timer.
+ */
+static void hal_sem_wait_expired(void *arg)
+{
+    sem_wait_t *wait = (sem_wait_t *)arg;
+    sem_instance_t *sem_inst = wait->sem_inst;
+
+    pthread_mutex_lock(&sem_inst->lock);
+
+    /* only this waiter times out, the others go back to sleep */
+    wait->expired = true;
+    pthread_cond_broadcast(&sem_inst->cond);
+
+    pthread_mutex_unlock(&sem_inst->lock);
 }
 
 ATCA_STATUS hal_wait_sem_timeout(void *sem, unsigned timeout_msec)
 {
-    struct timespec time_val;
     sem_instance_t *sem_inst = (sem_instance_t*)sem;
+    timer_instance_t timer;
+    sem_wait_t wait;
+    ATCA_STATUS status;
 
     if (!sem_inst)
     {
         return ATCA_BAD_PARAM;
     }
 
-    clock_gettime(CLOCK_REALTIME, &time_val);
+    pthread_mutex_lock(&sem_inst->lock);
 
-    // convert milliseconds to seconds and nano seconds
-    time_val.tv_sec += (timeout_msec / 1000u);
-    time_val.tv_nsec += (timeout_msec % 1000) * 1000000u;
+    if (sem_inst->count > 0)
+    {
+        sem_inst->count--;
+        pthread_mutex_unlock(&sem_inst->lock);
+        return ATCA_SUCCESS;
+    }
 
-    int ret = sem_timedwait(sem_inst->semaphore, &time_val);
+    pthread_mutex_unlock(&sem_inst->lock);
 
-    if(ret != 0 && errno == ETIMEDOUT)
+    if (timeout_msec == 0)
     {
         return ATCA_TIMEOUT;
     }
 
-    return ret == 0 ? ATCA_SUCCESS : ATCA_GEN_FAIL;
+    wait.sem_inst = sem_inst;
+    wait.expired = false;
+
+    memset(&timer, 0, sizeof(timer));
+    timer.timer_func = hal_sem_wait_expired;
+    timer.arg = &wait;
+
+    if (!hal_timer_start(&timer, timeout_msec))
+    {
+        return ATCA_GEN_FAIL;
+    }
+
+    pthread_mutex_lock(&sem_inst->lock);
+
+    while ((sem_inst->count == 0) && !wait.expired)
+    {
+        pthread_cond_wait(&sem_inst->cond, &sem_inst->lock);
+    }
+
+    /* given before or as the timer expired */
+    if (sem_inst->count > 0)
+    {
+        sem_inst->count--;
+        status = ATCA_SUCCESS;
+    }
+    else
+    {
+        status = ATCA_TIMEOUT;
+    }
+
+    pthread_mutex_unlock(&sem_inst->lock);
+
+    /* timers fire with the wheel locked, once this returns the timer no
+     * longer refers to wait */
+    hal_timer_cancel(&timer);
+
+    return status;
 }
 
 ATCA_STATUS hal_give_sem(void *sem)
 {
-    int sem_val = 0;
-    int ret = 0;
     sem_instance_t *sem_inst = (sem_instance_t*)sem;
 
     if (!sem_inst)
@@ -269,24 +394,17 @@ ATCA_STATUS hal_give_sem(void *sem)
         return ATCA_BAD_PARAM;
     }
 
-    // check the max value, this is a two step operation so
-    // lock access while performing
-    if(pthread_mutex_lock(&sem_count_mutex) != 0)
-    {
-        return ATCA_GEN_FAIL;
-    }
+    pthread_mutex_lock(&sem_inst->lock);
 
-    ret = sem_getvalue(sem_inst->semaphore, &sem_val);
-
-    if((ret == 0) && (sem_val < (int)sem_inst->max_sem_value))
+    if (sem_inst->count < sem_inst->max_sem_value)
     {
-        ret = sem_post(sem_inst->semaphore);
+        sem_inst->count++;
+        pthread_cond_signal(&sem_inst->cond);
     }
 
-    // unlock
-    pthread_mutex_unlock(&sem_count_mutex);
+    pthread_mutex_unlock(&sem_inst->lock);
 
-    return ret == 0 ? ATCA_SUCCESS : ATCA_GEN_FAIL;
+    return ATCA_SUCCESS;
 }
 
 
@@ -316,16 +434,422 @@ ATCA_STATUS hal_create_thread(void ** ppThread, thread_func_t thread_entry, void
     return ATCA_SUCCESS;
 }
 
+ATCA_STATUS hal_join_thread(void * pThread)
+{
+    pthread_t *thread_id = (pthread_t *)pThread;
+
+    if(thread_id == NULL)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    if(pthread_join(*thread_id, NULL) != 0)
+    {
+        return ATCA_FUNC_FAIL;
+    }
+
+    free(thread_id);
+
+    return ATCA_SUCCESS;
+}
+
 
 ATCA_STATUS hal_random(unsigned char *buf, unsigned len)
 {
-    // use pseudo random generator
-    for(unsigned cnt = 0; cnt < len; cnt++, buf++)
+    ssize_t ret;
+
+    if (!buf)
     {
-        // NOTE: Can be smarter about this, rand() returns 4 bytes
-        //       here we're only using one byte.
-        *buf = (uint8_t)rand();
+        return ATCA_BAD_PARAM;
+    }
+
+    // challenges and keys are taken from here, use the kernel CSPRNG
+    while (len > 0)
+    {
+        ret = getrandom(buf, len, 0);
+
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return ATCA_GEN_FAIL;
+        }
+
+        buf += ret;
+        len -= (unsigned)ret;
     }
 
     return ATCA_SUCCESS;
 }
+
+ATCA_STATUS hal_get_time_sec(uint32_t *seconds)
+{
+    struct timespec time_val;
+
+    if (!seconds)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    if (clock_gettime(CLOCK_REALTIME, &time_val) != 0)
+    {
+        return ATCA_GEN_FAIL;
+    }
+
+    *seconds = (uint32_t)time_val.tv_sec;
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_get_time_msec(uint64_t *msec)
+{
+    struct timespec time_val;
+
+    if (!msec)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    if (clock_gettime(CLOCK_MONOTONIC, &time_val) != 0)
+    {
+        return ATCA_GEN_FAIL;
+    }
+
+    *msec = ((uint64_t)time_val.tv_sec * 1000u) + ((uint64_t)time_val.tv_nsec / 1000000u);
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_get_cpu_count(unsigned *count)
+{
+    long cpus;
+
+    if (!count)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    *count = (cpus > 0) ? (unsigned)cpus : 1u;
+
+    return ATCA_SUCCESS;
+}
+
+static uint64_t hal_timer_now_tick(void)
+{
+    uint64_t msec = 0;
+
+    hal_get_time_msec(&msec);
+
+    return msec / HAL_TIMER_TICK_MSEC;
+}
+
+/**
+ * Adds a timer to the slot for its expiry tick, wheel must be locked.
+ */
+static void hal_timer_add(timer_instance_t *timer)
+{
+    timer_wheel_t *wheel = &timer_wheel;
+    uint64_t delta;
+    unsigned level;
+    unsigned slot;
+    timer_instance_t **head;
+
+    /* already expired, fire on the next tick */
+    if (timer->expires < wheel->curr_tick)
+    {
+        timer->expires = wheel->curr_tick;
+    }
+
+    delta = timer->expires - wheel->curr_tick;
+
+    for (level = 0; level < HAL_TIMER_WHEEL_LEVELS - 1u; level++)
+    {
+        if (delta < (1ull << (HAL_TIMER_WHEEL_BITS * (level + 1u))))
+        {
+            break;
+        }
+    }
+
+    slot = (unsigned)(timer->expires >> (HAL_TIMER_WHEEL_BITS * level)) & HAL_TIMER_WHEEL_MASK;
+    head = &wheel->slots[level][slot];
+
+    timer->next = *head;
+    if (timer->next)
+    {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+}
+
+/**
+ * Unlinks a pending timer, wheel must be locked.
+ */
+static void hal_timer_del(timer_instance_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/**
+ * Moves the timers of a slot down to the lower levels.
+ *
+ * @return The slot index, 0 if the next level has to be cascaded too.
+ */
+static unsigned hal_timer_cascade(unsigned level)
+{
+    timer_wheel_t *wheel = &timer_wheel;
+    unsigned slot = (unsigned)(wheel->curr_tick >> (HAL_TIMER_WHEEL_BITS * level)) & HAL_TIMER_WHEEL_MASK;
+    timer_instance_t *timer = wheel->slots[level][slot];
+    timer_instance_t *next;
+
+    wheel->slots[level][slot] = NULL;
+
+    for (; timer != NULL; timer = next)
+    {
+        next = timer->next;
+        hal_timer_add(timer);
+    }
+
+    return slot;
+}
+
+/**
+ * Processes the ticks up to now, the timers expiring on each tick fire as
+ * one batch.  Wheel must be locked.
+ */
+static void hal_timer_run(uint64_t now_tick)
+{
+    timer_wheel_t *wheel = &timer_wheel;
+    timer_instance_t *timer;
+    unsigned slot;
+    unsigned level;
+
+    while (wheel->curr_tick <= now_tick)
+    {
+        slot = (unsigned)wheel->curr_tick & HAL_TIMER_WHEEL_MASK;
+
+        /* level 0 wrapped, pull the timers of the next period down */
+        for (level = 1; (slot == 0) && (level < HAL_TIMER_WHEEL_LEVELS); level++)
+        {
+            if (hal_timer_cascade(level) != 0)
+            {
+                break;
+            }
+        }
+
+        while ((timer = wheel->slots[0][slot]) != NULL)
+        {
+            hal_timer_del(timer);
+            wheel->num_pending--;
+            timer->timer_func(timer->arg);
+        }
+
+        wheel->curr_tick++;
+
+        if (wheel->num_pending == 0)
+        {
+            /* nothing left to wait for, skip the idle ticks */
+            wheel->curr_tick = now_tick + 1u;
+        }
+    }
+}
+
+/**
+ * Timer thread, the only thread doing a timed kernel wait for timers.
+ */
+static void *hal_timer_thread(void *arg)
+{
+    timer_wheel_t *wheel = &timer_wheel;
+    struct timespec next_tick;
+    uint64_t msec;
+
+    (void)arg;
+
+    pthread_mutex_lock(&wheel->lock);
+
+    for (;;)
+    {
+        if (wheel->num_pending == 0)
+        {
+            pthread_cond_wait(&wheel->cond, &wheel->lock);
+        }
+        else
+        {
+            /* sleep until the tick the wheel has to process next */
+            msec = wheel->curr_tick * HAL_TIMER_TICK_MSEC;
+            next_tick.tv_sec = (time_t)(msec / 1000u);
+            next_tick.tv_nsec = (long)((msec % 1000u) * 1000000u);
+
+            pthread_cond_timedwait(&wheel->cond, &wheel->lock, &next_tick);
+        }
+
+        hal_timer_run(hal_timer_now_tick());
+    }
+
+    return NULL;
+}
+
+static void hal_timer_wheel_init(void)
+{
+    timer_wheel_t *wheel = &timer_wheel;
+    pthread_condattr_t cond_attr;
+
+    /* deadlines are on the monotonic clock, not affected by clock changes */
+    if ((pthread_condattr_init(&cond_attr) != 0) ||
+        (pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC) != 0) ||
+        (pthread_cond_init(&wheel->cond, &cond_attr) != 0))
+    {
+        return;
+    }
+
+    wheel->curr_tick = hal_timer_now_tick();
+
+    timer_wheel_ok = (pthread_create(&wheel->thread, NULL, hal_timer_thread, NULL) == 0);
+}
+
+/**
+ * Starts a timer, returns false if the wheel could not be started.
+ */
+static bool hal_timer_start(timer_instance_t *timer, unsigned timeout_msec)
+{
+    timer_wheel_t *wheel = &timer_wheel;
+    uint64_t msec = 0;
+    uint64_t ticks;
+
+    pthread_once(&timer_wheel_once, hal_timer_wheel_init);
+
+    if (!timer_wheel_ok)
+    {
+        return false;
+    }
+
+    hal_get_time_msec(&msec);
+
+    /* round up, a timer never fires early */
+    ticks = (msec + timeout_msec + HAL_TIMER_TICK_MSEC - 1u) / HAL_TIMER_TICK_MSEC - (msec / HAL_TIMER_TICK_MSEC);
+
+    if (ticks > HAL_TIMER_MAX_TICKS)
+    {
+        ticks = HAL_TIMER_MAX_TICKS;
+    }
+
+    pthread_mutex_lock(&wheel->lock);
+
+    if (timer->pprev != NULL)
+    {
+        hal_timer_del(timer);
+        wheel->num_pending--;
+    }
+
+    if (wheel->num_pending == 0)
+    {
+        /* the wheel was idle, it restarts at the current tick */
+        wheel->curr_tick = msec / HAL_TIMER_TICK_MSEC;
+        pthread_cond_signal(&wheel->cond);
+    }
+
+    timer->expires = (msec / HAL_TIMER_TICK_MSEC) + ticks;
+    hal_timer_add(timer);
+    wheel->num_pending++;
+
+    pthread_mutex_unlock(&wheel->lock);
+
+    return true;
+}
+
+/**
+ * Cancels a timer, returns true if it was pending.
+ */
+static bool hal_timer_cancel(timer_instance_t *timer)
+{
+    timer_wheel_t *wheel = &timer_wheel;
+    bool pending;
+
+    pthread_mutex_lock(&wheel->lock);
+
+    pending = (timer->pprev != NULL);
+
+    if (pending)
+    {
+        hal_timer_del(timer);
+        wheel->num_pending--;
+    }
+
+    pthread_mutex_unlock(&wheel->lock);
+
+    return pending;
+}
+
+ATCA_STATUS hal_create_timer(void **timer, hal_timer_func_t timer_func, void *arg)
+{
+    timer_instance_t *timer_inst;
+
+    if (!timer || !timer_func)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    timer_inst = calloc(1, sizeof(timer_instance_t));
+
+    if (timer_inst == NULL)
+    {
+        return ATCA_ALLOC_FAILURE;
+    }
+
+    timer_inst->timer_func = timer_func;
+    timer_inst->arg = arg;
+
+    *timer = timer_inst;
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_destroy_timer(void *timer)
+{
+    timer_instance_t *timer_inst = (timer_instance_t*)timer;
+
+    if (!timer_inst)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    hal_timer_cancel(timer_inst);
+    free(timer_inst);
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_start_timer(void *timer, unsigned timeout_msec)
+{
+    timer_instance_t *timer_inst = (timer_instance_t*)timer;
+
+    if (!timer_inst)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    return hal_timer_start(timer_inst, timeout_msec) ? ATCA_SUCCESS : ATCA_GEN_FAIL;
+}
+
+ATCA_STATUS hal_cancel_timer(void *timer)
+{
+    timer_instance_t *timer_inst = (timer_instance_t*)timer;
+
+    if (!timer_inst)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    return hal_timer_cancel(timer_inst) ? ATCA_SUCCESS : ATCA_FUNC_FAIL;
+}
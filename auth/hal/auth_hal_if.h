@@ -91,6 +91,7 @@ typedef enum
 typedef void * hal_mutex;
 typedef void * hal_sem;
 typedef void * hal_thread;
+typedef void * hal_timer;
 
 
 ATCA_STATUS hal_create_mutex(void ** ppMutex, char* pName);
@@ -106,6 +107,15 @@ typedef void *(*thread_func_t)(void *);
 
 ATCA_STATUS hal_create_thread(void ** ppThread, thread_func_t thread_entry, void *arg);
 
+/**
+ * Waits for a thread to exit and frees the thread handle.
+ *
+ * @param pThread  Thread created with hal_create_thread().
+ *
+ * @return ATCA_SUCCESS on success, else error.
+ */
+ATCA_STATUS hal_join_thread(void * pThread);
+
 /**
  * Creates a semaphore
  *
@@ -120,11 +130,111 @@ ATCA_STATUS hel_destroy_sem(void *sem);
 
 ATCA_STATUS hal_wait_sem(void *sem);
 
+/**
+ * Waits on a semaphore.  The timeout is tracked by the timer wheel, the
+ * calling thread blocks without a deadline of its own.  On expiry only this
+ * waiter is woken, the semaphore count is not changed.
+ *
+ * @param sem           Semaphore to wait on.
+ * @param timeout_msec  Time to wait, 0 to poll.
+ *
+ * @return ATCA_SUCCESS if the semaphore was given, ATCA_TIMEOUT on timeout.
+ */
 ATCA_STATUS hal_wait_sem_timeout(void *sem, unsigned timeout_msec);
 
 ATCA_STATUS hal_give_sem(void *sem);
 
+/**
+ * Fills a buffer with cryptographically secure random bytes.
+ *
+ * @param buf  Buffer to fill.
+ * @param len  Number of bytes.
+ *
+ * @return ATCA_SUCCESS, else ATCA_GEN_FAIL if no random bytes are available.
+ */
 ATCA_STATUS hal_random(unsigned char *buf, unsigned len);
 
+/**
+ * Gets the wall clock time, used for expiry times which must survive
+ * a restart.
+ *
+ * @param seconds  Seconds since the Unix epoch.
+ *
+ * @return ATCA_SUCCESS, else ATCA_GEN_FAIL if the clock is not available.
+ */
+ATCA_STATUS hal_get_time_sec(uint32_t *seconds);
+
+/**
+ * Gets the monotonic time, used for timeouts.
+ *
+ * @param msec  Milliseconds since an arbitrary start point.
+ *
+ * @return ATCA_SUCCESS, else ATCA_GEN_FAIL if the clock is not available.
+ */
+ATCA_STATUS hal_get_time_msec(uint64_t *msec);
+
+/**
+ * Gets the number of online CPUs.
+ *
+ * @param count  Number of CPUs, at least 1.
+ *
+ * @return ATCA_SUCCESS, else ATCA_BAD_PARAM.
+ */
+ATCA_STATUS hal_get_cpu_count(unsigned *count);
+
+
+/**
+ * Timers run on a single hierarchical timer wheel driven by one thread on
+ * the monotonic clock, instead of one timed kernel wait per session.
+ * Starting and canceling a timer is O(1), timers expiring on the same tick
+ * fire as a batch.
+ */
+
+/** Timer resolution */
+#define HAL_TIMER_TICK_MSEC                 (10u)
+
+/**
+ * Timer expiry function.  Called from the timer thread with the wheel
+ * locked, must be short and must not call the hal_*_timer functions.
+ */
+typedef void (*hal_timer_func_t)(void *arg);
+
+/**
+ * Creates a timer.
+ *
+ * @param timer       New timer is returned here.
+ * @param timer_func  Called when the timer expires.
+ * @param arg         Passed to timer_func.
+ *
+ * @return ATCA_SUCCESS, else error.
+ */
+ATCA_STATUS hal_create_timer(void **timer, hal_timer_func_t timer_func, void *arg);
+
+/**
+ * Cancels and frees a timer.
+ */
+ATCA_STATUS hal_destroy_timer(void *timer);
+
+/**
+ * Starts a timer, a pending timer is restarted.
+ *
+ * @param timer         Timer to start.
+ * @param timeout_msec  Expiry time, rounded up to HAL_TIMER_TICK_MSEC.
+ *
+ * @return ATCA_SUCCESS, else error.
+ */
+ATCA_STATUS hal_start_timer(void *timer, unsigned timeout_msec);
+
+/**
+ * Cancels a timer.  Once this returns the expiry function is not running
+ * and will not be called.
+ *
+ * @param timer  Timer to cancel.
+ *
+ * @return ATCA_SUCCESS if the timer was pending, ATCA_FUNC_FAIL if it had
+ *         expired or was not started.
+ */
+ATCA_STATUS hal_cancel_timer(void *timer);
+
 #endif
 
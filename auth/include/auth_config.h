@@ -77,6 +77,21 @@
 #define NUM_AUTH_INSTANCES   2
 #endif
 
+/**
+ * Data cache line size in bytes, transport buffers are laid out so fields
+ * written by different threads do not share a line.
+ */
+#if !defined(AUTH_CACHE_LINE_SIZE)
+#define AUTH_CACHE_LINE_SIZE   64
+#endif
+
+/**
+ * Most session manager shards, each shard has one worker thread.
+ */
+#if !defined(AUTH_SESSION_MAX_SHARDS)
+#define AUTH_SESSION_MAX_SHARDS   16
+#endif
+
 
 #endif
 
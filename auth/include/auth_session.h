@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ * Use of this software is per the terms of the Apache 2.0 license
+ * (here: https://www.apache.org/licenses/LICENSE-2.0) plus the following;
+ *
+ *
+ *  THIS IS OPEN SOURCE SOFTWARE, THERE ARE NO WARRANTIES OF ANY KIND FOR ANY ASPECT OF THIS SOFTWARE.
+ *  BY USING THIS SOFTWARE, YOU ACCEPT ALL LIABILITIES AND RESPONSIBILITIES FOR ANY ISSUES OR
+ *  PROBLEMS ARISING OUT OF USE. YOU ARE RESPONSIBLE FOR DETERMINING THE SUITABILITY OF THIS
+ *  SOFTWARE FOR YOUR USE.
+ *
+ *  IF YOU ARE UNSURE ABOUT USING THIS SOFTWARE, DON'T USE IT.
+ *
+ *  THIS SOFTWARE IS SUPPLIED BY GOLDEN BITS SOFTWARE, INC. "AS IS". NO WARRANTIES, WHETHER
+ *  EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, ANY IMPLIED
+ *  WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT WILL GOLDEN BITS SOFTWARE BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, EXEMPLARY,
+ *  INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ *  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) COST OR EXPENSE OF ANY
+ *  KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF GOLDEN BITS SOFTWARE HAS BEEN ADVISED
+ *  OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. GOLDEN BITS SOFTWARE SHALL NOT BE HELD LIABLE UNDER
+ *  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * @file auth_session.h
+ *
+ * @brief  Session manager, runs authentications on a pool of worker threads
+ *         instead of one thread per connection.
+ *
+ *         Sessions are kept in a table keyed by the transport handle, split
+ *         into shards with one worker thread each, by default one shard per
+ *         CPU.  A session is queued on its own shard when started, a worker
+ *         which has run out of sessions steals queued sessions from the
+ *         busiest shard so all workers stay busy when many peers
+ *         re-connect at once.
+ *
+ *         A worker runs one authentication at a time, the authentication
+ *         blocks while waiting for the peer.  Use more shards than CPUs if
+ *         peers are slow to answer.  A started server session is only
+ *         queued once the client's first message arrived, an idle client
+ *         does not hold a worker.  Workers do not wait after the final
+ *         flight to answer a peer which lost it, the peer retries instead.
+ *
+ *         With admission control enabled, see auth_lib_set_admission(),
+ *         each shard sheds server sessions which waited in its run queue too
+ *         long: the client is told to retry later and the session reports
+ *         AUTH_STATUS_SERVER_BUSY.
+ *
+ *         The authenticate_conn structs are owned by the caller, a session
+ *         must be removed before its connection is de-initialized.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef AUTH_SESSION_H_
+#define AUTH_SESSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "auth_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Session manager counters, one entry per shard.
+ */
+struct auth_session_stats {
+	uint32_t num_shards;
+
+	/* sessions in the shard's table */
+	uint32_t sessions[AUTH_SESSION_MAX_SHARDS];
+
+	/* authentications run by the shard's worker */
+	uint32_t runs[AUTH_SESSION_MAX_SHARDS];
+
+	/* of those, sessions stolen from other shards */
+	uint32_t steals[AUTH_SESSION_MAX_SHARDS];
+
+	/* sessions shed by admission control, they waited too long to run */
+	uint32_t sheds[AUTH_SESSION_MAX_SHARDS];
+};
+
+
+/**
+ * Starts the session manager and its worker threads.
+ *
+ * @param num_shards  Number of shards, 0 for one per CPU.  At most
+ *                    AUTH_SESSION_MAX_SHARDS are used.
+ *
+ * @return AUTH_SUCCESS on success, else negative error code.
+ */
+int auth_session_mgr_init(unsigned num_shards);
+
+/**
+ * Stops the worker threads and empties the session table.  Running
+ * authentications are completed first, cancel them with auth_lib_cancel()
+ * to stop sooner.  Queued sessions are not run.  Transport receive
+ * callbacks already running are waited out before the shards are freed.
+ */
+void auth_session_mgr_deinit(void);
+
+/**
+ * Adds a connection to the session table.  The transport handle must be
+ * set and must not change while the session is in the table.
+ *
+ * @param auth_conn  Connection initialized with auth_lib_init().
+ *
+ * @return AUTH_SUCCESS on success, AUTH_ERROR_INVALID_PARAM if there is
+ *         already a session for the transport, else negative error code.
+ */
+int auth_session_add(struct authenticate_conn *auth_conn);
+
+/**
+ * Removes a connection from the session table.  Waits for a running
+ * authentication to complete, must not be called from the status callback.
+ *
+ * @param auth_conn  Connection added with auth_session_add().
+ *
+ * @return AUTH_SUCCESS on success, else negative error code.
+ */
+int auth_session_remove(struct authenticate_conn *auth_conn);
+
+/**
+ * Looks up the session of a transport.
+ *
+ * @param xport_hdl  Transport handle.
+ *
+ * @return The connection, NULL if the transport has no session.
+ */
+struct authenticate_conn *auth_session_find(auth_xport_hdl_t xport_hdl);
+
+/**
+ * Queues an authentication, the session manager's version of
+ * auth_lib_start().  A server session waits for the client's first
+ * message before it is queued.  Progress is reported through the status
+ * callback.
+ * A session started while its authentication is running, for example from
+ * the status callback, is queued again once it completes.
+ *
+ * @param auth_conn  Connection added with auth_session_add().
+ *
+ * @return AUTH_SUCCESS on success, AUTH_ERROR_SESSION_BUSY if the session
+ *         is already queued, else negative error code.
+ */
+int auth_session_start(struct authenticate_conn *auth_conn);
+
+/**
+ * Returns the session manager counters.
+ *
+ * @param stats  Counters are copied here.
+ *
+ * @return AUTH_SUCCESS on success, else negative error code.
+ */
+int auth_session_get_stats(struct auth_session_stats *stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* AUTH_SESSION_H_ */
@@ -38,6 +38,14 @@
 
 #include <tinycrypt/constants.h>
 #include <tinycrypt/sha256.h>
+#include <tinycrypt/hkdf.h>
+#include <tinycrypt/hmac.h>
+#include <tinycrypt/aes.h>
+#include <tinycrypt/gcm_mode.h>
+#include <tinycrypt/ecc.h>
+#include <tinycrypt/ecc_dh.h>
+#include <tinycrypt/ecc_dsa.h>
+#include <tinycrypt/utils.h>
 
 
 #include "auth_config.h"
@@ -60,10 +68,62 @@
 #define AUTH_SERVER_CHALRESP_MSG_ID         0x02
 #define AUTH_CLIENT_CHALRESP_MSG_ID         0x03
 #define AUTH_CHALRESP_RESULT_MSG_ID         0x04
+#define AUTH_CLIENT_RESUME_MSG_ID           0x05
+#define AUTH_SERVER_RESUME_MSG_ID           0x06
+#define AUTH_SERVER_TICKET_MSG_ID           0x07
+#define AUTH_CLIENT_PK_CHAL_MSG_ID          0x08
+#define AUTH_SERVER_PK_CHALRESP_MSG_ID      0x09
+#define AUTH_CLIENT_PK_CHALRESP_MSG_ID      0x0A
+#define AUTH_SERVER_BUSY_MSG_ID             0x0B
+#define AUTH_CLIENT_RESUME_FINISH_MSG_ID    0x0C
+
+/* Result values */
+#define AUTH_RESULT_SUCCESS                 0
+#define AUTH_RESULT_FAILED                  1
+#define AUTH_RESULT_TICKET                  2   /* success, a ticket message follows */
 
 /* Timeout for receive */
 #define AUTH_RX_TIMEOUT_MSEC                (3000u)
 
+/* Handshake retransmission timeout, RFC 6298 except for the initial value
+ * which is lower than one second, authentication usually runs over a
+ * local link. */
+#define AUTH_RTO_INITIAL_MSEC               (250u)
+#define AUTH_RTO_MIN_MSEC                   (20u)
+#define AUTH_RTO_MAX_MSEC                   AUTH_RX_TIMEOUT_MSEC
+
+/* Timeouts waiting for the peer before giving up */
+#define AUTH_MAX_RETRANSMIT                 (6u)
+
+/* Retransmission timeouts the server keeps answering a lost final flight */
+#define AUTH_LINGER_RTO_COUNT               (4u)
+
+/* HKDF labels for the session keys of each direction */
+#define AUTH_CLIENT_TO_SERVER_LABEL         "chalresp client to server"
+#define AUTH_SERVER_TO_CLIENT_LABEL         "chalresp server to client"
+
+/* HKDF and HMAC labels used by resumption tickets */
+#define AUTH_RESUMPTION_LABEL               "chalresp resumption"
+#define AUTH_RESUME_BINDER_LABEL            "chalresp resume client"
+#define AUTH_RESUME_VERIFY_LABEL            "chalresp resume server"
+#define AUTH_RESUME_CONFIRM_LABEL           "chalresp resume confirm"
+#define AUTH_TICKET_ENC_LABEL               "chalresp ticket key"
+#define AUTH_TICKET_NONCE_LABEL             "chalresp ticket nonce"
+
+/* Public-key mode signature labels, each side signs a different transcript */
+#define AUTH_PK_SERVER_SIGN_LABEL           "chalresp pk server"
+#define AUTH_PK_CLIENT_SIGN_LABEL           "chalresp pk client"
+#define AUTH_PK_SIGNATURE_LEN               (64u)
+
+/* Ticket layout: nonce | sealed (resumption secret | expiry time) | tag */
+#define AUTH_TICKET_KEY_LEN                 (32u)
+#define AUTH_TICKET_TAG_LEN                 (16u)
+#define AUTH_TICKET_PLAIN_LEN               (AUTH_RESUME_SECRET_LEN + 4u)
+
+#if (TC_GCM_NONCE_SIZE + AUTH_TICKET_PLAIN_LEN + AUTH_TICKET_TAG_LEN) != AUTH_RESUME_TICKET_LEN
+#error "Resumption ticket layout does not match AUTH_RESUME_TICKET_LEN"
+#endif
+
 
 /* ensure structs are byte aligned */
 #pragma pack(push, 1)
@@ -112,11 +172,136 @@ struct client_chal_resp {
 /* From Central or Peripheral indicating result of challenge-response */
 struct auth_chalresp_result {
 	struct chalresp_header hdr;
-	uint8_t result; /* 0 == success, 1 == failure */
+	uint8_t result; /* one of AUTH_RESULT_* */
+};
+
+/**
+ * Sent by the client instead of a challenge to resume with a ticket.
+ */
+struct client_resume {
+	struct chalresp_header hdr;
+	uint8_t client_challenge[AUTH_CHALLENGE_LEN];
+	uint8_t ticket[AUTH_RESUME_TICKET_LEN];
+
+	/* HMAC of the challenge with the resumption secret, proves the
+	 * client owns the ticket */
+	uint8_t binder[AUTH_SHA256_HASH];
+};
+
+/**
+ * Server response to a resumption attempt.
+ */
+struct server_resume_resp {
+	struct chalresp_header hdr;
+	uint8_t result; /* AUTH_RESULT_SUCCESS or AUTH_RESULT_FAILED */
+	uint8_t server_challenge[AUTH_CHALLENGE_LEN];
+
+	/* HMAC of both challenges with the resumption secret, proves the
+	 * server could open the ticket */
+	uint8_t verify[AUTH_SHA256_HASH];
+};
+
+/**
+ * Client key confirmation, the last message of a resumption.
+ */
+struct client_resume_finish {
+	struct chalresp_header hdr;
+
+	/* HMAC of both challenges with the resumption secret, proves the
+	 * client answered this server challenge and is not a replay */
+	uint8_t confirm[AUTH_SHA256_HASH];
+};
+
+/**
+ * Resumption ticket, follows a AUTH_RESULT_TICKET result.
+ */
+struct server_ticket {
+	struct chalresp_header hdr;
+	uint8_t lifetime[4]; /* seconds, Big Endian */
+	uint8_t ticket[AUTH_RESUME_TICKET_LEN];
+};
+
+/**
+ * Public-key mode, sent by the client instead of a challenge.  The
+ * ephemeral key is the client challenge.
+ */
+struct client_pk_challenge {
+	struct chalresp_header hdr;
+	uint8_t ephemeral_key[AUTH_PK_PUBLIC_KEY_LEN];
+	uint8_t public_key[AUTH_PK_PUBLIC_KEY_LEN];  /* identifies the client */
+};
+
+/**
+ * Public-key mode server response, the server ephemeral key is the
+ * server challenge.  The signature covers both ephemeral keys.
+ */
+struct server_pk_response {
+	struct chalresp_header hdr;
+	uint8_t ephemeral_key[AUTH_PK_PUBLIC_KEY_LEN];
+	uint8_t public_key[AUTH_PK_PUBLIC_KEY_LEN];
+	uint8_t signature[AUTH_PK_SIGNATURE_LEN];
+};
+
+/**
+ * Public-key mode client response to the server challenge.
+ */
+struct client_pk_resp {
+	struct chalresp_header hdr;
+	uint8_t signature[AUTH_PK_SIGNATURE_LEN];
+};
+
+/**
+ * Sent by an overloaded server instead of its first answer, the client
+ * stops and re-connects later.
+ */
+struct server_busy {
+	struct chalresp_header hdr;
+	uint8_t retry_after[4]; /* msecs, Big Endian */
 };
 
 #pragma pack(pop)
 
+/**
+ * Any Challenge-Response message.
+ */
+union chalresp_msg {
+	struct chalresp_header hdr;
+	struct client_challenge chal;
+	struct server_chal_response server_resp;
+	struct client_chal_resp client_resp;
+	struct auth_chalresp_result result;
+	struct client_resume resume;
+	struct server_resume_resp resume_resp;
+	struct client_resume_finish resume_finish;
+	struct server_ticket ticket;
+	struct client_pk_challenge pk_chal;
+	struct server_pk_response pk_server_resp;
+	struct client_pk_resp pk_client_resp;
+	struct server_busy busy;
+};
+
+/**
+ * Handshake state used to recover lost messages.  The client resends its
+ * last flight when the retransmission timer expires, the server resends its
+ * last flight when the client's previous message arrives again.
+ */
+struct chalresp_session {
+	/* last flight sent, a result can be followed by a ticket */
+	uint8_t flight[sizeof(union chalresp_msg) + sizeof(struct server_ticket)];
+	size_t flight_len;
+	uint64_t flight_sent_msec;
+	bool flight_resent;
+	bool flight_unsent;
+
+	/* last message received, an identical message is a duplicate */
+	union chalresp_msg peer_msg;
+	size_t peer_msg_len;
+
+	/* server waits for the Client's last message, resend the last flight
+	 * on timeout as the Client does not */
+	bool resend_on_timeout;
+};
+
 
 /**
  * Shared key.
@@ -134,6 +319,24 @@ static uint8_t *shared_key = default_shared_key;
 /* If caller specifies a new shared key, it is copied into this buffer. */
 static uint8_t chalresp_key[AUTH_SHARED_KEY_LEN];
 
+/* Server resumption ticket state, set once by auth_lib_set_ticket_key() */
+static bool ticket_enabled;
+static uint32_t ticket_lifetime;
+static struct tc_aes_key_sched_struct ticket_sched;
+static struct tc_gcm_mode_struct ticket_gcm;
+static uint8_t ticket_nonce_key[AUTH_TICKET_KEY_LEN];
+
+/* Public-key mode state, this side's key pair and the registered peer keys */
+static bool pk_enabled;
+static uint8_t pk_private_key[AUTH_PK_PRIVATE_KEY_LEN];
+static uint8_t pk_public_key[AUTH_PK_PUBLIC_KEY_LEN];
+static uint8_t pk_peer_keys[AUTH_PK_MAX_PEER_KEYS][AUTH_PK_PUBLIC_KEY_LEN];
+static uint32_t pk_num_peer_keys;
+
+/* optional per peer key verify tables */
+static bool pk_use_tables;
+static struct uECC_verify_table pk_verify_tables[AUTH_PK_MAX_PEER_KEYS];
+
 /**
  * Utility function to create the hash of the random challenge and the shared key.
  * Uses Tiny Crypt hashing code.
@@ -163,6 +366,60 @@ static int auth_chalresp_hash(const uint8_t *random_chal, uint8_t *hash)
 	return err;
 }
 
+/**
+ * Derives the session keys from a secret and both challenges. The
+ * challenges are the HKDF salt, so every session gets fresh keys.
+ *
+ * @param auth_conn      Authentication connection structure, the keys are stored here.
+ * @param secret         The shared key, or the resumption secret when resuming.
+ * @param client_chal    The client random challenge.
+ * @param server_chal    The server random challenge.
+ * @param resume_secret  If not NULL, a resumption secret for a ticket is derived here.
+ *
+ * @return AUTH_SUCCESS on success, else error value.
+ */
+static int auth_chalresp_derive_keys(struct authenticate_conn *auth_conn, const uint8_t *secret,
+				     const uint8_t *client_chal, const uint8_t *server_chal,
+				     uint8_t *resume_secret)
+{
+	uint8_t salt[2 * AUTH_CHALLENGE_LEN];
+	uint8_t prk[TC_HKDF_PRK_SIZE];
+	uint8_t c2s[AUTH_SESSION_KEY_LEN + AUTH_SESSION_IV_LEN];
+	uint8_t s2c[AUTH_SESSION_KEY_LEN + AUTH_SESSION_IV_LEN];
+	struct auth_session_keys *keys = &auth_conn->session_keys;
+	const uint8_t *tx, *rx;
+	int err = AUTH_SUCCESS;
+
+	memcpy(salt, client_chal, AUTH_CHALLENGE_LEN);
+	memcpy(salt + AUTH_CHALLENGE_LEN, server_chal, AUTH_CHALLENGE_LEN);
+
+	if ((tc_hkdf_extract(prk, salt, sizeof(salt), secret, AUTH_SHARED_KEY_LEN) != TC_CRYPTO_SUCCESS) ||
+	    (tc_hkdf_expand(c2s, sizeof(c2s), prk, (const uint8_t *)AUTH_CLIENT_TO_SERVER_LABEL,
+			    sizeof(AUTH_CLIENT_TO_SERVER_LABEL) - 1) != TC_CRYPTO_SUCCESS) ||
+	    (tc_hkdf_expand(s2c, sizeof(s2c), prk, (const uint8_t *)AUTH_SERVER_TO_CLIENT_LABEL,
+			    sizeof(AUTH_SERVER_TO_CLIENT_LABEL) - 1) != TC_CRYPTO_SUCCESS) ||
+	    ((resume_secret != NULL) &&
+	     (tc_hkdf_expand(resume_secret, AUTH_RESUME_SECRET_LEN, prk, (const uint8_t *)AUTH_RESUMPTION_LABEL,
+			     sizeof(AUTH_RESUMPTION_LABEL) - 1) != TC_CRYPTO_SUCCESS))) {
+		err = AUTH_ERROR_CRYPTO;
+	} else {
+		tx = auth_conn->is_client ? c2s : s2c;
+		rx = auth_conn->is_client ? s2c : c2s;
+
+		memcpy(keys->tx_key, tx, AUTH_SESSION_KEY_LEN);
+		memcpy(keys->tx_iv, tx + AUTH_SESSION_KEY_LEN, AUTH_SESSION_IV_LEN);
+		memcpy(keys->rx_key, rx, AUTH_SESSION_KEY_LEN);
+		memcpy(keys->rx_iv, rx + AUTH_SESSION_KEY_LEN, AUTH_SESSION_IV_LEN);
+		auth_conn->has_session_keys = true;
+	}
+
+	_set_secure(prk, 0, sizeof(prk));
+	_set_secure(c2s, 0, sizeof(c2s));
+	_set_secure(s2c, 0, sizeof(s2c));
+
+	return err;
+}
+
 /**
  * Checks header and id.
  *
@@ -171,7 +428,7 @@ static int auth_chalresp_hash(const uint8_t *random_chal, uint8_t *hash)
  *
  * @return true if message is valid, else false.
  */
-static bool auth_check_msg(struct chalresp_header *hdr, const uint8_t msg_id)
+static bool auth_check_msg(const struct chalresp_header *hdr, const uint8_t msg_id)
 {
 	if ((hdr->soh != CHALLENGE_RESP_SOH) || (hdr->msg_id != msg_id)) {
 		return false;
@@ -180,271 +437,1078 @@ static bool auth_check_msg(struct chalresp_header *hdr, const uint8_t msg_id)
 	return true;
 }
 
-
 /**
- * Sends a challenge to the server.
+ * Public-key mode, hash of the handshake transcript signed by each side.
  *
- * @param auth_conn     Authentication connection structure.
- * @param random_chal   Random 32 byte challenge to send.
+ * @param hash        The AUTH_SHA256_HASH byte result.
+ * @param label       Signer specific label.
+ * @param client_eph  Client ephemeral public key.
+ * @param server_eph  Server ephemeral public key.
+ * @param client_pub  Client public key.
+ * @param server_pub  Server public key.
  *
- * @return true if message send successfully, else false on error.
+ * @return AUTH_SUCCESS on success, else error value.
  */
-static bool auth_client_send_challenge(struct authenticate_conn *auth_conn, const uint8_t *random_chal)
+static int auth_chalresp_pk_transcript(uint8_t *hash, const char *label, const uint8_t *client_eph,
+				       const uint8_t *server_eph, const uint8_t *client_pub,
+				       const uint8_t *server_pub)
 {
-	int numbytes;
-	struct client_challenge chal;
-
-	/* build and send challenge message to Peripheral */
-	memset(&chal, 0, sizeof(chal));
-	chal.hdr.soh = CHALLENGE_RESP_SOH;
-	chal.hdr.msg_id = AUTH_CLIENT_CHAL_MSG_ID;
-
-	memcpy(&chal.client_challenge, random_chal, sizeof(chal.client_challenge));
-
-	/* send to server */
-	numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&chal, sizeof(chal));
+	struct tc_sha256_state_struct hash_state;
+	int ok;
 
-	if ((numbytes <= 0) || (numbytes != sizeof(chal))) {
-		/* error */
-		LOG_ERROR("Error sending challenge to server, err: %d", numbytes);
-		return false;
-	}
+	ok = tc_sha256_init(&hash_state) &&
+	     tc_sha256_update(&hash_state, (const uint8_t *)label, strlen(label)) &&
+	     tc_sha256_update(&hash_state, client_eph, AUTH_PK_PUBLIC_KEY_LEN) &&
+	     tc_sha256_update(&hash_state, server_eph, AUTH_PK_PUBLIC_KEY_LEN) &&
+	     tc_sha256_update(&hash_state, client_pub, AUTH_PK_PUBLIC_KEY_LEN) &&
+	     tc_sha256_update(&hash_state, server_pub, AUTH_PK_PUBLIC_KEY_LEN) &&
+	     tc_sha256_final(hash, &hash_state);
 
-	return true;
+	return ok ? AUTH_SUCCESS : AUTH_ERROR_CRYPTO;
 }
 
 /**
- * Receives and processes the challenge response from the server.
+ * Public-key mode, verifies a signature from a registered peer.
  *
- * @param auth_conn     Authentication connection structure.
- * @param random_chal   32 byte challenge sent to the server.
- * @param status        Pointer to return authentication status.
+ * @param public_key  Public key the peer claims to own.
+ * @param hash        Transcript hash.
+ * @param signature   Peer signature of the hash.
  *
- * @return true on success, else false.
+ * @return true if the key is registered and the signature is valid.
  */
-static bool auth_client_recv_chal_resp(struct authenticate_conn *auth_conn, const uint8_t *random_chal,
-				       enum auth_status *status)
+static bool auth_chalresp_pk_verify(const uint8_t *public_key, const uint8_t *hash,
+				    const uint8_t *signature)
 {
-	uint8_t hash[AUTH_CHAL_RESPONSE_LEN];
-	int numbytes;
-	int err;
-	struct server_chal_response server_resp;
-	struct client_chal_resp client_resp;
-	struct auth_chalresp_result chal_result;
-	uint8_t *buf = (uint8_t *)&server_resp;
-	int len = sizeof(server_resp);
-
-	while (len > 0) {
-
-		numbytes = auth_xport_recv(auth_conn->xport_hdl, buf, len, AUTH_RX_TIMEOUT_MSEC);
-
-		/* canceled ? */
-		if (auth_conn->cancel_auth) {
-			*status = AUTH_STATUS_CANCELED;
-			return false;
-		}
-
-		/* timed out, try to read again */
-		if (numbytes == -EAGAIN) {
-			continue;
-		}
+	uint32_t cnt;
 
-		if (numbytes <= 0) {
-            LOG_ERROR("Failed to read server challenge response, err: %d", numbytes);
-			*status = AUTH_STATUS_FAILED;
-			return false;
+	for (cnt = 0; cnt < pk_num_peer_keys; cnt++) {
+		if (memcmp(pk_peer_keys[cnt], public_key, AUTH_PK_PUBLIC_KEY_LEN) == 0) {
+			break;
 		}
-
-		buf += numbytes;
-		len -= numbytes;
 	}
 
-	/* check message */
-	if (!auth_check_msg(&server_resp.hdr, AUTH_SERVER_CHALRESP_MSG_ID)) {
-        LOG_ERROR("Invalid message received from the server.");
-		*status = AUTH_STATUS_FAILED;
+	if (cnt == pk_num_peer_keys) {
+		LOG_ERROR("Peer public key is not registered.");
 		return false;
 	}
 
+	if (pk_use_tables) {
+		return uECC_verify_with_table(&pk_verify_tables[cnt], hash, AUTH_SHA256_HASH, signature) ==
+		       TC_CRYPTO_SUCCESS;
+	}
 
-	/* Now verify response, is the response correct?  Hash the random challenge
-	 * with the shared key. */
-	err = auth_chalresp_hash(random_chal, hash);
+	return uECC_verify(pk_peer_keys[cnt], hash, AUTH_SHA256_HASH, signature, uECC_secp256r1()) ==
+	       TC_CRYPTO_SUCCESS;
+}
 
-	if (err) {
-        LOG_ERROR("Failed to calc hash, err: %d", err);
-		*status = AUTH_STATUS_FAILED;
+/**
+ * Public-key mode, computes the ECDH secret of the ephemeral keys.
+ *
+ * @param secret       The 32 byte secret.
+ * @param peer_eph     Peer ephemeral public key.
+ * @param eph_private  This side's ephemeral private key.
+ *
+ * @return true on success, false if the peer key is not a valid point.
+ */
+static bool auth_chalresp_pk_secret(uint8_t *secret, const uint8_t *peer_eph, const uint8_t *eph_private)
+{
+	if (uECC_valid_public_key(peer_eph, uECC_secp256r1()) != 0) {
 		return false;
 	}
 
-	/* Does the response match what is expected? */
-	if (memcmp(hash, server_resp.server_response, sizeof(hash))) {
-		/* authentication failed */
-        LOG_ERROR("Server authentication failed.");
-		*status = AUTH_STATUS_AUTHENTICATION_FAILED;
-
-		/* send failed message to the Peripheral */
-		memset(&chal_result, 0, sizeof(chal_result));
-		chal_result.hdr.soh = CHALLENGE_RESP_SOH;
-		chal_result.hdr.msg_id = AUTH_CHALRESP_RESULT_MSG_ID;
-		chal_result.result = 1;
-
-		numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&chal_result, sizeof(chal_result));
+	return uECC_shared_secret(peer_eph, eph_private, secret, uECC_secp256r1()) == TC_CRYPTO_SUCCESS;
+}
 
-		if ((numbytes <= 0) || (numbytes != sizeof(chal_result))) {
-            LOG_ERROR("Failed to send authentication error result to server.");
-		}
+/**
+ * Public-key mode, sets this side's key pair and the peer keys.
+ *
+ * @param chal_resp  Challenge-Response params.
+ *
+ * @return AUTH_SUCCESS on success, else error value.
+ */
+static int auth_chalresp_pk_init(const struct auth_challenge_resp *chal_resp)
+{
+	uint32_t cnt;
 
-		return false;
+	if ((chal_resp->num_peer_keys == 0) || (chal_resp->num_peer_keys > AUTH_PK_MAX_PEER_KEYS) ||
+	    (chal_resp->peer_public_keys == NULL)) {
+		return AUTH_ERROR_INVALID_PARAM;
 	}
 
-	/* init Client response message */
-	memset(&client_resp, 0, sizeof(client_resp));
-	client_resp.hdr.soh = CHALLENGE_RESP_SOH;
-	client_resp.hdr.msg_id = AUTH_CLIENT_CHALRESP_MSG_ID;
-
-	/* Create response to the server's random challenge */
-	err = auth_chalresp_hash(server_resp.server_challenge, client_resp.client_response);
+	memcpy(pk_private_key, chal_resp->private_key, sizeof(pk_private_key));
 
-	if (err) {
-        LOG_ERROR("Failed to create server response to challenge, err: %d", err);
-		*status = AUTH_STATUS_FAILED;
-		return false;
+	if (!uECC_compute_public_key(pk_private_key, pk_public_key, uECC_secp256r1())) {
+		LOG_ERROR("Invalid private key.");
+		return AUTH_ERROR_INVALID_PARAM;
 	}
 
-	/* send Client's response to the Server's random challenge */
-	numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&client_resp, sizeof(client_resp));
+	for (cnt = 0; cnt < chal_resp->num_peer_keys; cnt++) {
+		memcpy(pk_peer_keys[cnt], chal_resp->peer_public_keys[cnt], AUTH_PK_PUBLIC_KEY_LEN);
 
-	if ((numbytes <= 0) || (numbytes != sizeof(client_resp))) {
-        LOG_ERROR("Failed to send Client response.");
-		*status = AUTH_STATUS_FAILED;
-		return false;
+		if (chal_resp->cache_verify_tables) {
+			if (!uECC_verify_table_init(&pk_verify_tables[cnt], pk_peer_keys[cnt], uECC_secp256r1())) {
+				LOG_ERROR("Invalid peer public key: %d", cnt);
+				return AUTH_ERROR_INVALID_PARAM;
+			}
+		}
 	}
 
-	/* so far so good, need to wait for Server response */
-	*status = AUTH_STATUS_IN_PROCESS;
-	return true;
+	pk_num_peer_keys = chal_resp->num_peer_keys;
+	pk_use_tables = chal_resp->cache_verify_tables;
+	pk_enabled = true;
+
+	return AUTH_SUCCESS;
 }
 
 /**
- * Server waits and receives a message from the client.
+ * HMAC-SHA256 of a label and one or two challenges.
  *
- * @param auth_conn   Authentication connection structure.
- * @param msgbuf      Buffer to copy message into.
- * @param msglen      Buffer byte length.
+ * @param mac    The AUTH_SHA256_HASH byte result.
+ * @param key    32 byte key.
+ * @param label  String prefixed to the data.
+ * @param chal1  First challenge.
+ * @param chal2  Second challenge, NULL if not used.
  *
- * @return true if number of bytes were received, else false.
+ * @return AUTH_SUCCESS on success, else error value.
  */
-static bool auth_server_recv_msg(struct authenticate_conn *auth_conn, uint8_t *msgbuf, size_t msglen)
+static int auth_chalresp_hmac(uint8_t *mac, const uint8_t *key, const char *label,
+			      const uint8_t *chal1, const uint8_t *chal2)
 {
-	int numbytes;
+	struct tc_hmac_state_struct h;
+	int ok;
 
-	while ((int)msglen > 0) {
+	ok = tc_hmac_set_key(&h, key, AUTH_SHARED_KEY_LEN) &&
+	     tc_hmac_init(&h) &&
+	     tc_hmac_update(&h, label, strlen(label)) &&
+	     tc_hmac_update(&h, chal1, AUTH_CHALLENGE_LEN) &&
+	     ((chal2 == NULL) || tc_hmac_update(&h, chal2, AUTH_CHALLENGE_LEN)) &&
+	     tc_hmac_final(mac, AUTH_SHA256_HASH, &h);
 
-		numbytes = auth_xport_recv(auth_conn->xport_hdl, msgbuf, msglen, AUTH_RX_TIMEOUT_MSEC);
+	_set_secure(&h, 0, sizeof(h));
 
-		if (auth_conn->cancel_auth) {
-			return false;
-		}
+	return ok ? AUTH_SUCCESS : AUTH_ERROR_CRYPTO;
+}
 
-		/* timed out, retry */
-		if (numbytes == -EAGAIN) {
-			continue;
-		}
+/**
+ * @see auth_internal.h
+ */
+int auth_chalresp_ticket_init(const uint8_t *key, uint32_t lifetime_sec)
+{
+	static const uint8_t zero_nonce[TC_GCM_NONCE_SIZE];
+	uint8_t random_key[AUTH_TICKET_KEY_LEN];
+	uint8_t enc_key[TC_AES256_KEY_SIZE];
+	int ok;
 
-		if (numbytes <= 0) {
-			return false;
+	ticket_enabled = false;
+
+	if (lifetime_sec == 0) {
+		_set_secure(ticket_nonce_key, 0, sizeof(ticket_nonce_key));
+		_set_secure(&ticket_sched, 0, sizeof(ticket_sched));
+		return AUTH_SUCCESS;
+	}
+
+	if (key == NULL) {
+		if (hal_random(random_key, sizeof(random_key)) != ATCA_SUCCESS) {
+			LOG_ERROR("Failed to generate ticket key.");
+			return AUTH_ERROR_CRYPTO;
 		}
 
-		msgbuf += numbytes;
-		msglen -= numbytes;
+		key = random_key;
 	}
 
-	return true;
+	/* the ticket key is uniformly random, use it directly as the HKDF PRK */
+	ok = tc_hkdf_expand(enc_key, sizeof(enc_key), key, (const uint8_t *)AUTH_TICKET_ENC_LABEL,
+			    sizeof(AUTH_TICKET_ENC_LABEL) - 1) &&
+	     tc_hkdf_expand(ticket_nonce_key, sizeof(ticket_nonce_key), key,
+			    (const uint8_t *)AUTH_TICKET_NONCE_LABEL, sizeof(AUTH_TICKET_NONCE_LABEL) - 1) &&
+	     tc_aes256_set_encrypt_key(&ticket_sched, enc_key) &&
+	     tc_gcm_config(&ticket_gcm, &ticket_sched, zero_nonce, TC_GCM_NONCE_SIZE, AUTH_TICKET_TAG_LEN);
+
+	_set_secure(random_key, 0, sizeof(random_key));
+	_set_secure(enc_key, 0, sizeof(enc_key));
+
+	if (!ok) {
+		return AUTH_ERROR_CRYPTO;
+	}
+
+	ticket_lifetime = lifetime_sec;
+	ticket_enabled = true;
+
+	return AUTH_SUCCESS;
 }
 
 /**
- * Handles the client challenge, creates a hash of the challenge with the
- * shared key.
+ * Seals a resumption secret and its expiry time into a ticket.  The nonce
+ * is a MAC of the sealed contents, so it never repeats for different
+ * contents even if the ticket key outlives a restart.
  *
- * @param auth_conn           Authentication connection structure.
- * @param server_random_chal  The server random challenge to be sent to the client.
+ * @param ticket  AUTH_RESUME_TICKET_LEN byte ticket.
+ * @param secret  Resumption secret.
  *
- * @return  true on success, else false on error.
+ * @return true on success, else false.
  */
-static bool auth_server_recv_challenge(struct authenticate_conn *auth_conn, uint8_t *server_random_chal)
+static bool auth_chalresp_ticket_seal(uint8_t *ticket, const uint8_t *secret)
 {
-	struct client_challenge chal;
-	struct server_chal_response server_resp;
-	int numbytes;
-
-	if (!auth_server_recv_msg(auth_conn, (uint8_t *)&chal, sizeof(chal))) {
-        LOG_ERROR("Failed to receive client challenge message.");
-		return false;
-	}
-
-	if (!auth_check_msg(&chal.hdr, AUTH_CLIENT_CHAL_MSG_ID)) {
-        LOG_ERROR("Invalid message.");
+	struct tc_gcm_mode_struct gcm = ticket_gcm;
+	struct tc_hmac_state_struct h;
+	uint8_t plain[AUTH_TICKET_PLAIN_LEN];
+	uint8_t nonce[AUTH_SHA256_HASH];
+	uint32_t expiry;
+	int ok;
+
+	if (hal_get_time_sec(&expiry) != ATCA_SUCCESS) {
 		return false;
 	}
 
-	/* create response and send back to the Client */
-	server_resp.hdr.soh = CHALLENGE_RESP_SOH;
-	server_resp.hdr.msg_id = AUTH_SERVER_CHALRESP_MSG_ID;
+	expiry += ticket_lifetime;
 
-	/* copy the server's challenge for the client */
-	memcpy(server_resp.server_challenge, server_random_chal,
-	       sizeof(server_resp.server_challenge));
+	memcpy(plain, secret, AUTH_RESUME_SECRET_LEN);
+	plain[AUTH_RESUME_SECRET_LEN] = (uint8_t)(expiry >> 24);
+	plain[AUTH_RESUME_SECRET_LEN + 1] = (uint8_t)(expiry >> 16);
+	plain[AUTH_RESUME_SECRET_LEN + 2] = (uint8_t)(expiry >> 8);
+	plain[AUTH_RESUME_SECRET_LEN + 3] = (uint8_t)expiry;
 
-	/* Now create the response for the Client */
-	auth_chalresp_hash(chal.client_challenge, server_resp.server_response);
+	ok = tc_hmac_set_key(&h, ticket_nonce_key, sizeof(ticket_nonce_key)) &&
+	     tc_hmac_init(&h) &&
+	     tc_hmac_update(&h, plain, sizeof(plain)) &&
+	     tc_hmac_final(nonce, sizeof(nonce), &h);
 
-	/* Send response */
-	numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&server_resp, sizeof(server_resp));
+	if (ok) {
+		memcpy(ticket, nonce, TC_GCM_NONCE_SIZE);
 
-	if ((numbytes <= 0) || (numbytes != sizeof(server_resp))) {
-        LOG_ERROR("Failed to send challenge response to the Client.");
-		return false;
+		ok = tc_gcm_set_nonce(&gcm, ticket, TC_GCM_NONCE_SIZE) &&
+		     tc_gcm_generation_encryption(ticket + TC_GCM_NONCE_SIZE,
+						  AUTH_TICKET_PLAIN_LEN + AUTH_TICKET_TAG_LEN,
+						  NULL, 0, plain, sizeof(plain), &gcm);
 	}
 
-	return true;
+	_set_secure(&h, 0, sizeof(h));
+	_set_secure(plain, 0, sizeof(plain));
+
+	return ok;
 }
 
 /**
- *  Handles the client response to the server challenge.
+ * Opens a ticket presented by a client.
  *
- * @param auth_conn            Authentication connection structure.
- * @param server_random_chal   The server random challenge sent to the client.
- * @param status               Status of the Challenge-Response authentication set here.
+ * @param ticket  AUTH_RESUME_TICKET_LEN byte ticket.
+ * @param secret  The resumption secret is returned here.
  *
- * @return  true on success, else false.
+ * @return true if the ticket is authentic and has not expired, else false.
  */
-static bool auth_server_recv_chalresp(struct authenticate_conn *auth_conn, uint8_t *server_random_chal,
-				      enum auth_status *status)
+static bool auth_chalresp_ticket_open(const uint8_t *ticket, uint8_t *secret)
 {
-	struct client_chal_resp client_resp;
-	struct auth_chalresp_result result_resp;
-	uint8_t hash[AUTH_SHA256_HASH];
-	int err, numbytes;
+	struct tc_gcm_mode_struct gcm = ticket_gcm;
+	uint8_t plain[AUTH_TICKET_PLAIN_LEN];
+	uint32_t expiry;
+	uint32_t now;
+
+	if (!tc_gcm_set_nonce(&gcm, ticket, TC_GCM_NONCE_SIZE) ||
+	    !tc_gcm_decryption_verification(plain, sizeof(plain), NULL, 0, ticket + TC_GCM_NONCE_SIZE,
+					    AUTH_TICKET_PLAIN_LEN + AUTH_TICKET_TAG_LEN, &gcm)) {
+		LOG_DEBUG("Invalid resumption ticket.");
+		return false;
+	}
 
-	memset(&client_resp, 0, sizeof(client_resp));
+	expiry = ((uint32_t)plain[AUTH_RESUME_SECRET_LEN] << 24) |
+		 ((uint32_t)plain[AUTH_RESUME_SECRET_LEN + 1] << 16) |
+		 ((uint32_t)plain[AUTH_RESUME_SECRET_LEN + 2] << 8) |
+		 (uint32_t)plain[AUTH_RESUME_SECRET_LEN + 3];
 
-	/* read just the header */
-	if (!auth_server_recv_msg(auth_conn, (uint8_t *)&client_resp, sizeof(client_resp.hdr))) {
-        LOG_ERROR("Failed to receive challenge response from the Client");
-		*status = AUTH_STATUS_FAILED;
+	if ((hal_get_time_sec(&now) != ATCA_SUCCESS) || (now > expiry)) {
+		LOG_DEBUG("Resumption ticket expired.");
+		_set_secure(plain, 0, sizeof(plain));
 		return false;
 	}
 
-	/* This is a result message, means the Client failed to authenticate the Server. */
-	if (client_resp.hdr.msg_id == AUTH_CHALRESP_RESULT_MSG_ID) {
+	memcpy(secret, plain, AUTH_RESUME_SECRET_LEN);
+	_set_secure(plain, 0, sizeof(plain));
 
-		/* read the remainder of the message */
-		auth_server_recv_msg(auth_conn, (uint8_t *)&result_resp.result, sizeof(result_resp.result));
+	return true;
+}
+
+
+/**
+ * Gets the length of a message from its header.
+ *
+ * @param hdr  Message header.
+ *
+ * @return Message length including the header, 0 if the message is not valid.
+ */
+static size_t auth_chalresp_msg_len(const struct chalresp_header *hdr)
+{
+	if (hdr->soh != CHALLENGE_RESP_SOH) {
+		return 0;
+	}
+
+	switch (hdr->msg_id) {
+	case AUTH_CLIENT_CHAL_MSG_ID:
+		return sizeof(struct client_challenge);
+	case AUTH_SERVER_CHALRESP_MSG_ID:
+		return sizeof(struct server_chal_response);
+	case AUTH_CLIENT_CHALRESP_MSG_ID:
+		return sizeof(struct client_chal_resp);
+	case AUTH_CHALRESP_RESULT_MSG_ID:
+		return sizeof(struct auth_chalresp_result);
+	case AUTH_CLIENT_RESUME_MSG_ID:
+		return sizeof(struct client_resume);
+	case AUTH_SERVER_RESUME_MSG_ID:
+		return sizeof(struct server_resume_resp);
+	case AUTH_CLIENT_RESUME_FINISH_MSG_ID:
+		return sizeof(struct client_resume_finish);
+	case AUTH_SERVER_TICKET_MSG_ID:
+		return sizeof(struct server_ticket);
+	case AUTH_CLIENT_PK_CHAL_MSG_ID:
+		return sizeof(struct client_pk_challenge);
+	case AUTH_SERVER_PK_CHALRESP_MSG_ID:
+		return sizeof(struct server_pk_response);
+	case AUTH_CLIENT_PK_CHALRESP_MSG_ID:
+		return sizeof(struct client_pk_resp);
+	case AUTH_SERVER_BUSY_MSG_ID:
+		return sizeof(struct server_busy);
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Gets the current retransmission timeout.
+ *
+ * @param auth_conn  Authentication connection structure.
+ *
+ * @return Timeout in milliseconds.
+ */
+static uint32_t auth_chalresp_rto(struct authenticate_conn *auth_conn)
+{
+	return (auth_conn->rtt.rto != 0) ? auth_conn->rtt.rto : AUTH_RTO_INITIAL_MSEC;
+}
+
+/**
+ * Doubles the retransmission timeout after a timeout, up to AUTH_RTO_MAX_MSEC.
+ *
+ * @param auth_conn  Authentication connection structure.
+ */
+static void auth_chalresp_rto_backoff(struct authenticate_conn *auth_conn)
+{
+	uint32_t rto = auth_chalresp_rto(auth_conn) * 2u;
+
+	auth_conn->rtt.rto = (rto > AUTH_RTO_MAX_MSEC) ? AUTH_RTO_MAX_MSEC : rto;
+}
+
+/**
+ * Adds a message to the last flight without sending it.
+ *
+ * @param sess    Handshake state.
+ * @param msg     Message to add.
+ * @param len     Message length.
+ * @param append  True to add the message to the last flight, else it
+ *                starts a new flight.
+ *
+ * @return true on success, else false.
+ */
+static bool auth_chalresp_queue(struct chalresp_session *sess, const void *msg, size_t len, bool append)
+{
+	if (!append) {
+		sess->flight_len = 0;
+	}
+
+	if (sess->flight_len + len > sizeof(sess->flight)) {
+		return false;
+	}
+
+	memcpy(sess->flight + sess->flight_len, msg, len);
+	sess->flight_len += len;
+	sess->flight_unsent = true;
+
+	return true;
+}
+
+/**
+ * Sends the last flight as one transport message, so its messages are
+ * lost or received together.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ *
+ * @return true on success, else false.
+ */
+static bool auth_chalresp_send_flight(struct authenticate_conn *auth_conn, struct chalresp_session *sess)
+{
+	int numbytes = auth_xport_send(auth_conn->xport_hdl, sess->flight, sess->flight_len);
+
+	sess->flight_unsent = false;
+
+	if ((numbytes <= 0) || ((size_t)numbytes != sess->flight_len)) {
+		LOG_ERROR("Failed to send message, err: %d", numbytes);
+		return false;
+	}
+
+	hal_get_time_msec(&sess->flight_sent_msec);
+	sess->flight_resent = false;
+
+	return true;
+}
+
+/**
+ * Sends a message as a new flight.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ * @param msg        Message to send.
+ * @param len        Message length.
+ *
+ * @return true on success, else false.
+ */
+static bool auth_chalresp_send(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+			       const void *msg, size_t len)
+{
+	return auth_chalresp_queue(sess, msg, len, false) && auth_chalresp_send_flight(auth_conn, sess);
+}
+
+/**
+ * Resends the last flight, the peer did not answer it.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ */
+static void auth_chalresp_resend(struct authenticate_conn *auth_conn, struct chalresp_session *sess)
+{
+	int numbytes = auth_xport_send(auth_conn->xport_hdl, sess->flight, sess->flight_len);
+
+	if ((numbytes <= 0) || ((size_t)numbytes != sess->flight_len)) {
+		LOG_WARNING("Failed to resend message, err: %d", numbytes);
+	}
+
+	sess->flight_resent = true;
+}
+
+/**
+ * Reads the remainder of a message, it arrives with its header.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param buf        Buffer to read into.
+ * @param len        Number of bytes to read.
+ *
+ * @return AUTH_SUCCESS on success, else negative error code.
+ */
+static int auth_chalresp_read(struct authenticate_conn *auth_conn, uint8_t *buf, size_t len)
+{
+	int numbytes;
+
+	while (len > 0) {
+
+		numbytes = auth_xport_recv(auth_conn->xport_hdl, buf, len, AUTH_RX_TIMEOUT_MSEC);
+
+		if (auth_conn->cancel_auth) {
+			return AUTH_ERROR_CANCELED;
+		}
+
+		if (numbytes == -EAGAIN) {
+			return AUTH_ERROR_TIMEOUT;
+		}
+
+		if (numbytes <= 0) {
+			return (numbytes < 0) ? numbytes : AUTH_ERROR_XPORT_FRAME;
+		}
+
+		buf += numbytes;
+		len -= numbytes;
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * Waits for the next message from the peer.  Until the first flight is sent
+ * this waits indefinitely.  Afterwards the client resends its last flight each
+ * time the retransmission timer expires, doubling the timeout, and both sides
+ * give up after AUTH_MAX_RETRANSMIT timeouts.  The server resends on timeout
+ * only while waiting for the Client's last message.  A copy of the previous peer
+ * message is dropped, the server answers it by resending its last flight.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ * @param msg        The message is copied here.
+ *
+ * @return AUTH_SUCCESS on success, AUTH_ERROR_TIMEOUT if the peer did not
+ *         answer, AUTH_ERROR_CANCELED, else negative error code.
+ */
+static int auth_chalresp_recv(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+			      union chalresp_msg *msg)
+{
+	uint32_t timeouts = 0;
+	uint64_t now_msec;
+	size_t len;
+	int numbytes;
+	int err;
+
+	while (true) {
+
+		numbytes = auth_xport_getnum_recvqueue_bytes_wait(auth_conn->xport_hdl,
+								  (sess->flight_len == 0) ? AUTH_RX_TIMEOUT_MSEC :
+								  auth_chalresp_rto(auth_conn));
+
+		if (auth_conn->cancel_auth) {
+			return AUTH_ERROR_CANCELED;
+		}
+
+		if (numbytes == -EAGAIN) {
+
+			/* waiting for the peer to start */
+			if (sess->flight_len == 0) {
+				continue;
+			}
+
+			if (++timeouts > AUTH_MAX_RETRANSMIT) {
+				LOG_ERROR("No response from peer.");
+				return AUTH_ERROR_TIMEOUT;
+			}
+
+			auth_chalresp_rto_backoff(auth_conn);
+
+			if (auth_conn->is_client || sess->resend_on_timeout) {
+				LOG_DEBUG("Resending message, timeout %u msec.", auth_chalresp_rto(auth_conn));
+				auth_chalresp_resend(auth_conn, sess);
+			}
+
+			continue;
+		}
+
+		if (numbytes < 0) {
+			return numbytes;
+		}
+
+		if (numbytes == 0) {
+			continue;
+		}
+
+		err = auth_chalresp_read(auth_conn, (uint8_t *)&msg->hdr, sizeof(msg->hdr));
+
+		if (err) {
+			return err;
+		}
+
+		len = auth_chalresp_msg_len(&msg->hdr);
+
+		if (len == 0) {
+			LOG_ERROR("Invalid message received.");
+			return AUTH_ERROR_XPORT_FRAME;
+		}
+
+		err = auth_chalresp_read(auth_conn, (uint8_t *)msg + sizeof(msg->hdr), len - sizeof(msg->hdr));
+
+		if (err) {
+			return err;
+		}
+
+		/* the server shed the authentication, back off */
+		if (auth_conn->is_client && (msg->hdr.msg_id == AUTH_SERVER_BUSY_MSG_ID)) {
+			auth_conn->retry_after_msec = ((uint32_t)msg->busy.retry_after[0] << 24) |
+						      ((uint32_t)msg->busy.retry_after[1] << 16) |
+						      ((uint32_t)msg->busy.retry_after[2] << 8) |
+						      (uint32_t)msg->busy.retry_after[3];
+
+			LOG_ERROR("Server busy, retry after %u msec.", auth_conn->retry_after_msec);
+			return AUTH_ERROR_SERVER_BUSY;
+		}
+
+		/* A copy of the last message, the peer resent it because our answer
+		 * was lost or slow.  Messages are resent unchanged, so the answer is
+		 * the same too. */
+		if ((len == sess->peer_msg_len) && (memcmp(msg, &sess->peer_msg, len) == 0)) {
+			LOG_DEBUG("Dropped duplicate message, id: %d", msg->hdr.msg_id);
+
+			if (!auth_conn->is_client && (sess->flight_len > 0)) {
+				auth_chalresp_resend(auth_conn, sess);
+			}
+
+			continue;
+		}
+
+		/* Karn's algorithm, no sample if the flight was resent */
+		if ((sess->flight_len > 0) && !sess->flight_resent &&
+		    (hal_get_time_msec(&now_msec) == ATCA_SUCCESS)) {
+			auth_lib_rtt_update(&auth_conn->rtt, (uint32_t)(now_msec - sess->flight_sent_msec),
+					    AUTH_RTO_MIN_MSEC, AUTH_RTO_MAX_MSEC);
+		}
+
+		memcpy(&sess->peer_msg, msg, len);
+		sess->peer_msg_len = len;
+
+		return AUTH_SUCCESS;
+	}
+}
+
+/**
+ * The peer may not have received the final flight.  For a few
+ * retransmission timeouts answer copies of the peer's last message by
+ * resending it.  Stops at any other message, which is left for the
+ * application.  Does not wait on a session manager worker, which would
+ * hold up the other sessions, a peer which lost the final flight retries
+ * the authentication.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ * @param rto_msec   Peer retransmission timeout.
+ */
+static void auth_chalresp_linger(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				 uint32_t rto_msec)
+{
+	union chalresp_msg msg;
+	uint64_t now_msec;
+	uint64_t end_msec;
+	int numbytes;
+
+	if ((sess->flight_len == 0) || (sess->peer_msg_len == 0) || auth_session_managed(auth_conn) ||
+	    (hal_get_time_msec(&now_msec) != ATCA_SUCCESS)) {
+		return;
+	}
+
+	end_msec = now_msec + (uint64_t)AUTH_LINGER_RTO_COUNT * rto_msec;
+
+	while (now_msec < end_msec) {
+
+		numbytes = auth_xport_getnum_recvqueue_bytes_wait(auth_conn->xport_hdl,
+								  (uint32_t)(end_msec - now_msec));
+
+		if (auth_conn->cancel_auth || ((numbytes < 0) && (numbytes != -EAGAIN))) {
+			return;
+		}
+
+		if (numbytes > 0) {
+
+			/* only take a copy of the peer's last message off the queue */
+			if ((auth_xport_recv_peek(auth_conn->xport_hdl, (uint8_t *)&msg,
+						  sess->peer_msg_len) != (int)sess->peer_msg_len) ||
+			    (memcmp(&msg, &sess->peer_msg, sess->peer_msg_len) != 0) ||
+			    (auth_chalresp_read(auth_conn, (uint8_t *)&msg, sess->peer_msg_len) != AUTH_SUCCESS)) {
+				return;
+			}
+
+			LOG_DEBUG("Peer resent message, resending last flight.");
+			auth_chalresp_resend(auth_conn, sess);
+		}
+
+		if (hal_get_time_msec(&now_msec) != ATCA_SUCCESS) {
+			return;
+		}
+	}
+}
+
+/**
+ * Server, tells the Client to re-connect later instead of answering its
+ * message.  Copies of the message already queued are dropped so a later
+ * authentication does not answer them.
+ *
+ * @param auth_conn         Authentication connection structure.
+ * @param sess              Handshake state, holds the Client's message.
+ * @param retry_after_msec  Back off time for the Client.
+ */
+static void auth_server_send_busy(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				  uint32_t retry_after_msec)
+{
+	struct server_busy busy;
+	union chalresp_msg msg;
+	int numbytes;
+
+	busy.hdr.soh = CHALLENGE_RESP_SOH;
+	busy.hdr.msg_id = AUTH_SERVER_BUSY_MSG_ID;
+	busy.retry_after[0] = (uint8_t)(retry_after_msec >> 24);
+	busy.retry_after[1] = (uint8_t)(retry_after_msec >> 16);
+	busy.retry_after[2] = (uint8_t)(retry_after_msec >> 8);
+	busy.retry_after[3] = (uint8_t)retry_after_msec;
+
+	numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&busy, sizeof(busy));
+
+	if (numbytes != sizeof(busy)) {
+		LOG_ERROR("Failed to send busy message, err: %d", numbytes);
+	}
+
+	while ((sess->peer_msg_len > 0) && (auth_xport_getnum_recvqueue_bytes(auth_conn->xport_hdl) > 0) &&
+	       (auth_xport_recv_peek(auth_conn->xport_hdl, (uint8_t *)&msg,
+				     sess->peer_msg_len) == (int)sess->peer_msg_len) &&
+	       (memcmp(&msg, &sess->peer_msg, sess->peer_msg_len) == 0) &&
+	       (auth_chalresp_read(auth_conn, (uint8_t *)&msg, sess->peer_msg_len) == AUTH_SUCCESS)) {
+		LOG_DEBUG("Dropped copy of shed message.");
+	}
+}
+
+/**
+ * Sends a challenge to the server.
+ *
+ * @param auth_conn     Authentication connection structure.
+ * @param sess          Handshake state.
+ * @param random_chal   Random 32 byte challenge to send.
+ *
+ * @return true if message send successfully, else false on error.
+ */
+static bool auth_client_send_challenge(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				       const uint8_t *random_chal)
+{
+	struct client_challenge chal;
+
+	/* build and send challenge message to Peripheral */
+	memset(&chal, 0, sizeof(chal));
+	chal.hdr.soh = CHALLENGE_RESP_SOH;
+	chal.hdr.msg_id = AUTH_CLIENT_CHAL_MSG_ID;
+
+	memcpy(&chal.client_challenge, random_chal, sizeof(chal.client_challenge));
+
+	/* send to server */
+	if (!auth_chalresp_send(auth_conn, sess, &chal, sizeof(chal))) {
+		/* error */
+		LOG_ERROR("Error sending challenge to server.");
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Receives and processes the challenge response from the server.
+ *
+ * @param auth_conn     Authentication connection structure.
+ * @param sess          Handshake state.
+ * @param random_chal   32 byte challenge sent to the server.
+ * @param server_chal   The server's 32 byte challenge is copied here.
+ * @param status        Pointer to return authentication status.
+ *
+ * @return true on success, else false.
+ */
+static bool auth_client_recv_chal_resp(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				       const uint8_t *random_chal, uint8_t *server_chal,
+				       enum auth_status *status)
+{
+	uint8_t hash[AUTH_CHAL_RESPONSE_LEN];
+	int numbytes;
+	int err;
+	union chalresp_msg msg;
+	struct server_chal_response *server_resp = &msg.server_resp;
+	struct client_chal_resp client_resp;
+	struct auth_chalresp_result chal_result;
+
+	err = auth_chalresp_recv(auth_conn, sess, &msg);
+
+	/* canceled ? */
+	if (err == AUTH_ERROR_CANCELED) {
+		*status = AUTH_STATUS_CANCELED;
+		return false;
+	}
+
+	if (err == AUTH_ERROR_SERVER_BUSY) {
+		*status = AUTH_STATUS_SERVER_BUSY;
+		return false;
+	}
+
+	if (err) {
+        LOG_ERROR("Failed to read server challenge response, err: %d", err);
+		*status = AUTH_STATUS_FAILED;
+		return false;
+	}
+
+	/* check message */
+	if (!auth_check_msg(&server_resp->hdr, AUTH_SERVER_CHALRESP_MSG_ID)) {
+        LOG_ERROR("Invalid message received from the server.");
+		*status = AUTH_STATUS_FAILED;
+		return false;
+	}
+
+
+	/* Now verify response, is the response correct?  Hash the random challenge
+	 * with the shared key. */
+	err = auth_chalresp_hash(random_chal, hash);
+
+	if (err) {
+        LOG_ERROR("Failed to calc hash, err: %d", err);
+		*status = AUTH_STATUS_FAILED;
+		return false;
+	}
+
+	/* Does the response match what is expected? */
+	if (memcmp(hash, server_resp->server_response, sizeof(hash))) {
+		/* authentication failed */
+        LOG_ERROR("Server authentication failed.");
+		*status = AUTH_STATUS_AUTHENTICATION_FAILED;
+
+		/* send failed message to the Peripheral */
+		memset(&chal_result, 0, sizeof(chal_result));
+		chal_result.hdr.soh = CHALLENGE_RESP_SOH;
+		chal_result.hdr.msg_id = AUTH_CHALRESP_RESULT_MSG_ID;
+		chal_result.result = 1;
+
+		numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&chal_result, sizeof(chal_result));
+
+		if ((numbytes <= 0) || (numbytes != sizeof(chal_result))) {
+            LOG_ERROR("Failed to send authentication error result to server.");
+		}
+
+		return false;
+	}
+
+	memcpy(server_chal, server_resp->server_challenge, AUTH_CHALLENGE_LEN);
+
+	/* init Client response message */
+	memset(&client_resp, 0, sizeof(client_resp));
+	client_resp.hdr.soh = CHALLENGE_RESP_SOH;
+	client_resp.hdr.msg_id = AUTH_CLIENT_CHALRESP_MSG_ID;
+
+	/* Create response to the server's random challenge */
+	err = auth_chalresp_hash(server_resp->server_challenge, client_resp.client_response);
+
+	if (err) {
+        LOG_ERROR("Failed to create server response to challenge, err: %d", err);
+		*status = AUTH_STATUS_FAILED;
+		return false;
+	}
+
+	/* send Client's response to the Server's random challenge */
+	if (!auth_chalresp_send(auth_conn, sess, &client_resp, sizeof(client_resp))) {
+        LOG_ERROR("Failed to send Client response.");
+		*status = AUTH_STATUS_FAILED;
+		return false;
+	}
+
+	/* so far so good, need to wait for Server response */
+	*status = AUTH_STATUS_IN_PROCESS;
+	return true;
+}
+
+/**
+ * Client attempts to resume a previous session with its ticket.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ *
+ * @return AUTH_SUCCESS if resumed, AUTH_ERROR_FAILED if the server did not
+ *         accept the ticket, else error value.
+ */
+static int auth_client_resume(struct authenticate_conn *auth_conn, struct chalresp_session *sess)
+{
+	const struct auth_resume_ticket *ticket = &auth_conn->resume_ticket;
+	struct client_resume resume;
+	union chalresp_msg msg;
+	struct server_resume_resp *resp = &msg.resume_resp;
+	struct client_resume_finish finish;
+	uint8_t verify[AUTH_SHA256_HASH];
+	int err;
+
+	memset(&resume, 0, sizeof(resume));
+	resume.hdr.soh = CHALLENGE_RESP_SOH;
+	resume.hdr.msg_id = AUTH_CLIENT_RESUME_MSG_ID;
+
+	if (hal_random(resume.client_challenge, sizeof(resume.client_challenge)) != ATCA_SUCCESS) {
+		LOG_ERROR("Failed to generate client challenge.");
+		return AUTH_ERROR_CRYPTO;
+	}
+
+	memcpy(resume.ticket, ticket->ticket, sizeof(resume.ticket));
+
+	err = auth_chalresp_hmac(resume.binder, ticket->secret, AUTH_RESUME_BINDER_LABEL,
+				 resume.client_challenge, NULL);
+
+	if (err) {
+		return err;
+	}
+
+	if (!auth_chalresp_send(auth_conn, sess, &resume, sizeof(resume))) {
+		LOG_ERROR("Error sending resumption ticket to server.");
+		return AUTH_ERROR_XPORT_SEND;
+	}
+
+	err = auth_chalresp_recv(auth_conn, sess, &msg);
+
+	if (err) {
+		return err;
+	}
+
+	if (!auth_check_msg(&resp->hdr, AUTH_SERVER_RESUME_MSG_ID) || (resp->result != AUTH_RESULT_SUCCESS)) {
+		return AUTH_ERROR_FAILED;
+	}
+
+	/* The server accepted the ticket, check it could actually open it */
+	err = auth_chalresp_hmac(verify, ticket->secret, AUTH_RESUME_VERIFY_LABEL,
+				 resume.client_challenge, resp->server_challenge);
+
+	if (err) {
+		return err;
+	}
+
+	if (_compare(verify, resp->verify, sizeof(verify)) != 0) {
+		LOG_ERROR("Invalid server resumption response.");
+		return AUTH_ERROR_CRYPTO;
+	}
+
+	/* confirm the server challenge, the server only accepts the
+	 * resumption once it has this */
+	memset(&finish, 0, sizeof(finish));
+	finish.hdr.soh = CHALLENGE_RESP_SOH;
+	finish.hdr.msg_id = AUTH_CLIENT_RESUME_FINISH_MSG_ID;
+
+	err = auth_chalresp_hmac(finish.confirm, ticket->secret, AUTH_RESUME_CONFIRM_LABEL,
+				 resume.client_challenge, resp->server_challenge);
+
+	if (err) {
+		return err;
+	}
+
+	err = auth_chalresp_derive_keys(auth_conn, ticket->secret, resume.client_challenge,
+					resp->server_challenge, NULL);
+
+	if (err) {
+		return err;
+	}
+
+	if (!auth_chalresp_send(auth_conn, sess, &finish, sizeof(finish))) {
+		LOG_ERROR("Error sending resumption confirmation to server.");
+		auth_conn->has_session_keys = false;
+		return AUTH_ERROR_XPORT_SEND;
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * Receives the resumption ticket issued by the server.
+ *
+ * @param auth_conn  Authentication connection structure, the ticket is stored here.
+ * @param sess       Handshake state.
+ * @param secret     Resumption secret derived with the session keys.
+ */
+static void auth_client_recv_ticket(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				    const uint8_t *secret)
+{
+	struct auth_resume_ticket *ticket = &auth_conn->resume_ticket;
+	union chalresp_msg msg;
+
+	if ((auth_chalresp_recv(auth_conn, sess, &msg) != AUTH_SUCCESS) ||
+	    !auth_check_msg(&msg.hdr, AUTH_SERVER_TICKET_MSG_ID)) {
+		LOG_WARNING("Did not receive a resumption ticket.");
+		return;
+	}
+
+	memcpy(ticket->ticket, msg.ticket.ticket, sizeof(ticket->ticket));
+	memcpy(ticket->secret, secret, sizeof(ticket->secret));
+	ticket->lifetime_sec = ((uint32_t)msg.ticket.lifetime[0] << 24) |
+			       ((uint32_t)msg.ticket.lifetime[1] << 16) |
+			       ((uint32_t)msg.ticket.lifetime[2] << 8) | (uint32_t)msg.ticket.lifetime[3];
+
+	auth_conn->has_resume_ticket = true;
+}
+
+/**
+ * Handles the client challenge, creates a hash of the challenge with the
+ * shared key.
+ *
+ * @param auth_conn           Authentication connection structure.
+ * @param sess                Handshake state.
+ * @param chal                The client challenge message.
+ * @param server_random_chal  The server random challenge to be sent to the client.
+ * @param client_chal         The client's 32 byte challenge is copied here.
+ *
+ * @return  true on success, else false on error.
+ */
+static bool auth_server_recv_challenge(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				       const struct client_challenge *chal,
+				       uint8_t *server_random_chal, uint8_t *client_chal)
+{
+	struct server_chal_response server_resp;
+
+	if (!auth_check_msg(&chal->hdr, AUTH_CLIENT_CHAL_MSG_ID)) {
+        LOG_ERROR("Invalid message.");
+		return false;
+	}
+
+	memcpy(client_chal, chal->client_challenge, AUTH_CHALLENGE_LEN);
+
+	/* create response and send back to the Client */
+	server_resp.hdr.soh = CHALLENGE_RESP_SOH;
+	server_resp.hdr.msg_id = AUTH_SERVER_CHALRESP_MSG_ID;
+
+	/* copy the server's challenge for the client */
+	memcpy(server_resp.server_challenge, server_random_chal,
+	       sizeof(server_resp.server_challenge));
+
+	/* Now create the response for the Client */
+	auth_chalresp_hash(chal->client_challenge, server_resp.server_response);
+
+	/* Send response */
+	if (!auth_chalresp_send(auth_conn, sess, &server_resp, sizeof(server_resp))) {
+        LOG_ERROR("Failed to send challenge response to the Client.");
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Sends the authentication result to the client.
+ *
+ * @param auth_conn      Authentication connection structure.
+ * @param sess           Handshake state.
+ * @param authenticated  True if the client response is valid.
+ * @param status         Status of the Challenge-Response authentication set here.
+ *
+ * @return  true on success, else false.
+ */
+static bool auth_server_send_result(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				    bool authenticated, enum auth_status *status)
+{
+	struct auth_chalresp_result result_resp;
+
+	/* init result response message */
+	memset(&result_resp, 0, sizeof(result_resp));
+	result_resp.hdr.soh = CHALLENGE_RESP_SOH;
+	result_resp.hdr.msg_id = AUTH_CHALRESP_RESULT_MSG_ID;
+
+	if (!authenticated) {
+		result_resp.result = AUTH_RESULT_FAILED;
+	} else if (ticket_enabled) {
+		/* success, tell the Client a resumption ticket follows */
+		result_resp.result = AUTH_RESULT_TICKET;
+	}
+
+	/* send result back to the Client, a ticket is sent with it */
+	if (!auth_chalresp_queue(sess, &result_resp, sizeof(result_resp), false) ||
+	    ((result_resp.result != AUTH_RESULT_TICKET) && !auth_chalresp_send_flight(auth_conn, sess))) {
+        LOG_ERROR("Failed to send Client authentication result.");
+		*status = AUTH_STATUS_FAILED;
+		return false;
+	}
+
+	*status = authenticated ? AUTH_STATUS_SUCCESSFUL : AUTH_STATUS_AUTHENTICATION_FAILED;
+
+	return true;
+}
+
+/**
+ *  Handles the client response to the server challenge.
+ *
+ * @param auth_conn            Authentication connection structure.
+ * @param sess                 Handshake state.
+ * @param server_random_chal   The server random challenge sent to the client.
+ * @param status               Status of the Challenge-Response authentication set here.
+ *
+ * @return  true on success, else false.
+ */
+static bool auth_server_recv_chalresp(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				      uint8_t *server_random_chal, enum auth_status *status)
+{
+	union chalresp_msg msg;
+	uint8_t hash[AUTH_SHA256_HASH];
+	int err;
+
+	if (auth_chalresp_recv(auth_conn, sess, &msg) != AUTH_SUCCESS) {
+        LOG_ERROR("Failed to receive challenge response from the Client");
+		*status = AUTH_STATUS_FAILED;
+		return false;
+	}
+
+	/* This is a result message, means the Client failed to authenticate the Server. */
+	if (msg.hdr.msg_id == AUTH_CHALRESP_RESULT_MSG_ID) {
 
 		/* Result should be non-zero, meaning an authentication failure. */
-		if (result_resp.result != 0) {
-            LOG_ERROR("Unexpected result value: %d", result_resp.result);
+		if (msg.result.result != 0) {
+            LOG_ERROR("Unexpected result value: %d", msg.result.result);
 		}
 
         LOG_ERROR("Client authentication failed.");
@@ -454,8 +1518,7 @@ static bool auth_server_recv_chalresp(struct authenticate_conn *auth_conn, uint8
 
 	/* The Client authenticated the Server (this code) response. Now verify the Client's
 	 * response to the Server challenge. */
-	if (!auth_server_recv_msg(auth_conn, (uint8_t *)&client_resp.hdr + sizeof(client_resp.hdr),
-				  sizeof(client_resp) - sizeof(client_resp.hdr))) {
+	if (!auth_check_msg(&msg.hdr, AUTH_CLIENT_CHALRESP_MSG_ID)) {
         LOG_ERROR("Failed to read Client response.");
 		*status = AUTH_STATUS_FAILED;
 		return false;
@@ -468,28 +1531,316 @@ static bool auth_server_recv_chalresp(struct authenticate_conn *auth_conn, uint8
 		return false;
 	}
 
-	/* init result response message */
-	memset(&result_resp, 0, sizeof(result_resp));
-	result_resp.hdr.soh = CHALLENGE_RESP_SOH;
-	result_resp.hdr.msg_id = AUTH_CHALRESP_RESULT_MSG_ID;
+	/* verify Central's response, on failure the Client did not sent the correct response */
+	return auth_server_send_result(auth_conn, sess,
+				       memcmp(hash, msg.client_resp.client_response, sizeof(hash)) == 0,
+				       status);
+}
+
+/**
+ * Public-key mode, handles the client ephemeral key and signature.
+ *
+ * @param auth_conn    Authentication connection structure.
+ * @param sess         Handshake state.
+ * @param chal         The client challenge message.
+ * @param client_chal  The client challenge used to derive keys is copied here.
+ * @param server_chal  The server challenge used to derive keys is copied here.
+ * @param secret       The 32 byte ECDH secret is copied here.
+ * @param status       Status of the Challenge-Response authentication set here.
+ *
+ * @return  true on success, else false.
+ */
+static bool auth_server_pk_exchange(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				    const struct client_pk_challenge *chal, uint8_t *client_chal,
+				    uint8_t *server_chal, uint8_t *secret, enum auth_status *status)
+{
+	struct server_pk_response server_resp;
+	union chalresp_msg msg;
+	uint8_t eph_private[AUTH_PK_PRIVATE_KEY_LEN];
+	uint8_t hash[AUTH_SHA256_HASH];
+	bool ok;
+
+	*status = AUTH_STATUS_FAILED;
+
+	server_resp.hdr.soh = CHALLENGE_RESP_SOH;
+	server_resp.hdr.msg_id = AUTH_SERVER_PK_CHALRESP_MSG_ID;
+	memcpy(server_resp.public_key, pk_public_key, sizeof(server_resp.public_key));
+
+	/* the ephemeral keys are the challenges, their ECDH secret keys the session */
+	ok = uECC_make_key(server_resp.ephemeral_key, eph_private, uECC_secp256r1()) &&
+	     auth_chalresp_pk_secret(secret, chal->ephemeral_key, eph_private);
 
-	/* verify Central's response */
-	if (memcmp(hash, client_resp.client_response, sizeof(hash))) {
-		/* authentication failed, the Client did not sent the correct response */
-		result_resp.result = 1;
+	_set_secure(eph_private, 0, sizeof(eph_private));
+
+	if (!ok ||
+	    (auth_chalresp_pk_transcript(hash, AUTH_PK_SERVER_SIGN_LABEL, chal->ephemeral_key,
+					 server_resp.ephemeral_key, chal->public_key, pk_public_key) != AUTH_SUCCESS) ||
+	    !uECC_sign(pk_private_key, hash, sizeof(hash), server_resp.signature, uECC_secp256r1())) {
+		LOG_ERROR("Failed to create challenge response.");
+		return false;
 	}
 
-	/* send result back to the Client */
-	numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&result_resp, sizeof(result_resp));
+	if (!auth_chalresp_send(auth_conn, sess, &server_resp, sizeof(server_resp))) {
+		LOG_ERROR("Failed to send challenge response to the Client.");
+		return false;
+	}
 
-	if ((numbytes <= 0) || (numbytes != sizeof(result_resp))) {
-        LOG_ERROR("Failed to send Client authentication result.");
-		*status = AUTH_STATUS_FAILED;
+	/* the Client sends a result if it rejected the Server */
+	if (auth_chalresp_recv(auth_conn, sess, &msg) != AUTH_SUCCESS) {
+		LOG_ERROR("Failed to receive challenge response from the Client");
+		return false;
+	}
+
+	if (msg.hdr.msg_id == AUTH_CHALRESP_RESULT_MSG_ID) {
+		LOG_ERROR("Client authentication failed.");
+		*status = AUTH_STATUS_AUTHENTICATION_FAILED;
+		return false;
+	}
+
+	if (!auth_check_msg(&msg.hdr, AUTH_CLIENT_PK_CHALRESP_MSG_ID)) {
+		LOG_ERROR("Failed to read Client response.");
+		return false;
+	}
+
+	if (auth_chalresp_pk_transcript(hash, AUTH_PK_CLIENT_SIGN_LABEL, chal->ephemeral_key,
+					server_resp.ephemeral_key, chal->public_key, pk_public_key) != AUTH_SUCCESS) {
+		LOG_ERROR("Failed to create hash.");
+		return false;
+	}
+
+	memcpy(client_chal, chal->ephemeral_key, AUTH_CHALLENGE_LEN);
+	memcpy(server_chal, server_resp.ephemeral_key, AUTH_CHALLENGE_LEN);
+
+	return auth_server_send_result(auth_conn, sess,
+				       auth_chalresp_pk_verify(chal->public_key, hash,
+							       msg.pk_client_resp.signature),
+				       status);
+}
+
+/**
+ * Handles a resumption attempt from the client.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ * @param resume     The client resumption message.
+ *
+ * @return AUTH_SUCCESS if resumed and the client confirmed it, AUTH_ERROR_FAILED
+ *         if the ticket was rejected, else error value.
+ */
+static int auth_server_resume(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+			      const struct client_resume *resume)
+{
+	struct server_resume_resp resp;
+	union chalresp_msg msg;
+	uint8_t secret[AUTH_RESUME_SECRET_LEN];
+	uint8_t binder[AUTH_SHA256_HASH];
+	uint8_t confirm[AUTH_SHA256_HASH];
+	bool resumed;
+	int err;
+
+	memset(&resp, 0, sizeof(resp));
+	resp.hdr.soh = CHALLENGE_RESP_SOH;
+	resp.hdr.msg_id = AUTH_SERVER_RESUME_MSG_ID;
+
+	/* one AEAD open, then check the client holds the ticket's secret */
+	resumed = ticket_enabled && auth_chalresp_ticket_open(resume->ticket, secret);
+
+	if (resumed) {
+		resumed = (hal_random(resp.server_challenge, sizeof(resp.server_challenge)) == ATCA_SUCCESS) &&
+			  (auth_chalresp_hmac(binder, secret, AUTH_RESUME_BINDER_LABEL,
+					      resume->client_challenge, NULL) == AUTH_SUCCESS) &&
+			  (_compare(binder, resume->binder, sizeof(binder)) == 0) &&
+			  (auth_chalresp_hmac(resp.verify, secret, AUTH_RESUME_VERIFY_LABEL,
+					      resume->client_challenge, resp.server_challenge) == AUTH_SUCCESS) &&
+			  (auth_chalresp_hmac(confirm, secret, AUTH_RESUME_CONFIRM_LABEL,
+					      resume->client_challenge, resp.server_challenge) == AUTH_SUCCESS) &&
+			  (auth_chalresp_derive_keys(auth_conn, secret, resume->client_challenge,
+						     resp.server_challenge, NULL) == AUTH_SUCCESS);
+	}
+
+	_set_secure(secret, 0, sizeof(secret));
+
+	if (!resumed) {
+		auth_conn->has_session_keys = false;
+		memset(resp.server_challenge, 0, sizeof(resp.server_challenge));
+		memset(resp.verify, 0, sizeof(resp.verify));
+		resp.result = AUTH_RESULT_FAILED;
+	}
+
+	if (!auth_chalresp_send(auth_conn, sess, &resp, sizeof(resp))) {
+		LOG_ERROR("Failed to send resumption response to the Client.");
+		auth_conn->has_session_keys = false;
+		return AUTH_ERROR_XPORT_SEND;
+	}
+
+	if (!resumed) {
+		return AUTH_ERROR_FAILED;
+	}
+
+	/* The binder only covers the client challenge, a replayed resumption
+	 * message gets this far.  Wait for the client to confirm the fresh
+	 * server challenge. */
+	sess->resend_on_timeout = true;
+	err = auth_chalresp_recv(auth_conn, sess, &msg);
+	sess->resend_on_timeout = false;
+
+	if (!err && (!auth_check_msg(&msg.hdr, AUTH_CLIENT_RESUME_FINISH_MSG_ID) ||
+		     (_compare(confirm, msg.resume_finish.confirm, sizeof(confirm)) != 0))) {
+		LOG_ERROR("Invalid resumption confirmation from the Client.");
+		err = AUTH_ERROR_CRYPTO;
+	}
+
+	_set_secure(confirm, 0, sizeof(confirm));
+
+	if (err) {
+		auth_conn->has_session_keys = false;
+	}
+
+	return err;
+}
+
+/**
+ * Seals a resumption ticket and sends it to the client together with the
+ * result.
+ *
+ * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ * @param secret     Resumption secret derived with the session keys.
+ */
+static void auth_server_send_ticket(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				    const uint8_t *secret)
+{
+	struct server_ticket msg;
+
+	msg.hdr.soh = CHALLENGE_RESP_SOH;
+	msg.hdr.msg_id = AUTH_SERVER_TICKET_MSG_ID;
+	msg.lifetime[0] = (uint8_t)(ticket_lifetime >> 24);
+	msg.lifetime[1] = (uint8_t)(ticket_lifetime >> 16);
+	msg.lifetime[2] = (uint8_t)(ticket_lifetime >> 8);
+	msg.lifetime[3] = (uint8_t)ticket_lifetime;
+
+	if (!auth_chalresp_ticket_seal(msg.ticket, secret) ||
+	    !auth_chalresp_queue(sess, &msg, sizeof(msg), true)) {
+		LOG_ERROR("Failed to seal resumption ticket.");
+	}
+
+	if (!auth_chalresp_send_flight(auth_conn, sess)) {
+		LOG_ERROR("Failed to send resumption ticket to the Client.");
+	}
+}
+
+/**
+ * Public-key mode, sends the client ephemeral key, verifies the server
+ * signature and signs the server ephemeral key.
+ *
+ * @param auth_conn    Authentication connection structure.
+ * @param sess         Handshake state.
+ * @param client_chal  The client challenge used to derive keys is copied here.
+ * @param server_chal  The server challenge used to derive keys is copied here.
+ * @param secret       The 32 byte ECDH secret is copied here.
+ * @param status       Pointer to return authentication status.
+ *
+ * @return true on success, else false.
+ */
+static bool auth_client_pk_exchange(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+				    uint8_t *client_chal, uint8_t *server_chal, uint8_t *secret,
+				    enum auth_status *status)
+{
+	struct client_pk_challenge chal;
+	union chalresp_msg msg;
+	struct server_pk_response *server_resp = &msg.pk_server_resp;
+	struct client_pk_resp client_resp;
+	struct auth_chalresp_result chal_result;
+	uint8_t eph_private[AUTH_PK_PRIVATE_KEY_LEN];
+	uint8_t hash[AUTH_SHA256_HASH];
+	int numbytes;
+	int err;
+	bool ok;
+
+	*status = AUTH_STATUS_FAILED;
+
+	chal.hdr.soh = CHALLENGE_RESP_SOH;
+	chal.hdr.msg_id = AUTH_CLIENT_PK_CHAL_MSG_ID;
+	memcpy(chal.public_key, pk_public_key, sizeof(chal.public_key));
+
+	if (!uECC_make_key(chal.ephemeral_key, eph_private, uECC_secp256r1())) {
+		LOG_ERROR("Failed to create ephemeral key.");
+		return false;
+	}
+
+	err = auth_chalresp_send(auth_conn, sess, &chal, sizeof(chal)) ?
+	      auth_chalresp_recv(auth_conn, sess, &msg) : AUTH_ERROR_XPORT_SEND;
+
+	if (err != AUTH_SUCCESS) {
+		_set_secure(eph_private, 0, sizeof(eph_private));
+
+		if (auth_conn->cancel_auth) {
+			*status = AUTH_STATUS_CANCELED;
+		} else if (err == AUTH_ERROR_SERVER_BUSY) {
+			*status = AUTH_STATUS_SERVER_BUSY;
+		}
+
+		LOG_ERROR("Failed to exchange challenge with the server.");
+		return false;
+	}
+
+	ok = auth_check_msg(&server_resp->hdr, AUTH_SERVER_PK_CHALRESP_MSG_ID) &&
+	     auth_chalresp_pk_secret(secret, server_resp->ephemeral_key, eph_private);
+
+	_set_secure(eph_private, 0, sizeof(eph_private));
+
+	if (!ok) {
+		LOG_ERROR("Invalid message received from the server.");
+		return false;
+	}
+
+	if (auth_chalresp_pk_transcript(hash, AUTH_PK_SERVER_SIGN_LABEL, chal.ephemeral_key,
+					server_resp->ephemeral_key, pk_public_key, server_resp->public_key)) {
+		LOG_ERROR("Failed to calc hash.");
+		return false;
+	}
+
+	if (!auth_chalresp_pk_verify(server_resp->public_key, hash, server_resp->signature)) {
+		/* authentication failed */
+		LOG_ERROR("Server authentication failed.");
+		*status = AUTH_STATUS_AUTHENTICATION_FAILED;
+
+		/* send failed message to the Peripheral */
+		memset(&chal_result, 0, sizeof(chal_result));
+		chal_result.hdr.soh = CHALLENGE_RESP_SOH;
+		chal_result.hdr.msg_id = AUTH_CHALRESP_RESULT_MSG_ID;
+		chal_result.result = AUTH_RESULT_FAILED;
+
+		numbytes = auth_xport_send(auth_conn->xport_hdl, (uint8_t *)&chal_result, sizeof(chal_result));
+
+		if ((numbytes <= 0) || (numbytes != sizeof(chal_result))) {
+			LOG_ERROR("Failed to send authentication error result to server.");
+		}
+
+		return false;
+	}
+
+	/* sign the Server's ephemeral key */
+	client_resp.hdr.soh = CHALLENGE_RESP_SOH;
+	client_resp.hdr.msg_id = AUTH_CLIENT_PK_CHALRESP_MSG_ID;
+
+	if (auth_chalresp_pk_transcript(hash, AUTH_PK_CLIENT_SIGN_LABEL, chal.ephemeral_key,
+					server_resp->ephemeral_key, pk_public_key, server_resp->public_key) ||
+	    !uECC_sign(pk_private_key, hash, sizeof(hash), client_resp.signature, uECC_secp256r1())) {
+		LOG_ERROR("Failed to create server response to challenge.");
 		return false;
 	}
 
-	*status = (result_resp.result == 0) ? AUTH_STATUS_SUCCESSFUL : AUTH_STATUS_AUTHENTICATION_FAILED;
+	memcpy(client_chal, chal.ephemeral_key, AUTH_CHALLENGE_LEN);
+	memcpy(server_chal, server_resp->ephemeral_key, AUTH_CHALLENGE_LEN);
+
+	if (!auth_chalresp_send(auth_conn, sess, &client_resp, sizeof(client_resp))) {
+		LOG_ERROR("Failed to send Client response.");
+		return false;
+	}
 
+	/* so far so good, need to wait for Server response */
+	*status = AUTH_STATUS_IN_PROCESS;
 	return true;
 }
 
@@ -502,42 +1853,112 @@ static bool auth_server_recv_chalresp(struct authenticate_conn *auth_conn, uint8
  */
 static int auth_chalresp_client(struct authenticate_conn *auth_conn)
 {
-	int numbytes;
+	int err;
 	uint8_t random_chal[AUTH_CHALLENGE_LEN];
-	struct auth_chalresp_result server_result;
+	uint8_t server_chal[AUTH_CHALLENGE_LEN];
+	uint8_t resume_secret[AUTH_RESUME_SECRET_LEN];
+	uint8_t pk_secret[AUTH_SHARED_KEY_LEN];
+	const uint8_t *secret;
+	struct chalresp_session sess;
+	union chalresp_msg server_result;
 	enum auth_status status;
+	bool ticket_follows;
+	uint32_t rto;
 
-	/* generate random number as challenge */
-    hal_random(random_chal,  sizeof(random_chal));
+	memset(&sess, 0, sizeof(sess));
+	auth_conn->retry_after_msec = 0;
 
-	if (!auth_client_send_challenge(auth_conn, random_chal)) {
-		auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
-		return AUTH_ERROR_FAILED;
-	}
+	/* try a single round trip with the ticket of a previous session first */
+	if (auth_conn->has_resume_ticket) {
 
-	/* check for cancel operation */
-	if (auth_conn->cancel_auth) {
-		return AUTH_ERROR_CANCELED;
+		err = auth_client_resume(auth_conn, &sess);
+
+		if (err == AUTH_SUCCESS) {
+			LOG_DEBUG("Resumed session with server.");
+			auth_lib_set_status(auth_conn, AUTH_STATUS_SUCCESSFUL);
+
+			/* The confirmation is the final flight, answer the server if
+			 * it was lost.  The server has no RTT sample yet and resends
+			 * with at least the initial timeout. */
+			rto = auth_chalresp_rto(auth_conn);
+			auth_chalresp_linger(auth_conn, &sess, (rto > AUTH_RTO_INITIAL_MSEC) ? rto :
+					     AUTH_RTO_INITIAL_MSEC);
+			return AUTH_SUCCESS;
+		}
+
+		if (auth_conn->cancel_auth) {
+			return AUTH_ERROR_CANCELED;
+		}
+
+		/* keep the ticket for the next attempt */
+		if (err == AUTH_ERROR_SERVER_BUSY) {
+			auth_lib_set_status(auth_conn, AUTH_STATUS_SERVER_BUSY);
+			return err;
+		}
+
+		if (err != AUTH_ERROR_FAILED) {
+			auth_lib_set_status(auth_conn, AUTH_STATUS_AUTHENTICATION_FAILED);
+			return err;
+		}
+
+		/* expired or unknown ticket, forget it and fall back to the full exchange */
+		LOG_DEBUG("Server rejected resumption ticket.");
+		auth_conn->has_resume_ticket = false;
+		_set_secure(&auth_conn->resume_ticket, 0, sizeof(auth_conn->resume_ticket));
 	}
 
-	/* read response from the sever */
-	if (!auth_client_recv_chal_resp(auth_conn, random_chal, &status)) {
-		auth_lib_set_status(auth_conn, status);
-		return AUTH_ERROR_FAILED;
+	if (pk_enabled) {
+
+		/* sign the server challenge, the session keys come from ECDH */
+		if (!auth_client_pk_exchange(auth_conn, &sess, random_chal, server_chal, pk_secret, &status)) {
+			_set_secure(pk_secret, 0, sizeof(pk_secret));
+			auth_lib_set_status(auth_conn, status);
+			return AUTH_ERROR_FAILED;
+		}
+
+		secret = pk_secret;
+
+	} else {
+
+		/* generate random number as challenge, it is key material */
+		if (hal_random(random_chal, sizeof(random_chal)) != ATCA_SUCCESS) {
+			LOG_ERROR("Failed to generate client challenge.");
+			auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
+			return AUTH_ERROR_FAILED;
+		}
+
+		if (!auth_client_send_challenge(auth_conn, &sess, random_chal)) {
+			auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
+			return AUTH_ERROR_FAILED;
+		}
+
+		/* check for cancel operation */
+		if (auth_conn->cancel_auth) {
+			return AUTH_ERROR_CANCELED;
+		}
+
+		/* read response from the sever */
+		if (!auth_client_recv_chal_resp(auth_conn, &sess, random_chal, server_chal, &status)) {
+			auth_lib_set_status(auth_conn, status);
+			return AUTH_ERROR_FAILED;
+		}
+
+		secret = shared_key;
 	}
 
 	/* Wait for the final response from the Server indicating success or failure
 	 * of the Client's response. */
-	numbytes = auth_xport_recv(auth_conn->xport_hdl, (uint8_t * ) &server_result,
-				   sizeof(server_result), AUTH_RX_TIMEOUT_MSEC);
+	err = auth_chalresp_recv(auth_conn, &sess, &server_result);
 
 	/* check for cancel operation */
 	if (auth_conn->cancel_auth) {
+		_set_secure(pk_secret, 0, sizeof(pk_secret));
 		return AUTH_ERROR_CANCELED;
 	}
 
-	if ((numbytes <= 0) || (numbytes != sizeof(server_result))) {
+	if (err) {
 		LOG_ERROR("Failed to receive server authentication result.");
+		_set_secure(pk_secret, 0, sizeof(pk_secret));
 		auth_lib_set_status(auth_conn, AUTH_STATUS_AUTHENTICATION_FAILED);
 		return AUTH_ERROR_FAILED;
 	}
@@ -545,17 +1966,37 @@ static int auth_chalresp_client(struct authenticate_conn *auth_conn)
 	/* check message */
 	if (!auth_check_msg(&server_result.hdr, AUTH_CHALRESP_RESULT_MSG_ID)) {
         LOG_ERROR("Server rejected Client response, authentication failed.");
+		_set_secure(pk_secret, 0, sizeof(pk_secret));
 		auth_lib_set_status(auth_conn, AUTH_STATUS_AUTHENTICATION_FAILED);
 		return AUTH_ERROR_FAILED;
 	}
 
 	/* check the Server result */
-	if (server_result.result != 0) {
+	if ((server_result.result.result != AUTH_RESULT_SUCCESS) &&
+	    (server_result.result.result != AUTH_RESULT_TICKET)) {
         LOG_ERROR("Authentication with server failed.");
+		_set_secure(pk_secret, 0, sizeof(pk_secret));
 		auth_lib_set_status(auth_conn, AUTH_STATUS_AUTHENTICATION_FAILED);
 		return AUTH_ERROR_FAILED;
 	}
 
+	ticket_follows = (server_result.result.result == AUTH_RESULT_TICKET);
+
+	err = auth_chalresp_derive_keys(auth_conn, secret, random_chal, server_chal,
+					ticket_follows ? resume_secret : NULL);
+	_set_secure(pk_secret, 0, sizeof(pk_secret));
+
+	if (err != AUTH_SUCCESS) {
+		LOG_ERROR("Failed to derive session keys.");
+		auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
+		return AUTH_ERROR_CRYPTO;
+	}
+
+	if (ticket_follows) {
+		auth_client_recv_ticket(auth_conn, &sess, resume_secret);
+		_set_secure(resume_secret, 0, sizeof(resume_secret));
+	}
+
     LOG_DEBUG("Authentication with server successful.");
 	auth_lib_set_status(auth_conn, AUTH_STATUS_SUCCESSFUL);
 
@@ -563,47 +2004,194 @@ static int auth_chalresp_client(struct authenticate_conn *auth_conn)
 }
 
 /**
- *  Server function used to execute Challenge-Response authentication.
+ *  Server, the Challenge-Response exchange once the Client's first message
+ *  is admitted.
  *
  * @param auth_conn  Authentication connection structure.
+ * @param sess       Handshake state.
+ * @param msg        The Client's first message, a challenge or a resumption ticket.
+ * @param linger     Set to true if the server should answer resent messages.
  *
  * @return  AUTH_SUCCESS on success, else AUTH error code.
  */
-static int auth_chalresp_server(struct authenticate_conn *auth_conn)
+static int auth_chalresp_server_exchange(struct authenticate_conn *auth_conn, struct chalresp_session *sess,
+					 union chalresp_msg *msg, bool *linger)
 {
 	enum auth_status status;
 	uint8_t random_chal[AUTH_CHALLENGE_LEN];
+	uint8_t client_chal[AUTH_CHALLENGE_LEN];
+	uint8_t resume_secret[AUTH_RESUME_SECRET_LEN];
+	uint8_t pk_secret[AUTH_SHARED_KEY_LEN];
+	const uint8_t *secret = shared_key;
+	int err;
 
-	/* generate random number as challenge */
-    hal_random(random_chal,  sizeof(random_chal));
-
-	/* Wait for challenge from the Central */
-	if (!auth_server_recv_challenge(auth_conn, random_chal)) {
+	/* generate random number as challenge, it is key material */
+	if (hal_random(random_chal, sizeof(random_chal)) != ATCA_SUCCESS) {
+		LOG_ERROR("Failed to generate server challenge.");
 		auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
 		return AUTH_ERROR_FAILED;
 	}
 
-	/* check for cancel operation */
-	if (auth_conn->cancel_auth) {
-		return AUTH_ERROR_CANCELED;
+	if (auth_check_msg(&msg->hdr, AUTH_CLIENT_RESUME_MSG_ID)) {
+
+		err = auth_server_resume(auth_conn, sess, &msg->resume);
+
+		/* the Client confirmed, it has the final flight */
+		if (err == AUTH_SUCCESS) {
+			LOG_DEBUG("Client resumed session.");
+			auth_lib_set_status(auth_conn, AUTH_STATUS_SUCCESSFUL);
+			return AUTH_SUCCESS;
+		}
+
+		/* ticket rejected, the Client falls back to a challenge */
+		if ((err != AUTH_ERROR_FAILED) ||
+		    (auth_chalresp_recv(auth_conn, sess, msg) != AUTH_SUCCESS)) {
+			auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
+			return AUTH_ERROR_FAILED;
+		}
+	}
+
+	if (pk_enabled) {
+
+		/* Public-key mode, the shared key is not accepted */
+		if (!auth_check_msg(&msg->hdr, AUTH_CLIENT_PK_CHAL_MSG_ID)) {
+			LOG_ERROR("Invalid message.");
+			auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
+			return AUTH_ERROR_FAILED;
+		}
+
+		/* the session keys come from ECDH */
+		auth_server_pk_exchange(auth_conn, sess, &msg->pk_chal, client_chal, random_chal,
+					pk_secret, &status);
+		secret = pk_secret;
+
+	} else {
+
+		/* Handle challenge from the Central */
+		if (!auth_server_recv_challenge(auth_conn, sess, &msg->chal, random_chal, client_chal)) {
+			auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
+			return AUTH_ERROR_FAILED;
+		}
+
+		/* check for cancel operation */
+		if (auth_conn->cancel_auth) {
+			return AUTH_ERROR_CANCELED;
+		}
+
+		/* Wait for challenge response from the Client */
+		auth_server_recv_chalresp(auth_conn, sess, random_chal, &status);
+	}
+
+	if ((status == AUTH_STATUS_SUCCESSFUL) &&
+	    (auth_chalresp_derive_keys(auth_conn, secret, client_chal, random_chal,
+				       ticket_enabled ? resume_secret : NULL) != AUTH_SUCCESS)) {
+		LOG_ERROR("Failed to derive session keys.");
+		status = AUTH_STATUS_FAILED;
+	}
+
+	_set_secure(pk_secret, 0, sizeof(pk_secret));
+
+	/* the result told the Client a ticket follows */
+	if ((status == AUTH_STATUS_SUCCESSFUL) && ticket_enabled) {
+		auth_server_send_ticket(auth_conn, sess, resume_secret);
+		_set_secure(resume_secret, 0, sizeof(resume_secret));
 	}
 
-	/* Wait for challenge response from the Client */
-	auth_server_recv_chalresp(auth_conn, random_chal, &status);
+	/* the result is still queued if the session keys could not be derived */
+	if (sess->flight_unsent) {
+		auth_chalresp_send_flight(auth_conn, sess);
+	}
 
 	auth_lib_set_status(auth_conn, status);
 
 	if (status != AUTH_STATUS_SUCCESSFUL) {
 		LOG_ERROR("Authentication with Client failed.");
+
+		/* resend a lost failure result too */
+		if (status == AUTH_STATUS_AUTHENTICATION_FAILED) {
+			*linger = true;
+		}
+
 		return AUTH_ERROR_FAILED;
 	}
 
 	LOG_DEBUG("Authentication with client successful.");
 
+	/* the Client resends its response if the result was lost */
+	*linger = true;
+
 	return AUTH_SUCCESS;
 }
 
 
+/**
+ *  Server function used to execute Challenge-Response authentication.
+ *
+ * @param auth_conn  Authentication connection structure.
+ *
+ * @return  AUTH_SUCCESS on success, else AUTH error code.
+ */
+static int auth_chalresp_server(struct authenticate_conn *auth_conn)
+{
+	struct chalresp_session sess;
+	union chalresp_msg msg;
+	uint64_t arrival_msec;
+	uint32_t retry_after_msec;
+	bool linger = false;
+	bool has_slot;
+	int err;
+
+	memset(&sess, 0, sizeof(sess));
+
+	/* Wait for the Central, it sends a challenge or a resumption ticket */
+	if (auth_chalresp_recv(auth_conn, &sess, &msg) != AUTH_SUCCESS) {
+		LOG_ERROR("Failed to receive client message.");
+		auth_lib_set_status(auth_conn, AUTH_STATUS_FAILED);
+		return AUTH_ERROR_FAILED;
+	}
+
+	/* admission control, an overloaded server sheds the authentication
+	 * before doing any work for it */
+	hal_get_time_msec(&arrival_msec);
+
+	if (auth_lib_admit(arrival_msec, &retry_after_msec, &has_slot) != AUTH_SUCCESS) {
+		auth_server_send_busy(auth_conn, &sess, retry_after_msec);
+		auth_lib_set_status(auth_conn, AUTH_STATUS_SERVER_BUSY);
+		return AUTH_ERROR_SERVER_BUSY;
+	}
+
+	err = auth_chalresp_server_exchange(auth_conn, &sess, &msg, &linger);
+
+	/* lingering only waits for the Client, it does not need a slot */
+	auth_lib_admit_release(has_slot);
+
+	if (linger) {
+		auth_chalresp_linger(auth_conn, &sess, auth_chalresp_rto(auth_conn));
+	}
+
+	return err;
+}
+
+/**
+ * @see auth_internal.h
+ */
+void auth_chalresp_shed(struct authenticate_conn *auth_conn, uint32_t retry_after_msec)
+{
+	struct chalresp_session sess;
+	union chalresp_msg msg;
+
+	memset(&sess, 0, sizeof(sess));
+
+	/* only a Client which sent its first message is waiting for an answer */
+	if ((auth_xport_getnum_recvqueue_bytes(auth_conn->xport_hdl) > 0) &&
+	    (auth_chalresp_recv(auth_conn, &sess, &msg) == AUTH_SUCCESS)) {
+		auth_server_send_busy(auth_conn, &sess, retry_after_msec);
+	}
+
+	auth_lib_set_status(auth_conn, AUTH_STATUS_SERVER_BUSY);
+}
+
+
 /**
  * @see auth_internal.h
  */
@@ -614,11 +2202,24 @@ int auth_init_chalresp_method(struct authenticate_conn *auth_conn, struct auth_c
 		return AUTH_ERROR_INVALID_PARAM;
 	}
 
-	/* set new shared key */
-	memcpy(chalresp_key, chal_resp->shared_key, AUTH_SHARED_KEY_LEN);
+	if (chal_resp->shared_key != NULL) {
+		/* set new shared key */
+		memcpy(chalresp_key, chal_resp->shared_key, AUTH_SHARED_KEY_LEN);
+
+		/* set shared key pointer to new key */
+		shared_key = chalresp_key;
+	}
+
+	/* Client, resume with a previous ticket */
+	if (chal_resp->ticket != NULL) {
+		memcpy(&auth_conn->resume_ticket, chal_resp->ticket, sizeof(auth_conn->resume_ticket));
+		auth_conn->has_resume_ticket = true;
+	}
 
-	/* set shared key pointer to new key */
-	shared_key = chalresp_key;
+	/* sign challenges instead of hashing them with the shared key */
+	if (chal_resp->private_key != NULL) {
+		return auth_chalresp_pk_init(chal_resp);
+	}
 
 	return AUTH_SUCCESS;
 }
@@ -634,6 +2235,9 @@ void * auth_chalresp_thread(void *arg)
 	int ret;
     struct authenticate_conn *auth_conn = (struct authenticate_conn *)arg;
 
+	/* keys of a previous session are not valid anymore */
+	auth_conn->has_session_keys = false;
+
 	auth_lib_set_status(auth_conn, AUTH_STATUS_STARTED);
 
 	/**
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ * Use of this software is per the terms of the Apache 2.0 license
+ * (here: https://www.apache.org/licenses/LICENSE-2.0) plus the following;
+ *
+ *
+ *  THIS IS OPEN SOURCE SOFTWARE, THERE ARE NO WARRANTIES OF ANY KIND FOR ANY ASPECT OF THIS SOFTWARE.
+ *  BY USING THIS SOFTWARE, YOU ACCEPT ALL LIABILITIES AND RESPONSIBILITIES FOR ANY ISSUES OR
+ *  PROBLEMS ARISING OUT OF USE. YOU ARE RESPONSIBLE FOR DETERMINING THE SUITABILITY OF THIS
+ *  SOFTWARE FOR YOUR USE.
+ *
+ *  IF YOU ARE UNSURE ABOUT USING THIS SOFTWARE, DON'T USE IT.
+ *
+ *  THIS SOFTWARE IS SUPPLIED BY GOLDEN BITS SOFTWARE, INC. "AS IS". NO WARRANTIES, WHETHER
+ *  EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, ANY IMPLIED
+ *  WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT WILL GOLDEN BITS SOFTWARE BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, EXEMPLARY,
+ *  INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ *  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) COST OR EXPENSE OF ANY
+ *  KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF GOLDEN BITS SOFTWARE HAS BEEN ADVISED
+ *  OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. GOLDEN BITS SOFTWARE SHALL NOT BE HELD LIABLE UNDER
+ *  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file  auth_crc32c.c
+ *
+ *  @brief  CRC32C (Castagnoli) used to check transport fragments.  Uses the
+ *          SSE4.2 crc32 instruction when the CPU has it, else slice-by-8
+ *          tables.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "auth_config.h"
+#include "auth_lib.h"
+#include "auth_internal.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define AUTH_CRC32C_SSE42
+#include <nmmintrin.h>
+#endif
+
+
+/* reflected Castagnoli polynomial */
+#define CRC32C_POLY         (0x82F63B78u)
+
+
+/* table[k][n] is the CRC of byte n followed by k zero bytes */
+static uint32_t crc32c_table[8][256];
+
+#if defined(AUTH_CRC32C_SSE42)
+static bool crc32c_use_sse42;
+#endif
+
+
+/**
+ * CRC32C with slice-by-8, eight bytes per step.
+ *
+ * @param crc  Inverted CRC so far.
+ * @param buf  Bytes to add.
+ * @param len  Number of bytes.
+ *
+ * @return Inverted CRC.
+ */
+static uint32_t auth_crc32c_sw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+	uint32_t lo, hi;
+
+	while (len >= 8) {
+		lo = crc ^ ((uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+			    ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24));
+		hi = (uint32_t)buf[4] | ((uint32_t)buf[5] << 8) |
+		     ((uint32_t)buf[6] << 16) | ((uint32_t)buf[7] << 24);
+
+		crc = crc32c_table[7][lo & 0xFF] ^ crc32c_table[6][(lo >> 8) & 0xFF] ^
+		      crc32c_table[5][(lo >> 16) & 0xFF] ^ crc32c_table[4][lo >> 24] ^
+		      crc32c_table[3][hi & 0xFF] ^ crc32c_table[2][(hi >> 8) & 0xFF] ^
+		      crc32c_table[1][(hi >> 16) & 0xFF] ^ crc32c_table[0][hi >> 24];
+
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len-- > 0) {
+		crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *buf++) & 0xFF];
+	}
+
+	return crc;
+}
+
+#if defined(AUTH_CRC32C_SSE42)
+/**
+ * CRC32C with the SSE4.2 crc32 instruction.
+ *
+ * @param crc  Inverted CRC so far.
+ * @param buf  Bytes to add.
+ * @param len  Number of bytes.
+ *
+ * @return Inverted CRC.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t auth_crc32c_hw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+#if defined(__x86_64__)
+	uint64_t crc64 = crc;
+	uint64_t val;
+
+	while (len >= sizeof(val)) {
+		__builtin_memcpy(&val, buf, sizeof(val));
+		crc64 = _mm_crc32_u64(crc64, val);
+		buf += sizeof(val);
+		len -= sizeof(val);
+	}
+
+	crc = (uint32_t)crc64;
+#else
+	uint32_t val;
+
+	while (len >= sizeof(val)) {
+		__builtin_memcpy(&val, buf, sizeof(val));
+		crc = _mm_crc32_u32(crc, val);
+		buf += sizeof(val);
+		len -= sizeof(val);
+	}
+#endif
+
+	while (len-- > 0) {
+		crc = _mm_crc32_u8(crc, *buf++);
+	}
+
+	return crc;
+}
+#endif
+
+/**
+ * @see auth_internal.h
+ */
+void auth_crc32c_init(void)
+{
+	uint32_t crc;
+	int n, k;
+
+	for (n = 0; n < 256; n++) {
+		crc = (uint32_t)n;
+
+		for (k = 0; k < 8; k++) {
+			crc = (crc & 1u) ? ((crc >> 1) ^ CRC32C_POLY) : (crc >> 1);
+		}
+
+		crc32c_table[0][n] = crc;
+	}
+
+	for (n = 0; n < 256; n++) {
+		for (k = 1; k < 8; k++) {
+			crc32c_table[k][n] = (crc32c_table[k - 1][n] >> 8) ^
+					     crc32c_table[0][crc32c_table[k - 1][n] & 0xFF];
+		}
+	}
+
+#if defined(AUTH_CRC32C_SSE42)
+	__builtin_cpu_init();
+	crc32c_use_sse42 = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+/**
+ * @see auth_internal.h
+ */
+uint32_t auth_crc32c(uint32_t crc, const uint8_t *buf, size_t len)
+{
+#if defined(AUTH_CRC32C_SSE42)
+	if (crc32c_use_sse42) {
+		return ~auth_crc32c_hw(~crc, buf, len);
+	}
+#endif
+
+	return ~auth_crc32c_sw(~crc, buf, len);
+}
@@ -77,8 +77,15 @@ LOG_MODULE_DECLARE(auth_lib, CONFIG_AUTH_LOG_LEVEL);
 #define DTLS_PACKET_SYNC_BYTES      (0x45B8)
 #define DTLS_HEADER_BYTES           (sizeof(struct dtls_packet_hdr))
 
-#define AUTH_DTLS_MIN_TIMEOUT       (10000u)
-#define ATUH_DTLS_MAX_TIMEOUT       (30000u)
+/* Initial handshake timeout is the retransmission timeout learned for the
+ * peer, else from recent handshakes, else the RFC 6347 default of 1 second. */
+#define AUTH_DTLS_INITIAL_TIMEOUT   (1000u)
+#define AUTH_DTLS_MIN_TIMEOUT       (100u)
+#define AUTH_DTLS_MAX_TIMEOUT       (30000u)
+
+/* Number of peers whose round trip time is remembered */
+#define AUTH_DTLS_RTT_PEERS         (8u)
+
 #define AUTH_DTLS_HELLO_WAIT_MSEC   (15000u)
 
 
@@ -95,6 +102,20 @@ struct dtls_packet_hdr {
 #pragma pack(pop)
 
 
+/**
+ * Handshake retransmission timer.  Also times each flight to measure the
+ * round trip time to the peer.
+ */
+struct auth_dtls_timer {
+	mbedtls_timing_delay_context delay;
+	struct authenticate_conn *auth_conn;
+
+	/* set when a datagram was received while the timer was running */
+	bool flight_answered;
+
+	/* set when the flight was retransmitted, no sample is taken (Karn) */
+	bool flight_resent;
+};
 
 /**
  * Mbed context, one context per DTLS connection.
@@ -109,7 +130,7 @@ struct mbed_tls_context {
 	mbedtls_x509_crt cacert;
 	mbedtls_x509_crt device_cert;
 	mbedtls_pk_context device_private_key;
-	mbedtls_timing_delay_context timer;
+	struct auth_dtls_timer timer;
 	mbedtls_ssl_cookie_ctx cookie_ctx;
 
 	/* Temp buffer used to assemble full frame when sending. */
@@ -124,6 +145,29 @@ struct mbed_tls_context {
  */
 static struct mbed_tls_context tlscontext[MAX_MBEDTLS_CONTEXT];
 
+/**
+ * Round trip time learned for a peer.  Kept outside of authenticate_conn,
+ * which is cleared for each connection, so a peer which re-connects starts
+ * with its own estimate.  The transport handle identifies the peer.
+ */
+struct auth_dtls_peer_rtt {
+	auth_xport_hdl_t xport_hdl;
+	struct auth_rtt_estimate rtt;
+	uint32_t last_used;
+};
+
+static struct auth_dtls_peer_rtt peer_rtt[AUTH_DTLS_RTT_PEERS];
+static uint32_t peer_rtt_clock;
+
+/**
+ * Round trip time over recent handshakes with any peer, seeds the timeout
+ * for a peer without an estimate of its own.
+ */
+static struct auth_rtt_estimate recent_rtt;
+
+/* protects peer_rtt and recent_rtt */
+static K_MUTEX_DEFINE(rtt_lock);
+
 
 /* ===================== local functions =========================== */
 
@@ -180,6 +224,7 @@ static void auth_init_context(struct mbed_tls_context *mbed_ctx)
 	mbedtls_ssl_cookie_init(&mbed_ctx->cookie_ctx);
 	mbedtls_ctr_drbg_init(&mbed_ctx->ctr_drbg);
 	mbedtls_entropy_init(&mbed_ctx->entropy);
+	memset(&mbed_ctx->timer, 0, sizeof(mbed_ctx->timer));
 
 	sys_rand_get(mbed_ctx->cookie, sizeof(mbed_ctx->cookie));
 }
@@ -305,16 +350,127 @@ static unsigned long auth_tls_timing_get_timer(struct mbedtls_timing_hr_time *va
 }
 
 /**
- * Set delays to watch, final and intermediate delays.
+ * Finds the round trip time entry of a peer, rtt_lock must be held.
+ *
+ * @param xport_hdl  Transport to the peer.
+ * @param add        If the peer has no entry, replace the least recently
+ *                   used one.
+ *
+ * @return The peer's entry, NULL if not found and add is false.
+ */
+static struct auth_dtls_peer_rtt *auth_dtls_peer_rtt_get(auth_xport_hdl_t xport_hdl, bool add)
+{
+	struct auth_dtls_peer_rtt *peer = NULL;
+	struct auth_dtls_peer_rtt *oldest = &peer_rtt[0];
+	uint32_t cnt;
+
+	for (cnt = 0; cnt < AUTH_DTLS_RTT_PEERS; cnt++) {
+
+		if (peer_rtt[cnt].xport_hdl == xport_hdl) {
+			peer = &peer_rtt[cnt];
+			break;
+		}
+
+		if (peer_rtt[cnt].last_used < oldest->last_used) {
+			oldest = &peer_rtt[cnt];
+		}
+	}
+
+	if ((peer == NULL) && add) {
+		peer = oldest;
+		memset(peer, 0, sizeof(*peer));
+		peer->xport_hdl = xport_hdl;
+	}
+
+	if (peer != NULL) {
+		peer->last_used = ++peer_rtt_clock;
+	}
+
+	return peer;
+}
+
+/**
+ * Adds a handshake round trip sample to the connection's, the peer's and
+ * the recent estimates.
+ *
+ * @param auth_conn    The auth connection/instance.
+ * @param sample_msec  Time from sending a flight to receiving the peer's reply.
+ */
+static void auth_dtls_rtt_sample(struct authenticate_conn *auth_conn, uint32_t sample_msec)
+{
+	struct auth_dtls_peer_rtt *peer;
+	uint32_t peer_rto;
+
+	auth_lib_rtt_update(&auth_conn->rtt, sample_msec, AUTH_DTLS_MIN_TIMEOUT,
+			    AUTH_DTLS_MAX_TIMEOUT);
+
+	k_mutex_lock(&rtt_lock, K_FOREVER);
+
+	peer = auth_dtls_peer_rtt_get(auth_conn->xport_hdl, true);
+	auth_lib_rtt_update(&peer->rtt, sample_msec, AUTH_DTLS_MIN_TIMEOUT,
+			    AUTH_DTLS_MAX_TIMEOUT);
+	peer_rto = peer->rtt.rto;
+
+	auth_lib_rtt_update(&recent_rtt, sample_msec, AUTH_DTLS_MIN_TIMEOUT,
+			    AUTH_DTLS_MAX_TIMEOUT);
+
+	k_mutex_unlock(&rtt_lock);
+
+	LOG_DBG("Handshake RTT sample %u msec, peer timeout now %u msec", sample_msec,
+		peer_rto);
+}
+
+/**
+ * Gets the initial handshake retransmission timeout for the peer.
+ *
+ * @param auth_conn  The auth connection/instance.
+ *
+ * @return Timeout in milliseconds.
+ */
+static uint32_t auth_dtls_initial_timeout(struct authenticate_conn *auth_conn)
+{
+	struct auth_dtls_peer_rtt *peer;
+	uint32_t timeout;
+
+	k_mutex_lock(&rtt_lock, K_FOREVER);
+
+	peer = auth_dtls_peer_rtt_get(auth_conn->xport_hdl, false);
+	timeout = (peer != NULL) ? peer->rtt.rto : recent_rtt.rto;
+
+	k_mutex_unlock(&rtt_lock);
+
+	return (timeout != 0) ? timeout : AUTH_DTLS_INITIAL_TIMEOUT;
+}
+
+/**
+ * Set delays to watch, final and intermediate delays.  Mbed starts the timer
+ * when a flight is sent, restarts it when the flight is retransmitted and
+ * cancels it once the peer's flight is received, which gives a round trip
+ * sample.
  *
  * @param data    Timing delay context.
  * @param int_ms  Intermediate delay in milliseconds.
- * @param fin_ms  Final delay in milliseconds.
+ * @param fin_ms  Final delay in milliseconds, 0 cancels the timer.
  *
  */
 static void auth_tls_timing_set_delay(void *data, uint32_t int_ms, uint32_t fin_ms)
 {
-	mbedtls_timing_delay_context *ctx = (mbedtls_timing_delay_context *) data;
+	struct auth_dtls_timer *timer = (struct auth_dtls_timer *) data;
+	mbedtls_timing_delay_context *ctx = &timer->delay;
+
+	if (ctx->fin_ms == 0) {
+		/* new flight */
+		timer->flight_answered = false;
+		timer->flight_resent = false;
+	} else if (fin_ms != 0) {
+		/* restarted while running, the flight is retransmitted */
+		timer->flight_resent = true;
+	} else if (timer->flight_answered && !timer->flight_resent) {
+		/* Mbed also cancels the timer after sending the last flight, only
+		 * time flights the peer replied to. */
+		auth_dtls_rtt_sample(timer->auth_conn,
+				     (uint32_t)auth_tls_timing_get_timer(&ctx->timer, 0));
+	}
 
 	ctx->int_ms = int_ms;
 	ctx->fin_ms = fin_ms;
@@ -335,7 +491,7 @@ static void auth_tls_timing_set_delay(void *data, uint32_t int_ms, uint32_t fin_
  */
 static int auth_tls_timing_get_delay(void *data)
 {
-	mbedtls_timing_delay_context *ctx = (mbedtls_timing_delay_context *)data;
+	mbedtls_timing_delay_context *ctx = &((struct auth_dtls_timer *)data)->delay;
 	int64_t elapsed_ms;
 
 	if (ctx->fin_ms == 0) {
@@ -591,6 +747,8 @@ static int auth_mbedtls_rx(void *ctx, uint8_t *buffer, size_t len)
 			len -= rx_bytes;
 			buffer += rx_bytes;
 
+			((struct mbed_tls_context *)auth_conn->internal_obj)->timer.flight_answered = true;
+
 			/* we're done with one DTLS packet, return */
 			return rx_bytes;
 		}
@@ -699,9 +857,10 @@ int auth_init_dtls_method(struct authenticate_conn *auth_conn, struct auth_dtls_
 	/* set max record len to 512, as small as possible */
 	mbedtls_ssl_conf_max_frag_len(&mbed_ctx->conf, MBEDTLS_SSL_MAX_FRAG_LEN_512);
 
-	/* Set the DTLS time out */
-	mbedtls_ssl_conf_handshake_timeout(&mbed_ctx->conf, AUTH_DTLS_MIN_TIMEOUT,
-					   ATUH_DTLS_MAX_TIMEOUT);
+	/* Set the DTLS time out, the initial timeout is set again when the
+	 * handshake starts with what was learned about the peer. */
+	mbedtls_ssl_conf_handshake_timeout(&mbed_ctx->conf, AUTH_DTLS_INITIAL_TIMEOUT,
+					   AUTH_DTLS_MAX_TIMEOUT);
 
 	/*  Force verification.  */
 	mbedtls_ssl_conf_authmode(&mbed_ctx->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
@@ -815,6 +974,7 @@ int auth_init_dtls_method(struct authenticate_conn *auth_conn, struct auth_dtls_
 	}
 
 	/* Setup timers */
+	mbed_ctx->timer.auth_conn = auth_conn;
 	mbedtls_ssl_set_timer_cb(&mbed_ctx->ssl, &mbed_ctx->timer,
 				 auth_tls_timing_set_delay,
 				 auth_tls_timing_get_delay);
@@ -891,6 +1051,11 @@ void auth_dtls_thead(void *arg)
 	/* Set status */
 	auth_lib_set_status(auth_conn, AUTH_STATUS_IN_PROCESS);
 
+	/* Retransmit after the round trip time to the peer instead of a fixed
+	 * timeout, Mbed doubles it on each retransmission up to the max. */
+	mbedtls_ssl_conf_handshake_timeout(&mbed_ctx->conf, auth_dtls_initial_timeout(auth_conn),
+					   AUTH_DTLS_MAX_TIMEOUT);
+
 	int ret = 0;
 
 	/* start handshake */
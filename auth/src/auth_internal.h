@@ -62,11 +62,30 @@
 #define XPORT_FRAG_BEGIN                (0x1)
 #define XPORT_FRAG_NEXT                 (0x2)
 #define XPORT_FRAG_END                  (0x4)
-#define XPORT_FRAG_UNUSED               (0x8)
+#define XPORT_FRAG_COMPACT_OK           (0x8)   /* sender accepts compact frames */
+#define XPORT_FRAG_FLAGS_MASK           (0xF)
 
 #define XPORT_FRAG_HDR_BYTECNT          (sizeof(struct auth_message_frag_hdr))
 #define XPORT_MIN_FRAGMENT              XPORT_FRAG_HDR_BYTECNT
 
+/**
+ * Bit 15 of the payload length is set if a CRC32C trailer follows the
+ * payload.  The CRC is over the header and payload as sent, Big Endian.
+ */
+#define XPORT_FRAG_LEN_CRC              (0x8000)
+#define XPORT_FRAG_LEN_MASK             (0x7FFF)
+#define XPORT_FRAG_CRC_BYTECNT          (4u)
+
+/**
+ * Compact frames, used on message preserving transports once the peer sent
+ * XPORT_FRAG_COMPACT_OK.  A one byte header, bits 7-4 mark a compact frame
+ * and bits 3-0 are the fragment flags.  The payload is the rest of the
+ * datagram, there are no sync bytes to scan for.
+ */
+#define XPORT_COMPACT_MARK              (0x50)
+#define XPORT_COMPACT_MARK_MASK         (0xF0)
+#define XPORT_COMPACT_HDR_BYTECNT       (1u)
+
 
 #pragma pack(push, 1)
 /**
@@ -76,15 +95,16 @@ struct auth_message_frag_hdr {
 	/* bits 15-4  are for fragment sync, bits 3-0 are flags */
 	uint16_t sync_flags;    /* bytes to insure we're at a fragment */
 	uint16_t payload_len;   /* number of bytes in the payload, does not
-	                         * include the header. */
+	                         * include the header or CRC trailer. */
 };
 
 /**
- * One fragment, one or more fragments make up a message.
+ * One fragment, one or more fragments make up a message.  An optional CRC
+ * trailer follows the payload.
  */
 struct auth_message_fragment {
 	struct auth_message_frag_hdr hdr;
-	uint8_t frag_payload[XPORT_MAX_MESSAGE_SIZE];
+	uint8_t frag_payload[XPORT_MAX_MESSAGE_SIZE + XPORT_FRAG_CRC_BYTECNT];
 };
 #pragma pack(pop)
 
@@ -101,13 +121,85 @@ int auth_start_thread(struct authenticate_conn *auth_conn);
 
 
 /**
- * Set the authentication status.
+ * Set the authentication status.  A final status, canceled or later, is
+ * reported once the messages queued on the transport were sent.
  *
  * @param auth_conn   Authentication connection struct.
  * @param status      Authentication status.
  */
 void auth_lib_set_status(struct authenticate_conn *auth_conn, enum auth_status status);
 
+/**
+ * Adds a round trip time sample to an estimate and recalculates the
+ * retransmission timeout, Jacobson/Karels as in RFC 6298.
+ *
+ * @param rtt          Round trip time estimate.
+ * @param sample_msec  Measured round trip time.
+ * @param min_msec     Lower bound for the retransmission timeout.
+ * @param max_msec     Upper bound for the retransmission timeout.
+ */
+void auth_lib_rtt_update(struct auth_rtt_estimate *rtt, uint32_t sample_msec,
+			 uint32_t min_msec, uint32_t max_msec);
+
+
+/**
+ * CoDel state for one queue, decides when to shed authentications which
+ * waited too long.
+ */
+struct auth_codel {
+	uint64_t first_above_msec;  /* when the wait may shed, 0 while below target */
+	uint64_t drop_next_msec;    /* next shed while shedding */
+	uint32_t drop_count;        /* sheds since shedding started */
+	bool dropping;
+};
+
+/**
+ * @return true if admission control is enabled.
+ */
+bool auth_lib_admission_enabled(void);
+
+/**
+ * Decides whether to shed an authentication leaving a queue, with the
+ * admission target and interval.
+ *
+ * @param codel         Queue state, protected by the caller.
+ * @param sojourn_msec  Time the authentication waited in the queue.
+ * @param now_msec      Current time.
+ *
+ * @return true to shed the authentication.
+ */
+bool auth_lib_codel_drop(struct auth_codel *codel, uint32_t sojourn_msec, uint64_t now_msec);
+
+/**
+ * Back off time sent to a shed client, grows with the wait and is
+ * randomized so shed clients do not re-connect together.
+ *
+ * @param wait_msec  Time the shed authentication waited.
+ *
+ * @return Retry after time in msecs.
+ */
+uint32_t auth_lib_retry_after(uint32_t wait_msec);
+
+/**
+ * Server, waits for an admission slot.
+ *
+ * @param arrival_msec      Time the client's first message was received.
+ * @param retry_after_msec  Back off time for the client if shed.
+ * @param has_slot          Set to true if a slot was taken.
+ *
+ * @return AUTH_SUCCESS, release the slot with auth_lib_admit_release(),
+ *         AUTH_ERROR_SERVER_BUSY if the authentication is shed.
+ */
+int auth_lib_admit(uint64_t arrival_msec, uint32_t *retry_after_msec, bool *has_slot);
+
+/**
+ * Releases the slot taken by auth_lib_admit().
+ *
+ * @param has_slot  As returned by auth_lib_admit(), nothing is released
+ *                  if false.
+ */
+void auth_lib_admit_release(bool has_slot);
+
 
 /**
  * Initializes DTLS authentication method.
@@ -121,6 +213,44 @@ int auth_init_dtls_method(struct authenticate_conn *auth_conn,
 			  struct auth_dtls_certs *certs);
 
 
+/**
+ * Runs a Challenge-Response authentication to completion, the entry point
+ * of the authentication thread or a session manager worker.
+ *
+ * @param arg  Pointer to Authentication connection struct.
+ */
+void *auth_chalresp_thread(void *arg);
+
+/**
+ * Server, sheds an authentication before it runs.  A client message already
+ * received is answered with a busy message.
+ *
+ * @param auth_conn         Pointer to Authentication connection struct.
+ * @param retry_after_msec  Back off time for the client.
+ */
+void auth_chalresp_shed(struct authenticate_conn *auth_conn, uint32_t retry_after_msec);
+
+/**
+ * Checks if a connection was added to the session manager, its
+ * authentications run on a shared worker thread.
+ *
+ * @param auth_conn  Pointer to Authentication connection struct.
+ *
+ * @return true if the session manager runs the connection.
+ */
+bool auth_session_managed(const struct authenticate_conn *auth_conn);
+
+/**
+ * Sets up the server resumption ticket key, shared by all connections.
+ *
+ * @param key           32 byte ticket key, NULL to use a random key.
+ * @param lifetime_sec  Ticket lifetime in seconds, 0 to not issue tickets.
+ *
+ * @return AUTH_SUCCESS on success, else error value.
+ */
+int auth_chalresp_ticket_init(const uint8_t *key, uint32_t lifetime_sec);
+
+
 /**
  * Initialize Challenge-Response method with additional parameters.
  *
@@ -284,6 +414,36 @@ bool auth_message_get_fragment(const uint8_t *buffer, uint16_t buflen,
 int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
 			  size_t buflen);
 
+/**
+ * Used by message preserving transports to put one received datagram into
+ * the recv queue.  The datagram holds one frame, compact or with the
+ * fragment header, and tells if the peer accepts compact frames.
+ *
+ * @param xporthdl  Transport handle.
+ * @param buf       Datagram received.
+ * @param buflen    Datagram length.
+ *
+ * @return The number of bytes queued, on error negative value.
+ */
+int auth_message_recv_datagram(const auth_xport_hdl_t xporthdl, uint8_t *buf,
+			       size_t buflen);
+
+/**
+ * Builds the CRC32C tables, called before auth_crc32c() is used.
+ */
+void auth_crc32c_init(void);
+
+/**
+ * Calculates a CRC32C (Castagnoli), can be called in pieces.
+ *
+ * @param crc  0 to start, else the CRC of the previous bytes.
+ * @param buf  Bytes to add.
+ * @param len  Number of bytes.
+ *
+ * @return CRC of all bytes so far.
+ */
+uint32_t auth_crc32c(uint32_t crc, const uint8_t *buf, size_t len);
+
 /**
  * Swap the fragment header from Big Endian to the processor's byte
  * ordering.
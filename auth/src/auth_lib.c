@@ -38,6 +38,7 @@
 #include <errno.h>
 #include <stdint.h>
 
+#include <tinycrypt/utils.h>
 
 #include "auth_config.h"
 #include "auth_lib.h"
@@ -49,6 +50,20 @@
 #define AUTH_THRD_STACK_SIZE       (4096u)
 #define AUTH_THRD_PRIORITY         CONFIG_AUTH_THREAD_PRIORITY
 
+/* admission control defaults */
+#define AUTH_ADMIT_TARGET_MSEC     (100u)
+#define AUTH_ADMIT_INTERVAL_MSEC   (1000u)
+#define AUTH_ADMIT_MAX_WAIT_MSEC   (1000u)
+
+/* longest back off time sent to shed clients */
+#define AUTH_RETRY_AFTER_MAX_MSEC  (30000u)
+
+/* shed count is capped, keeps the control law in range */
+#define AUTH_CODEL_MAX_COUNT       (4095u)
+
+/* longest wait for queued messages to go out before a final status */
+#define AUTH_FLUSH_WAIT_MSEC       (1000u)
+
 
 
 
@@ -59,6 +74,19 @@ void *auth_dtls_thead(void *arg);
 void *auth_chalresp_thread(void *arg);
 
 
+/* Admission control, active while admit_slots is set.  admit_lock protects
+ * the parameters, slots and admit_users, it is created on first use and
+ * never destroyed. */
+static struct auth_admission_param admit_param;
+static hal_sem admit_slots;
+static hal_mutex admit_lock;
+static struct auth_codel admit_codel;
+
+/* threads waiting for or holding a slot, the slots are not replaced
+ * while there are any */
+static uint32_t admit_users;
+
+
 /* ========================== local functions ========================= */
 
 /**
@@ -87,6 +115,136 @@ static bool auth_lib_checkflags(uint32_t flags)
 	return true;
 }
 
+/**
+ * Integer square root.
+ *
+ * @param val  Value.
+ *
+ * @return floor(sqrt(val))
+ */
+static uint32_t auth_lib_isqrt(uint64_t val)
+{
+	uint64_t root = 0;
+	uint64_t bit = 1ull << 62;
+
+	while (bit > val) {
+		bit >>= 2;
+	}
+
+	while (bit != 0) {
+
+		if (val >= root + bit) {
+			val -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+
+		bit >>= 2;
+	}
+
+	return (uint32_t)root;
+}
+
+/**
+ * CoDel control law, the time between sheds shrinks with the square
+ * root of the shed count.
+ *
+ * @param interval_msec  Admission interval.
+ * @param time_msec      Time of the last shed.
+ * @param drop_count     Sheds so far.
+ *
+ * @return Time of the next shed.
+ */
+static uint64_t auth_lib_codel_next(uint32_t interval_msec, uint64_t time_msec,
+				    uint32_t drop_count)
+{
+	/* sqrt scaled by 1024 */
+	return time_msec + ((uint64_t)interval_msec * 1024u) /
+	       auth_lib_isqrt((uint64_t)drop_count << 20);
+}
+
+/**
+ * Copies the admission parameters, they may be changed by
+ * auth_lib_set_admission() while servers run.
+ *
+ * @param param  Parameters are returned here.
+ */
+static void auth_lib_admit_param_get(struct auth_admission_param *param)
+{
+	if (admit_lock == NULL) {
+		memset(param, 0, sizeof(*param));
+		return;
+	}
+
+	hal_lock_mutex(admit_lock);
+	*param = admit_param;
+	hal_unlock_mutex(admit_lock);
+}
+
+/**
+ * Decides whether to shed an authentication leaving a queue.
+ *
+ * @param param         Admission parameters.
+ * @param codel         Queue state, protected by the caller.
+ * @param sojourn_msec  Time the authentication waited in the queue.
+ * @param now_msec      Current time.
+ *
+ * @return true to shed the authentication.
+ */
+static bool auth_lib_codel_shed(const struct auth_admission_param *param,
+				struct auth_codel *codel, uint32_t sojourn_msec,
+				uint64_t now_msec)
+{
+	bool ok_to_drop = false;
+	uint64_t since_last;
+
+	if (sojourn_msec < param->target_msec) {
+		codel->first_above_msec = 0;
+	} else if (codel->first_above_msec == 0) {
+		codel->first_above_msec = now_msec + param->interval_msec;
+	} else if (now_msec >= codel->first_above_msec) {
+		ok_to_drop = true;
+	}
+
+	if (codel->dropping) {
+
+		if (!ok_to_drop) {
+			codel->dropping = false;
+			return false;
+		}
+
+		if (now_msec < codel->drop_next_msec) {
+			return false;
+		}
+
+		if (codel->drop_count < AUTH_CODEL_MAX_COUNT) {
+			codel->drop_count++;
+		}
+
+		codel->drop_next_msec = auth_lib_codel_next(param->interval_msec,
+							    codel->drop_next_msec,
+							    codel->drop_count);
+		return true;
+	}
+
+	if (!ok_to_drop) {
+		return false;
+	}
+
+	/* start shedding, near the earlier rate if the last episode just ended */
+	since_last = now_msec - codel->drop_next_msec;
+
+	codel->dropping = true;
+	codel->drop_count = ((codel->drop_count > 2) &&
+			     (since_last < 16u * (uint64_t)param->interval_msec)) ?
+			    codel->drop_count - 2 : 1;
+	codel->drop_next_msec = auth_lib_codel_next(param->interval_msec, now_msec,
+						    codel->drop_count);
+
+	return true;
+}
+
 
 
 /* ========================= external API ============================ */
@@ -176,8 +334,12 @@ int auth_lib_init(struct authenticate_conn *auth_conn, enum auth_instance_id ins
  */
 int auth_lib_deinit(struct authenticate_conn *auth_conn)
 {
-	/* Free any resources, nothing for now, but maybe
-	 * needed in the future */
+	/* wipe the session keys and resumption ticket */
+	auth_conn->has_session_keys = false;
+	_set_secure(&auth_conn->session_keys, 0, sizeof(auth_conn->session_keys));
+	auth_conn->has_resume_ticket = false;
+	_set_secure(&auth_conn->resume_ticket, 0, sizeof(auth_conn->resume_ticket));
+
 	return AUTH_SUCCESS;
 }
 
@@ -186,6 +348,13 @@ int auth_lib_deinit(struct authenticate_conn *auth_conn)
  */
 int auth_lib_start(struct authenticate_conn *auth_conn)
 {
+	/* a new authentication clears an earlier cancel */
+	auth_conn->cancel_auth = false;
+
+	if (auth_conn->xport_hdl != NULL) {
+		auth_xport_cancel_recv(auth_conn->xport_hdl, false);
+	}
+
     /**
      * Start auth thread for this instance
      */
@@ -201,11 +370,54 @@ int auth_lib_cancel(struct authenticate_conn *auth_conn)
 {
 	auth_conn->cancel_auth = true;
 
+	/* wake the auth thread if it is waiting for the peer */
+	if (auth_conn->xport_hdl != NULL) {
+		auth_xport_cancel_recv(auth_conn->xport_hdl, true);
+	}
+
 	auth_lib_set_status(auth_conn, AUTH_STATUS_CANCELED);
 
 	return AUTH_SUCCESS;
 }
 
+/**
+ * @see auth_lib.h
+ */
+int auth_lib_get_session_keys(struct authenticate_conn *auth_conn,
+			      struct auth_session_keys *keys)
+{
+	if ((auth_conn == NULL) || (keys == NULL)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	if (!auth_conn->has_session_keys) {
+		return AUTH_ERROR_NO_SESSION;
+	}
+
+	memcpy(keys, &auth_conn->session_keys, sizeof(*keys));
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_lib.h
+ */
+int auth_lib_get_resume_ticket(struct authenticate_conn *auth_conn,
+			       struct auth_resume_ticket *ticket)
+{
+	if ((auth_conn == NULL) || (ticket == NULL)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	if (!auth_conn->has_resume_ticket) {
+		return AUTH_ERROR_NO_SESSION;
+	}
+
+	memcpy(ticket, &auth_conn->resume_ticket, sizeof(*ticket));
+
+	return AUTH_SUCCESS;
+}
+
 /**
  * @see auth_lib.h
  */
@@ -236,6 +448,10 @@ const char *auth_lib_getstatus_str(enum auth_status status)
 		return "Authentication Successful";
 		break;
 
+	case AUTH_STATUS_SERVER_BUSY:
+		return "Server busy";
+		break;
+
 	default:
 		break;
 	}
@@ -256,6 +472,12 @@ enum auth_status auth_lib_get_status(struct authenticate_conn *auth_conn)
  */
 void auth_lib_set_status(struct authenticate_conn *auth_conn, enum auth_status status)
 {
+	/* The last message may still be in the send queue.  Send it before the
+	 * application is told the result, it may shut down on a final status. */
+	if ((status >= AUTH_STATUS_CANCELED) && (auth_conn->xport_hdl != NULL)) {
+		auth_xport_flush(auth_conn->xport_hdl, AUTH_FLUSH_WAIT_MSEC);
+	}
+
 	auth_conn->curr_status = status;
 
 	if (auth_conn->status_cb) {
@@ -266,3 +488,261 @@ void auth_lib_set_status(struct authenticate_conn *auth_conn, enum auth_status s
 
 	}
 }
+
+/**
+ * @see auth_lib.h
+ */
+uint32_t auth_lib_get_retry_after(struct authenticate_conn *auth_conn)
+{
+	return auth_conn->retry_after_msec;
+}
+
+/**
+ * @see auth_lib.h
+ */
+int auth_lib_set_admission(const struct auth_admission_param *param)
+{
+	struct auth_admission_param new_param;
+	unsigned max_active;
+	hal_sem new_slots = NULL;
+
+	if (param != NULL) {
+		new_param = *param;
+
+		if (new_param.max_active == 0) {
+			hal_get_cpu_count(&max_active);
+			new_param.max_active = max_active;
+		}
+
+		if (new_param.target_msec == 0) {
+			new_param.target_msec = AUTH_ADMIT_TARGET_MSEC;
+		}
+
+		if (new_param.interval_msec == 0) {
+			new_param.interval_msec = AUTH_ADMIT_INTERVAL_MSEC;
+		}
+
+		if (new_param.max_wait_msec == 0) {
+			new_param.max_wait_msec = AUTH_ADMIT_MAX_WAIT_MSEC;
+		}
+	}
+
+	if ((admit_lock == NULL) && (hal_create_mutex(&admit_lock, NULL) != ATCA_SUCCESS)) {
+		admit_lock = NULL;
+		return AUTH_ERROR_NO_RESOURCE;
+	}
+
+	hal_lock_mutex(admit_lock);
+
+	/* a server thread waits for or holds a slot of the current semaphore */
+	if (admit_users != 0) {
+		hal_unlock_mutex(admit_lock);
+		LOG_ERROR("Admission slots in use, parameters not changed.");
+		return AUTH_ERROR_SESSION_BUSY;
+	}
+
+	if ((param != NULL) &&
+	    (hal_create_sem(&new_slots, new_param.max_active, new_param.max_active) != ATCA_SUCCESS)) {
+		hal_unlock_mutex(admit_lock);
+		return AUTH_ERROR_NO_RESOURCE;
+	}
+
+	if (admit_slots != NULL) {
+		hel_destroy_sem(admit_slots);
+	}
+
+	admit_slots = new_slots;
+
+	if (param != NULL) {
+		admit_param = new_param;
+	}
+
+	memset(&admit_codel, 0, sizeof(admit_codel));
+
+	hal_unlock_mutex(admit_lock);
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_lib.h
+ */
+int auth_lib_set_ticket_key(const uint8_t *ticket_key, uint32_t lifetime_sec)
+{
+	return auth_chalresp_ticket_init(ticket_key, lifetime_sec);
+}
+
+/**
+ * @see auth_internal.h
+ */
+bool auth_lib_admission_enabled(void)
+{
+	return admit_slots != NULL;
+}
+
+/**
+ * @see auth_internal.h
+ */
+bool auth_lib_codel_drop(struct auth_codel *codel, uint32_t sojourn_msec, uint64_t now_msec)
+{
+	struct auth_admission_param param;
+
+	auth_lib_admit_param_get(&param);
+
+	/* admission control was never enabled */
+	if (param.interval_msec == 0) {
+		return false;
+	}
+
+	return auth_lib_codel_shed(&param, codel, sojourn_msec, now_msec);
+}
+
+/**
+ * @see auth_internal.h
+ */
+uint32_t auth_lib_retry_after(uint32_t wait_msec)
+{
+	struct auth_admission_param param;
+	uint32_t retry_msec = wait_msec;
+	uint32_t jitter;
+
+	auth_lib_admit_param_get(&param);
+
+	if (retry_msec < param.target_msec) {
+		retry_msec = param.target_msec;
+	}
+
+	if (retry_msec > AUTH_RETRY_AFTER_MAX_MSEC) {
+		retry_msec = AUTH_RETRY_AFTER_MAX_MSEC;
+	}
+
+	if (hal_random((unsigned char *)&jitter, sizeof(jitter)) != ATCA_SUCCESS) {
+		jitter = 0;
+	}
+
+	/* up to 50% more */
+	return retry_msec + (jitter % (retry_msec / 2u + 1u));
+}
+
+/**
+ * @see auth_internal.h
+ */
+int auth_lib_admit(uint64_t arrival_msec, uint32_t *retry_after_msec, bool *has_slot)
+{
+	uint64_t now_msec = arrival_msec;
+	uint32_t wait_msec;
+	uint32_t max_wait_msec;
+	hal_sem slots;
+	bool drop;
+
+	*has_slot = false;
+
+	if (admit_lock == NULL) {
+		return AUTH_SUCCESS;
+	}
+
+	/* while counted as a user the slots are not replaced */
+	hal_lock_mutex(admit_lock);
+
+	slots = admit_slots;
+	max_wait_msec = admit_param.max_wait_msec;
+
+	if (slots != NULL) {
+		admit_users++;
+	}
+
+	hal_unlock_mutex(admit_lock);
+
+	if (slots == NULL) {
+		return AUTH_SUCCESS;
+	}
+
+	if (hal_wait_sem_timeout(slots, max_wait_msec) != ATCA_SUCCESS) {
+		hal_lock_mutex(admit_lock);
+		admit_users--;
+		hal_unlock_mutex(admit_lock);
+
+		hal_get_time_msec(&now_msec);
+		*retry_after_msec = auth_lib_retry_after((uint32_t)(now_msec - arrival_msec));
+
+		LOG_ERROR("No admission slot, authentication shed.");
+		return AUTH_ERROR_SERVER_BUSY;
+	}
+
+	hal_get_time_msec(&now_msec);
+	wait_msec = (uint32_t)(now_msec - arrival_msec);
+
+	hal_lock_mutex(admit_lock);
+
+	drop = auth_lib_codel_shed(&admit_param, &admit_codel, wait_msec, now_msec);
+
+	if (drop) {
+		hal_give_sem(slots);
+		admit_users--;
+	}
+
+	hal_unlock_mutex(admit_lock);
+
+	if (drop) {
+		*retry_after_msec = auth_lib_retry_after(wait_msec);
+
+		LOG_ERROR("Admission wait %u msec, authentication shed.", wait_msec);
+		return AUTH_ERROR_SERVER_BUSY;
+	}
+
+	*has_slot = true;
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_internal.h
+ */
+void auth_lib_admit_release(bool has_slot)
+{
+	if (!has_slot) {
+		return;
+	}
+
+	hal_lock_mutex(admit_lock);
+	hal_give_sem(admit_slots);
+	admit_users--;
+	hal_unlock_mutex(admit_lock);
+}
+
+/**
+ * @see auth_internal.h
+ */
+void auth_lib_rtt_update(struct auth_rtt_estimate *rtt, uint32_t sample_msec,
+			 uint32_t min_msec, uint32_t max_msec)
+{
+	int32_t delta;
+	uint32_t rto;
+
+	if ((rtt->srtt == 0) && (rtt->rttvar == 0)) {
+		/* first sample, SRTT = R, RTTVAR = R / 2 */
+		rtt->srtt = sample_msec << 3;
+		rtt->rttvar = sample_msec << 1;
+	} else {
+		/* SRTT += (R - SRTT) / 8, RTTVAR += (|R - SRTT| - RTTVAR) / 4 */
+		delta = (int32_t)sample_msec - (int32_t)(rtt->srtt >> 3);
+		rtt->srtt += delta;
+
+		if (delta < 0) {
+			delta = -delta;
+		}
+
+		rtt->rttvar = rtt->rttvar - (rtt->rttvar >> 2) + (uint32_t)delta;
+	}
+
+	/* RTO = SRTT + max(G, 4 * RTTVAR), the clock granularity is the HAL timer tick */
+	rto = (rtt->srtt >> 3) + ((rtt->rttvar > HAL_TIMER_TICK_MSEC) ? rtt->rttvar : HAL_TIMER_TICK_MSEC);
+
+	if (rto < min_msec) {
+		rto = min_msec;
+	} else if (rto > max_msec) {
+		rto = max_msec;
+	}
+
+	rtt->rto = rto;
+}
@@ -0,0 +1,612 @@
+/**
+ * Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ * Use of this software is per the terms of the Apache 2.0 license
+ * (here: https://www.apache.org/licenses/LICENSE-2.0) plus the following;
+ *
+ *
+ *  THIS IS OPEN SOURCE SOFTWARE, THERE ARE NO WARRANTIES OF ANY KIND FOR ANY ASPECT OF THIS SOFTWARE.
+ *  BY USING THIS SOFTWARE, YOU ACCEPT ALL LIABILITIES AND RESPONSIBILITIES FOR ANY ISSUES OR
+ *  PROBLEMS ARISING OUT OF USE. YOU ARE RESPONSIBLE FOR DETERMINING THE SUITABILITY OF THIS
+ *  SOFTWARE FOR YOUR USE.
+ *
+ *  IF YOU ARE UNSURE ABOUT USING THIS SOFTWARE, DON'T USE IT.
+ *
+ *  THIS SOFTWARE IS SUPPLIED BY GOLDEN BITS SOFTWARE, INC. "AS IS". NO WARRANTIES, WHETHER
+ *  EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, ANY IMPLIED
+ *  WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT WILL GOLDEN BITS SOFTWARE BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, EXEMPLARY,
+ *  INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ *  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) COST OR EXPENSE OF ANY
+ *  KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF GOLDEN BITS SOFTWARE HAS BEEN ADVISED
+ *  OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. GOLDEN BITS SOFTWARE SHALL NOT BE HELD LIABLE UNDER
+ *  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file  auth_record.c
+ *
+ *  @brief  Secure channel records carried over the authentication transport.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include <tinycrypt/constants.h>
+#include <tinycrypt/utils.h>
+
+#include "auth_config.h"
+#include "auth_lib.h"
+#include "auth_record.h"
+#include "auth_internal.h"
+#include "auth_logger.h"
+
+
+#if AUTH_RECORD_MAX_LEN > XPORT_MAX_MESSAGE_SIZE
+#error "A record must fit in one transport message"
+#endif
+
+#define AUTH_RECORD_TYPE_DATA      (0x17u)
+
+/* Most records that can be carried in one transport message */
+#define AUTH_RECORD_BATCH_MAX      (XPORT_MAX_MESSAGE_SIZE / AUTH_RECORD_OVERHEAD)
+
+
+/* ========================== local functions ========================= */
+
+/**
+ * Writes a record header, multi-byte fields are Big Endian.
+ *
+ * @param record  Record buffer.
+ * @param cipher  Record cipher.
+ * @param len     Bytes following the header, encrypted payload and tag.
+ * @param seq     Record sequence number.
+ */
+static void auth_record_put_hdr(uint8_t *record, enum auth_record_cipher cipher,
+				uint16_t len, uint64_t seq)
+{
+	int i;
+
+	record[0] = AUTH_RECORD_TYPE_DATA;
+	record[1] = (uint8_t)cipher;
+	record[2] = (uint8_t)(len >> 8);
+	record[3] = (uint8_t)len;
+
+	for (i = 0; i < 8; i++) {
+		record[4 + i] = (uint8_t)(seq >> (56 - 8 * i));
+	}
+}
+
+/**
+ * Checks a record header received from the peer.
+ *
+ * @param chan    Channel.
+ * @param record  Record header.
+ * @param len     Bytes following the header are returned here.
+ * @param seq     Record sequence number is returned here.
+ *
+ * @return true if the header is valid for this channel, else false.
+ */
+static bool auth_record_get_hdr(const struct auth_record_channel *chan, const uint8_t *record,
+				uint16_t *len, uint64_t *seq)
+{
+	int i;
+
+	if ((record[0] != AUTH_RECORD_TYPE_DATA) || (record[1] != (uint8_t)chan->cipher)) {
+		return false;
+	}
+
+	*len = (uint16_t)((record[2] << 8) | record[3]);
+
+	if ((*len < AUTH_RECORD_TAG_LEN) || (*len > AUTH_RECORD_MAX_LEN - AUTH_RECORD_HDR_LEN)) {
+		return false;
+	}
+
+	*seq = 0;
+	for (i = 0; i < 8; i++) {
+		*seq = (*seq << 8) | record[4 + i];
+	}
+
+	return true;
+}
+
+/**
+ * Forms the nonce of a record, the sequence number is xor'ed into the last
+ * 8 bytes of the IV.  CCM uses all AUTH_RECORD_NONCE_LEN bytes, the leading
+ * byte is zero.
+ *
+ * @param dir  Direction keys, nonce is updated.
+ * @param seq  Record sequence number.
+ */
+static void auth_record_set_nonce(struct auth_record_dir *dir, uint64_t seq)
+{
+	int i;
+
+	dir->nonce[0] = 0;
+
+	for (i = 0; i < 4; i++) {
+		dir->nonce[1 + i] = dir->iv[i];
+	}
+
+	for (i = 0; i < 8; i++) {
+		dir->nonce[5 + i] = dir->iv[4 + i] ^ (uint8_t)(seq >> (56 - 8 * i));
+	}
+}
+
+/**
+ * Points the cipher state at the key schedule and nonce of this direction.
+ * The cipher state holds pointers into the direction, re-pointing them before
+ * each record keeps a copied or moved channel off the original's buffers.
+ *
+ * @param dir     Direction keys.
+ * @param cipher  Record cipher.
+ */
+static void auth_record_dir_bind(struct auth_record_dir *dir, enum auth_record_cipher cipher)
+{
+	switch (cipher) {
+	case AUTH_RECORD_AES_CCM:
+		dir->aead.ccm.sched = &dir->sched;
+		dir->aead.ccm.nonce = dir->nonce;
+		break;
+
+	case AUTH_RECORD_AES_GCM:
+		dir->aead.gcm.sched = &dir->sched;
+		dir->aead.gcm.nonce = dir->nonce + 1;
+		break;
+
+	case AUTH_RECORD_CHACHA20_POLY1305:
+		dir->aead.chacha.nonce = dir->nonce + 1;
+		break;
+	}
+}
+
+/**
+ * Keys one direction of the channel.
+ *
+ * @param dir     Direction to set up.
+ * @param cipher  Record cipher.
+ * @param key     AUTH_SESSION_KEY_LEN byte key.
+ * @param iv      AUTH_SESSION_IV_LEN byte IV.
+ *
+ * @return true on success, else false.
+ */
+static bool auth_record_dir_init(struct auth_record_dir *dir, enum auth_record_cipher cipher,
+				 const uint8_t *key, const uint8_t *iv)
+{
+	int ret = TC_CRYPTO_FAIL;
+
+	memcpy(dir->iv, iv, sizeof(dir->iv));
+	dir->seq = 0;
+	auth_record_set_nonce(dir, 0);
+
+	switch (cipher) {
+	case AUTH_RECORD_AES_CCM:
+		ret = tc_aes256_set_encrypt_key(&dir->sched, key);
+		if (ret == TC_CRYPTO_SUCCESS) {
+			ret = tc_ccm_config(&dir->aead.ccm, &dir->sched, dir->nonce,
+					    AUTH_RECORD_NONCE_LEN, AUTH_RECORD_TAG_LEN);
+		}
+		break;
+
+	case AUTH_RECORD_AES_GCM:
+		ret = tc_aes256_set_encrypt_key(&dir->sched, key);
+		if (ret == TC_CRYPTO_SUCCESS) {
+			ret = tc_gcm_config(&dir->aead.gcm, &dir->sched, dir->nonce + 1,
+					    TC_GCM_NONCE_SIZE, AUTH_RECORD_TAG_LEN);
+		}
+		break;
+
+	case AUTH_RECORD_CHACHA20_POLY1305:
+		ret = tc_chacha20_poly1305_config(&dir->aead.chacha, key, dir->nonce + 1,
+						  TC_CHACHA20_NONCE_SIZE);
+		break;
+	}
+
+	return ret == TC_CRYPTO_SUCCESS;
+}
+
+/**
+ * Checks a sequence number against the replay window.
+ *
+ * @param chan  Channel.
+ * @param seq   Received sequence number.
+ *
+ * @return true if the record has not been received, else false.
+ */
+static bool auth_record_replay_check(const struct auth_record_channel *chan, uint64_t seq)
+{
+	uint64_t diff;
+
+	if (seq > chan->rx.seq) {
+		return true;
+	}
+
+	diff = chan->rx.seq - seq;
+
+	/* too old to tell */
+	if (diff >= AUTH_RECORD_REPLAY_WINDOW) {
+		return false;
+	}
+
+	return (chan->rx_window & ((uint64_t)1 << diff)) == 0;
+}
+
+/**
+ * Marks a sequence number as received, only called once the record
+ * has been authenticated.
+ *
+ * @param chan  Channel.
+ * @param seq   Received sequence number.
+ */
+static void auth_record_replay_update(struct auth_record_channel *chan, uint64_t seq)
+{
+	uint64_t diff;
+
+	if (seq > chan->rx.seq) {
+		diff = seq - chan->rx.seq;
+
+		chan->rx_window = (diff >= AUTH_RECORD_REPLAY_WINDOW) ? 0 : chan->rx_window << diff;
+		chan->rx_window |= 1u;
+		chan->rx.seq = seq;
+	} else {
+		chan->rx_window |= (uint64_t)1 << (chan->rx.seq - seq);
+	}
+}
+
+/**
+ * Reads exactly len bytes from the transport.
+ *
+ * @param chan          Channel.
+ * @param buf           Buffer to read into.
+ * @param len           Number of bytes.
+ * @param timeout_msec  Time to wait for each read.
+ *
+ * @return AUTH_SUCCESS, AUTH_ERROR_TIMEOUT, else negative error code.
+ */
+static int auth_record_read(struct auth_record_channel *chan, uint8_t *buf, size_t len,
+			    uint32_t timeout_msec)
+{
+	int numbytes;
+
+	while (len > 0) {
+
+		numbytes = auth_xport_recv(chan->xport_hdl, buf, len, timeout_msec);
+
+		if (numbytes == -EAGAIN) {
+			return AUTH_ERROR_TIMEOUT;
+		}
+
+		if (numbytes < 0) {
+			return numbytes;
+		}
+
+		buf += numbytes;
+		len -= numbytes;
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * Discards everything in the receive queue to get back in step with
+ * the peer after a malformed record.
+ *
+ * @param chan  Channel.
+ */
+static void auth_record_flush(struct auth_record_channel *chan)
+{
+	uint8_t scratch[64];
+
+	while (auth_xport_getnum_recvqueue_bytes(chan->xport_hdl) > 0) {
+		if (auth_xport_recv(chan->xport_hdl, scratch, sizeof(scratch), 0) <= 0) {
+			break;
+		}
+	}
+}
+
+
+/* ========================== API functions ========================= */
+
+/**
+ * @see auth_record.h
+ */
+int auth_record_init(struct auth_record_channel *chan, struct authenticate_conn *auth_conn,
+		     enum auth_record_cipher cipher)
+{
+	struct auth_session_keys keys;
+	bool ok;
+	int err;
+
+	if ((chan == NULL) || (auth_conn == NULL)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	if ((cipher != AUTH_RECORD_AES_CCM) && (cipher != AUTH_RECORD_AES_GCM) &&
+	    (cipher != AUTH_RECORD_CHACHA20_POLY1305)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	err = auth_lib_get_session_keys(auth_conn, &keys);
+
+	if (err) {
+		return err;
+	}
+
+	memset(chan, 0, sizeof(*chan));
+	chan->xport_hdl = auth_conn->xport_hdl;
+	chan->cipher = cipher;
+
+	ok = auth_record_dir_init(&chan->tx, cipher, keys.tx_key, keys.tx_iv) &&
+	     auth_record_dir_init(&chan->rx, cipher, keys.rx_key, keys.rx_iv);
+
+	_set_secure(&keys, 0, sizeof(keys));
+
+	if (!ok) {
+		LOG_ERROR("Failed to set record keys.");
+		auth_record_deinit(chan);
+		return AUTH_ERROR_CRYPTO;
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_record.h
+ */
+void auth_record_deinit(struct auth_record_channel *chan)
+{
+	if (chan != NULL) {
+		_set_secure(chan, 0, sizeof(*chan));
+	}
+}
+
+/**
+ * @see auth_record.h
+ */
+int auth_record_seal(struct auth_record_channel *chan, uint8_t *record, size_t payload_len)
+{
+	struct auth_record_dir *tx;
+	uint8_t *payload;
+	unsigned int olen;
+	int ret = TC_CRYPTO_FAIL;
+
+	if ((chan == NULL) || (record == NULL) || (payload_len > AUTH_RECORD_MAX_PAYLOAD)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	tx = &chan->tx;
+
+	/* never re-use a nonce */
+	if (tx->seq == UINT64_MAX) {
+		LOG_ERROR("Record sequence numbers used up.");
+		return AUTH_ERROR_NO_RESOURCE;
+	}
+
+	payload = record + AUTH_RECORD_HDR_LEN;
+	olen = (unsigned int)payload_len + AUTH_RECORD_TAG_LEN;
+
+	auth_record_put_hdr(record, chan->cipher, (uint16_t)olen, tx->seq);
+	auth_record_set_nonce(tx, tx->seq);
+	auth_record_dir_bind(tx, chan->cipher);
+
+	/* encrypt in place, the header is the associated data */
+	switch (chan->cipher) {
+	case AUTH_RECORD_AES_CCM:
+		ret = tc_ccm_generation_encryption(payload, olen, record, AUTH_RECORD_HDR_LEN,
+						   payload, payload_len, &tx->aead.ccm);
+		break;
+
+	case AUTH_RECORD_AES_GCM:
+		ret = tc_gcm_generation_encryption(payload, olen, record, AUTH_RECORD_HDR_LEN,
+						   payload, payload_len, &tx->aead.gcm);
+		break;
+
+	case AUTH_RECORD_CHACHA20_POLY1305:
+		ret = tc_chacha20_poly1305_generation_encryption(payload, olen, record,
+								 AUTH_RECORD_HDR_LEN, payload,
+								 payload_len, &tx->aead.chacha);
+		break;
+	}
+
+	if (ret != TC_CRYPTO_SUCCESS) {
+		LOG_ERROR("Failed to seal record.");
+		return AUTH_ERROR_CRYPTO;
+	}
+
+	tx->seq++;
+
+	return (int)(payload_len + AUTH_RECORD_OVERHEAD);
+}
+
+/**
+ * @see auth_record.h
+ */
+int auth_record_open(struct auth_record_channel *chan, uint8_t *record, size_t record_len,
+		     uint8_t **payload)
+{
+	struct auth_record_dir *rx;
+	uint8_t *data;
+	uint16_t len;
+	uint64_t seq;
+	int ret = TC_CRYPTO_FAIL;
+
+	if ((chan == NULL) || (record == NULL) || (payload == NULL) ||
+	    (record_len < AUTH_RECORD_OVERHEAD)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	if (!auth_record_get_hdr(chan, record, &len, &seq) ||
+	    (len != record_len - AUTH_RECORD_HDR_LEN)) {
+		LOG_ERROR("Invalid record header.");
+		return AUTH_ERROR_XPORT_FRAME;
+	}
+
+	/* cheap check first, the window is only moved once the record authenticates */
+	if (!auth_record_replay_check(chan, seq)) {
+		LOG_DEBUG("Dropping replayed record.");
+		return AUTH_ERROR_REPLAY;
+	}
+
+	rx = &chan->rx;
+	data = record + AUTH_RECORD_HDR_LEN;
+	auth_record_set_nonce(rx, seq);
+	auth_record_dir_bind(rx, chan->cipher);
+
+	switch (chan->cipher) {
+	case AUTH_RECORD_AES_CCM:
+		ret = tc_ccm_decryption_verification(data, len - AUTH_RECORD_TAG_LEN, record,
+						     AUTH_RECORD_HDR_LEN, data, len,
+						     &rx->aead.ccm);
+		break;
+
+	case AUTH_RECORD_AES_GCM:
+		ret = tc_gcm_decryption_verification(data, len - AUTH_RECORD_TAG_LEN, record,
+						     AUTH_RECORD_HDR_LEN, data, len,
+						     &rx->aead.gcm);
+		break;
+
+	case AUTH_RECORD_CHACHA20_POLY1305:
+		ret = tc_chacha20_poly1305_decryption_verification(data, len - AUTH_RECORD_TAG_LEN,
+								   record, AUTH_RECORD_HDR_LEN,
+								   data, len, &rx->aead.chacha);
+		break;
+	}
+
+	if (ret != TC_CRYPTO_SUCCESS) {
+		LOG_ERROR("Record failed authentication.");
+		return AUTH_ERROR_CRYPTO;
+	}
+
+	auth_record_replay_update(chan, seq);
+
+	*payload = data;
+
+	return len - AUTH_RECORD_TAG_LEN;
+}
+
+/**
+ * @see auth_record.h
+ */
+int auth_record_send(struct auth_record_channel *chan, uint8_t *record, size_t payload_len)
+{
+	int record_len;
+	int ret;
+
+	record_len = auth_record_seal(chan, record, payload_len);
+
+	if (record_len < 0) {
+		return record_len;
+	}
+
+	ret = auth_xport_send(chan->xport_hdl, record, record_len);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	return (int)payload_len;
+}
+
+/**
+ * @see auth_record.h
+ */
+int auth_record_send_batch(struct auth_record_channel *chan, struct auth_record_buf *recs,
+			   int count)
+{
+	struct auth_xport_iov iov[AUTH_RECORD_BATCH_MAX];
+	size_t msg_len = 0;
+	int num_iov = 0;
+	int record_len;
+	int ret;
+	int i;
+
+	if ((chan == NULL) || (recs == NULL) || (count <= 0)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	/* check everything first so a bad entry doesn't leave a partial batch */
+	for (i = 0; i < count; i++) {
+		if ((recs[i].record == NULL) || (recs[i].payload_len > AUTH_RECORD_MAX_PAYLOAD)) {
+			return AUTH_ERROR_INVALID_PARAM;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+
+		record_len = auth_record_seal(chan, recs[i].record, recs[i].payload_len);
+
+		if (record_len < 0) {
+			return record_len;
+		}
+
+		/* send the current message if this record doesn't fit */
+		if (msg_len + record_len > XPORT_MAX_MESSAGE_SIZE) {
+
+			ret = auth_xport_sendv(chan->xport_hdl, iov, num_iov);
+
+			if (ret < 0) {
+				return ret;
+			}
+
+			num_iov = 0;
+			msg_len = 0;
+		}
+
+		iov[num_iov].data = recs[i].record;
+		iov[num_iov].len = record_len;
+		num_iov++;
+		msg_len += record_len;
+	}
+
+	ret = auth_xport_sendv(chan->xport_hdl, iov, num_iov);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	return count;
+}
+
+/**
+ * @see auth_record.h
+ */
+int auth_record_recv(struct auth_record_channel *chan, uint8_t *buf, size_t buf_len,
+		     uint32_t timeout_msec, uint8_t **payload)
+{
+	uint16_t len;
+	uint64_t seq;
+	int err;
+
+	if ((chan == NULL) || (buf == NULL) || (payload == NULL) ||
+	    (buf_len < AUTH_RECORD_OVERHEAD)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	err = auth_record_read(chan, buf, AUTH_RECORD_HDR_LEN, timeout_msec);
+
+	if (err) {
+		return err;
+	}
+
+	if (!auth_record_get_hdr(chan, buf, &len, &seq) ||
+	    (AUTH_RECORD_HDR_LEN + len > buf_len)) {
+		LOG_ERROR("Invalid record header, discarding received data.");
+		auth_record_flush(chan);
+		return AUTH_ERROR_XPORT_FRAME;
+	}
+
+	/* a record is never split across transport messages, the rest is queued */
+	err = auth_record_read(chan, buf + AUTH_RECORD_HDR_LEN, len, timeout_msec);
+
+	if (err) {
+		auth_record_flush(chan);
+		return err;
+	}
+
+	return auth_record_open(chan, buf, AUTH_RECORD_HDR_LEN + len, payload);
+}
@@ -0,0 +1,824 @@
+/**
+ * Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ * Use of this software is per the terms of the Apache 2.0 license
+ * (here: https://www.apache.org/licenses/LICENSE-2.0) plus the following;
+ *
+ *
+ *  THIS IS OPEN SOURCE SOFTWARE, THERE ARE NO WARRANTIES OF ANY KIND FOR ANY ASPECT OF THIS SOFTWARE.
+ *  BY USING THIS SOFTWARE, YOU ACCEPT ALL LIABILITIES AND RESPONSIBILITIES FOR ANY ISSUES OR
+ *  PROBLEMS ARISING OUT OF USE. YOU ARE RESPONSIBLE FOR DETERMINING THE SUITABILITY OF THIS
+ *  SOFTWARE FOR YOUR USE.
+ *
+ *  IF YOU ARE UNSURE ABOUT USING THIS SOFTWARE, DON'T USE IT.
+ *
+ *  THIS SOFTWARE IS SUPPLIED BY GOLDEN BITS SOFTWARE, INC. "AS IS". NO WARRANTIES, WHETHER
+ *  EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, ANY IMPLIED
+ *  WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT WILL GOLDEN BITS SOFTWARE BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, EXEMPLARY,
+ *  INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ *  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) COST OR EXPENSE OF ANY
+ *  KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF GOLDEN BITS SOFTWARE HAS BEEN ADVISED
+ *  OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. GOLDEN BITS SOFTWARE SHALL NOT BE HELD LIABLE UNDER
+ *  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file  auth_session.c
+ *
+ *  @brief  Sharded session table with work stealing worker threads.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "auth_config.h"
+#include "auth_lib.h"
+#include "auth_session.h"
+#include "auth_internal.h"
+#include "auth_hal_if.h"
+#include "auth_logger.h"
+
+
+/* hash buckets per shard, power of 2 */
+#define AUTH_SESSION_BUCKETS            (64u)
+
+/* an idle worker looks for sessions to steal this often */
+#define AUTH_SESSION_IDLE_MSEC          (100u)
+
+/* most threads waiting for a running session to complete */
+#define AUTH_SESSION_MAX_WAITERS        (64u)
+
+#define AUTH_SESSION_CACHE_ALIGNED      __attribute__((aligned(AUTH_CACHE_LINE_SIZE)))
+
+
+/**
+ * Session states, kept in authenticate_conn.session_state
+ */
+enum auth_session_state {
+	AUTH_SESSION_NONE = 0,  /* not in the table */
+	AUTH_SESSION_IDLE,
+	AUTH_SESSION_WAITING,   /* server, started, waits for the client's first message */
+	AUTH_SESSION_QUEUED,
+	AUTH_SESSION_RUNNING,
+	AUTH_SESSION_RESTART    /* running, queued again when done */
+};
+
+/**
+ * One shard of the session table.  A session always lives on the shard
+ * its transport handle hashes to, the shard lock protects its table
+ * entry, run queue link and state, also while another shard's worker
+ * runs it.
+ */
+struct auth_session_shard {
+	hal_mutex lock;
+
+	/* given when a session is queued, wakes the worker */
+	hal_sem run_sem;
+
+	/* given when a running session completes */
+	hal_sem done_sem;
+	uint32_t done_waiters;
+
+	/* queued sessions, oldest first */
+	struct authenticate_conn *run_head;
+	struct authenticate_conn *run_tail;
+	volatile uint32_t run_len;
+
+	/* worker is running an authentication */
+	volatile bool worker_busy;
+
+	/* sheds sessions which waited too long in the run queue */
+	struct auth_codel codel;
+
+	struct authenticate_conn *buckets[AUTH_SESSION_BUCKETS];
+	uint32_t num_sessions;
+
+	hal_thread worker;
+	uint32_t runs;
+	uint32_t steals;
+	uint32_t sheds;
+} AUTH_SESSION_CACHE_ALIGNED;
+
+
+static struct auth_session_shard session_shard[AUTH_SESSION_MAX_SHARDS];
+static unsigned session_num_shards;
+static volatile bool session_shutdown;
+
+/* Held by a transport receive callback while it runs.  Deinit takes it to
+ * wait out callbacks in flight, never destroyed since a receive thread may
+ * have loaded the callback before it was cleared. */
+static hal_mutex session_cb_lock;
+
+
+/* ========================== local functions ========================= */
+
+/**
+ * Hashes a transport handle, the low bits select the shard, the
+ * remaining bits the bucket.
+ *
+ * @param xport_hdl  Transport handle.
+ *
+ * @return Hash value.
+ */
+static uint32_t auth_session_hash(auth_xport_hdl_t xport_hdl)
+{
+	uint64_t key = (uint64_t)(uintptr_t)xport_hdl;
+
+	/* handles are aligned pointers, mix the high bits down */
+	key ^= key >> 29;
+	key *= 0x9E3779B97F4A7C15ull;
+
+	return (uint32_t)(key >> 32);
+}
+
+/**
+ * Finds the shard and bucket of a transport handle.
+ *
+ * @param xport_hdl  Transport handle.
+ * @param bucket     Bucket index is returned here.
+ *
+ * @return The shard.
+ */
+static struct auth_session_shard *auth_session_home(auth_xport_hdl_t xport_hdl,
+						    uint32_t *bucket)
+{
+	const uint32_t hash = auth_session_hash(xport_hdl);
+
+	*bucket = (hash / session_num_shards) & (AUTH_SESSION_BUCKETS - 1u);
+
+	return &session_shard[hash % session_num_shards];
+}
+
+/**
+ * Queues a session on its home shard.
+ *
+ * @param shard      Home shard, locked.
+ * @param auth_conn  Session to queue.
+ */
+static void auth_session_enqueue(struct auth_session_shard *shard,
+				 struct authenticate_conn *auth_conn)
+{
+	auth_conn->run_next = NULL;
+	auth_conn->session_state = AUTH_SESSION_QUEUED;
+	hal_get_time_msec(&auth_conn->session_queued_msec);
+
+	if (shard->run_tail != NULL) {
+		shard->run_tail->run_next = auth_conn;
+	} else {
+		shard->run_head = auth_conn;
+	}
+
+	shard->run_tail = auth_conn;
+	shard->run_len++;
+}
+
+/**
+ * Starts a new authentication.  A server session is only queued once the
+ * client's first message arrived, until then it does not hold a worker.
+ *
+ * @param shard      Home shard, locked.
+ * @param auth_conn  Session to start.
+ *
+ * @return true if the session was queued.
+ */
+static bool auth_session_ready(struct auth_session_shard *shard,
+			       struct authenticate_conn *auth_conn)
+{
+	/* a new authentication clears an earlier cancel */
+	auth_conn->cancel_auth = false;
+	auth_xport_cancel_recv(auth_conn->xport_hdl, false);
+
+	if (!auth_conn->is_client && (auth_xport_getnum_recvqueue_bytes(auth_conn->xport_hdl) <= 0)) {
+		auth_conn->session_state = AUTH_SESSION_WAITING;
+		return false;
+	}
+
+	auth_session_enqueue(shard, auth_conn);
+
+	return true;
+}
+
+/**
+ * Takes the oldest queued session of a shard.  With admission control
+ * the shard's CoDel state decides if a server session waited too long to
+ * run, client sessions are never shed.
+ *
+ * @param shard      Shard to take from.
+ * @param wait_msec  Time the session was queued.
+ * @param shed       Set to true if the session is to be shed.
+ *
+ * @return The session, marked running, or NULL if none is queued.
+ */
+static struct authenticate_conn *auth_session_pop(struct auth_session_shard *shard,
+						  uint32_t *wait_msec, bool *shed)
+{
+	struct authenticate_conn *auth_conn;
+	uint64_t now_msec;
+
+	*wait_msec = 0;
+	*shed = false;
+
+	hal_lock_mutex(shard->lock);
+
+	auth_conn = shard->run_head;
+
+	if (auth_conn != NULL) {
+		shard->run_head = auth_conn->run_next;
+
+		if (shard->run_head == NULL) {
+			shard->run_tail = NULL;
+		}
+
+		auth_conn->run_next = NULL;
+		auth_conn->session_state = AUTH_SESSION_RUNNING;
+		shard->run_len--;
+
+		if (!auth_conn->is_client && auth_lib_admission_enabled() &&
+		    (hal_get_time_msec(&now_msec) == ATCA_SUCCESS)) {
+			*wait_msec = (uint32_t)(now_msec - auth_conn->session_queued_msec);
+			*shed = auth_lib_codel_drop(&shard->codel, *wait_msec, now_msec);
+			shard->sheds += *shed ? 1u : 0u;
+		}
+	}
+
+	hal_unlock_mutex(shard->lock);
+
+	return auth_conn;
+}
+
+/**
+ * Steals a queued session from the shard with the longest run queue.  A
+ * session is only taken from an idle worker if it has more than one.
+ *
+ * @param self       The stealing worker's shard.
+ * @param wait_msec  Time the session was queued.
+ * @param shed       Set to true if the session is to be shed.
+ *
+ * @return The session, marked running, or NULL if no other shard has one.
+ */
+static struct authenticate_conn *auth_session_steal(struct auth_session_shard *self,
+						    uint32_t *wait_msec, bool *shed)
+{
+	struct auth_session_shard *victim = NULL;
+	uint32_t victim_len = 0;
+	unsigned cnt;
+
+	uint32_t run_len;
+
+	/* run_len is read without the lock, a stale value only picks
+	 * a different victim */
+	for (cnt = 0; cnt < session_num_shards; cnt++) {
+
+		run_len = session_shard[cnt].run_len;
+
+		if (!session_shard[cnt].worker_busy) {
+			run_len = (run_len > 0) ? run_len - 1u : 0;
+		}
+
+		if ((&session_shard[cnt] != self) && (run_len > victim_len)) {
+			victim = &session_shard[cnt];
+			victim_len = run_len;
+		}
+	}
+
+	if (victim == NULL) {
+		return NULL;
+	}
+
+	return auth_session_pop(victim, wait_msec, shed);
+}
+
+/**
+ * Wakes an idle worker to steal a session queued on a busy shard.
+ *
+ * @param home  Shard the session was queued on.
+ */
+static void auth_session_wake_idle(struct auth_session_shard *home)
+{
+	unsigned cnt;
+
+	if (!home->worker_busy) {
+		return;
+	}
+
+	for (cnt = 0; cnt < session_num_shards; cnt++) {
+
+		if (!session_shard[cnt].worker_busy) {
+			hal_give_sem(session_shard[cnt].run_sem);
+			return;
+		}
+	}
+}
+
+/**
+ * Transport receive callback of server sessions, queues a session waiting
+ * for the client's first message.  Runs on the transport's receive thread.
+ *
+ * @param xport_hdl  Transport which received data.
+ */
+static void auth_session_recv_ready(auth_xport_hdl_t xport_hdl)
+{
+	struct auth_session_shard *shard;
+	struct authenticate_conn *entry;
+	uint32_t bucket;
+
+	hal_lock_mutex(session_cb_lock);
+
+	/* the session manager was shut down after the callback was loaded */
+	if (session_num_shards == 0) {
+		hal_unlock_mutex(session_cb_lock);
+		return;
+	}
+
+	shard = auth_session_home(xport_hdl, &bucket);
+
+	hal_lock_mutex(shard->lock);
+
+	for (entry = shard->buckets[bucket]; entry != NULL; entry = entry->session_next) {
+
+		if (entry->xport_hdl == xport_hdl) {
+			break;
+		}
+	}
+
+	if ((entry != NULL) && (entry->session_state == AUTH_SESSION_WAITING)) {
+		auth_session_enqueue(shard, entry);
+	} else {
+		entry = NULL;
+	}
+
+	hal_unlock_mutex(shard->lock);
+
+	if (entry != NULL) {
+		hal_give_sem(shard->run_sem);
+		auth_session_wake_idle(shard);
+	}
+
+	hal_unlock_mutex(session_cb_lock);
+}
+
+/**
+ * Runs or sheds one authentication, then marks the session idle or queues
+ * it again if it was restarted while running.
+ *
+ * @param auth_conn  Session to run.
+ * @param wait_msec  Time the session was queued.
+ * @param shed       True to shed the authentication instead.
+ */
+static void auth_session_run(struct authenticate_conn *auth_conn, uint32_t wait_msec, bool shed)
+{
+	struct auth_session_shard *home;
+	uint32_t bucket;
+
+	if (shed) {
+		auth_chalresp_shed(auth_conn, auth_lib_retry_after(wait_msec));
+	} else {
+		auth_chalresp_thread(auth_conn);
+	}
+
+	home = auth_session_home(auth_conn->xport_hdl, &bucket);
+
+	hal_lock_mutex(home->lock);
+
+	if (auth_conn->session_state == AUTH_SESSION_RESTART) {
+		if (auth_session_ready(home, auth_conn)) {
+			hal_give_sem(home->run_sem);
+		}
+	} else {
+		auth_conn->session_state = AUTH_SESSION_IDLE;
+	}
+
+	/* wake threads waiting to remove a session */
+	while (home->done_waiters > 0) {
+		hal_give_sem(home->done_sem);
+		home->done_waiters--;
+	}
+
+	hal_unlock_mutex(home->lock);
+}
+
+/**
+ * Worker thread, runs the sessions queued on its shard and steals from
+ * other shards when its own queue is empty.
+ *
+ * @param arg  The worker's shard.
+ */
+static void *auth_session_worker(void *arg)
+{
+	struct auth_session_shard *shard = (struct auth_session_shard *)arg;
+	struct authenticate_conn *auth_conn;
+	uint32_t wait_msec;
+	bool stolen;
+	bool shed;
+
+	while (!session_shutdown) {
+
+		stolen = false;
+		auth_conn = auth_session_pop(shard, &wait_msec, &shed);
+
+		if (auth_conn == NULL) {
+			auth_conn = auth_session_steal(shard, &wait_msec, &shed);
+			stolen = true;
+		}
+
+		if (auth_conn == NULL) {
+			hal_wait_sem_timeout(shard->run_sem, AUTH_SESSION_IDLE_MSEC);
+			continue;
+		}
+
+		shard->worker_busy = true;
+		shard->runs++;
+		shard->steals += stolen ? 1u : 0u;
+
+		auth_session_run(auth_conn, wait_msec, shed);
+
+		shard->worker_busy = false;
+	}
+
+	return NULL;
+}
+
+/**
+ * Unlinks a queued session from its shard's run queue.
+ *
+ * @param shard      Home shard, locked.
+ * @param auth_conn  Queued session.
+ */
+static void auth_session_dequeue(struct auth_session_shard *shard,
+				 struct authenticate_conn *auth_conn)
+{
+	struct authenticate_conn **link = &shard->run_head;
+	struct authenticate_conn *prev = NULL;
+
+	while (*link != NULL) {
+
+		if (*link == auth_conn) {
+			*link = auth_conn->run_next;
+
+			if (shard->run_tail == auth_conn) {
+				shard->run_tail = prev;
+			}
+
+			auth_conn->run_next = NULL;
+			shard->run_len--;
+			return;
+		}
+
+		prev = *link;
+		link = &prev->run_next;
+	}
+}
+
+
+/* ========================= external API ============================ */
+
+/**
+ * @see auth_session.h
+ */
+int auth_session_mgr_init(unsigned num_shards)
+{
+	struct auth_session_shard *shard;
+	unsigned cnt;
+
+	if (session_num_shards != 0) {
+		LOG_ERROR("Session manager already started.");
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	if (num_shards == 0) {
+		hal_get_cpu_count(&num_shards);
+	}
+
+	if (num_shards > AUTH_SESSION_MAX_SHARDS) {
+		num_shards = AUTH_SESSION_MAX_SHARDS;
+	}
+
+	if ((session_cb_lock == NULL) && (hal_create_mutex(&session_cb_lock, NULL) != ATCA_SUCCESS)) {
+		LOG_ERROR("Failed to create session callback lock.");
+		session_cb_lock = NULL;
+		return AUTH_ERROR_NO_RESOURCE;
+	}
+
+	memset(session_shard, 0, sizeof(session_shard));
+	session_shutdown = false;
+
+	for (cnt = 0; cnt < num_shards; cnt++) {
+
+		shard = &session_shard[cnt];
+
+		if ((hal_create_mutex(&shard->lock, NULL) != ATCA_SUCCESS) ||
+		    (hal_create_sem(&shard->run_sem, 0, 1) != ATCA_SUCCESS) ||
+		    (hal_create_sem(&shard->done_sem, 0, AUTH_SESSION_MAX_WAITERS) != ATCA_SUCCESS)) {
+			LOG_ERROR("Failed to create session shard.");
+			break;
+		}
+	}
+
+	/* every shard must exist before a worker starts stealing */
+	session_num_shards = num_shards;
+
+	for (cnt = 0; (cnt < num_shards) && (session_shard[cnt].done_sem != NULL); cnt++) {
+
+		if (hal_create_thread(&session_shard[cnt].worker, auth_session_worker,
+				      &session_shard[cnt]) != ATCA_SUCCESS) {
+			session_shard[cnt].worker = NULL;
+			LOG_ERROR("Failed to start session worker.");
+			break;
+		}
+	}
+
+	if (cnt != num_shards) {
+		auth_session_mgr_deinit();
+		return AUTH_ERROR_NO_RESOURCE;
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_session.h
+ */
+void auth_session_mgr_deinit(void)
+{
+	struct auth_session_shard *shard;
+	struct authenticate_conn *auth_conn;
+	const unsigned num_shards = session_num_shards;
+	unsigned cnt;
+	uint32_t bucket;
+
+	if (num_shards == 0) {
+		return;
+	}
+
+	session_shutdown = true;
+
+	for (cnt = 0; cnt < num_shards; cnt++) {
+
+		shard = &session_shard[cnt];
+
+		if (shard->worker != NULL) {
+			hal_give_sem(shard->run_sem);
+			hal_join_thread(shard->worker);
+		}
+	}
+
+	/* Stop the receive callbacks.  Once the callback lock is released no
+	 * callback runs on the shards, a late one sees no shards and returns. */
+	hal_lock_mutex(session_cb_lock);
+
+	for (cnt = 0; cnt < num_shards; cnt++) {
+
+		shard = &session_shard[cnt];
+
+		for (bucket = 0; bucket < AUTH_SESSION_BUCKETS; bucket++) {
+
+			while (shard->buckets[bucket] != NULL) {
+				auth_conn = shard->buckets[bucket];
+				shard->buckets[bucket] = auth_conn->session_next;
+
+				auth_xport_set_recv_callback(auth_conn->xport_hdl, NULL);
+				auth_conn->session_next = NULL;
+				auth_conn->run_next = NULL;
+				auth_conn->session_state = AUTH_SESSION_NONE;
+			}
+		}
+	}
+
+	session_num_shards = 0;
+
+	hal_unlock_mutex(session_cb_lock);
+
+	for (cnt = 0; cnt < num_shards; cnt++) {
+
+		shard = &session_shard[cnt];
+
+		if (shard->done_sem != NULL) {
+			hel_destroy_sem(shard->done_sem);
+		}
+
+		if (shard->run_sem != NULL) {
+			hel_destroy_sem(shard->run_sem);
+		}
+
+		if (shard->lock != NULL) {
+			hal_destroy_mutex(shard->lock);
+		}
+	}
+
+	memset(session_shard, 0, sizeof(session_shard));
+}
+
+/**
+ * @see auth_session.h
+ */
+int auth_session_add(struct authenticate_conn *auth_conn)
+{
+	struct auth_session_shard *shard;
+	struct authenticate_conn *entry;
+	uint32_t bucket;
+
+	if ((session_num_shards == 0) || (auth_conn == NULL) || (auth_conn->xport_hdl == NULL) ||
+	    (auth_conn->session_state != AUTH_SESSION_NONE)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	shard = auth_session_home(auth_conn->xport_hdl, &bucket);
+
+	hal_lock_mutex(shard->lock);
+
+	for (entry = shard->buckets[bucket]; entry != NULL; entry = entry->session_next) {
+
+		if (entry->xport_hdl == auth_conn->xport_hdl) {
+			hal_unlock_mutex(shard->lock);
+			LOG_ERROR("Transport already has a session.");
+			return AUTH_ERROR_INVALID_PARAM;
+		}
+	}
+
+	auth_conn->session_next = shard->buckets[bucket];
+	auth_conn->run_next = NULL;
+	auth_conn->session_state = AUTH_SESSION_IDLE;
+	shard->buckets[bucket] = auth_conn;
+	shard->num_sessions++;
+
+	hal_unlock_mutex(shard->lock);
+
+	/* a server session runs once its client sends something */
+	if (!auth_conn->is_client) {
+		auth_xport_set_recv_callback(auth_conn->xport_hdl, auth_session_recv_ready);
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_session.h
+ */
+int auth_session_remove(struct authenticate_conn *auth_conn)
+{
+	struct auth_session_shard *shard;
+	struct authenticate_conn **link;
+	uint32_t bucket;
+
+	if ((session_num_shards == 0) || (auth_conn == NULL) || (auth_conn->xport_hdl == NULL)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	shard = auth_session_home(auth_conn->xport_hdl, &bucket);
+
+	hal_lock_mutex(shard->lock);
+
+	if (auth_conn->session_state == AUTH_SESSION_NONE) {
+		hal_unlock_mutex(shard->lock);
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	/* wait for a running authentication, the timeout covers a
+	 * wakeup lost to the semaphore's max value */
+	while ((auth_conn->session_state == AUTH_SESSION_RUNNING) ||
+	       (auth_conn->session_state == AUTH_SESSION_RESTART)) {
+		shard->done_waiters++;
+		hal_unlock_mutex(shard->lock);
+
+		hal_wait_sem_timeout(shard->done_sem, AUTH_SESSION_IDLE_MSEC);
+
+		hal_lock_mutex(shard->lock);
+	}
+
+	if (auth_conn->session_state == AUTH_SESSION_QUEUED) {
+		auth_session_dequeue(shard, auth_conn);
+	}
+
+	for (link = &shard->buckets[bucket]; *link != NULL; link = &(*link)->session_next) {
+
+		if (*link == auth_conn) {
+			*link = auth_conn->session_next;
+			shard->num_sessions--;
+			break;
+		}
+	}
+
+	auth_conn->session_next = NULL;
+	auth_conn->session_state = AUTH_SESSION_NONE;
+
+	hal_unlock_mutex(shard->lock);
+
+	auth_xport_set_recv_callback(auth_conn->xport_hdl, NULL);
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_session.h
+ */
+struct authenticate_conn *auth_session_find(auth_xport_hdl_t xport_hdl)
+{
+	struct auth_session_shard *shard;
+	struct authenticate_conn *entry;
+	uint32_t bucket;
+
+	if ((session_num_shards == 0) || (xport_hdl == NULL)) {
+		return NULL;
+	}
+
+	shard = auth_session_home(xport_hdl, &bucket);
+
+	hal_lock_mutex(shard->lock);
+
+	for (entry = shard->buckets[bucket]; entry != NULL; entry = entry->session_next) {
+
+		if (entry->xport_hdl == xport_hdl) {
+			break;
+		}
+	}
+
+	hal_unlock_mutex(shard->lock);
+
+	return entry;
+}
+
+/**
+ * @see auth_session.h
+ */
+int auth_session_start(struct authenticate_conn *auth_conn)
+{
+	struct auth_session_shard *shard;
+	uint32_t bucket;
+
+	if ((session_num_shards == 0) || (auth_conn == NULL) || (auth_conn->xport_hdl == NULL)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	shard = auth_session_home(auth_conn->xport_hdl, &bucket);
+
+	hal_lock_mutex(shard->lock);
+
+	switch (auth_conn->session_state) {
+	case AUTH_SESSION_IDLE:
+		if (!auth_session_ready(shard, auth_conn)) {
+			hal_unlock_mutex(shard->lock);
+			return AUTH_SUCCESS;
+		}
+		break;
+
+	case AUTH_SESSION_RUNNING:
+		/* typically called from the status callback, run it again
+		 * once the worker is done */
+		auth_conn->session_state = AUTH_SESSION_RESTART;
+		hal_unlock_mutex(shard->lock);
+		return AUTH_SUCCESS;
+
+	case AUTH_SESSION_NONE:
+		hal_unlock_mutex(shard->lock);
+		return AUTH_ERROR_INVALID_PARAM;
+
+	default:
+		hal_unlock_mutex(shard->lock);
+		return AUTH_ERROR_SESSION_BUSY;
+	}
+
+	hal_unlock_mutex(shard->lock);
+
+	hal_give_sem(shard->run_sem);
+	auth_session_wake_idle(shard);
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_internal.h
+ */
+bool auth_session_managed(const struct authenticate_conn *auth_conn)
+{
+	return auth_conn->session_state != AUTH_SESSION_NONE;
+}
+
+/**
+ * @see auth_session.h
+ */
+int auth_session_get_stats(struct auth_session_stats *stats)
+{
+	unsigned cnt;
+
+	if (stats == NULL) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+
+	stats->num_shards = session_num_shards;
+
+	for (cnt = 0; cnt < session_num_shards; cnt++) {
+		stats->sessions[cnt] = session_shard[cnt].num_sessions;
+		stats->runs[cnt] = session_shard[cnt].runs;
+		stats->steals[cnt] = session_shard[cnt].steals;
+		stats->sheds[cnt] = session_shard[cnt].sheds;
+	}
+
+	return AUTH_SUCCESS;
+}
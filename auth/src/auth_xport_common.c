@@ -34,6 +34,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <endian.h>
 
@@ -49,64 +50,145 @@
  */
 #define XPORT_IOBUF_LEN      (4096u)
 
+/**
+ * Time a sender waits for room in a full send queue.
+ */
+#define XPORT_TX_WAIT_MSEC   (1000u)
+
 #define MIN(a, b)   ({ __typeof__ (a) _a = (a); \
                       __typeof__ (b) _b = (b); \
                        _a < _b ? _a : _b; })
 
 
+/**
+ * Aligns a struct member on a cache line.
+ */
+#define XPORT_CACHE_ALIGNED  __attribute__((aligned(AUTH_CACHE_LINE_SIZE)))
+
+
 /**
  * @brief Circular buffer used to save received data.
+ *
+ * The rx thread puts data while the auth thread gets it.  The index each
+ * side advances is on a cache line of its own, away from the lock and
+ * the read mostly fields.
  */
 struct auth_xport_io_buffer {
 	hal_mutex buf_mutex;
 	hal_sem buf_sem;
 
-	uint32_t head_index;
-	uint32_t tail_index;
+	/* set to wake waiters, they return AUTH_ERROR_CANCELED */
+	volatile bool canceled;
+
+	/* written by the producer, the byte count by both sides */
+	uint32_t head_index XPORT_CACHE_ALIGNED;
 	uint32_t num_valid_bytes;
 
-	uint8_t io_buffer[XPORT_IOBUF_LEN];
+	/* written by the consumer */
+	uint32_t tail_index XPORT_CACHE_ALIGNED;
+
+	uint8_t io_buffer[XPORT_IOBUF_LEN] XPORT_CACHE_ALIGNED;
 };
 
 
+/**
+ * Header in front of each frame in the send queue.
+ */
+#pragma pack(push, 1)
+struct auth_xport_tx_hdr {
+	uint16_t frame_len;     /* frame bytes after this header */
+	uint16_t msg_len;       /* message bytes, set on the last frame of a message */
+};
+
+/**
+ * A frame as queued for the tx thread.
+ */
+struct auth_xport_tx_frame {
+	struct auth_xport_tx_hdr hdr;
+	struct auth_message_fragment frag;
+};
+#pragma pack(pop)
+
+
 /**
  * Contains buffer used to assemble a message from multiple fragments.
  */
 struct auth_message_recv {
-	/* pointer to buffer where message is assembled */
-	uint8_t rx_buffer[XPORT_MAX_MESSAGE_SIZE];
-
 	/* vars used for re-assembling frames into a message */
 	uint32_t rx_curr_offset;
 	bool rx_first_frag;
+
+	/* pointer to buffer where message is assembled */
+	uint8_t rx_buffer[XPORT_MAX_MESSAGE_SIZE];
 };
 
 
 /**
- * Transport instance, contains send and recv circular queues.
+ * Transport instance, contains send and recv circular queues.  Each instance
+ * starts on a cache line, with the fields used on every send and receive
+ * first so they share one line.
  */
 struct auth_xport_instance {
-	/* Send & Recv circular queues */
-	struct auth_xport_io_buffer send_buf;
-	struct auth_xport_io_buffer recv_buf;
-
 	/* Lower transport type */
 	enum auth_xport_type xport_type;
 
+	uint32_t payload_size; /* Max payload size for lower transport. */
+
 	void *xport_ctx; /* transport specific context */
 
 	/* If the lower transport has a send function */
 	send_xport_t send_func;
+	send_batch_xport_t send_batch_func;
 
-	/* Struct for handling assembling message from multiple fragments */
-	struct auth_message_recv recv_msg;
+	/* called when a queued message was sent */
+	send_callback_t send_cb;
 
-	uint32_t payload_size; /* Max payload size for lower transport. */
-};
+	/* called when received bytes were queued */
+	volatile recv_callback_t recv_cb;
+
+	/* Lower transport preserves message boundaries, and the peer showed it
+	 * accepts compact frames. */
+	bool msg_preserving;
+	volatile bool peer_compact;
+
+	/* add a CRC trailer to each fragment */
+	bool frag_crc;
+
+	/* Thread sending the frames queued in send_buf, runs if the lower
+	 * transport has a send function. */
+	hal_thread tx_thrd;
+	volatile bool tx_shutdown;
+
+	/* error sending the message in progress, tx thread only */
+	int tx_msg_err;
+
+	/* keeps the frames of a message together in send_buf */
+	hal_mutex tx_mutex;
+
+	/* given when the tx thread frees space in send_buf */
+	hal_sem tx_space_sem;
+
+	/* messages queued, under tx_mutex, and handed to the lower transport,
+	 * by the tx thread.  tx_sent_sem is given as messages are sent. */
+	volatile uint32_t tx_msgs_queued;
+	volatile uint32_t tx_msgs_sent;
+	hal_sem tx_sent_sem;
+
+	/* Send & Recv circular queues */
+	struct auth_xport_io_buffer send_buf XPORT_CACHE_ALIGNED;
+	struct auth_xport_io_buffer recv_buf XPORT_CACHE_ALIGNED;
+
+	/* Struct for handling assembling message from multiple fragments,
+	 * only used by the rx thread. */
+	struct auth_message_recv recv_msg XPORT_CACHE_ALIGNED;
+} XPORT_CACHE_ALIGNED;
 
 /* transport instances */
 static struct auth_xport_instance xport_inst[NUM_AUTH_INSTANCES];
 
+/* set once the CRC tables are built */
+static bool crc32c_ready;
+
 
 /* ================ local static funcs ================== */
 
@@ -152,6 +234,7 @@ static void auth_xport_iobuffer_init(struct auth_xport_io_buffer *iobuf)
 	iobuf->head_index = 0;
 	iobuf->tail_index = 0;
 	iobuf->num_valid_bytes = 0;
+	iobuf->canceled = false;
 }
 
 /**
@@ -168,6 +251,46 @@ static void auth_xport_iobuffer_reset(struct auth_xport_io_buffer *iobuf)
 	iobuf->num_valid_bytes = 0;
 }
 
+/**
+ * Wakes any thread waiting on an IO buffer, or clears the canceled state.
+ *
+ * @param iobuf   IO buffer.
+ * @param cancel  True to wake waiters, false to wait normally again.
+ */
+static void auth_xport_iobuffer_cancel(struct auth_xport_io_buffer *iobuf, bool cancel)
+{
+	if (cancel) {
+		iobuf->canceled = true;
+		hal_give_sem(iobuf->buf_sem);
+		return;
+	}
+
+	iobuf->canceled = false;
+
+	/* drop a pending wakeup, waiters check the buffer before waiting */
+	while (hal_wait_sem_timeout(iobuf->buf_sem, 0) == ATCA_SUCCESS) {
+	}
+}
+
+/**
+ * Checks if an IO buffer was canceled.  Passes the wakeup on so every
+ * waiter on the buffer returns.
+ *
+ * @param iobuf  IO buffer.
+ *
+ * @return true if canceled.
+ */
+static bool auth_xport_iobuffer_canceled(struct auth_xport_io_buffer *iobuf)
+{
+	if (!iobuf->canceled) {
+		return false;
+	}
+
+	hal_give_sem(iobuf->buf_sem);
+
+	return true;
+}
+
 
 /**
  * Puts data into the transport buffer.
@@ -390,7 +513,8 @@ static int auth_xport_buffer_get(struct auth_xport_io_buffer *iobuf,
  * @param waitmsec   Number of milliseconds to wait if no data.
  *
  * @return  On success, number of bytes copied, can be less than requested amount.
- *          Negative number on error. -EAGAIN if a timeout occurred.
+ *          Negative number on error. -EAGAIN if a timeout occurred,
+ *          AUTH_ERROR_CANCELED if the wait was canceled.
  */
 static int auth_xport_buffer_get_wait(struct auth_xport_io_buffer *iobuf,
 				      uint8_t *out_buf,
@@ -405,6 +529,10 @@ static int auth_xport_buffer_get_wait(struct auth_xport_io_buffer *iobuf,
 	}
 
 	do {
+		if (auth_xport_iobuffer_canceled(iobuf)) {
+			return AUTH_ERROR_CANCELED;
+		}
+
 		int err = hal_wait_sem_timeout(iobuf->buf_sem, waitmsec);
 
 		if(err == ATCA_TIMEOUT)
@@ -416,6 +544,10 @@ static int auth_xport_buffer_get_wait(struct auth_xport_io_buffer *iobuf,
 			return err; /* timed out -EAGAIN or error */
 		}
 
+		if (auth_xport_iobuffer_canceled(iobuf)) {
+			return AUTH_ERROR_CANCELED;
+		}
+
 		/* return byte count or error (bytecount < 0) */
 		bytecount = auth_xport_buffer_get(iobuf, out_buf, num_bytes);
 
@@ -454,7 +586,7 @@ static int auth_xport_buffer_bytecount(struct auth_xport_io_buffer *iobuf)
  * @param waitmsec  Number of milliseconds to wait.
  *
  * @return  On success, number of bytes in the IO buffer.
- *          -EAGAIN on timeout.
+ *          -EAGAIN on timeout, AUTH_ERROR_CANCELED if the wait was canceled.
  */
 static int auth_xport_buffer_bytecount_wait(struct auth_xport_io_buffer *iobuf,
 					    uint32_t waitmsec)
@@ -466,15 +598,34 @@ static int auth_xport_buffer_bytecount_wait(struct auth_xport_io_buffer *iobuf,
 		return num_bytes;
 	}
 
+	if (auth_xport_iobuffer_canceled(iobuf)) {
+		return AUTH_ERROR_CANCELED;
+	}
+
 	/* wait for byte to fill the io buffer */
 	int err = hal_wait_sem_timeout(iobuf->buf_sem, waitmsec);
 
+	if (err == ATCA_TIMEOUT) {
+		err = -EAGAIN;
+	}
+
 	if (err) {
 		return err; /* timed out -EAGAIN or error */
 	}
 
+	if (auth_xport_iobuffer_canceled(iobuf)) {
+		return AUTH_ERROR_CANCELED;
+	}
+
+	num_bytes = auth_xport_buffer_bytecount(iobuf);
+
+	/* counting does not take the bytes, leave the wakeup for a reader */
+	if (num_bytes > 0) {
+		hal_give_sem(iobuf->buf_sem);
+	}
+
 	/* return the number of bytes in the queue */
-	return auth_xport_buffer_bytecount(iobuf);
+	return num_bytes;
 }
 
 
@@ -491,27 +642,226 @@ static int auth_xport_buffer_avail_bytes(struct auth_xport_io_buffer *iobuf)
 }
 
 /**
- * Internal function to send data to peer
+ * Queues a frame for the tx thread.  Waits if the send queue is full.
  *
- * @param xporthdl  Transport handle
- * @param data      Buffer to send.
- * @param len       Number of bytes to send.
+ * @param xp_inst   Transport instance.
+ * @param frame     Frame, preceded by room for the queue header.
+ * @param len       Frame bytes.
+ * @param msg_len   Message bytes if this is the last frame of a message, else 0.
  *
- * @return  Number of bytes sent on success, can be less than requested.
- *          On error, negative error code.
+ * @return  Number of frame bytes queued, on error negative error code.
  */
-static int auth_xport_internal_send(const auth_xport_hdl_t xporthdl,
-				    const uint8_t *data, size_t len)
+static int auth_xport_tx_queue(struct auth_xport_instance *xp_inst,
+			       uint8_t *frame, size_t len, size_t msg_len)
 {
-	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+	struct auth_xport_tx_hdr tx_hdr;
+	uint8_t *queued = frame - sizeof(tx_hdr);
+	const size_t queued_len = sizeof(tx_hdr) + len;
+	int ret;
+
+	while (auth_xport_buffer_avail_bytes(&xp_inst->send_buf) < (int)queued_len) {
+
+		if (xp_inst->tx_shutdown) {
+			return AUTH_ERROR_XPORT_SEND;
+		}
+
+		if (hal_wait_sem_timeout(xp_inst->tx_space_sem, XPORT_TX_WAIT_MSEC) != ATCA_SUCCESS) {
+			LOG_ERROR("Send queue full.");
+			return AUTH_ERROR_IOBUFF_FULL;
+		}
+	}
+
+	tx_hdr.frame_len = (uint16_t)len;
+	tx_hdr.msg_len = (uint16_t)msg_len;
+	memcpy(queued, &tx_hdr, sizeof(tx_hdr));
+
+	/* the header and frame are put at once, the tx thread never sees
+	 * half a frame */
+	ret = auth_xport_buffer_put(&xp_inst->send_buf, queued, queued_len);
+
+	if (ret != (int)queued_len) {
+		return (ret < 0) ? ret : AUTH_ERROR_IOBUFF_FULL;
+	}
+
+	if (msg_len != 0) {
+		xp_inst->tx_msgs_queued++;
+	}
+
+	return (int)len;
+}
+
+/**
+ * Hands the frames queued in send_buf to the lower transport, up to
+ * AUTH_XPORT_TX_BATCH_MAX frames at once, and reports sent messages.
+ *
+ * @param xp_inst  Transport instance.
+ * @param tx_buf   Room for AUTH_XPORT_TX_BATCH_MAX frames.
+ */
+static void auth_xport_tx_drain(struct auth_xport_instance *xp_inst, uint8_t *tx_buf)
+{
+	struct auth_xport_tx_hdr hdr[AUTH_XPORT_TX_BATCH_MAX];
+	struct auth_xport_iov frames[AUTH_XPORT_TX_BATCH_MAX];
+	int count = 0;
+	int sent = 0;
+	int msgs = 0;
+	int ret;
+	int i;
+
+	/* coalesce everything queued into one batch */
+	while ((count < (int)AUTH_XPORT_TX_BATCH_MAX) &&
+	       (auth_xport_buffer_bytecount(&xp_inst->send_buf) > 0)) {
+
+		auth_xport_buffer_get(&xp_inst->send_buf, (uint8_t *)&hdr[count], sizeof(hdr[count]));
+
+		frames[count].data = tx_buf + (count * sizeof(struct auth_message_fragment));
+		frames[count].len = auth_xport_buffer_get(&xp_inst->send_buf,
+							  (uint8_t *)frames[count].data,
+							  hdr[count].frame_len);
+		count++;
+	}
+
+	/* wake a sender waiting for room */
+	hal_give_sem(xp_inst->tx_space_sem);
+
+	if ((count > 1) && (xp_inst->send_batch_func != NULL)) {
+		sent = xp_inst->send_batch_func((auth_xport_hdl_t)xp_inst, frames, count);
+
+		if (sent < 0) {
+			LOG_ERROR("Failed to send frame batch, error: %d", sent);
+			sent = 0;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
 
-	/* if the lower transport set a send function, call it */
+		/* frames the batch didn't send go one at a time */
+		if (i >= sent) {
+			ret = xp_inst->send_func((auth_xport_hdl_t)xp_inst, frames[i].data, frames[i].len);
+
+			if (ret != (int)frames[i].len) {
+				LOG_ERROR("Failed to send xport frame, error: %d", ret);
+				xp_inst->tx_msg_err = AUTH_ERROR_XPORT_SEND;
+			}
+		}
+
+		if (hdr[i].msg_len != 0) {
+
+			if (xp_inst->send_cb != NULL) {
+				xp_inst->send_cb(xp_inst->tx_msg_err,
+						 (xp_inst->tx_msg_err == 0) ? hdr[i].msg_len : 0);
+			}
+
+			xp_inst->tx_msg_err = 0;
+			msgs++;
+		}
+	}
+
+	if (msgs != 0) {
+		xp_inst->tx_msgs_sent += msgs;
+		hal_give_sem(xp_inst->tx_sent_sem);
+	}
+}
+
+/**
+ * Transmit thread, sends queued frames so protocol threads never block
+ * on the lower transport.  On shutdown the queue is flushed before exiting.
+ *
+ * @param arg  Transport instance.
+ */
+static void *auth_xport_tx_thread(void *arg)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)arg;
+	uint8_t *tx_buf;
+
+	tx_buf = malloc(AUTH_XPORT_TX_BATCH_MAX * sizeof(struct auth_message_fragment));
+
+	if (tx_buf == NULL) {
+		LOG_ERROR("Failed to allocate tx buffer.");
+		return NULL;
+	}
+
+	while (true) {
+
+		if (auth_xport_buffer_bytecount(&xp_inst->send_buf) > 0) {
+			auth_xport_tx_drain(xp_inst, tx_buf);
+			continue;
+		}
+
+		if (xp_inst->tx_shutdown) {
+			break;
+		}
+
+		/* returns when a frame is queued, or at once after shutdown */
+		auth_xport_buffer_bytecount_wait(&xp_inst->send_buf, XPORT_TX_WAIT_MSEC);
+	}
+
+	free(tx_buf);
+
+	return NULL;
+}
+
+/**
+ * Starts the tx thread.
+ *
+ * @param xp_inst  Transport instance.
+ *
+ * @return AUTH_SUCCESS, else AUTH_ERROR_NO_RESOURCE.
+ */
+static int auth_xport_tx_start(struct auth_xport_instance *xp_inst)
+{
+	xp_inst->tx_shutdown = false;
+	xp_inst->tx_msg_err = 0;
+	xp_inst->tx_msgs_queued = 0;
+	xp_inst->tx_msgs_sent = 0;
+
+	if (hal_create_thread(&xp_inst->tx_thrd, auth_xport_tx_thread, xp_inst) != ATCA_SUCCESS) {
+		LOG_ERROR("Failed to start tx thread.");
+		xp_inst->tx_thrd = NULL;
+		return AUTH_ERROR_NO_RESOURCE;
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * Stops the tx thread once the frames already queued are sent.
+ *
+ * @param xp_inst  Transport instance.
+ */
+static void auth_xport_tx_stop(struct auth_xport_instance *xp_inst)
+{
+	if (xp_inst->tx_thrd == NULL) {
+		return;
+	}
+
+	xp_inst->tx_shutdown = true;
+	auth_xport_iobuffer_cancel(&xp_inst->send_buf, true);
+
+	hal_join_thread(xp_inst->tx_thrd);
+	xp_inst->tx_thrd = NULL;
+}
+
+/**
+ * Internal function to send a frame to the peer.
+ *
+ * @param xp_inst   Transport instance.
+ * @param frame     Frame to send, inside a struct auth_xport_tx_frame.
+ * @param len       Number of frame bytes.
+ * @param msg_len   Message bytes if this is the last frame of a message, else 0.
+ *
+ * @return  Number of bytes sent or queued on success, can be less than requested.
+ *          On error, negative error code.
+ */
+static int auth_xport_internal_send(struct auth_xport_instance *xp_inst,
+				    uint8_t *frame, size_t len, size_t msg_len)
+{
+	/* if the lower transport set a send function, the tx thread calls it */
 	if (xp_inst->send_func != NULL) {
-		return xp_inst->send_func(xporthdl, data, len);
+		return auth_xport_tx_queue(xp_inst, frame, len, msg_len);
 	}
 
-	/* queue the send bytes into tx buffer */
-	return auth_xport_buffer_put(&xp_inst->send_buf, data, len);
+	/* else the lower transport reads frames from the send queue */
+	return auth_xport_buffer_put(&xp_inst->send_buf, frame, len);
 }
 
 /**
@@ -574,9 +924,23 @@ int auth_xport_init(auth_xport_hdl_t *xporthdl, enum auth_instance_id instance,
 	auth_xport_iobuffer_init(&xport_inst[instance].recv_buf);
 	auth_message_frag_init(&xport_inst[instance].recv_msg);
 
+	hal_create_mutex(&xport_inst[instance].tx_mutex, NULL);
+	hal_create_sem(&xport_inst[instance].tx_space_sem, 0, 1);
+	hal_create_sem(&xport_inst[instance].tx_sent_sem, 0, 1);
+
 	/* Set the lower transport type */
 	xport_inst[instance].xport_type = xport_type;
 
+	/* the lower transport and the peer tell if compact frames can be used */
+	xport_inst[instance].msg_preserving = false;
+	xport_inst[instance].peer_compact = false;
+	xport_inst[instance].frag_crc = false;
+
+	if (!crc32c_ready) {
+		auth_crc32c_init();
+		crc32c_ready = true;
+	}
+
 
 
 #if defined(AUTH_UDP_XPORT)
@@ -585,6 +949,11 @@ int auth_xport_init(auth_xport_hdl_t *xporthdl, enum auth_instance_id instance,
     }
 #endif
 
+	/* lower transports with a send function are fed by the tx thread */
+	if ((ret == AUTH_SUCCESS) && (xport_inst[instance].send_func != NULL)) {
+		ret = auth_xport_tx_start(&xport_inst[instance]);
+	}
+
 	return ret;
 }
 
@@ -603,6 +972,18 @@ int auth_xport_deinit(const auth_xport_hdl_t xporthdl)
 
 	xport_type = auth_get_xport_type(xporthdl);
 
+	/* wake any thread still waiting for data */
+	auth_xport_iobuffer_cancel(&xp_inst->recv_buf, true);
+
+	/* send what is queued while the lower transport is still up */
+	auth_xport_tx_stop(xp_inst);
+
+#if defined(AUTH_UDP_XPORT)
+	if (xport_type == AUTH_XP_TYPE_UDP) {
+		ret = auth_xp_udp_deinit(xporthdl);
+	}
+#endif
+
 	/* reset queues */
 	auth_xport_iobuffer_reset(&xp_inst->send_buf);
 	auth_xport_iobuffer_reset(&xp_inst->recv_buf);
@@ -616,6 +997,14 @@ int auth_xport_deinit(const auth_xport_hdl_t xporthdl)
 #endif
 
 	xp_inst->xport_type = AUTH_XP_TYPE_NONE;
+	xp_inst->send_func = NULL;
+	xp_inst->send_batch_func = NULL;
+	xp_inst->send_cb = NULL;
+	xp_inst->recv_cb = NULL;
+
+	hel_destroy_sem(xp_inst->tx_space_sem);
+	hel_destroy_sem(xp_inst->tx_sent_sem);
+	hal_destroy_mutex(xp_inst->tx_mutex);
 
 	return ret;
 }
@@ -651,6 +1040,12 @@ int auth_xport_get_max_payload(const auth_xport_hdl_t xporthdl)
 	int mtu = 0;
 	enum auth_xport_type xport_type = auth_get_xport_type(xporthdl);
 
+#if defined(AUTH_UDP_XPORT)
+	if (xport_type == AUTH_XP_TYPE_UDP) {
+		mtu = auth_xp_udp_get_max_payload(xporthdl);
+	}
+#endif
+
 #if defined(CONFIG_BT_XPORT)
 	if (xport_type == AUTH_XP_TYPE_BLUETOOTH) {
 		mtu = auth_xp_bt_get_max_payload(xporthdl);
@@ -669,15 +1064,40 @@ int auth_xport_get_max_payload(const auth_xport_hdl_t xporthdl)
  * @see auth_xport.h
  */
 int auth_xport_send(const auth_xport_hdl_t xporthdl, const uint8_t *data, size_t len)
+{
+	struct auth_xport_iov iov = { .data = data, .len = len };
+
+	return auth_xport_sendv(xporthdl, &iov, 1);
+}
+
+/**
+ * @see auth_xport.h
+ */
+int auth_xport_sendv(const auth_xport_hdl_t xporthdl, const struct auth_xport_iov *iov,
+		     int iovcnt)
 {
 	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
 	int fragment_bytes;
 	int payload_bytes;
+	int copied;
 	int send_count = 0;
 	int num_fragments = 0;
 	int send_ret = AUTH_SUCCESS;
-	struct auth_message_fragment msg_frag;
+	size_t len = 0;
+	size_t iov_offset = 0;
+	int i;
+	struct auth_xport_tx_frame tx_frame;
+	struct auth_message_fragment *msg_frag = &tx_frame.frag;
+	uint8_t *frame;
 
+	/* sanity check */
+	if ((xp_inst == NULL) || (iov == NULL) || (iovcnt <= 0)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		len += iov[i].len;
+	}
 
 	/* If the lower transport MTU size isn't set, get it.  This can happen
 	 * when the the MTU is negotiated after the initial connection. */
@@ -685,69 +1105,109 @@ int auth_xport_send(const auth_xport_hdl_t xporthdl, const uint8_t *data, size_t
 		xp_inst->payload_size = auth_xport_get_max_payload(xporthdl);
 	}
 
-	const uint16_t max_frame = MIN(sizeof(msg_frag), xp_inst->payload_size);
-	const uint16_t max_payload = max_frame - XPORT_FRAG_HDR_BYTECNT;
-
-	/* sanity check */
-	if (xp_inst == NULL) {
-		return AUTH_ERROR_INVALID_PARAM;
-	}
+	/* Compact frames once the peer accepts them, until then advertise
+	 * them on a message preserving transport. */
+	const bool compact = xp_inst->msg_preserving && xp_inst->peer_compact;
+	const uint16_t sync_bits = XPORT_FRAG_SYNC_BITS |
+				   (xp_inst->msg_preserving ? XPORT_FRAG_COMPACT_OK : 0);
+	const uint16_t hdr_bytes = compact ? XPORT_COMPACT_HDR_BYTECNT : XPORT_FRAG_HDR_BYTECNT;
+	const uint16_t crc_bytes = (xp_inst->frag_crc && !compact) ? XPORT_FRAG_CRC_BYTECNT : 0;
+	const uint16_t max_payload = MIN(XPORT_MAX_MESSAGE_SIZE,
+					 xp_inst->payload_size - hdr_bytes - crc_bytes);
+	uint32_t crc;
 
 	/* set frame header */
-	msg_frag.hdr.sync_flags = XPORT_FRAG_SYNC_BITS | XPORT_FRAG_BEGIN;
+	msg_frag->hdr.sync_flags = sync_bits | XPORT_FRAG_BEGIN;
+
+	/* the frames of a message are queued back to back */
+	hal_lock_mutex(xp_inst->tx_mutex);
 
 	/* Break up data to fit into lower transport MTU */
+	i = 0;
 	while (len > 0) {
 
 		/* get payload bytes */
 		payload_bytes = MIN(max_payload, len);
 
-		fragment_bytes = payload_bytes + XPORT_FRAG_HDR_BYTECNT;
+		fragment_bytes = payload_bytes + hdr_bytes + crc_bytes;
 
 		/* is this the last frame? */
 		if ((len - payload_bytes) == 0) {
 
-			msg_frag.hdr.sync_flags = XPORT_FRAG_SYNC_BITS | XPORT_FRAG_END;
+			msg_frag->hdr.sync_flags = sync_bits | XPORT_FRAG_END;
 
 			/* now check if we're only sending one frame, then set
 			 * the frame begin flag */
 			if (num_fragments == 0) {
-				msg_frag.hdr.sync_flags |= XPORT_FRAG_BEGIN;
+				msg_frag->hdr.sync_flags |= XPORT_FRAG_BEGIN;
+			}
+		}
+
+		/* gather body, a fragment can span several buffers */
+		for (copied = 0; copied < payload_bytes; ) {
+			size_t cnt = MIN(iov[i].len - iov_offset, (size_t)(payload_bytes - copied));
+
+			memcpy(msg_frag->frag_payload + copied, iov[i].data + iov_offset, cnt);
+			copied += cnt;
+			iov_offset += cnt;
+
+			if (iov_offset == iov[i].len) {
+				i++;
+				iov_offset = 0;
 			}
 		}
 
-		/* copy body */
-		memcpy(msg_frag.frag_payload, data, payload_bytes);
-		msg_frag.hdr.payload_len = payload_bytes;
+		if (compact) {
+			/* the one byte header goes right in front of the payload */
+			frame = msg_frag->frag_payload - XPORT_COMPACT_HDR_BYTECNT;
+			*frame = XPORT_COMPACT_MARK | (msg_frag->hdr.sync_flags & XPORT_FRAG_FLAGS_MASK);
+		} else {
+			msg_frag->hdr.payload_len = payload_bytes | (crc_bytes ? XPORT_FRAG_LEN_CRC : 0);
 
-		/* convert header to Big Endian, network byte order */
-		auth_message_hdr_to_be16(&msg_frag.hdr);
+			/* convert header to Big Endian, network byte order */
+			auth_message_hdr_to_be16(&msg_frag->hdr);
+
+			frame = (uint8_t *)msg_frag;
+
+			if (crc_bytes) {
+				crc = htobe32(auth_crc32c(0, frame, XPORT_FRAG_HDR_BYTECNT + payload_bytes));
+				memcpy(msg_frag->frag_payload + payload_bytes, &crc, sizeof(crc));
+			}
+		}
+
+		len -= payload_bytes;
+		send_count += payload_bytes;
 
 		/* send frame */
-		send_ret = auth_xport_internal_send(xporthdl,
-						    (const uint8_t *)&msg_frag, fragment_bytes);
+		send_ret = auth_xport_internal_send(xp_inst, frame, fragment_bytes,
+						    (len == 0) ? (size_t)send_count : 0);
+
+		if (send_ret == AUTH_ERROR_IOBUFF_FULL) {
+			break;
+		}
 
 		if (send_ret < 0) {
 			LOG_ERROR("Failed to send xport frame, error: %d", send_ret);
-			return AUTH_ERROR_XPORT_SEND;
+			send_ret = AUTH_ERROR_XPORT_SEND;
+			break;
 		}
 
 		/* verify all bytes were sent */
 		if (send_ret != fragment_bytes) {
             LOG_ERROR("Failed to to send all bytes, send: %d, requested: %d", send_ret, fragment_bytes);
-			return AUTH_ERROR_XPORT_SEND;
+			send_ret = AUTH_ERROR_XPORT_SEND;
+			break;
 		}
 
 		/* set next flags */
-		msg_frag.hdr.sync_flags = XPORT_FRAG_SYNC_BITS | XPORT_FRAG_NEXT;
+		msg_frag->hdr.sync_flags = sync_bits | XPORT_FRAG_NEXT;
 
-		len -= payload_bytes;
-		data += payload_bytes;
-		send_count += payload_bytes;
 		num_fragments++;
 	}
 
-	return send_count;
+	hal_unlock_mutex(xp_inst->tx_mutex);
+
+	return (send_ret < 0) ? send_ret : send_count;
 }
 
 
@@ -760,12 +1220,22 @@ int auth_xport_put_recv(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
 			size_t buflen)
 {
 	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+	recv_callback_t recv_cb;
+	int ret;
 
 	if (xp_inst == NULL) {
 		return AUTH_ERROR_INVALID_PARAM;
 	}
 
-	return auth_xport_buffer_put(&xp_inst->recv_buf, buf, buflen);
+	ret = auth_xport_buffer_put(&xp_inst->recv_buf, buf, buflen);
+
+	recv_cb = xp_inst->recv_cb;
+
+	if ((ret > 0) && (recv_cb != NULL)) {
+		recv_cb(xporthdl);
+	}
+
+	return ret;
 }
 
 
@@ -785,6 +1255,22 @@ int auth_xport_recv(const auth_xport_hdl_t xporthdl, uint8_t *buf,
 					  timeoutMsec);
 }
 
+/**
+ * @see auth_xport.h
+ */
+int auth_xport_cancel_recv(const auth_xport_hdl_t xporthdl, bool cancel)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+
+	if (xp_inst == NULL) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	auth_xport_iobuffer_cancel(&xp_inst->recv_buf, cancel);
+
+	return AUTH_SUCCESS;
+}
+
 /**
  * @see auth_xport.h
  */
@@ -884,8 +1370,10 @@ bool auth_message_get_fragment(const uint8_t *buffer, uint16_t buflen,
 	frm_hdr = (struct auth_message_frag_hdr *)buffer;
 
 	/* convert from be to cpu */
-	temp_payload_len = auth_be16_to_host(frm_hdr->payload_len) +
-			   XPORT_FRAG_HDR_BYTECNT;
+	temp_payload_len = auth_be16_to_host(frm_hdr->payload_len);
+
+	temp_payload_len = (temp_payload_len & XPORT_FRAG_LEN_MASK) + XPORT_FRAG_HDR_BYTECNT +
+			   ((temp_payload_len & XPORT_FRAG_LEN_CRC) ? XPORT_FRAG_CRC_BYTECNT : 0);
 
 	/* does the buffer contian all of the fragment bytes?
 	 * Including the header. */
@@ -900,47 +1388,67 @@ bool auth_message_get_fragment(const uint8_t *buffer, uint16_t buflen,
 	/* Have a full fragment */
 	*frag_beg_offset = cur_offset;
 
-	/* Return fragment byte count, including the header */
-	*frag_byte_cnt = frm_hdr->payload_len + XPORT_FRAG_HDR_BYTECNT;
+	/* Return fragment byte count, including the header and CRC */
+	*frag_byte_cnt = temp_payload_len;
 
 	return true;
 }
 
 /**
- * @see auth_internal.h
+ * Checks the CRC trailer of a received fragment.
+ *
+ * @param rx_frag   Fragment, the header in CPU byte order.
+ * @param body_len  Bytes after the header, payload and CRC.
+ *
+ * @return true if the CRC matches.
  */
-int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
-			  size_t buflen)
+static bool auth_message_check_crc(const struct auth_message_fragment *rx_frag, size_t body_len)
 {
-	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
-	struct auth_message_recv *msg_recv;
-	struct auth_message_fragment *rx_frag;
-	int free_buf_space;
-	int recv_ret = 0;
+	struct auth_message_frag_hdr be_hdr = rx_frag->hdr;
+	const size_t payload_len = rx_frag->hdr.payload_len & XPORT_FRAG_LEN_MASK;
+	uint32_t crc;
+	uint32_t frag_crc;
 
-	/* check input params */
-	if ((xp_inst == NULL) || (buf == NULL) || (buflen == 0u)) {
-		return AUTH_ERROR_INVALID_PARAM;
+	if (body_len < payload_len + XPORT_FRAG_CRC_BYTECNT) {
+		return false;
 	}
 
-	msg_recv = (struct auth_message_recv *)&xp_inst->recv_msg;
+	/* the CRC is over the header as sent */
+	auth_message_hdr_to_be16(&be_hdr);
 
-	/* If max payload size isn't set, get it from the lower transport.
-	 * This can happen if the lower transports frame/MTU size is set
-	 * after an initial connection. */
-	if (xp_inst->payload_size == 0) {
-		xp_inst->payload_size = auth_xport_get_max_payload(xporthdl);
-	}
+	crc = auth_crc32c(0, (const uint8_t *)&be_hdr, sizeof(be_hdr));
+	crc = auth_crc32c(crc, rx_frag->frag_payload, payload_len);
 
-	/* Reassemble a message from one for more fragments. */
-	rx_frag = (struct auth_message_fragment *)buf;
+	memcpy(&frag_crc, rx_frag->frag_payload + payload_len, sizeof(frag_crc));
+
+	return be32toh(frag_crc) == crc;
+}
+
+/**
+ * Adds the payload of one frame to the message being reassembled, the
+ * message is put into the receive queue after its last frame.
+ *
+ * @param xp_inst      Transport instance.
+ * @param flags        Fragment flags of the frame.
+ * @param payload      Frame payload.
+ * @param payload_len  Payload bytes.
+ *
+ * @return The number of bytes queued, on error negative value.
+ */
+static int auth_message_assemble_payload(struct auth_xport_instance *xp_inst, uint16_t flags,
+					 const uint8_t *payload, size_t payload_len)
+{
+	struct auth_message_recv *msg_recv = &xp_inst->recv_msg;
+	int free_buf_space;
+	int recv_ret = 0;
+	recv_callback_t recv_cb;
 
 	/* check for start flag */
 	if (msg_recv->rx_first_frag) {
 
 		msg_recv->rx_first_frag = false;
 
-		if (!(rx_frag->hdr.sync_flags & XPORT_FRAG_BEGIN)) {
+		if (!(flags & XPORT_FRAG_BEGIN)) {
 			/* reset vars */
 			msg_recv->rx_curr_offset = 0;
 			msg_recv->rx_first_frag = true;
@@ -952,25 +1460,8 @@ int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
         LOG_DEBUG("RX-Got BEGIN fragment.");
 	}
 
-	/* check fragment sync bytes */
-	if ((rx_frag->hdr.sync_flags & XPORT_FRAG_SYNC_MASK) != XPORT_FRAG_SYNC_BITS) {
-		/* reset vars */
-		msg_recv->rx_curr_offset = 0;
-		msg_recv->rx_first_frag = true;
-
-        LOG_ERROR("RX-Invalid fragment.");
-		return AUTH_ERROR_XPORT_FRAME;
-	}
-
-
-	/* Subtract out fragment header */
-	buflen -= XPORT_FRAG_HDR_BYTECNT;
-
-	/* move beyond fragment header */
-	buf += XPORT_FRAG_HDR_BYTECNT;
-
-	/* sanity check, if zero or negative */
-	if (buflen <= 0) {
+	/* sanity check, if zero */
+	if (payload_len == 0) {
 		/* reset vars */
 		msg_recv->rx_curr_offset = 0;
 		msg_recv->rx_first_frag = true;
@@ -981,7 +1472,7 @@ int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
 	/* ensure there's enough free space in our temp buffer */
 	free_buf_space = sizeof(msg_recv->rx_buffer) - msg_recv->rx_curr_offset;
 
-	if (free_buf_space < buflen) {
+	if (free_buf_space < (int)payload_len) {
 		/* reset vars */
 		msg_recv->rx_curr_offset = 0;
 		msg_recv->rx_first_frag = true;
@@ -990,15 +1481,15 @@ int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
 	}
 
 	/* copy payload bytes */
-	memcpy(msg_recv->rx_buffer + msg_recv->rx_curr_offset, buf, buflen);
+	memcpy(msg_recv->rx_buffer + msg_recv->rx_curr_offset, payload, payload_len);
 
-	msg_recv->rx_curr_offset += buflen;
+	msg_recv->rx_curr_offset += payload_len;
 
 	/* returned the number of bytes queued */
-	recv_ret = buflen;
+	recv_ret = payload_len;
 
 	/* Is this the last fragment of the message? */
-	if (rx_frag->hdr.sync_flags & XPORT_FRAG_END) {
+	if (flags & XPORT_FRAG_END) {
 
 		/* log number payload bytes received. */
         LOG_DEBUG("RX-Got LAST fragment, total bytes: %d", msg_recv->rx_curr_offset);
@@ -1013,6 +1504,12 @@ int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
 							 msg_recv->rx_buffer,
 							 msg_recv->rx_curr_offset);
 
+			recv_cb = xp_inst->recv_cb;
+
+			if ((recv_ret > 0) && (recv_cb != NULL)) {
+				recv_cb(xp_inst);
+			}
+
 		} else {
 			int need = msg_recv->rx_curr_offset - free_bytes;
             LOG_ERROR("Not enough room in RX buffer, free: %d, need %d bytes.", free_bytes, need);
@@ -1026,6 +1523,106 @@ int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
 	return recv_ret;
 }
 
+/**
+ * @see auth_internal.h
+ */
+int auth_message_assemble(const auth_xport_hdl_t xporthdl, const uint8_t *buf,
+			  size_t buflen)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+	struct auth_message_recv *msg_recv;
+	struct auth_message_fragment *rx_frag;
+
+	/* check input params */
+	if ((xp_inst == NULL) || (buf == NULL) || (buflen == 0u)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	msg_recv = (struct auth_message_recv *)&xp_inst->recv_msg;
+
+	/* If max payload size isn't set, get it from the lower transport.
+	 * This can happen if the lower transports frame/MTU size is set
+	 * after an initial connection. */
+	if (xp_inst->payload_size == 0) {
+		xp_inst->payload_size = auth_xport_get_max_payload(xporthdl);
+	}
+
+	/* Reassemble a message from one for more fragments. */
+	rx_frag = (struct auth_message_fragment *)buf;
+
+	/* check fragment sync bytes */
+	if ((buflen < XPORT_FRAG_HDR_BYTECNT) ||
+	    ((rx_frag->hdr.sync_flags & XPORT_FRAG_SYNC_MASK) != XPORT_FRAG_SYNC_BITS)) {
+		/* reset vars */
+		msg_recv->rx_curr_offset = 0;
+		msg_recv->rx_first_frag = true;
+
+        LOG_ERROR("RX-Invalid fragment.");
+		return AUTH_ERROR_XPORT_FRAME;
+	}
+
+	/* Subtract out fragment header */
+	buflen -= XPORT_FRAG_HDR_BYTECNT;
+
+	if (rx_frag->hdr.payload_len & XPORT_FRAG_LEN_CRC) {
+
+		if (!auth_message_check_crc(rx_frag, buflen)) {
+			/* drop the fragment and the message it belongs to, the
+			 * transport resyncs on the next fragment */
+			msg_recv->rx_curr_offset = 0;
+			msg_recv->rx_first_frag = true;
+
+			LOG_ERROR("RX-Fragment CRC mismatch.");
+			return AUTH_ERROR_XPORT_FRAME;
+		}
+
+		buflen = rx_frag->hdr.payload_len & XPORT_FRAG_LEN_MASK;
+	}
+
+	return auth_message_assemble_payload(xp_inst, rx_frag->hdr.sync_flags,
+					     buf + XPORT_FRAG_HDR_BYTECNT, buflen);
+}
+
+/**
+ * @see auth_internal.h
+ */
+int auth_message_recv_datagram(const auth_xport_hdl_t xporthdl, uint8_t *buf,
+			       size_t buflen)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+	struct auth_message_frag_hdr *frm_hdr;
+	uint16_t begin_offset;
+	uint16_t byte_cnt;
+
+	if ((xp_inst == NULL) || (buf == NULL) || (buflen == 0u)) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	/* A compact frame, the datagram is the frame.  Only a peer which saw
+	 * XPORT_FRAG_COMPACT_OK from us sends them. */
+	if ((buf[0] & XPORT_COMPACT_MARK_MASK) == XPORT_COMPACT_MARK) {
+		xp_inst->peer_compact = true;
+
+		return auth_message_assemble_payload(xp_inst, buf[0] & XPORT_FRAG_FLAGS_MASK,
+						     buf + XPORT_COMPACT_HDR_BYTECNT,
+						     buflen - XPORT_COMPACT_HDR_BYTECNT);
+	}
+
+	if (!auth_message_get_fragment(buf, (uint16_t)buflen, &begin_offset, &byte_cnt)) {
+		LOG_ERROR("Didn't recv full packet.");
+		return AUTH_ERROR_XPORT_FRAME;
+	}
+
+	/* the header is in CPU byte order now */
+	frm_hdr = (struct auth_message_frag_hdr *)(buf + begin_offset);
+
+	if (frm_hdr->sync_flags & XPORT_FRAG_COMPACT_OK) {
+		xp_inst->peer_compact = true;
+	}
+
+	return auth_message_assemble(xporthdl, buf + begin_offset, byte_cnt);
+}
+
 /**
  * @see auth_internal.h
  */
@@ -1055,6 +1652,101 @@ void auth_xport_set_sendfunc(auth_xport_hdl_t xporthdl, send_xport_t send_func)
 	xp_inst->send_func = send_func;
 }
 
+/**
+ * @see auth_xport.h
+ */
+void auth_xport_set_msg_preserving(auth_xport_hdl_t xporthdl)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+
+	xp_inst->msg_preserving = true;
+}
+
+/**
+ * @see auth_xport.h
+ */
+void auth_xport_set_frag_crc(auth_xport_hdl_t xporthdl, bool enable)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+
+	xp_inst->frag_crc = enable;
+}
+
+/**
+ * @see auth_xport.h
+ */
+void auth_xport_set_send_batchfunc(auth_xport_hdl_t xporthdl, send_batch_xport_t batch_func)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+
+	xp_inst->send_batch_func = batch_func;
+}
+
+/**
+ * @see auth_xport.h
+ */
+int auth_xport_flush(const auth_xport_hdl_t xporthdl, uint32_t timeout_msec)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+	uint32_t queued;
+	uint64_t start;
+	uint64_t now;
+
+	if (xp_inst == NULL) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
+	/* without a tx thread frames are not queued by the auth library */
+	if (xp_inst->tx_thrd == NULL) {
+		return AUTH_SUCCESS;
+	}
+
+	hal_lock_mutex(xp_inst->tx_mutex);
+	queued = xp_inst->tx_msgs_queued;
+	hal_unlock_mutex(xp_inst->tx_mutex);
+
+	hal_get_time_msec(&start);
+
+	while ((int32_t)(queued - xp_inst->tx_msgs_sent) > 0) {
+
+		if (xp_inst->tx_shutdown) {
+			return AUTH_ERROR_XPORT_SEND;
+		}
+
+		hal_get_time_msec(&now);
+
+		if ((now - start) >= timeout_msec) {
+			LOG_ERROR("Timed out flushing the send queue.");
+			return AUTH_ERROR_TIMEOUT;
+		}
+
+		hal_wait_sem_timeout(xp_inst->tx_sent_sem,
+				     (unsigned)(timeout_msec - (uint32_t)(now - start)));
+	}
+
+	return AUTH_SUCCESS;
+}
+
+/**
+ * @see auth_xport.h
+ */
+void auth_xport_set_send_callback(auth_xport_hdl_t xporthdl, send_callback_t send_cb)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+
+	xp_inst->send_cb = send_cb;
+}
+
+/**
+ * @see auth_xport.h
+ */
+void auth_xport_set_recv_callback(auth_xport_hdl_t xporthdl, recv_callback_t recv_cb)
+{
+	struct auth_xport_instance *xp_inst = (struct auth_xport_instance *)xporthdl;
+
+	xp_inst->recv_cb = recv_cb;
+}
+
 /**
  * @see auth_xport.h
  */
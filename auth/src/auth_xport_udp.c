@@ -31,6 +31,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#define _GNU_SOURCE     /* sendmmsg() */
+
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
@@ -64,6 +66,9 @@ struct udp_xp_instance {
 	int send_socket_fd;
     struct sockaddr_in send_addr;
 
+    /* Socket the receive thread reads from */
+    int recv_socket_fd;
+
     /**
      * UDP network info
      */
@@ -126,14 +131,9 @@ static void auth_xp_udp_free_instance(struct udp_xp_instance *udp_inst)
  */
 static void *auth_xp_udp_recv(void *arg)
 {
-    int fd;
-    size_t num_bytes;
-    struct sockaddr_in recv_addr;
     uint8_t *rx_buf;
     auth_xport_hdl_t xport_hdl = (auth_xport_hdl_t)arg;
     struct udp_xp_instance *xp_inst;
-    uint32_t recv_ip_addr;
-    uint16_t begin_offset, byte_cnt;
 
     // get instance
     xp_inst = (struct udp_xp_instance *)auth_xport_get_context(xport_hdl);
@@ -144,64 +144,39 @@ static void *auth_xp_udp_recv(void *arg)
         return 0;
     }
 
-
-    fd = socket(AF_INET, SOCK_DGRAM, 0);
-
-    if(fd == -1)
-    {
-        free(rx_buf);
-        LOG_ERROR("Failed to create socket, errno: %d", errno);
-        return 0;
-    }
-
-
-    recv_ip_addr = inet_addr(xp_inst->recv_ip_addr);
-
-    memset((char *) &recv_addr, 0, sizeof(recv_addr));
-    recv_addr.sin_family = AF_INET;
-    recv_addr.sin_addr.s_addr = recv_ip_addr; /* host-to-network endian */
-    recv_addr.sin_port = htons(xp_inst->recv_port_num);
-
-    // bind address to address
-    if(bind(fd, (const struct sockaddr*)&recv_addr, sizeof(recv_addr)) < 0)
-    {
-        LOG_ERROR("Failed to bind to IP address: %s, errno: %d", xp_inst->recv_ip_addr, errno);
-        return 0;
-    }
-
     rx_buf = malloc(UDP_LINK_MTU);
 
     if(rx_buf == NULL)
     {
-        close(fd);
         LOG_ERROR("Failed to allocate rx buffer, errno: %d", errno);
         return 0;
     }
 
     while(!xp_inst->shutdown_rx_thread)
     {
-        ssize_t byte_recv = recvfrom(fd, rx_buf, UDP_LINK_MTU, 0, NULL, 0);
+        ssize_t byte_recv = recvfrom(xp_inst->recv_socket_fd, rx_buf, UDP_LINK_MTU, 0, NULL, 0);
+
+        /* woken by auth_xp_udp_deinit() */
+        if(xp_inst->shutdown_rx_thread)
+        {
+            break;
+        }
 
         if((int)byte_recv == -1)
         {
-            LOG_ERROR("Failed to receive from source, errno: %d", errno);
+            if(errno != EINTR)
+            {
+                LOG_ERROR("Failed to receive from source, errno: %d", errno);
+            }
             continue;
         }
 
         LOG_DEBUG("Received %d bytes.", (int)byte_recv);
 
-        if(!xp_inst->shutdown_rx_thread) {
-
-            // NOTE: With UDP we should receive a full message without any fragmentation
-            if(auth_message_get_fragment(rx_buf, (uint16_t)byte_recv, &begin_offset, &byte_cnt)) {
-
-                // forward common transport layer
-                auth_message_assemble(xport_hdl, rx_buf, byte_recv);
-            }
-            else
-            {
-                LOG_ERROR("Didn't recv full packet.");
-            }
+        // NOTE: With UDP each datagram holds one frame, forward to common transport layer
+        if(byte_recv > 0)
+        {
+            auth_message_recv_datagram(xport_hdl, rx_buf, (size_t)byte_recv);
         }
     }
 
@@ -247,6 +222,54 @@ static int auth_xp_udp_send(auth_xport_hdl_t xport_hdl, const uint8_t *data,
 	return (int)bytes_sent;
 }
 
+/**
+ * Send several frames over UDP with one system call, one datagram per frame.
+ *
+ * @param xport_hdl  Transport handle.
+ * @param frames     Frames to send.
+ * @param count      Number of frames.
+ *
+ * @return  Number of frames sent on success, else negative error value.
+ */
+static int auth_xp_udp_send_batch(auth_xport_hdl_t xport_hdl, const struct auth_xport_iov *frames,
+                                  int count)
+{
+    struct udp_xp_instance *udp_inst = (struct udp_xp_instance *)auth_xport_get_context(xport_hdl);
+    struct mmsghdr msgs[AUTH_XPORT_TX_BATCH_MAX];
+    struct iovec iov[AUTH_XPORT_TX_BATCH_MAX];
+    int cnt;
+
+    if((count <= 0) || (count > (int)AUTH_XPORT_TX_BATCH_MAX))
+    {
+        return AUTH_ERROR_INVALID_PARAM;
+    }
+
+    memset(msgs, 0, sizeof(msgs));
+
+    for(cnt = 0; cnt < count; cnt++)
+    {
+        iov[cnt].iov_base = (void *)frames[cnt].data;
+        iov[cnt].iov_len = frames[cnt].len;
+
+        msgs[cnt].msg_hdr.msg_name = &udp_inst->send_addr;
+        msgs[cnt].msg_hdr.msg_namelen = sizeof(udp_inst->send_addr);
+        msgs[cnt].msg_hdr.msg_iov = &iov[cnt];
+        msgs[cnt].msg_hdr.msg_iovlen = 1;
+    }
+
+    int frames_sent = sendmmsg(udp_inst->send_socket_fd, msgs, (unsigned int)count, 0);
+
+    if(frames_sent == -1)
+    {
+        LOG_ERROR("Failed to send %d frames, errno: %d", count, errno);
+        return AUTH_ERROR_XPORT_SEND;
+    }
+
+    LOG_DEBUG("Sent %d of %d frames.", frames_sent, count);
+
+    return frames_sent;
+}
+
 
 /**
  * @see auth_xport.h
@@ -258,6 +281,7 @@ int auth_xp_udp_init(const auth_xport_hdl_t xport_hdl, uint32_t flags,
 		              (struct auth_xp_udp_params*)xport_param;
 
 	struct udp_xp_instance *udp_inst = auth_xp_udp_get_instance();
+    struct sockaddr_in recv_addr;
 
 	if (udp_inst == NULL) {
 		LOG_ERROR("No free UDP xport instances.");
@@ -274,8 +298,31 @@ int auth_xp_udp_init(const auth_xport_hdl_t xport_hdl, uint32_t flags,
     strncpy(udp_inst->send_ip_addr, udp_param->send_ip_addr, sizeof(udp_inst->send_ip_addr));
     strncpy(udp_inst->recv_ip_addr, udp_param->recv_ip_addr, sizeof(udp_inst->recv_ip_addr));
 
-    /* Create send address and socket, the receive socket and
-     * address is created in the receive thread. */
+    /* Create the receive socket here so the receive thread never
+     * blocks on a socket deinit can't see. */
+    udp_inst->recv_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(udp_inst->recv_socket_fd == -1)
+    {
+        LOG_ERROR("Failed to create socket, errno: %d", errno);
+        auth_xp_udp_free_instance(udp_inst);
+        return AUTH_ERROR_NO_RESOURCE;
+    }
+
+    memset(&recv_addr, 0, sizeof(recv_addr));
+    recv_addr.sin_family = AF_INET;
+    recv_addr.sin_addr.s_addr = inet_addr(udp_inst->recv_ip_addr); /* host-to-network endian */
+    recv_addr.sin_port = htons(udp_inst->recv_port_num);
+
+    if(bind(udp_inst->recv_socket_fd, (const struct sockaddr*)&recv_addr, sizeof(recv_addr)) < 0)
+    {
+        LOG_ERROR("Failed to bind to IP address: %s, errno: %d", udp_inst->recv_ip_addr, errno);
+        close(udp_inst->recv_socket_fd);
+        auth_xp_udp_free_instance(udp_inst);
+        return AUTH_ERROR_NO_RESOURCE;
+    }
+
+    /* Create send address and socket */
     udp_inst->send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
 
     // IP address to send messages to
@@ -291,6 +338,8 @@ int auth_xp_udp_init(const auth_xport_hdl_t xport_hdl, uint32_t flags,
 	auth_xport_set_context(xport_hdl, udp_inst);
 
 	auth_xport_set_sendfunc(xport_hdl, auth_xp_udp_send);
+	auth_xport_set_send_batchfunc(xport_hdl, auth_xp_udp_send_batch);
+	auth_xport_set_msg_preserving(xport_hdl);
 
 	/* Start receive thread, will block on read of socket */
     hal_create_thread(&udp_inst->recv_thrd, auth_xp_udp_recv, xport_hdl);
@@ -301,12 +350,25 @@ int auth_xp_udp_init(const auth_xport_hdl_t xport_hdl, uint32_t flags,
 /**
  * @see auth_xport.h
  */
-int auuth_xp_udp_deinit(const auth_xport_hdl_t xport_hdl)
+int auth_xp_udp_deinit(const auth_xport_hdl_t xport_hdl)
 {
 	struct udp_xp_instance *udp_inst = (struct udp_xp_instance *)auth_xport_get_context(xport_hdl);
 
+	if (udp_inst == NULL) {
+		return AUTH_ERROR_INVALID_PARAM;
+	}
+
     udp_inst->shutdown_rx_thread = true;
 
+    /* Shutting down the socket makes a blocked recvfrom() return, wait
+     * for the receive thread to exit before closing it. */
+    shutdown(udp_inst->recv_socket_fd, SHUT_RDWR);
+    hal_join_thread(udp_inst->recv_thrd);
+    udp_inst->recv_thrd = NULL;
+
+    close(udp_inst->recv_socket_fd);
+    udp_inst->recv_socket_fd = -1;
+
 	// close socket
 	if(udp_inst->send_socket_fd != 0)
     {
@@ -1,4 +1,4 @@
-/* aes.h - TinyCrypt interface to an AES-128 implementation */
+/* aes.h - TinyCrypt interface to an AES-128/AES-256 implementation */
 
 /*
  *  Copyright (C) 2017 by Intel Corporation, All Rights Reserved.
@@ -32,16 +32,25 @@
 
 /**
  * @file
- * @brief -- Interface to an AES-128 implementation.
+ * @brief -- Interface to an AES-128/AES-256 implementation.
  *
- *  Overview:   AES-128 is a NIST approved block cipher specified in
+ *  Overview:   AES is a NIST approved block cipher specified in
  *              FIPS 197. Block ciphers are deterministic algorithms that
  *              perform a transformation specified by a symmetric key in fixed-
- *              length data sets, also called blocks.
+ *              length data sets, also called blocks. The key schedule records
+ *              its number of rounds, so every mode works with either key
+ *              size.
  *
- *  Security:   AES-128 provides approximately 128 bits of security.
+ *              struct tc_aes_sched_cache keeps the expanded schedules of the
+ *              most recently used keys, so per-session keys are expanded once
+ *              rather than on every message.
  *
- *  Usage:      1) call tc_aes128_set_encrypt/decrypt_key to set the key.
+ *  Security:   AES-128 provides approximately 128 bits of security, AES-256
+ *              approximately 256 bits.
+ *
+ *  Usage:      1) call tc_aes128_set_encrypt/decrypt_key or
+ *                 tc_aes256_set_encrypt/decrypt_key to set the key, or fetch
+ *                 the schedule with tc_aes_sched_cache_get.
  *
  *              2) call tc_aes_encrypt/decrypt to process the data.
  */
@@ -61,10 +70,24 @@ extern "C" {
 #define TC_AES_BLOCK_SIZE (Nb*Nk)
 #define TC_AES_KEY_SIZE (Nb*Nk)
 
+#define TC_AES256_NK (8)  /* number of 32-bit words comprising an AES-256 key */
+#define TC_AES256_NR (14) /* number of AES-256 rounds */
+#define TC_AES256_KEY_SIZE (Nb*TC_AES256_NK)
+
+/* maximum number of blocks the multi-block routines process per iteration */
+#define TC_AES_PARALLEL_BLOCKS (8)
+
 typedef struct tc_aes_key_sched_struct {
-	unsigned int words[Nb*(Nr+1)];
+	unsigned int words[Nb*(TC_AES256_NR+1)];
+	unsigned int rounds; /* 0 in zero-initialized schedules, read as Nr */
 } *TCAesKeySched_t;
 
+/* number of rounds of the key schedule s */
+static inline unsigned int tc_aes_rounds(const struct tc_aes_key_sched_struct *s)
+{
+	return (s->rounds != 0) ? s->rounds : Nr;
+}
+
 /**
  *  @brief Set AES-128 encryption key
  *  Uses key k to initialize s
@@ -79,7 +102,17 @@ typedef struct tc_aes_key_sched_struct {
 int tc_aes128_set_encrypt_key(TCAesKeySched_t s, const uint8_t *k);
 
 /**
- *  @brief AES-128 Encryption procedure
+ *  @brief Set AES-256 encryption key
+ *  Uses the 32 byte key k to initialize s
+ *  @return  returns TC_CRYPTO_SUCCESS (1)
+ *           returns TC_CRYPTO_FAIL (0) if: s == NULL or k == NULL
+ *  @param      s IN/OUT -- initialized struct tc_aes_key_sched_struct
+ *  @param      k IN -- points to the AES key
+ */
+int tc_aes256_set_encrypt_key(TCAesKeySched_t s, const uint8_t *k);
+
+/**
+ *  @brief AES Encryption procedure
  *  Encrypts contents of in buffer into out buffer under key;
  *              schedule s
  *  @note Assumes s was initialized by aes_set_encrypt_key;
@@ -90,9 +123,27 @@ int tc_aes128_set_encrypt_key(TCAesKeySched_t s, const uint8_t *k);
  *  @param in IN -- a plaintext block to encrypt
  *  @param s IN -- initialized AES key schedule
  */
-int tc_aes_encrypt(uint8_t *out, const uint8_t *in, 
+int tc_aes_encrypt(uint8_t *out, const uint8_t *in,
 		   const TCAesKeySched_t s);
 
+/**
+ *  @brief AES multi-block encryption procedure
+ *  Encrypts nblocks independent blocks of in into out under key schedule s,
+ *  TC_AES_PARALLEL_BLOCKS at a time. Intended for the counter based modes,
+ *  where the keystream blocks do not depend on each other.
+ *  @note Assumes s was initialized by aes_set_encrypt_key;
+ *              out and in point to nblocks * 16 byte buffers
+ *  @return  returns TC_CRYPTO_SUCCESS (1)
+ *           returns TC_CRYPTO_FAIL (0) if: out == NULL or in == NULL or
+ *           s == NULL or nblocks == 0
+ *  @param out IN/OUT -- buffer to receive ciphertext blocks
+ *  @param in IN -- plaintext blocks to encrypt
+ *  @param nblocks IN -- number of 16 byte blocks in in
+ *  @param s IN -- initialized AES key schedule
+ */
+int tc_aes_encrypt_blocks(uint8_t *out, const uint8_t *in,
+			  unsigned int nblocks, const TCAesKeySched_t s);
+
 /**
  *  @brief Set the AES-128 decryption key
  *  Uses key k to initialize s
@@ -110,7 +161,17 @@ int tc_aes_encrypt(uint8_t *out, const uint8_t *in,
 int tc_aes128_set_decrypt_key(TCAesKeySched_t s, const uint8_t *k);
 
 /**
- *  @brief AES-128 Encryption procedure
+ *  @brief Set the AES-256 decryption key
+ *  Uses the 32 byte key k to initialize s
+ *  @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if: s == NULL or k == NULL
+ *  @param s  IN/OUT -- initialized struct tc_aes_key_sched_struct
+ *  @param k  IN -- points to the AES key
+ */
+int tc_aes256_set_decrypt_key(TCAesKeySched_t s, const uint8_t *k);
+
+/**
+ *  @brief AES Encryption procedure
  *  Decrypts in buffer into out buffer under key schedule s
  *  @return returns TC_CRYPTO_SUCCESS (1)
  *          returns TC_CRYPTO_FAIL (0) if: out is NULL or in is NULL or s is NULL
@@ -120,9 +181,93 @@ int tc_aes128_set_decrypt_key(TCAesKeySched_t s, const uint8_t *k);
  *  @param in IN -- a plaintext block to encrypt
  *  @param s IN -- initialized AES key schedule
  */
-int tc_aes_decrypt(uint8_t *out, const uint8_t *in, 
+int tc_aes_decrypt(uint8_t *out, const uint8_t *in,
 		   const TCAesKeySched_t s);
 
+/**
+ *  @brief AES multi-block decryption procedure
+ *  Decrypts nblocks independent blocks of in into out under key schedule s.
+ *  The blocks are processed TC_AES_PARALLEL_BLOCKS at a time so the rounds
+ *  of several blocks are interleaved; when compiled with AES-NI support
+ *  (-maes) the blocks are pipelined through the AESDEC instruction.
+ *  @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if: out is NULL or in is NULL or
+ *          s is NULL or nblocks == 0
+ *  @note   Assumes s was initialized by aes_set_decrypt_key;
+ *          out and in point to nblocks * 16 byte buffers
+ *  @param out IN/OUT -- buffer to receive plaintext blocks
+ *  @param in IN -- ciphertext blocks to decrypt
+ *  @param nblocks IN -- number of 16 byte blocks in in
+ *  @param s IN -- initialized AES key schedule
+ */
+int tc_aes_decrypt_blocks(uint8_t *out, const uint8_t *in,
+			  unsigned int nblocks, const TCAesKeySched_t s);
+
+/* number of key schedules kept by struct tc_aes_sched_cache */
+#ifndef TC_AES_SCHED_CACHE_SIZE
+#define TC_AES_SCHED_CACHE_SIZE 8
+#endif
+
+/* tc_aes_cache_lock_fn type
+ * Lock and unlock callbacks of struct tc_aes_sched_cache, 'ctx' is the
+ * pointer given when the cache was initialized.
+ */
+typedef void (*tc_aes_cache_lock_fn)(void *ctx);
+
+struct tc_aes_sched_cache_entry {
+	uint32_t hash;
+	unsigned int keylen; /* 0 when the entry is unused */
+	unsigned int last_use;
+	uint8_t key[TC_AES256_KEY_SIZE];
+	struct tc_aes_key_sched_struct sched;
+};
+
+/*
+ * Expanded key schedules indexed by a hash of the key. Lookups compare the
+ * whole key, a hash collision only costs an expansion. When full the least
+ * recently used schedule is replaced.
+ */
+struct tc_aes_sched_cache {
+	struct tc_aes_sched_cache_entry entries[TC_AES_SCHED_CACHE_SIZE];
+	unsigned int clock;
+	tc_aes_cache_lock_fn lock;
+	tc_aes_cache_lock_fn unlock;
+	void *lock_ctx;
+};
+
+/**
+ *  @brief Initialize an empty key schedule cache
+ *  @param c IN/OUT -- the cache
+ *  @param lock IN -- called before the cache is accessed, may be NULL
+ *  @param unlock IN -- called after the cache is accessed, may be NULL
+ *  @param lock_ctx IN -- passed to lock and unlock
+ */
+void tc_aes_sched_cache_init(struct tc_aes_sched_cache *c,
+			     tc_aes_cache_lock_fn lock,
+			     tc_aes_cache_lock_fn unlock, void *lock_ctx);
+
+/**
+ *  @brief Get the key schedule of a key
+ *  Copies the cached schedule of k into s, expanding and caching it first
+ *  if k is not in the cache. The schedule is valid for both encryption and
+ *  decryption.
+ *  @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if: c, s or k is NULL or keylen is
+ *          not TC_AES_KEY_SIZE or TC_AES256_KEY_SIZE
+ *  @param c IN/OUT -- the cache
+ *  @param s OUT -- receives the key schedule
+ *  @param k IN -- the AES key
+ *  @param keylen IN -- key length in bytes
+ */
+int tc_aes_sched_cache_get(struct tc_aes_sched_cache *c, TCAesKeySched_t s,
+			   const uint8_t *k, unsigned int keylen);
+
+/**
+ *  @brief Wipe all keys and schedules held by the cache
+ *  @param c IN/OUT -- the cache
+ */
+void tc_aes_sched_cache_clear(struct tc_aes_sched_cache *c);
+
 #ifdef __cplusplus
 }
 #endif
@@ -132,6 +132,8 @@ int tc_cbc_mode_encrypt(uint8_t *out, unsigned int outlen, const uint8_t *in,
  *              - out buffer is large enough to hold the decrypted plaintext
  *              and is a contiguous buffer
  *              - inlen gives the number of bytes in the in buffer
+ * @note The block decryptions are independent and are done up to
+ *       TC_AES_PARALLEL_BLOCKS at a time with tc_aes_decrypt_blocks
  * @param out IN/OUT -- buffer to receive decrypted data
  * @param outlen IN -- length of plaintext buffer in bytes
  * @param in IN -- ciphertext to decrypt, including IV
@@ -0,0 +1,161 @@
+/* chacha20_poly1305.h - TinyCrypt interface to a ChaCha20-Poly1305 AEAD */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * @brief Interface to a ChaCha20-Poly1305 AEAD implementation.
+ *
+ *  Overview: ChaCha20-Poly1305 is the authenticated encryption construction
+ *            defined in RFC 8439. The ChaCha20 stream cipher encrypts the
+ *            payload and the Poly1305 one-time authenticator, keyed from the
+ *            first ChaCha20 block, authenticates the associated data and the
+ *            ciphertext. It only uses 32-bit additions, rotations and xors,
+ *            so it is fast on processors without AES acceleration.
+ *
+ *            The keystream is generated several blocks at a time: 8 blocks
+ *            with AVX2 (-mavx2), 4 blocks with SSE2 (-msse2), one block with
+ *            the portable code otherwise. Poly1305 uses 64-bit limbs when the
+ *            compiler provides a 128-bit integer type and 26-bit limbs
+ *            otherwise.
+ *
+ *  Security: The 96-bit nonce must never be repeated under the same key,
+ *            doing so reveals the Poly1305 key and the xor of the payloads.
+ *            The tag is always 16 bytes.
+ *
+ *  Requires: Nothing
+ *
+ *  Usage:    1) call tc_chacha20_poly1305_config to configure.
+ *
+ *            2) call tc_chacha20_poly1305_set_nonce to change the nonce for
+ *               each message.
+ *
+ *            3) call tc_chacha20_poly1305_generation_encryption to encrypt
+ *               data and generate tag.
+ *
+ *            4) call tc_chacha20_poly1305_decryption_verification to verify
+ *               tag and decrypt data.
+ */
+
+#ifndef __TC_CHACHA20_POLY1305_H__
+#define __TC_CHACHA20_POLY1305_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* key size in bytes */
+#define TC_CHACHA20_KEY_SIZE 32
+
+/* nonce size in bytes */
+#define TC_CHACHA20_NONCE_SIZE 12
+
+/* ChaCha20 block size in bytes */
+#define TC_CHACHA20_BLOCK_SIZE 64
+
+/* tag size in bytes */
+#define TC_POLY1305_TAG_SIZE 16
+
+/* struct tc_chacha20_poly1305_struct represents the state of an AEAD */
+typedef struct tc_chacha20_poly1305_struct {
+	uint32_t key[TC_CHACHA20_KEY_SIZE / 4]; /* ChaCha20 key words */
+	const uint8_t *nonce; /* nonce, TC_CHACHA20_NONCE_SIZE bytes */
+} *TCChaChaPolyMode_t;
+
+/**
+ * @brief ChaCha20-Poly1305 configuration procedure
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if:
+ *                c == NULL or
+ *                key == NULL or
+ *                nonce == NULL or
+ *                nlen != TC_CHACHA20_NONCE_SIZE
+ * @param c -- AEAD state
+ * @param key IN -- TC_CHACHA20_KEY_SIZE byte key
+ * @param nonce IN - nonce
+ * @param nlen -- nonce length in bytes
+ */
+int tc_chacha20_poly1305_config(TCChaChaPolyMode_t c, const uint8_t *key,
+				const uint8_t *nonce, unsigned int nlen);
+
+/**
+ * @brief Sets the nonce for the next message.
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if:
+ *                c == NULL or
+ *                nonce == NULL or
+ *                nlen != TC_CHACHA20_NONCE_SIZE
+ * @param c -- AEAD state, configured by tc_chacha20_poly1305_config
+ * @param nonce IN - nonce
+ * @param nlen -- nonce length in bytes
+ */
+int tc_chacha20_poly1305_set_nonce(TCChaChaPolyMode_t c, const uint8_t *nonce,
+				   unsigned int nlen);
+
+/**
+ * @brief ChaCha20-Poly1305 encryption and tag generation procedure
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *         returns TC_CRYPTO_FAIL (0) if:
+ *                out == NULL or
+ *                c == NULL or
+ *                ((plen > 0) and (payload == NULL)) or
+ *                ((alen > 0) and (associated_data == NULL)) or
+ *                (olen < plen + TC_POLY1305_TAG_SIZE)
+ *
+ * @param out OUT -- encrypted data followed by the tag
+ * @param olen IN -- output length in bytes
+ * @param associated_data IN -- associated data
+ * @param alen IN -- associated data length in bytes
+ * @param payload IN -- payload
+ * @param plen IN -- payload length in bytes
+ * @param c IN -- AEAD state
+ */
+int tc_chacha20_poly1305_generation_encryption(uint8_t *out, unsigned int olen,
+					       const uint8_t *associated_data,
+					       unsigned int alen,
+					       const uint8_t *payload,
+					       unsigned int plen,
+					       TCChaChaPolyMode_t c);
+
+/**
+ * @brief ChaCha20-Poly1305 tag verification and decryption procedure
+ * The tag is verified before anything is decrypted, out is only written
+ * when the tag is valid.
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *         returns TC_CRYPTO_FAIL (0) if:
+ *                out == NULL or
+ *                c == NULL or
+ *                (payload == NULL) or
+ *                ((alen > 0) and (associated_data == NULL)) or
+ *                (plen < TC_POLY1305_TAG_SIZE) or
+ *                (olen < plen - TC_POLY1305_TAG_SIZE) or
+ *                the tag does not verify
+ *
+ * @param out OUT -- decrypted data
+ * @param olen IN -- output length in bytes
+ * @param associated_data IN -- associated data
+ * @param alen IN -- associated data length in bytes
+ * @param payload IN -- encrypted data followed by the tag
+ * @param plen IN -- payload length in bytes, including the tag
+ * @param c IN -- AEAD state
+ */
+int tc_chacha20_poly1305_decryption_verification(uint8_t *out,
+						 unsigned int olen,
+						 const uint8_t *associated_data,
+						 unsigned int alen,
+						 const uint8_t *payload,
+						 unsigned int plen,
+						 TCChaChaPolyMode_t c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TC_CHACHA20_POLY1305_H__ */
@@ -0,0 +1,100 @@
+/* curve25519.h - TinyCrypt interface to arithmetic modulo 2^255 - 19 */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * @brief -- Interface to the field arithmetic shared by X25519 and Ed25519.
+ *
+ *  Overview: Elements of GF(2^255 - 19). When the compiler provides a 128-bit
+ *            integer type the elements are five 51-bit limbs in 64-bit
+ *            words (radix 2^51), so a multiplication is 25 64x64->128 bit
+ *            products. Otherwise sixteen 16-bit limbs in signed 64-bit words
+ *            are used, which only needs 32x32->64 bit products.
+ *
+ *            All routines run in constant time. Results of tc_fe25519_add
+ *            and tc_fe25519_sub are not fully reduced, they are valid
+ *            inputs to any other routine; tc_fe25519_tobytes produces the
+ *            canonical encoding.
+ *
+ *  Security: These are building blocks, use x25519.h for key agreement.
+ */
+
+#ifndef __TC_CURVE25519_H__
+#define __TC_CURVE25519_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size in bytes of an encoded field element */
+#define TC_FE25519_BYTES 32
+
+#if defined(__SIZEOF_INT128__)
+#define TC_FE25519_LIMBS 5
+typedef struct {
+	uint64_t v[TC_FE25519_LIMBS];
+} tc_fe25519;
+#else
+#define TC_FE25519_LIMBS 16
+typedef struct {
+	int64_t v[TC_FE25519_LIMBS];
+} tc_fe25519;
+#endif
+
+/* h = 0 */
+void tc_fe25519_0(tc_fe25519 *h);
+
+/* h = 1 */
+void tc_fe25519_1(tc_fe25519 *h);
+
+/* h = f + g */
+void tc_fe25519_add(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g);
+
+/* h = f - g */
+void tc_fe25519_sub(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g);
+
+/* h = f * g */
+void tc_fe25519_mul(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g);
+
+/* h = f^2 */
+void tc_fe25519_sq(tc_fe25519 *h, const tc_fe25519 *f);
+
+/* h = -f */
+void tc_fe25519_neg(tc_fe25519 *h, const tc_fe25519 *f);
+
+/* h = f * n, for a small constant n < 2^20 */
+void tc_fe25519_mul_small(tc_fe25519 *h, const tc_fe25519 *f, uint32_t n);
+
+/* h = f^(p - 2) = 1 / f, h = 0 when f = 0 */
+void tc_fe25519_invert(tc_fe25519 *h, const tc_fe25519 *f);
+
+/* h = f^((p - 5) / 8), used for square roots */
+void tc_fe25519_pow22523(tc_fe25519 *h, const tc_fe25519 *f);
+
+/* swaps f and g when b == 1, leaves them when b == 0 */
+void tc_fe25519_cswap(tc_fe25519 *f, tc_fe25519 *g, unsigned int b);
+
+/* h = f, the top bit of s is ignored */
+void tc_fe25519_frombytes(tc_fe25519 *h, const uint8_t *s);
+
+/* s = canonical little-endian encoding of f */
+void tc_fe25519_tobytes(uint8_t *s, const tc_fe25519 *f);
+
+/* returns 1 if f = 0, 0 otherwise */
+int tc_fe25519_iszero(const tc_fe25519 *f);
+
+/* returns the low bit of the canonical encoding of f, the Ed25519 sign bit */
+int tc_fe25519_isnegative(const tc_fe25519 *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TC_CURVE25519_H__ */
@@ -117,12 +117,26 @@ struct uECC_Curve_t {
   uECC_word_t n[NUM_ECC_WORDS];
   uECC_word_t G[NUM_ECC_WORDS * 2];
   uECC_word_t b[NUM_ECC_WORDS];
+  /* R^2 mod p with R = 2^(32 * num_words), converts into the Montgomery domain */
+  uECC_word_t R2[NUM_ECC_WORDS];
+  /* floor(2^(64 * num_words) / n), Barrett constant for reductions mod n */
+  uECC_word_t mu_n[NUM_ECC_WORDS + 1];
   void (*double_jacobian)(uECC_word_t * X1, uECC_word_t * Y1, uECC_word_t * Z1,
 	uECC_Curve curve);
   void (*x_side)(uECC_word_t *result, const uECC_word_t *x, uECC_Curve curve);
   void (*mmod_fast)(uECC_word_t *result, uECC_word_t *product);
+  void (*mont_mult)(uECC_word_t *result, const uECC_word_t *left,
+	const uECC_word_t *right);
+  void (*mont_square)(uECC_word_t *result, const uECC_word_t *left);
 };
 
+/*
+ * Point arithmetic (double_jacobian, apply_z, XYcZ_add) works on coordinates
+ * in the Montgomery domain, x R mod p, so every field multiplication is a
+ * single multiply-and-reduce. EccPoint_mult converts at its edges, callers
+ * of the point routines use uECC_vli_toMont and uECC_vli_fromMont.
+ */
+
 /*
  * @brief computes doubling of point ion jacobian coordinates, in place.
  * @param X1 IN/OUT -- x coordinate
@@ -150,6 +164,20 @@ void x_side_default(uECC_word_t *result, const uECC_word_t *x,
  */
 void vli_mmod_fast_secp256r1(unsigned int *result, unsigned int *product);
 
+/*
+ * @brief Computes result = left * right / R % curve_p, R = 2^256
+ * @param result OUT -- Montgomery product, may alias left or right
+ * @param left IN -- factor, < curve_p
+ * @param right IN -- factor, < curve_p
+ */
+void vli_mont_mult_secp256r1(unsigned int *result, const unsigned int *left,
+			     const unsigned int *right);
+
+/*
+ * @brief Computes result = left^2 / R % curve_p, R = 2^256
+ */
+void vli_mont_square_secp256r1(unsigned int *result, const unsigned int *left);
+
 /* Bytes to words ordering: */
 #define BYTES_TO_WORDS_8(a, b, c, d, e, f, g, h) 0x##d##c##b##a, 0x##h##g##f##e
 #define BYTES_TO_WORDS_4(a, b, c, d) 0x##d##c##b##a
@@ -186,10 +214,23 @@ static const struct uECC_Curve_t curve_secp256r1 = {
                 BYTES_TO_WORDS_8(F6, B0, 53, CC, B0, 06, 1D, 65),
                 BYTES_TO_WORDS_8(BC, 86, 98, 76, 55, BD, EB, B3),
                 BYTES_TO_WORDS_8(E7, 93, 3A, AA, D8, 35, C6, 5A)
+	}, {
+		BYTES_TO_WORDS_8(03, 00, 00, 00, 00, 00, 00, 00),
+		BYTES_TO_WORDS_8(FF, FF, FF, FF, FB, FF, FF, FF),
+		BYTES_TO_WORDS_8(FE, FF, FF, FF, FF, FF, FF, FF),
+		BYTES_TO_WORDS_8(FD, FF, FF, FF, 04, 00, 00, 00)
+	}, {
+		BYTES_TO_WORDS_8(FE, 9B, DF, EE, 85, FD, 2F, 01),
+		BYTES_TO_WORDS_8(21, 6C, 1A, DF, 52, 05, 19, 43),
+		BYTES_TO_WORDS_8(FF, FF, FF, FF, FE, FF, FF, FF),
+		BYTES_TO_WORDS_8(FF, FF, FF, FF, 00, 00, 00, 00),
+		BYTES_TO_WORDS_4(01, 00, 00, 00)
 	},
         &double_jacobian_default,
         &x_side_default,
-        &vli_mmod_fast_secp256r1
+        &vli_mmod_fast_secp256r1,
+        &vli_mont_mult_secp256r1,
+        &vli_mont_square_secp256r1
 };
 
 uECC_Curve uECC_secp256r1(void);
@@ -242,6 +283,13 @@ void uECC_set_rng(uECC_RNG_Function rng_function);
  */
 uECC_RNG_Function uECC_get_rng(void);
 
+/* uECC_pool_lock_fn type
+ * Lock and unlock callbacks of the precomputation pools (struct
+ * uECC_presign_pool and struct uECC_ephemeral_pool), 'ctx' is the pointer
+ * given when the pool was initialized.
+ */
+typedef void (*uECC_pool_lock_fn)(void *ctx);
+
 /*
  * @brief computes the size of a private key for the curve in bytes.
  * @param curve IN -- elliptic curve
@@ -398,6 +446,25 @@ uECC_word_t uECC_vli_testBit(const uECC_word_t *vli, bitcount_t bit);
 void uECC_vli_mmod(uECC_word_t *result, uECC_word_t *product,
 		   const uECC_word_t *mod, wordcount_t num_words);
 
+/*
+ * @brief Computes result = product % curve_n with Barrett reduction
+ * @param result OUT -- product % curve_n
+ * @param product IN -- value to be reduced mod curve_n, 2 * num_words long
+ * @param curve IN -- elliptic curve
+ */
+void uECC_vli_mmod_n(uECC_word_t *result, const uECC_word_t *product,
+		     uECC_Curve curve);
+
+/*
+ * @brief Computes modular product mod curve_n (using uECC_vli_mmod_n)
+ * @param result OUT -- (left * right) % curve_n
+ * @param left IN -- left term in product
+ * @param right IN -- right term in product
+ * @param curve IN -- elliptic curve
+ */
+void uECC_vli_modMult_n(uECC_word_t *result, const uECC_word_t *left,
+			const uECC_word_t *right, uECC_Curve curve);
+
 /*
  * @brief Computes modular product (using curve->mmod_fast)
  * @param result OUT -- (left * right) mod % curve_p
@@ -408,6 +475,43 @@ void uECC_vli_mmod(uECC_word_t *result, uECC_word_t *product,
 void uECC_vli_modMult_fast(uECC_word_t *result, const uECC_word_t *left,
 			   const uECC_word_t *right, uECC_Curve curve);
 
+/*
+ * @brief Computes Montgomery product (using curve->mont_mult)
+ * @param result OUT -- (left * right / R) % curve_p
+ * @param left IN -- left term in product, in the Montgomery domain
+ * @param right IN -- right term in product, in the Montgomery domain
+ * @param curve IN -- elliptic curve
+ */
+void uECC_vli_modMult_mont(uECC_word_t *result, const uECC_word_t *left,
+			   const uECC_word_t *right, uECC_Curve curve);
+
+/*
+ * @brief Converts into the Montgomery domain, result = x R % curve_p
+ * @param result OUT -- x in the Montgomery domain
+ * @param x IN -- value < curve_p
+ * @param curve IN -- elliptic curve
+ */
+void uECC_vli_toMont(uECC_word_t *result, const uECC_word_t *x,
+		     uECC_Curve curve);
+
+/*
+ * @brief Converts out of the Montgomery domain, result = x / R % curve_p
+ * @param result OUT -- x in the normal domain
+ * @param x IN -- value in the Montgomery domain
+ * @param curve IN -- elliptic curve
+ */
+void uECC_vli_fromMont(uECC_word_t *result, const uECC_word_t *x,
+		       uECC_Curve curve);
+
+/*
+ * @brief Computes the Montgomery domain inverse, (1 / x) R % curve_p
+ * @param result OUT -- inverse in the Montgomery domain, 0 if x = 0
+ * @param x IN -- value in the Montgomery domain
+ * @param curve IN -- elliptic curve
+ */
+void uECC_vli_modInv_mont(uECC_word_t *result, const uECC_word_t *x,
+			  uECC_Curve curve);
+
 /*
  * @brief Computes result = left - right.
  * @note Can modify in place.
@@ -444,8 +548,10 @@ void uECC_vli_modMult(uECC_word_t *result, const uECC_word_t *left,
 
 /*
  * @brief Computes (1 / input) % mod
- * @note All VLIs are the same size.
- * @note See "Euclid's GCD to Montgomery Multiplication to the Great Divide"
+ * @note All VLIs are the same size, mod must be odd and at most 256 bits.
+ * @note Constant time (Bernstein-Yang safegcd) when the compiler provides a
+ * 128-bit integer type, otherwise see "Euclid's GCD to Montgomery
+ * Multiplication to the Great Divide"
  * @param result OUT -- (1 / input) % mod
  * @param input IN -- value to be modular inverted
  * @param mod IN -- mod
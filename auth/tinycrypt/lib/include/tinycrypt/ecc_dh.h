@@ -64,6 +64,10 @@
  *            uses curve NIST p-256.
  *
  *  Security: The curve NIST p-256 provides approximately 128 bits of security.
+ *
+ *  Usage:    For ECDHE handshakes keep a struct uECC_ephemeral_pool filled with
+ *            uECC_ephemeral_pool_fill() from an idle thread and get each
+ *            ephemeral key pair with uECC_ephemeral_pool_take().
  */
 
 #ifndef __TC_ECC_DH_H__
@@ -124,6 +128,82 @@ int uECC_make_key_with_d(uint8_t *p_public_key, uint8_t *p_private_key,
 int uECC_shared_secret(const uint8_t *p_public_key, const uint8_t *p_private_key,
 		       uint8_t *p_secret, uECC_Curve curve);
 
+/* number of key pairs a struct uECC_ephemeral_pool holds */
+#ifndef uECC_EPHEMERAL_POOL_SIZE
+#define uECC_EPHEMERAL_POOL_SIZE 8
+#endif
+
+/* a pregenerated ephemeral key pair */
+struct uECC_ephemeral_key {
+	uint8_t public_key[2 * NUM_ECC_BYTES];
+	uint8_t private_key[NUM_ECC_BYTES];
+};
+
+/*
+ * Pool of pregenerated ephemeral key pairs so the scalar multiplication of
+ * uECC_make_key() can run ahead of time, e.g. from an idle thread. Every key
+ * pair is handed out exactly once and wiped from the pool when taken. The
+ * lock callbacks are optional, they are needed when the pool is filled and
+ * used from different threads.
+ */
+struct uECC_ephemeral_pool {
+	struct uECC_ephemeral_key entries[uECC_EPHEMERAL_POOL_SIZE];
+	unsigned int count;
+	uECC_Curve curve;
+	uECC_pool_lock_fn lock;
+	uECC_pool_lock_fn unlock;
+	void *lock_ctx;
+};
+
+/**
+ * @brief Initialize an empty ephemeral key pool.
+ *
+ * @param pool OUT -- pool to initialize
+ * @param lock IN -- optional, called before the pool is accessed
+ * @param unlock IN -- optional, called after the pool is accessed
+ * @param lock_ctx IN -- passed to lock and unlock
+ */
+void uECC_ephemeral_pool_init(struct uECC_ephemeral_pool *pool,
+			      uECC_Curve curve, uECC_pool_lock_fn lock,
+			      uECC_pool_lock_fn unlock, void *lock_ctx);
+
+/**
+ * @brief Add key pairs to a pool.
+ * @return returns the number of key pairs added
+ *
+ * @param pool IN/OUT -- pool to fill
+ * @param max IN -- most key pairs to generate in this call
+ *
+ * @note The key generation runs without holding the pool lock.
+ */
+unsigned int uECC_ephemeral_pool_fill(struct uECC_ephemeral_pool *pool,
+				      unsigned int max);
+
+/**
+ * @brief Number of key pairs available in a pool.
+ */
+unsigned int uECC_ephemeral_pool_count(struct uECC_ephemeral_pool *pool);
+
+/**
+ * @brief Take an ephemeral key pair out of the pool.
+ * @return returns TC_CRYPTO_SUCCESS (1) if a key pair was returned
+ *         returns TC_CRYPTO_FAIL (0) if error while generating a key pair
+ *
+ * @param p_public_key OUT -- same as for uECC_make_key()
+ * @param p_private_key OUT -- same as for uECC_make_key(), wipe it once the
+ * shared secret is computed
+ *
+ * @note Falls back to uECC_make_key() when the pool is empty. The key pair is
+ * removed from the pool and wiped, it is never handed out twice.
+ */
+int uECC_ephemeral_pool_take(struct uECC_ephemeral_pool *pool,
+			     uint8_t *p_public_key, uint8_t *p_private_key);
+
+/**
+ * @brief Wipe all key pairs in a pool, e.g. before freeing it.
+ */
+void uECC_ephemeral_pool_clear(struct uECC_ephemeral_pool *pool);
+
 #ifdef __cplusplus
 }
 #endif
@@ -73,6 +73,9 @@
  *          - To verify a signature: Compute the hash of the signed data using
  *          the same hash as the signer and pass it to this function along with
  *          the signer's public key and the signature values (r and s).
+ *          - To sign with low latency: keep a struct uECC_presign_pool
+ *          filled with uECC_presign_pool_fill() from an idle thread and sign
+ *          with uECC_sign_pooled().
  */
 
 #ifndef __TC_ECC_DSA_H__
@@ -115,6 +118,109 @@ int uECC_sign_with_k(const uint8_t *private_key, const uint8_t *message_hash,
 		     uECC_Curve curve);
 #endif
 
+/* number of presignatures a struct uECC_presign_pool holds */
+#ifndef uECC_PRESIGN_POOL_SIZE
+#define uECC_PRESIGN_POOL_SIZE 8
+#endif
+
+/*
+ * The part of a signature that does not depend on the message or the key:
+ * r = x(kG) and k^-1 mod n. It is as secret as the private key and must be
+ * used for exactly one signature.
+ */
+struct uECC_presignature {
+	uECC_word_t r[NUM_ECC_WORDS];
+	uECC_word_t k_inv[NUM_ECC_WORDS];
+};
+
+/*
+ * Pool of presignatures so the scalar multiplication and the inversion of
+ * uECC_sign() can run ahead of time, e.g. from an idle thread, and signing
+ * only costs two modular multiplications. The lock callbacks are optional,
+ * they are needed when the pool is filled and used from different threads.
+ */
+struct uECC_presign_pool {
+	struct uECC_presignature entries[uECC_PRESIGN_POOL_SIZE];
+	unsigned int count;
+	uECC_Curve curve;
+	uECC_pool_lock_fn lock;
+	uECC_pool_lock_fn unlock;
+	void *lock_ctx;
+};
+
+/**
+ * @brief Compute a presignature, the offline half of uECC_sign().
+ * @return returns TC_CRYPTO_SUCCESS (1) if the presignature was computed
+ *         returns TC_CRYPTO_FAIL (0) if an error occurred.
+ *
+ * @param presig OUT -- presignature, use it once with uECC_sign_presigned()
+ *
+ * @warning A cryptographically-secure PRNG function must be set (using
+ * uECC_set_rng()) before calling uECC_presign().
+ */
+int uECC_presign(struct uECC_presignature *presig, uECC_Curve curve);
+
+/**
+ * @brief Finish an ECDSA signature from a presignature.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the signature generated successfully
+ *         returns TC_CRYPTO_FAIL (0) if an error occurred.
+ *
+ * @param presig IN/OUT -- presignature from uECC_presign(), wiped on return
+ *
+ * @note The other parameters are the same as for uECC_sign().
+ */
+int uECC_sign_presigned(const uint8_t *p_private_key,
+			const uint8_t *p_message_hash, unsigned p_hash_size,
+			struct uECC_presignature *presig, uint8_t *p_signature,
+			uECC_Curve curve);
+
+/**
+ * @brief Initialize an empty presignature pool.
+ *
+ * @param pool OUT -- pool to initialize
+ * @param lock IN -- optional, called before the pool is accessed
+ * @param unlock IN -- optional, called after the pool is accessed
+ * @param lock_ctx IN -- passed to lock and unlock
+ */
+void uECC_presign_pool_init(struct uECC_presign_pool *pool, uECC_Curve curve,
+			    uECC_pool_lock_fn lock, uECC_pool_lock_fn unlock,
+			    void *lock_ctx);
+
+/**
+ * @brief Add presignatures to a pool.
+ * @return returns the number of presignatures added
+ *
+ * @param pool IN/OUT -- pool to fill
+ * @param max IN -- most presignatures to compute in this call, so an idle
+ * thread can fill the pool in small steps
+ *
+ * @note The scalar multiplications run without holding the pool lock.
+ */
+unsigned int uECC_presign_pool_fill(struct uECC_presign_pool *pool,
+				    unsigned int max);
+
+/**
+ * @brief Number of presignatures available in a pool.
+ */
+unsigned int uECC_presign_pool_count(struct uECC_presign_pool *pool);
+
+/**
+ * @brief Generate an ECDSA signature using a presignature from the pool.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the signature generated successfully
+ *         returns TC_CRYPTO_FAIL (0) if an error occurred.
+ *
+ * @note Falls back to uECC_sign() when the pool is empty. The presignature
+ * is removed from the pool and wiped, it is never used twice.
+ */
+int uECC_sign_pooled(struct uECC_presign_pool *pool,
+		     const uint8_t *p_private_key, const uint8_t *p_message_hash,
+		     unsigned p_hash_size, uint8_t *p_signature);
+
+/**
+ * @brief Wipe all presignatures in a pool, e.g. before freeing it.
+ */
+void uECC_presign_pool_clear(struct uECC_presign_pool *pool);
+
 /**
  * @brief Verify an ECDSA signature.
  * @return returns TC_SUCCESS (1) if the signature is valid
@@ -132,6 +238,44 @@ int uECC_sign_with_k(const uint8_t *private_key, const uint8_t *message_hash,
 int uECC_verify(const uint8_t *p_public_key, const uint8_t *p_message_hash,
 		unsigned int p_hash_size, const uint8_t *p_signature, uECC_Curve curve);
 
+/*
+ * Per public key part of uECC_verify(): the key and the generator in the
+ * Montgomery domain and their sum for Shamir's trick. Verifiers checking
+ * many signatures from the same keys compute it once per key, which saves
+ * a modular inversion and the domain conversions on every verification.
+ */
+struct uECC_verify_table {
+	uECC_word_t public_key[NUM_ECC_WORDS * 2];
+	uECC_word_t G[NUM_ECC_WORDS * 2];
+	uECC_word_t sum[NUM_ECC_WORDS * 2];
+	uECC_Curve curve;
+};
+
+/**
+ * @brief Precompute the verify table of a public key.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the table was computed
+ *         returns TC_CRYPTO_FAIL (0) if the public key is not a valid point
+ *
+ * @param table OUT -- table for uECC_verify_with_table()
+ * @param p_public_key IN -- the signer's public key
+ */
+int uECC_verify_table_init(struct uECC_verify_table *table,
+			   const uint8_t *p_public_key, uECC_Curve curve);
+
+/**
+ * @brief Verify an ECDSA signature with a precomputed table.
+ * @return returns TC_SUCCESS (1) if the signature is valid
+ * 	   returns TC_FAIL (0) if the signature is invalid.
+ *
+ * @param table IN -- table of the signer's public key from
+ * uECC_verify_table_init()
+ *
+ * @note The other parameters are the same as for uECC_verify().
+ */
+int uECC_verify_with_table(const struct uECC_verify_table *table,
+			   const uint8_t *p_message_hash, unsigned p_hash_size,
+			   const uint8_t *p_signature);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,138 @@
+/* ed25519.h - TinyCrypt interface to Ed25519 signatures */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * @brief -- Interface to Ed25519 signatures.
+ *
+ *  Overview: Ed25519 is the Edwards-curve digital signature algorithm over
+ *            edwards25519 with SHA-512, defined in RFC 8032. It is an
+ *            alternative to ECDSA on NIST p-256 (ecc_dsa.h): signing is
+ *            deterministic, so it does not depend on the RNG, and
+ *            verification is a double scalar multiplication on a curve with
+ *            cheap, complete addition formulas.
+ *
+ *            tc_ed25519_verify_batch checks several signatures with a single
+ *            multi-scalar multiplication: the verification equations are
+ *            combined with random 128-bit coefficients so the 252 doublings
+ *            are shared by all of them.
+ *
+ *  Security: Ed25519 provides approximately 128 bits of security. Batch
+ *            verification uses the cofactored equation [8][S]B = [8]R +
+ *            [8][k]A while tc_ed25519_verify uses the cofactorless one,
+ *            they only disagree on signatures deliberately built from small
+ *            order components, which no honest signer produces.
+ *
+ *  Usage:    1) call tc_ed25519_make_key to create a key pair.
+ *
+ *            2) call tc_ed25519_sign to sign a message.
+ *
+ *            3) call tc_ed25519_verify or tc_ed25519_verify_batch to verify
+ *               signatures.
+ */
+
+#ifndef __TC_ED25519_H__
+#define __TC_ED25519_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size in bytes of private keys (the seed) and public keys */
+#define TC_ED25519_KEY_SIZE 32
+
+/* size in bytes of a signature */
+#define TC_ED25519_SIGNATURE_SIZE 64
+
+/*
+ * Number of signatures combined in one multi-scalar multiplication, larger
+ * batches are verified in chunks. The tables need about 2.6 KB of stack per
+ * signature with 64-bit limbs.
+ */
+#ifndef TC_ED25519_BATCH_MAX
+#define TC_ED25519_BATCH_MAX 8
+#endif
+
+/**
+ * @brief Create a public/private key pair.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the key pair was generated successfully
+ *         returns TC_CRYPTO_FAIL (0) if error while generating key pair
+ *
+ * @param public_key OUT -- TC_ED25519_KEY_SIZE byte public key
+ * @param private_key OUT -- TC_ED25519_KEY_SIZE byte private key
+ *
+ * @warning Uses the RNG set with uECC_set_rng(), a cryptographically-secure
+ * PRNG function must be set before calling tc_ed25519_make_key().
+ */
+int tc_ed25519_make_key(uint8_t *public_key, uint8_t *private_key);
+
+/**
+ * @brief Compute the public key of a private key.
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *         returns TC_CRYPTO_FAIL (0) if public_key or private_key is NULL
+ *
+ * @param public_key OUT -- TC_ED25519_KEY_SIZE byte public key
+ * @param private_key IN -- TC_ED25519_KEY_SIZE byte private key
+ */
+int tc_ed25519_public_key(uint8_t *public_key, const uint8_t *private_key);
+
+/**
+ * @brief Ed25519 signature generation.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the signature was generated
+ *         returns TC_CRYPTO_FAIL (0) otherwise
+ *
+ * @param private_key IN -- your private key
+ * @param public_key IN -- the matching public key
+ * @param message IN -- message to sign
+ * @param mlen IN -- message length in bytes
+ * @param signature OUT -- TC_ED25519_SIGNATURE_SIZE byte signature
+ */
+int tc_ed25519_sign(const uint8_t *private_key, const uint8_t *public_key,
+		    const uint8_t *message, unsigned int mlen,
+		    uint8_t *signature);
+
+/**
+ * @brief Ed25519 signature verification.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the signature is valid
+ *         returns TC_CRYPTO_FAIL (0) if the signature is invalid, the public
+ *         key does not decode or S is not reduced modulo the group order
+ *
+ * @param public_key IN -- the signer's public key
+ * @param message IN -- signed message
+ * @param mlen IN -- message length in bytes
+ * @param signature IN -- TC_ED25519_SIGNATURE_SIZE byte signature
+ */
+int tc_ed25519_verify(const uint8_t *public_key, const uint8_t *message,
+		      unsigned int mlen, const uint8_t *signature);
+
+/**
+ * @brief Ed25519 batch signature verification.
+ * @return returns TC_CRYPTO_SUCCESS (1) if every signature is valid
+ *         returns TC_CRYPTO_FAIL (0) if at least one is not, call
+ *         tc_ed25519_verify on each to find which
+ *
+ * @param public_keys IN -- n public keys
+ * @param messages IN -- n messages
+ * @param mlens IN -- n message lengths in bytes
+ * @param signatures IN -- n signatures
+ * @param n IN -- number of signatures
+ *
+ * @warning Uses the RNG set with uECC_set_rng() for the random coefficients.
+ */
+int tc_ed25519_verify_batch(const uint8_t *const *public_keys,
+			    const uint8_t *const *messages,
+			    const unsigned int *mlens,
+			    const uint8_t *const *signatures, unsigned int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TC_ED25519_H__ */
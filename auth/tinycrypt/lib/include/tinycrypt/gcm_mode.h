@@ -0,0 +1,175 @@
+/* gcm_mode.h - TinyCrypt interface to a GCM mode implementation */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * @brief Interface to a GCM mode implementation.
+ *
+ *  Overview: GCM (for "Galois/Counter Mode") mode is a NIST approved mode of
+ *            operation defined in SP 800-38D. It encrypts the payload with
+ *            AES in counter mode and authenticates the ciphertext and the
+ *            associated data with GHASH, a polynomial hash over GF(2^128).
+ *            Unlike CCM, which needs one AES call for the CBC-MAC and one for
+ *            the counter per block, GCM needs one AES call per block.
+ *
+ *            TinyCrypt GCM implementation accepts:
+ *
+ *            1) Both non-empty payload and associated data (it encrypts and
+ *            authenticates the payload and also authenticates the associated
+ *            data);
+ *            2) Non-empty payload and empty associated data (it encrypts and
+ *            authenticates the payload);
+ *            3) Non-empty associated data and empty payload (it degenerates to
+ *            an authentication mode on the associated data, aka GMAC).
+ *
+ *            GHASH uses the PCLMULQDQ carry-less multiply instruction when the
+ *            library is compiled with -mpclmul -mssse3, otherwise a portable
+ *            4-bit table (Shoup's method) built from the hash subkey by
+ *            tc_gcm_config.
+ *
+ *  Security: Only the 96-bit nonce recommended by SP 800-38D is supported.
+ *            The nonce must never be repeated under the same key, doing so
+ *            reveals the GHASH subkey and allows forgeries. The tag length
+ *            can be 12 to 16 bytes.
+ *
+ *  Requires: AES-128
+ *
+ *  Usage:    1) call tc_gcm_config to configure.
+ *
+ *            2) call tc_gcm_set_nonce to change the nonce for each message.
+ *
+ *            3) call tc_gcm_generation_encryption to encrypt data and
+ *               generate tag.
+ *
+ *            4) call tc_gcm_decryption_verification to verify tag and decrypt
+ *               data.
+ */
+
+#ifndef __TC_GCM_MODE_H__
+#define __TC_GCM_MODE_H__
+
+#include <tinycrypt/aes.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* nonce size in bytes, only the 96-bit nonce is supported */
+#define TC_GCM_NONCE_SIZE 12
+
+/* max tag size in bytes */
+#define TC_GCM_TAG_MAX_BYTES 16
+
+/* max payload size in bytes: (2^32 - 2) blocks, limited by unsigned int */
+#define TC_GCM_PAYLOAD_MAX_BYTES 0xfffffff0
+
+/* struct tc_gcm_mode_struct represents the state of a GCM computation */
+typedef struct tc_gcm_mode_struct {
+	TCAesKeySched_t sched; /* AES key schedule */
+	const uint8_t *nonce; /* nonce required by GCM */
+	unsigned int mlen; /* tag length in bytes */
+	uint8_t h[TC_AES_BLOCK_SIZE]; /* hash subkey H = E(K, 0^128) */
+	uint64_t hl[16]; /* 4-bit GHASH table, low halves of i * H */
+	uint64_t hh[16]; /* 4-bit GHASH table, high halves of i * H */
+} *TCGcmMode_t;
+
+/**
+ * @brief GCM configuration procedure
+ * Derives the hash subkey from the key schedule, so it only needs to be
+ * called again when the key changes.
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if:
+ *                c == NULL or
+ *                sched == NULL or
+ *                nonce == NULL or
+ *                nlen != TC_GCM_NONCE_SIZE or
+ *                mlen < 12 or mlen > 16
+ * @param c -- GCM state
+ * @param sched IN -- AES key schedule
+ * @param nonce IN - nonce
+ * @param nlen -- nonce length in bytes
+ * @param mlen -- tag length in bytes
+ */
+int tc_gcm_config(TCGcmMode_t c, TCAesKeySched_t sched, const uint8_t *nonce,
+		  unsigned int nlen, unsigned int mlen);
+
+/**
+ * @brief Sets the nonce for the next message without re-deriving the hash
+ *        subkey.
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if:
+ *                c == NULL or
+ *                nonce == NULL or
+ *                nlen != TC_GCM_NONCE_SIZE
+ * @param c -- GCM state, configured by tc_gcm_config
+ * @param nonce IN - nonce
+ * @param nlen -- nonce length in bytes
+ */
+int tc_gcm_set_nonce(TCGcmMode_t c, const uint8_t *nonce, unsigned int nlen);
+
+/**
+ * @brief GCM encryption and tag generation procedure
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *         returns TC_CRYPTO_FAIL (0) if:
+ *                out == NULL or
+ *                c == NULL or
+ *                ((plen > 0) and (payload == NULL)) or
+ *                ((alen > 0) and (associated_data == NULL)) or
+ *                (plen > TC_GCM_PAYLOAD_MAX_BYTES) or
+ *                (olen < plen + c->mlen)
+ *
+ * @param out OUT -- encrypted data followed by the tag
+ * @param olen IN -- output length in bytes
+ * @param associated_data IN -- associated data
+ * @param alen IN -- associated data length in bytes
+ * @param payload IN -- payload
+ * @param plen IN -- payload length in bytes
+ * @param c IN -- GCM state
+ *
+ * @note: out buffer should be at least (plen + c->mlen) bytes long.
+ */
+int tc_gcm_generation_encryption(uint8_t *out, unsigned int olen,
+				 const uint8_t *associated_data,
+				 unsigned int alen, const uint8_t *payload,
+				 unsigned int plen, TCGcmMode_t c);
+
+/**
+ * @brief GCM tag verification and decryption procedure
+ * The tag is verified before anything is decrypted, out is only written
+ * when the tag is valid.
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *         returns TC_CRYPTO_FAIL (0) if:
+ *                out == NULL or
+ *                c == NULL or
+ *                (payload == NULL) or
+ *                ((alen > 0) and (associated_data == NULL)) or
+ *                (plen < c->mlen) or
+ *                (olen < plen - c->mlen) or
+ *                the tag does not verify
+ *
+ * @param out OUT -- decrypted data
+ * @param olen IN -- output length in bytes
+ * @param associated_data IN -- associated data
+ * @param alen IN -- associated data length in bytes
+ * @param payload IN -- encrypted data followed by the tag
+ * @param plen IN -- payload length in bytes, including the tag
+ * @param c IN -- GCM state
+ *
+ * @note: out buffer should be at least (plen - c->mlen) bytes long.
+ */
+int tc_gcm_decryption_verification(uint8_t *out, unsigned int olen,
+				   const uint8_t *associated_data,
+				   unsigned int alen, const uint8_t *payload,
+				   unsigned int plen, TCGcmMode_t c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TC_GCM_MODE_H__ */
@@ -0,0 +1,106 @@
+/* hkdf.h - TinyCrypt interface to an HKDF-SHA256 implementation */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * @brief Interface to an HKDF-SHA256 implementation.
+ *
+ *  Overview:   HKDF is the HMAC based extract-and-expand key derivation
+ *              function specified in RFC 5869. The extract step concentrates
+ *              the entropy of the input keying material into a pseudorandom
+ *              key (PRK), the expand step derives any number of independent
+ *              keys from the PRK, each bound to its own 'info' label.
+ *
+ *  Security:   The derived keys are as strong as the input keying material,
+ *              up to 256 bits. Distinct 'info' labels give independent keys.
+ *
+ *  Requires:   HMAC-SHA256
+ *
+ *  Usage:      1) call tc_hkdf_extract to compute the PRK from the input
+ *              keying material and an optional salt.
+ *
+ *              2) call tc_hkdf_expand once per key to derive, or call
+ *              tc_hkdf to run both steps.
+ */
+
+#ifndef __TC_HKDF_H__
+#define __TC_HKDF_H__
+
+#include <tinycrypt/sha256.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size in bytes of the pseudorandom key produced by tc_hkdf_extract */
+#define TC_HKDF_PRK_SIZE (TC_SHA256_DIGEST_SIZE)
+
+/* largest output of one expand step, 255 HMAC blocks */
+#define TC_HKDF_MAX_OKM_SIZE (255 * TC_SHA256_DIGEST_SIZE)
+
+/**
+ *  @brief HKDF extract procedure
+ *  Computes prk = HMAC-SHA256(salt, ikm)
+ *  @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if:
+ *                prk == NULL or
+ *                ikm == NULL and ikm_len != 0 or
+ *                salt == NULL and salt_len != 0
+ *  @param prk OUT -- TC_HKDF_PRK_SIZE byte pseudorandom key
+ *  @param salt IN -- optional salt, when salt_len is 0 a string of
+ *                    TC_SHA256_DIGEST_SIZE zero bytes is used
+ *  @param salt_len IN -- salt size in bytes
+ *  @param ikm IN -- input keying material
+ *  @param ikm_len IN -- input keying material size in bytes
+ */
+int tc_hkdf_extract(uint8_t *prk, const uint8_t *salt, unsigned int salt_len,
+		    const uint8_t *ikm, unsigned int ikm_len);
+
+/**
+ *  @brief HKDF expand procedure
+ *  Derives okm_len bytes of output keying material from prk and info
+ *  @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if:
+ *                okm == NULL or
+ *                prk == NULL or
+ *                info == NULL and info_len != 0 or
+ *                okm_len == 0 or okm_len > TC_HKDF_MAX_OKM_SIZE
+ *  @param okm OUT -- output keying material
+ *  @param okm_len IN -- number of bytes to derive
+ *  @param prk IN -- TC_HKDF_PRK_SIZE byte pseudorandom key from
+ *                   tc_hkdf_extract
+ *  @param info IN -- context and application specific label
+ *  @param info_len IN -- info size in bytes
+ */
+int tc_hkdf_expand(uint8_t *okm, unsigned int okm_len, const uint8_t *prk,
+		   const uint8_t *info, unsigned int info_len);
+
+/**
+ *  @brief HKDF procedure
+ *  Runs tc_hkdf_extract followed by tc_hkdf_expand
+ *  @return returns TC_CRYPTO_SUCCESS (1)
+ *          returns TC_CRYPTO_FAIL (0) if either step fails
+ *  @param okm OUT -- output keying material
+ *  @param okm_len IN -- number of bytes to derive
+ *  @param salt IN -- optional salt
+ *  @param salt_len IN -- salt size in bytes
+ *  @param ikm IN -- input keying material
+ *  @param ikm_len IN -- input keying material size in bytes
+ *  @param info IN -- context and application specific label
+ *  @param info_len IN -- info size in bytes
+ */
+int tc_hkdf(uint8_t *okm, unsigned int okm_len,
+	    const uint8_t *salt, unsigned int salt_len,
+	    const uint8_t *ikm, unsigned int ikm_len,
+	    const uint8_t *info, unsigned int info_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TC_HKDF_H__ */
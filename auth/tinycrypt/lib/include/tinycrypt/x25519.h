@@ -0,0 +1,89 @@
+/* x25519.h - TinyCrypt interface to X25519 key agreement */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * @brief -- Interface to X25519 key agreement.
+ *
+ *  Overview: X25519 is the Diffie-Hellman function over Curve25519 defined in
+ *            RFC 7748. It is an alternative to EC-DH on NIST p-256
+ *            (ecc_dh.h): keys are 32 bytes, the Montgomery ladder only needs
+ *            the x-coordinate, and every operation runs in constant time
+ *            without the point validation p-256 requires. With 64-bit limbs
+ *            (see curve25519.h) a shared secret costs a fraction of a
+ *            uECC_shared_secret.
+ *
+ *  Security: Curve25519 provides approximately 128 bits of security.
+ *
+ *  Usage:    1) call tc_x25519_make_key to create a key pair.
+ *
+ *            2) exchange public keys with the peer.
+ *
+ *            3) call tc_x25519_shared_secret with the peer's public key.
+ */
+
+#ifndef __TC_X25519_H__
+#define __TC_X25519_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size in bytes of private keys, public keys and shared secrets */
+#define TC_X25519_KEY_SIZE 32
+
+/**
+ * @brief The X25519 function: multiplies the point with u-coordinate u by
+ * the clamped scalar.
+ * @return returns TC_CRYPTO_SUCCESS (1)
+ *         returns TC_CRYPTO_FAIL (0) if out, scalar or u is NULL
+ *
+ * @param out OUT -- TC_X25519_KEY_SIZE byte result
+ * @param scalar IN -- TC_X25519_KEY_SIZE byte scalar
+ * @param u IN -- TC_X25519_KEY_SIZE byte u-coordinate
+ */
+int tc_x25519(uint8_t *out, const uint8_t *scalar, const uint8_t *u);
+
+/**
+ * @brief Create a public/private key pair.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the key pair was generated successfully
+ *         returns TC_CRYPTO_FAIL (0) if error while generating key pair
+ *
+ * @param public_key OUT -- TC_X25519_KEY_SIZE byte public key
+ * @param private_key OUT -- TC_X25519_KEY_SIZE byte private key
+ *
+ * @warning Uses the RNG set with uECC_set_rng(), a cryptographically-secure
+ * PRNG function must be set before calling tc_x25519_make_key().
+ */
+int tc_x25519_make_key(uint8_t *public_key, uint8_t *private_key);
+
+/**
+ * @brief Compute a shared secret given your private key and someone else's
+ * public key.
+ * @return returns TC_CRYPTO_SUCCESS (1) if the shared secret was computed successfully
+ *         returns TC_CRYPTO_FAIL (0) otherwise, including when the peer's
+ *         public key is a low order point and the result is all zeros
+ *
+ * @param public_key IN -- The public key of the remote party.
+ * @param private_key IN -- Your private key.
+ * @param secret OUT -- TC_X25519_KEY_SIZE byte shared secret
+ *
+ * @warning It is recommended to use the output of tc_x25519_shared_secret() as
+ * the input of a Key Derivation Function in order to produce a
+ * cryptographically secure symmetric key.
+ */
+int tc_x25519_shared_secret(const uint8_t *public_key,
+			    const uint8_t *private_key, uint8_t *secret);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TC_X25519_H__ */
@@ -64,6 +64,11 @@ int tc_aes128_set_decrypt_key(TCAesKeySched_t s, const uint8_t *k)
 	return tc_aes128_set_encrypt_key(s, k);
 }
 
+int tc_aes256_set_decrypt_key(TCAesKeySched_t s, const uint8_t *k)
+{
+	return tc_aes256_set_encrypt_key(s, k);
+}
+
 #define mult8(a)(_double_byte(_double_byte(_double_byte(a))))
 #define mult9(a)(mult8(a)^(a))
 #define multb(a)(mult8(a)^_double_byte(a)^(a))
@@ -129,7 +134,7 @@ static inline void inv_shift_rows(uint8_t *s)
 int tc_aes_decrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 {
 	uint8_t state[Nk*Nb];
-	unsigned int i;
+	unsigned int i, nr;
 
 	if (out == (uint8_t *) 0) {
 		return TC_CRYPTO_FAIL;
@@ -139,11 +144,12 @@ int tc_aes_decrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 		return TC_CRYPTO_FAIL;
 	}
 
+	nr = tc_aes_rounds(s);
 	(void)_copy(state, sizeof(state), in, sizeof(state));
 
-	add_round_key(state, s->words + Nb*Nr);
+	add_round_key(state, s->words + Nb*nr);
 
-	for (i = Nr - 1; i > 0; --i) {
+	for (i = nr - 1; i > 0; --i) {
 		inv_shift_rows(state);
 		inv_sub_bytes(state);
 		add_round_key(state, s->words + Nb*i);
@@ -162,3 +168,141 @@ int tc_aes_decrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 
 	return TC_CRYPTO_SUCCESS;
 }
+
+#if defined(__AES__) && defined(__SSE2__)
+
+#include <wmmintrin.h>
+
+/*
+ * Loads round key r of the schedule in the byte order used by AESDEC, the
+ * schedule words are stored big endian as one 32-bit word per column.
+ */
+static inline __m128i load_round_key(const TCAesKeySched_t s, unsigned int r)
+{
+	uint8_t k[Nb*Nk];
+
+	_set(k, TC_ZERO_BYTE, sizeof(k));
+	add_round_key(k, s->words + Nb*r);
+
+	return _mm_loadu_si128((const __m128i *) k);
+}
+
+int tc_aes_decrypt_blocks(uint8_t *out, const uint8_t *in,
+			  unsigned int nblocks, const TCAesKeySched_t s)
+{
+	__m128i dk[TC_AES256_NR + 1];
+	__m128i b[TC_AES_PARALLEL_BLOCKS];
+	unsigned int i, j, n, nr;
+
+	if (out == (uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (in == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (s == (TCAesKeySched_t) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (nblocks == 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* AESDEC implements the equivalent inverse cipher, which needs the
+	 * inner round keys passed through InvMixColumns. */
+	nr = tc_aes_rounds(s);
+	dk[0] = load_round_key(s, nr);
+	for (i = 1; i < nr; ++i) {
+		dk[i] = _mm_aesimc_si128(load_round_key(s, nr - i));
+	}
+	dk[nr] = load_round_key(s, 0);
+
+	while (nblocks > 0) {
+		n = (nblocks < TC_AES_PARALLEL_BLOCKS) ?
+		    nblocks : TC_AES_PARALLEL_BLOCKS;
+
+		for (j = 0; j < n; ++j) {
+			b[j] = _mm_loadu_si128((const __m128i *) in + j);
+			b[j] = _mm_xor_si128(b[j], dk[0]);
+		}
+		for (i = 1; i < nr; ++i) {
+			for (j = 0; j < n; ++j) {
+				b[j] = _mm_aesdec_si128(b[j], dk[i]);
+			}
+		}
+		for (j = 0; j < n; ++j) {
+			b[j] = _mm_aesdeclast_si128(b[j], dk[nr]);
+			_mm_storeu_si128((__m128i *) out + j, b[j]);
+		}
+
+		in += n * TC_AES_BLOCK_SIZE;
+		out += n * TC_AES_BLOCK_SIZE;
+		nblocks -= n;
+	}
+
+	/* zeroing out the expanded round keys and state */
+	_set_secure(dk, TC_ZERO_BYTE, sizeof(dk));
+	_set_secure(b, TC_ZERO_BYTE, sizeof(b));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+#else /* portable */
+
+int tc_aes_decrypt_blocks(uint8_t *out, const uint8_t *in,
+			  unsigned int nblocks, const TCAesKeySched_t s)
+{
+	uint8_t state[TC_AES_PARALLEL_BLOCKS][Nk*Nb];
+	unsigned int i, j, n, nr;
+
+	if (out == (uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (in == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (s == (TCAesKeySched_t) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (nblocks == 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	nr = tc_aes_rounds(s);
+
+	while (nblocks > 0) {
+		n = (nblocks < TC_AES_PARALLEL_BLOCKS) ?
+		    nblocks : TC_AES_PARALLEL_BLOCKS;
+
+		(void)_copy(state[0], sizeof(state), in, n * TC_AES_BLOCK_SIZE);
+
+		/* Run each round across all blocks so the round key and the
+		 * lookup tables stay hot and the blocks' independent byte
+		 * operations can overlap. */
+		for (j = 0; j < n; ++j) {
+			add_round_key(state[j], s->words + Nb*nr);
+		}
+
+		for (i = nr - 1; i > 0; --i) {
+			for (j = 0; j < n; ++j) {
+				inv_shift_rows(state[j]);
+				inv_sub_bytes(state[j]);
+				add_round_key(state[j], s->words + Nb*i);
+				inv_mix_columns(state[j]);
+			}
+		}
+
+		for (j = 0; j < n; ++j) {
+			inv_shift_rows(state[j]);
+			inv_sub_bytes(state[j]);
+			add_round_key(state[j], s->words);
+		}
+
+		(void)_copy(out, n * TC_AES_BLOCK_SIZE, state[0],
+			    n * TC_AES_BLOCK_SIZE);
+
+		in += n * TC_AES_BLOCK_SIZE;
+		out += n * TC_AES_BLOCK_SIZE;
+		nblocks -= n;
+	}
+
+	/*zeroing out the state buffer */
+	_set(state, TC_ZERO_BYTE, sizeof(state));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+#endif /* __AES__ */
@@ -67,7 +67,13 @@ static inline unsigned int rotword(unsigned int a)
 #define subbyte(a, o)(sbox[((a) >> (o))&0xff] << (o))
 #define subword(a)(subbyte(a, 24)|subbyte(a, 16)|subbyte(a, 8)|subbyte(a, 0))
 
-int tc_aes128_set_encrypt_key(TCAesKeySched_t s, const uint8_t *k)
+/*
+ * FIPS 197 key expansion for a key of nk 32-bit words and nr rounds. The
+ * words past the last round key are zeroed so a schedule's contents only
+ * depend on the key.
+ */
+static void expand_key(TCAesKeySched_t s, const uint8_t *k, unsigned int nk,
+		       unsigned int nr)
 {
 	const unsigned int rconst[11] = {
 		0x00000000, 0x01000000, 0x02000000, 0x04000000, 0x08000000, 0x10000000,
@@ -76,25 +82,51 @@ int tc_aes128_set_encrypt_key(TCAesKeySched_t s, const uint8_t *k)
 	unsigned int i;
 	unsigned int t;
 
+	for (i = 0; i < nk; ++i) {
+		s->words[i] = (k[Nb*i]<<24) | (k[Nb*i+1]<<16) |
+			      (k[Nb*i+2]<<8) | (k[Nb*i+3]);
+	}
+
+	for (; i < (Nb * (nr + 1)); ++i) {
+		t = s->words[i-1];
+		if ((i % nk) == 0) {
+			t = subword(rotword(t)) ^ rconst[i/nk];
+		} else if (nk > 6 && (i % nk) == 4) {
+			t = subword(t);
+		}
+		s->words[i] = s->words[i-nk] ^ t;
+	}
+
+	for (; i < (Nb * (TC_AES256_NR + 1)); ++i) {
+		s->words[i] = 0;
+	}
+
+	s->rounds = nr;
+}
+
+int tc_aes128_set_encrypt_key(TCAesKeySched_t s, const uint8_t *k)
+{
 	if (s == (TCAesKeySched_t) 0) {
 		return TC_CRYPTO_FAIL;
 	} else if (k == (const uint8_t *) 0) {
 		return TC_CRYPTO_FAIL;
 	}
 
-	for (i = 0; i < Nk; ++i) {
-		s->words[i] = (k[Nb*i]<<24) | (k[Nb*i+1]<<16) |
-			      (k[Nb*i+2]<<8) | (k[Nb*i+3]);
-	}
+	expand_key(s, k, Nk, Nr);
 
-	for (; i < (Nb * (Nr + 1)); ++i) {
-		t = s->words[i-1];
-		if ((i % Nk) == 0) {
-			t = subword(rotword(t)) ^ rconst[i/Nk];
-		}
-		s->words[i] = s->words[i-Nk] ^ t;
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_aes256_set_encrypt_key(TCAesKeySched_t s, const uint8_t *k)
+{
+	if (s == (TCAesKeySched_t) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (k == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
 	}
 
+	expand_key(s, k, TC_AES256_NK, TC_AES256_NR);
+
 	return TC_CRYPTO_SUCCESS;
 }
 
@@ -158,7 +190,7 @@ static inline void shift_rows(uint8_t *s)
 int tc_aes_encrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 {
 	uint8_t state[Nk*Nb];
-	unsigned int i;
+	unsigned int i, nr;
 
 	if (out == (uint8_t *) 0) {
 		return TC_CRYPTO_FAIL;
@@ -168,10 +200,11 @@ int tc_aes_encrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 		return TC_CRYPTO_FAIL;
 	}
 
+	nr = tc_aes_rounds(s);
 	(void)_copy(state, sizeof(state), in, sizeof(state));
 	add_round_key(state, s->words);
 
-	for (i = 0; i < (Nr - 1); ++i) {
+	for (i = 0; i < (nr - 1); ++i) {
 		sub_bytes(state);
 		shift_rows(state);
 		mix_columns(state);
@@ -189,3 +222,225 @@ int tc_aes_encrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 
 	return TC_CRYPTO_SUCCESS;
 }
+
+#if defined(__AES__) && defined(__SSE2__)
+
+#include <wmmintrin.h>
+
+int tc_aes_encrypt_blocks(uint8_t *out, const uint8_t *in,
+			  unsigned int nblocks, const TCAesKeySched_t s)
+{
+	uint8_t k[Nb*Nk];
+	__m128i rk[TC_AES256_NR + 1];
+	__m128i b[TC_AES_PARALLEL_BLOCKS];
+	unsigned int i, j, n, nr;
+
+	if (out == (uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (in == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (s == (TCAesKeySched_t) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (nblocks == 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	nr = tc_aes_rounds(s);
+
+	/* the schedule words are big endian, one 32-bit word per column */
+	for (i = 0; i <= nr; ++i) {
+		_set(k, TC_ZERO_BYTE, sizeof(k));
+		add_round_key(k, s->words + Nb*i);
+		rk[i] = _mm_loadu_si128((const __m128i *) k);
+	}
+
+	while (nblocks > 0) {
+		n = (nblocks < TC_AES_PARALLEL_BLOCKS) ?
+		    nblocks : TC_AES_PARALLEL_BLOCKS;
+
+		for (j = 0; j < n; ++j) {
+			b[j] = _mm_loadu_si128((const __m128i *) in + j);
+			b[j] = _mm_xor_si128(b[j], rk[0]);
+		}
+		for (i = 1; i < nr; ++i) {
+			for (j = 0; j < n; ++j) {
+				b[j] = _mm_aesenc_si128(b[j], rk[i]);
+			}
+		}
+		for (j = 0; j < n; ++j) {
+			b[j] = _mm_aesenclast_si128(b[j], rk[nr]);
+			_mm_storeu_si128((__m128i *) out + j, b[j]);
+		}
+
+		in += n * TC_AES_BLOCK_SIZE;
+		out += n * TC_AES_BLOCK_SIZE;
+		nblocks -= n;
+	}
+
+	/* zeroing out the expanded round keys and state */
+	_set_secure(k, TC_ZERO_BYTE, sizeof(k));
+	_set_secure(rk, TC_ZERO_BYTE, sizeof(rk));
+	_set_secure(b, TC_ZERO_BYTE, sizeof(b));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+#else /* portable */
+
+int tc_aes_encrypt_blocks(uint8_t *out, const uint8_t *in,
+			  unsigned int nblocks, const TCAesKeySched_t s)
+{
+	uint8_t state[TC_AES_PARALLEL_BLOCKS][Nk*Nb];
+	unsigned int i, j, n, nr;
+
+	if (out == (uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (in == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (s == (TCAesKeySched_t) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (nblocks == 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	nr = tc_aes_rounds(s);
+
+	while (nblocks > 0) {
+		n = (nblocks < TC_AES_PARALLEL_BLOCKS) ?
+		    nblocks : TC_AES_PARALLEL_BLOCKS;
+
+		(void)_copy(state[0], sizeof(state), in, n * TC_AES_BLOCK_SIZE);
+
+		/* round-major order, see tc_aes_decrypt_blocks */
+		for (j = 0; j < n; ++j) {
+			add_round_key(state[j], s->words);
+		}
+
+		for (i = 0; i < (nr - 1); ++i) {
+			for (j = 0; j < n; ++j) {
+				sub_bytes(state[j]);
+				shift_rows(state[j]);
+				mix_columns(state[j]);
+				add_round_key(state[j], s->words + Nb*(i+1));
+			}
+		}
+
+		for (j = 0; j < n; ++j) {
+			sub_bytes(state[j]);
+			shift_rows(state[j]);
+			add_round_key(state[j], s->words + Nb*(i+1));
+		}
+
+		(void)_copy(out, n * TC_AES_BLOCK_SIZE, state[0],
+			    n * TC_AES_BLOCK_SIZE);
+
+		in += n * TC_AES_BLOCK_SIZE;
+		out += n * TC_AES_BLOCK_SIZE;
+		nblocks -= n;
+	}
+
+	/* zeroing out the state buffer */
+	_set(state, TC_ZERO_BYTE, sizeof(state));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+#endif /* __AES__ */
+
+/* FNV-1a, only used to pick candidate entries, matches compare the key */
+static uint32_t key_hash(const uint8_t *k, unsigned int keylen)
+{
+	uint32_t h = 2166136261U ^ keylen;
+	unsigned int i;
+
+	for (i = 0; i < keylen; ++i) {
+		h = (h ^ k[i]) * 16777619U;
+	}
+
+	return h;
+}
+
+void tc_aes_sched_cache_init(struct tc_aes_sched_cache *c,
+			     tc_aes_cache_lock_fn lock,
+			     tc_aes_cache_lock_fn unlock, void *lock_ctx)
+{
+	_set(c, TC_ZERO_BYTE, sizeof(*c));
+	c->lock = lock;
+	c->unlock = unlock;
+	c->lock_ctx = lock_ctx;
+}
+
+int tc_aes_sched_cache_get(struct tc_aes_sched_cache *c, TCAesKeySched_t s,
+			   const uint8_t *k, unsigned int keylen)
+{
+	struct tc_aes_sched_cache_entry *e;
+	struct tc_aes_sched_cache_entry *victim;
+	uint32_t h;
+	unsigned int i;
+
+	if (c == (struct tc_aes_sched_cache *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (s == (TCAesKeySched_t) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (k == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (keylen != TC_AES_KEY_SIZE && keylen != TC_AES256_KEY_SIZE) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	h = key_hash(k, keylen);
+
+	if (c->lock) {
+		c->lock(c->lock_ctx);
+	}
+
+	victim = &c->entries[0];
+	for (i = 0; i < TC_AES_SCHED_CACHE_SIZE; ++i) {
+		e = &c->entries[i];
+		if (e->keylen == keylen && e->hash == h &&
+		    _compare(e->key, k, keylen) == 0) {
+			break;
+		}
+		/* unused entries have last_use 0 and are replaced first */
+		if (e->last_use < victim->last_use) {
+			victim = e;
+		}
+	}
+
+	if (i == TC_AES_SCHED_CACHE_SIZE) {
+		e = victim;
+		if (keylen == TC_AES256_KEY_SIZE) {
+			expand_key(&e->sched, k, TC_AES256_NK, TC_AES256_NR);
+		} else {
+			expand_key(&e->sched, k, Nk, Nr);
+		}
+		_set_secure(e->key, TC_ZERO_BYTE, sizeof(e->key));
+		(void)_copy(e->key, sizeof(e->key), k, keylen);
+		e->keylen = keylen;
+		e->hash = h;
+	}
+
+	e->last_use = ++c->clock;
+	(void)_copy((uint8_t *) s, sizeof(*s), (const uint8_t *) &e->sched,
+		    sizeof(e->sched));
+
+	if (c->unlock) {
+		c->unlock(c->lock_ctx);
+	}
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+void tc_aes_sched_cache_clear(struct tc_aes_sched_cache *c)
+{
+	if (c->lock) {
+		c->lock(c->lock_ctx);
+	}
+
+	_set_secure(c->entries, TC_ZERO_BYTE, sizeof(c->entries));
+	c->clock = 0;
+
+	if (c->unlock) {
+		c->unlock(c->lock_ctx);
+	}
+}
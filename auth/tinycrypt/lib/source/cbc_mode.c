@@ -79,9 +79,9 @@ int tc_cbc_mode_decrypt(uint8_t *out, unsigned int outlen, const uint8_t *in,
 			    const TCAesKeySched_t sched)
 {
 
-	uint8_t buffer[TC_AES_BLOCK_SIZE];
+	uint8_t buffer[TC_AES_PARALLEL_BLOCKS * TC_AES_BLOCK_SIZE];
 	const uint8_t *p;
-	unsigned int n, m;
+	unsigned int n, m, len;
 
 	/* sanity check the inputs */
 	if (out == (uint8_t *) 0 ||
@@ -99,16 +99,29 @@ int tc_cbc_mode_decrypt(uint8_t *out, unsigned int outlen, const uint8_t *in,
 	 * Note that in == iv + ciphertext, i.e. the iv and the ciphertext are
 	 * contiguous. This allows for a very efficient decryption algorithm
 	 * that would not otherwise be possible.
+	 *
+	 * Unlike encryption, the block decryptions do not depend on each
+	 * other, so decrypt up to TC_AES_PARALLEL_BLOCKS blocks at once and
+	 * then apply the XOR chain with the previous ciphertext blocks.
 	 */
 	p = iv;
-	for (n = m = 0; n < outlen; ++n) {
-		if ((n % TC_AES_BLOCK_SIZE) == 0) {
-			(void)tc_aes_decrypt(buffer, in, sched);
-			in += TC_AES_BLOCK_SIZE;
-			m = 0;
+	for (n = 0; n < outlen; n += len) {
+		len = outlen - n;
+		if (len > sizeof(buffer)) {
+			len = sizeof(buffer);
+		}
+
+		(void)tc_aes_decrypt_blocks(buffer, in,
+					    len / TC_AES_BLOCK_SIZE, sched);
+		in += len;
+
+		for (m = 0; m < len; ++m) {
+			*out++ = buffer[m] ^ *p++;
 		}
-		*out++ = buffer[m++] ^ *p++;
 	}
 
+	/* zeroing out the plaintext buffer */
+	_set(buffer, TC_ZERO_BYTE, sizeof(buffer));
+
 	return TC_CRYPTO_SUCCESS;
 }
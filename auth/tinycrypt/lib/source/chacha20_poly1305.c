@@ -0,0 +1,710 @@
+/* chacha20_poly1305.c - TinyCrypt implementation of ChaCha20-Poly1305 */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <tinycrypt/chacha20_poly1305.h>
+#include <tinycrypt/constants.h>
+#include <tinycrypt/utils.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* "expand 32-byte k" */
+static const uint32_t sigma[4] = {
+	0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+};
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+	return ((uint32_t) p[0]) | ((uint32_t) p[1] << 8) |
+	       ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)(v);
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t rotl32(uint32_t v, unsigned int n)
+{
+	return (v << n) | (v >> (32 - n));
+}
+
+#define QUARTERROUND(a, b, c, d) \
+	do { \
+		a += b; d ^= a; d = rotl32(d, 16); \
+		c += d; b ^= c; b = rotl32(b, 12); \
+		a += b; d ^= a; d = rotl32(d, 8); \
+		c += d; b ^= c; b = rotl32(b, 7); \
+	} while (0)
+
+static void chacha20_init_state(uint32_t *st, const TCChaChaPolyMode_t c,
+				uint32_t counter)
+{
+	unsigned int i;
+
+	for (i = 0; i < 4; ++i) {
+		st[i] = sigma[i];
+	}
+	for (i = 0; i < 8; ++i) {
+		st[4 + i] = c->key[i];
+	}
+	st[12] = counter;
+	st[13] = get_le32(c->nonce);
+	st[14] = get_le32(c->nonce + 4);
+	st[15] = get_le32(c->nonce + 8);
+}
+
+/*
+ * Portable single block function, writes one 64 byte keystream block.
+ */
+static void chacha20_block(uint8_t *out, const uint32_t *st)
+{
+	uint32_t x[16];
+	unsigned int i;
+
+	for (i = 0; i < 16; ++i) {
+		x[i] = st[i];
+	}
+
+	for (i = 0; i < 10; ++i) {
+		/* column round */
+		QUARTERROUND(x[0], x[4], x[8], x[12]);
+		QUARTERROUND(x[1], x[5], x[9], x[13]);
+		QUARTERROUND(x[2], x[6], x[10], x[14]);
+		QUARTERROUND(x[3], x[7], x[11], x[15]);
+		/* diagonal round */
+		QUARTERROUND(x[0], x[5], x[10], x[15]);
+		QUARTERROUND(x[1], x[6], x[11], x[12]);
+		QUARTERROUND(x[2], x[7], x[8], x[13]);
+		QUARTERROUND(x[3], x[4], x[9], x[14]);
+	}
+
+	for (i = 0; i < 16; ++i) {
+		put_le32(out + 4 * i, x[i] + st[i]);
+	}
+
+	_set_secure(x, 0, sizeof(x));
+}
+
+#if defined(__SSE2__)
+
+#define ROTL128(v, n) \
+	_mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+#define QUARTERROUND128(a, b, c, d) \
+	do { \
+		a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ROTL128(d, 16); \
+		c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ROTL128(b, 12); \
+		a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ROTL128(d, 8); \
+		c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ROTL128(b, 7); \
+	} while (0)
+
+/*
+ * Encrypts 4 consecutive blocks. Each vector holds one state word of the
+ * 4 blocks, so the rounds need no shuffles; the keystream is transposed
+ * back to block order at the end.
+ */
+static void chacha20_4blocks(uint8_t *out, const uint8_t *in,
+			     const uint32_t *st)
+{
+	__m128i x[16], o[16];
+	unsigned int i;
+
+	for (i = 0; i < 16; ++i) {
+		o[i] = _mm_set1_epi32((int) st[i]);
+	}
+	o[12] = _mm_add_epi32(o[12], _mm_set_epi32(3, 2, 1, 0));
+
+	for (i = 0; i < 16; ++i) {
+		x[i] = o[i];
+	}
+
+	for (i = 0; i < 10; ++i) {
+		QUARTERROUND128(x[0], x[4], x[8], x[12]);
+		QUARTERROUND128(x[1], x[5], x[9], x[13]);
+		QUARTERROUND128(x[2], x[6], x[10], x[14]);
+		QUARTERROUND128(x[3], x[7], x[11], x[15]);
+		QUARTERROUND128(x[0], x[5], x[10], x[15]);
+		QUARTERROUND128(x[1], x[6], x[11], x[12]);
+		QUARTERROUND128(x[2], x[7], x[8], x[13]);
+		QUARTERROUND128(x[3], x[4], x[9], x[14]);
+	}
+
+	for (i = 0; i < 16; ++i) {
+		x[i] = _mm_add_epi32(x[i], o[i]);
+	}
+
+	/* transpose 4 words of 4 blocks at a time and xor with the input */
+	for (i = 0; i < 4; ++i) {
+		__m128i t0, t1, t2, t3, b[4];
+		unsigned int j;
+
+		t0 = _mm_unpacklo_epi32(x[4 * i], x[4 * i + 1]);
+		t1 = _mm_unpacklo_epi32(x[4 * i + 2], x[4 * i + 3]);
+		t2 = _mm_unpackhi_epi32(x[4 * i], x[4 * i + 1]);
+		t3 = _mm_unpackhi_epi32(x[4 * i + 2], x[4 * i + 3]);
+		b[0] = _mm_unpacklo_epi64(t0, t1);
+		b[1] = _mm_unpackhi_epi64(t0, t1);
+		b[2] = _mm_unpacklo_epi64(t2, t3);
+		b[3] = _mm_unpackhi_epi64(t2, t3);
+
+		for (j = 0; j < 4; ++j) {
+			const unsigned int off = j * TC_CHACHA20_BLOCK_SIZE + i * 16;
+			__m128i m = _mm_loadu_si128((const __m128i *)(in + off));
+
+			_mm_storeu_si128((__m128i *)(out + off),
+					 _mm_xor_si128(m, b[j]));
+		}
+	}
+}
+
+#endif /* __SSE2__ */
+
+#if defined(__AVX2__)
+
+#define ROTL256(v, n) \
+	_mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+
+#define QUARTERROUND256(a, b, c, d) \
+	do { \
+		a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = ROTL256(d, 16); \
+		c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL256(b, 12); \
+		a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = ROTL256(d, 8); \
+		c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL256(b, 7); \
+	} while (0)
+
+/*
+ * Encrypts 8 consecutive blocks, same layout as chacha20_4blocks. The
+ * unpack instructions work within 128-bit lanes, so after the transpose
+ * the low lane holds block j and the high lane block j + 4.
+ */
+static void chacha20_8blocks(uint8_t *out, const uint8_t *in,
+			     const uint32_t *st)
+{
+	__m256i x[16], o[16];
+	unsigned int i;
+
+	for (i = 0; i < 16; ++i) {
+		o[i] = _mm256_set1_epi32((int) st[i]);
+	}
+	o[12] = _mm256_add_epi32(o[12], _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+	for (i = 0; i < 16; ++i) {
+		x[i] = o[i];
+	}
+
+	for (i = 0; i < 10; ++i) {
+		QUARTERROUND256(x[0], x[4], x[8], x[12]);
+		QUARTERROUND256(x[1], x[5], x[9], x[13]);
+		QUARTERROUND256(x[2], x[6], x[10], x[14]);
+		QUARTERROUND256(x[3], x[7], x[11], x[15]);
+		QUARTERROUND256(x[0], x[5], x[10], x[15]);
+		QUARTERROUND256(x[1], x[6], x[11], x[12]);
+		QUARTERROUND256(x[2], x[7], x[8], x[13]);
+		QUARTERROUND256(x[3], x[4], x[9], x[14]);
+	}
+
+	for (i = 0; i < 16; ++i) {
+		x[i] = _mm256_add_epi32(x[i], o[i]);
+	}
+
+	for (i = 0; i < 4; ++i) {
+		__m256i t0, t1, t2, t3, b[4];
+		unsigned int j;
+
+		t0 = _mm256_unpacklo_epi32(x[4 * i], x[4 * i + 1]);
+		t1 = _mm256_unpacklo_epi32(x[4 * i + 2], x[4 * i + 3]);
+		t2 = _mm256_unpackhi_epi32(x[4 * i], x[4 * i + 1]);
+		t3 = _mm256_unpackhi_epi32(x[4 * i + 2], x[4 * i + 3]);
+		b[0] = _mm256_unpacklo_epi64(t0, t1);
+		b[1] = _mm256_unpackhi_epi64(t0, t1);
+		b[2] = _mm256_unpacklo_epi64(t2, t3);
+		b[3] = _mm256_unpackhi_epi64(t2, t3);
+
+		for (j = 0; j < 4; ++j) {
+			const unsigned int lo = j * TC_CHACHA20_BLOCK_SIZE + i * 16;
+			const unsigned int hi = lo + 4 * TC_CHACHA20_BLOCK_SIZE;
+			__m128i m;
+
+			m = _mm_loadu_si128((const __m128i *)(in + lo));
+			_mm_storeu_si128((__m128i *)(out + lo),
+					 _mm_xor_si128(m, _mm256_castsi256_si128(b[j])));
+			m = _mm_loadu_si128((const __m128i *)(in + hi));
+			_mm_storeu_si128((__m128i *)(out + hi),
+					 _mm_xor_si128(m, _mm256_extracti128_si256(b[j], 1)));
+		}
+	}
+}
+
+#endif /* __AVX2__ */
+
+/*
+ * Xors len bytes of in with the keystream starting at block counter.
+ */
+static void chacha20_xor(uint8_t *out, const uint8_t *in, unsigned int len,
+			 const TCChaChaPolyMode_t c, uint32_t counter)
+{
+	uint8_t ks[TC_CHACHA20_BLOCK_SIZE];
+	uint32_t st[16];
+	unsigned int i, n;
+
+	chacha20_init_state(st, c, counter);
+
+#if defined(__AVX2__)
+	while (len >= 8 * TC_CHACHA20_BLOCK_SIZE) {
+		chacha20_8blocks(out, in, st);
+		st[12] += 8;
+		in += 8 * TC_CHACHA20_BLOCK_SIZE;
+		out += 8 * TC_CHACHA20_BLOCK_SIZE;
+		len -= 8 * TC_CHACHA20_BLOCK_SIZE;
+	}
+#endif
+#if defined(__SSE2__)
+	while (len >= 4 * TC_CHACHA20_BLOCK_SIZE) {
+		chacha20_4blocks(out, in, st);
+		st[12] += 4;
+		in += 4 * TC_CHACHA20_BLOCK_SIZE;
+		out += 4 * TC_CHACHA20_BLOCK_SIZE;
+		len -= 4 * TC_CHACHA20_BLOCK_SIZE;
+	}
+#endif
+
+	while (len > 0) {
+		chacha20_block(ks, st);
+		st[12]++;
+
+		n = (len < sizeof(ks)) ? len : sizeof(ks);
+		for (i = 0; i < n; ++i) {
+			out[i] = in[i] ^ ks[i];
+		}
+
+		in += n;
+		out += n;
+		len -= n;
+	}
+
+	_set_secure(ks, 0, sizeof(ks));
+	_set_secure(st, 0, sizeof(st));
+}
+
+#if defined(__SIZEOF_INT128__)
+
+/* Poly1305 with three 44/44/42-bit limbs and 64x64->128 bit products */
+typedef unsigned __int128 uint128_t;
+
+#define MASK44 ((uint64_t) 0xfffffffffff)
+#define MASK42 ((uint64_t) 0x3ffffffffff)
+
+struct poly1305_state {
+	uint64_t r[3];
+	uint64_t h[3];
+	uint64_t pad[2];
+};
+
+static inline uint64_t get_le64(const uint8_t *p)
+{
+	return (uint64_t) get_le32(p) | ((uint64_t) get_le32(p + 4) << 32);
+}
+
+static void poly1305_init(struct poly1305_state *p, const uint8_t *key)
+{
+	uint64_t t0 = get_le64(key);
+	uint64_t t1 = get_le64(key + 8);
+
+	/* r &= 0xffffffc0ffffffc0ffffffc0fffffff */
+	p->r[0] = t0 & 0xffc0fffffff;
+	p->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+	p->r[2] = (t1 >> 24) & 0x00ffffffc0f;
+
+	p->h[0] = p->h[1] = p->h[2] = 0;
+
+	p->pad[0] = get_le64(key + 16);
+	p->pad[1] = get_le64(key + 24);
+}
+
+/*
+ * Absorbs len bytes, len is a multiple of 16 and every block gets the 2^128
+ * bit; the AEAD construction pads everything to whole blocks.
+ */
+static void poly1305_blocks(struct poly1305_state *p, const uint8_t *m,
+			    unsigned int len)
+{
+	const uint64_t r0 = p->r[0], r1 = p->r[1], r2 = p->r[2];
+	const uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+	uint64_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2];
+	uint128_t d0, d1, d2;
+	uint64_t c, t0, t1;
+
+	while (len >= 16) {
+		t0 = get_le64(m);
+		t1 = get_le64(m + 8);
+
+		h0 += t0 & MASK44;
+		h1 += ((t0 >> 44) | (t1 << 20)) & MASK44;
+		h2 += ((t1 >> 24) & MASK42) | ((uint64_t) 1 << 40);
+
+		/* h *= r, the limbs above 2^130 fold back multiplied by 5 */
+		d0 = (uint128_t) h0 * r0 + (uint128_t) h1 * s2 +
+		     (uint128_t) h2 * s1;
+		d1 = (uint128_t) h0 * r1 + (uint128_t) h1 * r0 +
+		     (uint128_t) h2 * s2;
+		d2 = (uint128_t) h0 * r2 + (uint128_t) h1 * r1 +
+		     (uint128_t) h2 * r0;
+
+		/* partial reduction mod 2^130 - 5 */
+		c = (uint64_t)(d0 >> 44); h0 = (uint64_t) d0 & MASK44;
+		d1 += c;
+		c = (uint64_t)(d1 >> 44); h1 = (uint64_t) d1 & MASK44;
+		d2 += c;
+		c = (uint64_t)(d2 >> 42); h2 = (uint64_t) d2 & MASK42;
+		h0 += c * 5;
+		c = h0 >> 44; h0 &= MASK44;
+		h1 += c;
+
+		m += 16;
+		len -= 16;
+	}
+
+	p->h[0] = h0;
+	p->h[1] = h1;
+	p->h[2] = h2;
+}
+
+static void poly1305_finish(struct poly1305_state *p, uint8_t *tag)
+{
+	uint64_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2];
+	uint64_t g0, g1, g2, c, mask;
+
+	/* fully carry h */
+	c = h1 >> 44; h1 &= MASK44;
+	h2 += c; c = h2 >> 42; h2 &= MASK42;
+	h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+	h1 += c; c = h1 >> 44; h1 &= MASK44;
+	h2 += c; c = h2 >> 42; h2 &= MASK42;
+	h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+	h1 += c;
+
+	/* g = h + -p = h - (2^130 - 5) */
+	g0 = h0 + 5; c = g0 >> 44; g0 &= MASK44;
+	g1 = h1 + c; c = g1 >> 44; g1 &= MASK44;
+	g2 = h2 + c - ((uint64_t) 1 << 42);
+
+	/* select h if h < p, or h - p if h >= p, without branching */
+	mask = (g2 >> 63) - 1;
+	g0 &= mask;
+	g1 &= mask;
+	g2 &= mask;
+	mask = ~mask;
+	h0 = (h0 & mask) | g0;
+	h1 = (h1 & mask) | g1;
+	h2 = (h2 & mask) | g2;
+
+	/* h = (h + pad) mod 2^128 */
+	h0 += p->pad[0] & MASK44; c = h0 >> 44; h0 &= MASK44;
+	h1 += (((p->pad[0] >> 44) | (p->pad[1] << 20)) & MASK44) + c;
+	c = h1 >> 44; h1 &= MASK44;
+	h2 += ((p->pad[1] >> 24) & MASK42) + c; h2 &= MASK42;
+
+	h0 = h0 | (h1 << 44);
+	h1 = (h1 >> 20) | (h2 << 24);
+
+	put_le32(tag, (uint32_t) h0);
+	put_le32(tag + 4, (uint32_t)(h0 >> 32));
+	put_le32(tag + 8, (uint32_t) h1);
+	put_le32(tag + 12, (uint32_t)(h1 >> 32));
+}
+
+#else /* no 128-bit integer type */
+
+/* Poly1305 with five 26-bit limbs and 32x32->64 bit products */
+#define MASK26 ((uint32_t) 0x3ffffff)
+
+struct poly1305_state {
+	uint32_t r[5];
+	uint32_t h[5];
+	uint32_t pad[4];
+};
+
+static void poly1305_init(struct poly1305_state *p, const uint8_t *key)
+{
+	/* r &= 0xffffffc0ffffffc0ffffffc0fffffff */
+	p->r[0] = (get_le32(key)) & 0x3ffffff;
+	p->r[1] = (get_le32(key + 3) >> 2) & 0x3ffff03;
+	p->r[2] = (get_le32(key + 6) >> 4) & 0x3ffc0ff;
+	p->r[3] = (get_le32(key + 9) >> 6) & 0x3f03fff;
+	p->r[4] = (get_le32(key + 12) >> 8) & 0x00fffff;
+
+	p->h[0] = p->h[1] = p->h[2] = p->h[3] = p->h[4] = 0;
+
+	p->pad[0] = get_le32(key + 16);
+	p->pad[1] = get_le32(key + 20);
+	p->pad[2] = get_le32(key + 24);
+	p->pad[3] = get_le32(key + 28);
+}
+
+static void poly1305_blocks(struct poly1305_state *p, const uint8_t *m,
+			    unsigned int len)
+{
+	const uint32_t r0 = p->r[0], r1 = p->r[1], r2 = p->r[2],
+		       r3 = p->r[3], r4 = p->r[4];
+	const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+	uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2],
+		 h3 = p->h[3], h4 = p->h[4];
+	uint64_t d0, d1, d2, d3, d4;
+	uint32_t c;
+
+	while (len >= 16) {
+		h0 += (get_le32(m)) & MASK26;
+		h1 += (get_le32(m + 3) >> 2) & MASK26;
+		h2 += (get_le32(m + 6) >> 4) & MASK26;
+		h3 += (get_le32(m + 9) >> 6) & MASK26;
+		h4 += (get_le32(m + 12) >> 8) | (1 << 24);
+
+		d0 = (uint64_t) h0 * r0 + (uint64_t) h1 * s4 +
+		     (uint64_t) h2 * s3 + (uint64_t) h3 * s2 +
+		     (uint64_t) h4 * s1;
+		d1 = (uint64_t) h0 * r1 + (uint64_t) h1 * r0 +
+		     (uint64_t) h2 * s4 + (uint64_t) h3 * s3 +
+		     (uint64_t) h4 * s2;
+		d2 = (uint64_t) h0 * r2 + (uint64_t) h1 * r1 +
+		     (uint64_t) h2 * r0 + (uint64_t) h3 * s4 +
+		     (uint64_t) h4 * s3;
+		d3 = (uint64_t) h0 * r3 + (uint64_t) h1 * r2 +
+		     (uint64_t) h2 * r1 + (uint64_t) h3 * r0 +
+		     (uint64_t) h4 * s4;
+		d4 = (uint64_t) h0 * r4 + (uint64_t) h1 * r3 +
+		     (uint64_t) h2 * r2 + (uint64_t) h3 * r1 +
+		     (uint64_t) h4 * r0;
+
+		c = (uint32_t)(d0 >> 26); h0 = (uint32_t) d0 & MASK26;
+		d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t) d1 & MASK26;
+		d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t) d2 & MASK26;
+		d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t) d3 & MASK26;
+		d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t) d4 & MASK26;
+		h0 += c * 5; c = h0 >> 26; h0 &= MASK26;
+		h1 += c;
+
+		m += 16;
+		len -= 16;
+	}
+
+	p->h[0] = h0;
+	p->h[1] = h1;
+	p->h[2] = h2;
+	p->h[3] = h3;
+	p->h[4] = h4;
+}
+
+static void poly1305_finish(struct poly1305_state *p, uint8_t *tag)
+{
+	uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2],
+		 h3 = p->h[3], h4 = p->h[4];
+	uint32_t g0, g1, g2, g3, g4, c, mask;
+	uint64_t f;
+
+	/* fully carry h */
+	c = h1 >> 26; h1 &= MASK26;
+	h2 += c; c = h2 >> 26; h2 &= MASK26;
+	h3 += c; c = h3 >> 26; h3 &= MASK26;
+	h4 += c; c = h4 >> 26; h4 &= MASK26;
+	h0 += c * 5; c = h0 >> 26; h0 &= MASK26;
+	h1 += c;
+
+	/* g = h + -p = h - (2^130 - 5) */
+	g0 = h0 + 5; c = g0 >> 26; g0 &= MASK26;
+	g1 = h1 + c; c = g1 >> 26; g1 &= MASK26;
+	g2 = h2 + c; c = g2 >> 26; g2 &= MASK26;
+	g3 = h3 + c; c = g3 >> 26; g3 &= MASK26;
+	g4 = h4 + c - (1 << 26);
+
+	/* select h if h < p, or h - p if h >= p, without branching */
+	mask = (g4 >> 31) - 1;
+	g0 &= mask;
+	g1 &= mask;
+	g2 &= mask;
+	g3 &= mask;
+	g4 &= mask;
+	mask = ~mask;
+	h0 = (h0 & mask) | g0;
+	h1 = (h1 & mask) | g1;
+	h2 = (h2 & mask) | g2;
+	h3 = (h3 & mask) | g3;
+	h4 = (h4 & mask) | g4;
+
+	/* h = h % 2^128 */
+	h0 = (h0) | (h1 << 26);
+	h1 = (h1 >> 6) | (h2 << 20);
+	h2 = (h2 >> 12) | (h3 << 14);
+	h3 = (h3 >> 18) | (h4 << 8);
+
+	/* h = (h + pad) mod 2^128 */
+	f = (uint64_t) h0 + p->pad[0]; h0 = (uint32_t) f;
+	f = (uint64_t) h1 + p->pad[1] + (f >> 32); h1 = (uint32_t) f;
+	f = (uint64_t) h2 + p->pad[2] + (f >> 32); h2 = (uint32_t) f;
+	f = (uint64_t) h3 + p->pad[3] + (f >> 32); h3 = (uint32_t) f;
+
+	put_le32(tag, h0);
+	put_le32(tag + 4, h1);
+	put_le32(tag + 8, h2);
+	put_le32(tag + 12, h3);
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/*
+ * Absorbs data zero padded to a multiple of 16 bytes.
+ */
+static void poly1305_update_padded(struct poly1305_state *p,
+				   const uint8_t *data, unsigned int len)
+{
+	uint8_t block[16];
+	unsigned int full = len & ~15u;
+
+	poly1305_blocks(p, data, full);
+
+	if (len > full) {
+		_set(block, 0, sizeof(block));
+		(void)_copy(block, sizeof(block), data + full, len - full);
+		poly1305_blocks(p, block, sizeof(block));
+	}
+}
+
+/*
+ * Computes the RFC 8439 tag over the associated data and the ciphertext.
+ */
+static void chacha20_poly1305_tag(uint8_t *tag, const uint8_t *associated_data,
+				  unsigned int alen, const uint8_t *ciphertext,
+				  unsigned int clen, const TCChaChaPolyMode_t c)
+{
+	struct poly1305_state p;
+	uint8_t block[TC_CHACHA20_BLOCK_SIZE];
+	uint32_t st[16];
+
+	/* the one-time Poly1305 key is the first half of keystream block 0 */
+	chacha20_init_state(st, c, 0);
+	chacha20_block(block, st);
+	poly1305_init(&p, block);
+
+	poly1305_update_padded(&p, associated_data, alen);
+	poly1305_update_padded(&p, ciphertext, clen);
+
+	/* lengths block: 64-bit little-endian byte counts */
+	_set(block, 0, 16);
+	put_le32(block, alen);
+	put_le32(block + 8, clen);
+	poly1305_blocks(&p, block, 16);
+
+	poly1305_finish(&p, tag);
+
+	_set_secure(&p, 0, sizeof(p));
+	_set_secure(block, 0, sizeof(block));
+	_set_secure(st, 0, sizeof(st));
+}
+
+int tc_chacha20_poly1305_config(TCChaChaPolyMode_t c, const uint8_t *key,
+				const uint8_t *nonce, unsigned int nlen)
+{
+	unsigned int i;
+
+	/* input sanity check: */
+	if (c == (TCChaChaPolyMode_t) 0 ||
+	    key == (const uint8_t *) 0 ||
+	    nonce == (const uint8_t *) 0 ||
+	    nlen != TC_CHACHA20_NONCE_SIZE) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	for (i = 0; i < TC_CHACHA20_KEY_SIZE / 4; ++i) {
+		c->key[i] = get_le32(key + 4 * i);
+	}
+	c->nonce = nonce;
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_chacha20_poly1305_set_nonce(TCChaChaPolyMode_t c, const uint8_t *nonce,
+				   unsigned int nlen)
+{
+	if (c == (TCChaChaPolyMode_t) 0 ||
+	    nonce == (const uint8_t *) 0 ||
+	    nlen != TC_CHACHA20_NONCE_SIZE) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	c->nonce = nonce;
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_chacha20_poly1305_generation_encryption(uint8_t *out, unsigned int olen,
+					       const uint8_t *associated_data,
+					       unsigned int alen,
+					       const uint8_t *payload,
+					       unsigned int plen,
+					       TCChaChaPolyMode_t c)
+{
+	/* input sanity check: */
+	if ((out == (uint8_t *) 0) ||
+	    (c == (TCChaChaPolyMode_t) 0) ||
+	    ((plen > 0) && (payload == (uint8_t *) 0)) ||
+	    ((alen > 0) && (associated_data == (uint8_t *) 0)) ||
+	    (olen < TC_POLY1305_TAG_SIZE) ||
+	    (plen > olen - TC_POLY1305_TAG_SIZE)) { /* invalid output buffer size */
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* ENCRYPTION, the payload keystream starts at block 1: */
+	chacha20_xor(out, payload, plen, c, 1);
+
+	/* GENERATING THE AUTHENTICATION TAG over the ciphertext: */
+	chacha20_poly1305_tag(out + plen, associated_data, alen, out, plen, c);
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_chacha20_poly1305_decryption_verification(uint8_t *out,
+						 unsigned int olen,
+						 const uint8_t *associated_data,
+						 unsigned int alen,
+						 const uint8_t *payload,
+						 unsigned int plen,
+						 TCChaChaPolyMode_t c)
+{
+	uint8_t tag[TC_POLY1305_TAG_SIZE];
+	unsigned int clen;
+
+	/* input sanity check: */
+	if ((out == (uint8_t *) 0) ||
+	    (c == (TCChaChaPolyMode_t) 0) ||
+	    (payload == (const uint8_t *) 0) ||
+	    ((alen > 0) && (associated_data == (uint8_t *) 0)) ||
+	    (plen < TC_POLY1305_TAG_SIZE) ||
+	    (olen < plen - TC_POLY1305_TAG_SIZE)) { /* invalid output buffer size */
+		return TC_CRYPTO_FAIL;
+	}
+
+	clen = plen - TC_POLY1305_TAG_SIZE;
+
+	/* VERIFYING THE AUTHENTICATION TAG before decrypting: */
+	chacha20_poly1305_tag(tag, associated_data, alen, payload, clen, c);
+
+	if (_compare(tag, payload + clen, TC_POLY1305_TAG_SIZE) != 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* DECRYPTION: */
+	chacha20_xor(out, payload, clen, c, 1);
+
+	return TC_CRYPTO_SUCCESS;
+}
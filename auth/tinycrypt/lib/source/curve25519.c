@@ -0,0 +1,474 @@
+/* curve25519.c - TinyCrypt implementation of arithmetic modulo 2^255 - 19 */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <tinycrypt/curve25519.h>
+#include <tinycrypt/utils.h>
+
+#if defined(__SIZEOF_INT128__)
+
+/* radix 2^51: f = v[0] + v[1] 2^51 + v[2] 2^102 + v[3] 2^153 + v[4] 2^204 */
+typedef unsigned __int128 uint128_t;
+
+#define MASK51 ((uint64_t) 0x7ffffffffffff)
+
+static inline uint64_t load_le64(const uint8_t *p)
+{
+	uint64_t v = 0;
+	int i;
+
+	for (i = 7; i >= 0; --i) {
+		v = (v << 8) | p[i];
+	}
+	return v;
+}
+
+static inline void store_le64(uint8_t *p, uint64_t v)
+{
+	unsigned int i;
+
+	for (i = 0; i < 8; ++i) {
+		p[i] = (uint8_t)(v >> (8 * i));
+	}
+}
+
+/*
+ * Carries the 128-bit column sums of a product back into 51-bit limbs,
+ * 2^255 wraps around as 19.
+ */
+static void fe_carry_wide(tc_fe25519 *h, uint128_t r0, uint128_t r1,
+			  uint128_t r2, uint128_t r3, uint128_t r4)
+{
+	uint128_t t;
+
+	r1 += (uint64_t)(r0 >> 51);
+	r2 += (uint64_t)(r1 >> 51);
+	r3 += (uint64_t)(r2 >> 51);
+	r4 += (uint64_t)(r3 >> 51);
+
+	t = ((uint64_t) r0 & MASK51) + (uint128_t)(uint64_t)(r4 >> 51) * 19;
+
+	h->v[0] = (uint64_t) t & MASK51;
+	h->v[1] = ((uint64_t) r1 & MASK51) + (uint64_t)(t >> 51);
+	h->v[2] = (uint64_t) r2 & MASK51;
+	h->v[3] = (uint64_t) r3 & MASK51;
+	h->v[4] = (uint64_t) r4 & MASK51;
+}
+
+void tc_fe25519_0(tc_fe25519 *h)
+{
+	_set(h, 0, sizeof(*h));
+}
+
+void tc_fe25519_1(tc_fe25519 *h)
+{
+	_set(h, 0, sizeof(*h));
+	h->v[0] = 1;
+}
+
+void tc_fe25519_add(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g)
+{
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		h->v[i] = f->v[i] + g->v[i];
+	}
+}
+
+void tc_fe25519_sub(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g)
+{
+	/* add 4p so the limbs stay positive for inputs below 2^53 */
+	uint64_t r0 = (f->v[0] + 0x1fffffffffffb4) - g->v[0];
+	uint64_t r1 = (f->v[1] + 0x1ffffffffffffc) - g->v[1];
+	uint64_t r2 = (f->v[2] + 0x1ffffffffffffc) - g->v[2];
+	uint64_t r3 = (f->v[3] + 0x1ffffffffffffc) - g->v[3];
+	uint64_t r4 = (f->v[4] + 0x1ffffffffffffc) - g->v[4];
+
+	r1 += r0 >> 51; r0 &= MASK51;
+	r2 += r1 >> 51; r1 &= MASK51;
+	r3 += r2 >> 51; r2 &= MASK51;
+	r4 += r3 >> 51; r3 &= MASK51;
+	r0 += (r4 >> 51) * 19; r4 &= MASK51;
+
+	h->v[0] = r0;
+	h->v[1] = r1;
+	h->v[2] = r2;
+	h->v[3] = r3;
+	h->v[4] = r4;
+}
+
+void tc_fe25519_mul(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g)
+{
+	const uint64_t f0 = f->v[0], f1 = f->v[1], f2 = f->v[2],
+		       f3 = f->v[3], f4 = f->v[4];
+	const uint64_t g0 = g->v[0], g1 = g->v[1], g2 = g->v[2],
+		       g3 = g->v[3], g4 = g->v[4];
+	const uint64_t g1_19 = g1 * 19, g2_19 = g2 * 19,
+		       g3_19 = g3 * 19, g4_19 = g4 * 19;
+	uint128_t r0, r1, r2, r3, r4;
+
+	r0 = (uint128_t) f0 * g0 + (uint128_t) f1 * g4_19 +
+	     (uint128_t) f2 * g3_19 + (uint128_t) f3 * g2_19 +
+	     (uint128_t) f4 * g1_19;
+	r1 = (uint128_t) f0 * g1 + (uint128_t) f1 * g0 +
+	     (uint128_t) f2 * g4_19 + (uint128_t) f3 * g3_19 +
+	     (uint128_t) f4 * g2_19;
+	r2 = (uint128_t) f0 * g2 + (uint128_t) f1 * g1 +
+	     (uint128_t) f2 * g0 + (uint128_t) f3 * g4_19 +
+	     (uint128_t) f4 * g3_19;
+	r3 = (uint128_t) f0 * g3 + (uint128_t) f1 * g2 +
+	     (uint128_t) f2 * g1 + (uint128_t) f3 * g0 +
+	     (uint128_t) f4 * g4_19;
+	r4 = (uint128_t) f0 * g4 + (uint128_t) f1 * g3 +
+	     (uint128_t) f2 * g2 + (uint128_t) f3 * g1 +
+	     (uint128_t) f4 * g0;
+
+	fe_carry_wide(h, r0, r1, r2, r3, r4);
+}
+
+void tc_fe25519_sq(tc_fe25519 *h, const tc_fe25519 *f)
+{
+	const uint64_t f0 = f->v[0], f1 = f->v[1], f2 = f->v[2],
+		       f3 = f->v[3], f4 = f->v[4];
+	const uint64_t f0_2 = f0 * 2, f1_2 = f1 * 2;
+	const uint64_t f3_19 = f3 * 19, f4_19 = f4 * 19;
+	uint128_t r0, r1, r2, r3, r4;
+
+	r0 = (uint128_t) f0 * f0 + (uint128_t) f1_2 * f4_19 +
+	     (uint128_t)(f2 * 2) * f3_19;
+	r1 = (uint128_t) f0_2 * f1 + (uint128_t)(f2 * 2) * f4_19 +
+	     (uint128_t) f3 * f3_19;
+	r2 = (uint128_t) f0_2 * f2 + (uint128_t) f1 * f1 +
+	     (uint128_t)(f3 * 2) * f4_19;
+	r3 = (uint128_t) f0_2 * f3 + (uint128_t) f1_2 * f2 +
+	     (uint128_t) f4 * f4_19;
+	r4 = (uint128_t) f0_2 * f4 + (uint128_t) f1_2 * f3 +
+	     (uint128_t) f2 * f2;
+
+	fe_carry_wide(h, r0, r1, r2, r3, r4);
+}
+
+void tc_fe25519_mul_small(tc_fe25519 *h, const tc_fe25519 *f, uint32_t n)
+{
+	fe_carry_wide(h, (uint128_t) f->v[0] * n, (uint128_t) f->v[1] * n,
+		      (uint128_t) f->v[2] * n, (uint128_t) f->v[3] * n,
+		      (uint128_t) f->v[4] * n);
+}
+
+void tc_fe25519_cswap(tc_fe25519 *f, tc_fe25519 *g, unsigned int b)
+{
+	const uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		uint64_t x = mask & (f->v[i] ^ g->v[i]);
+
+		f->v[i] ^= x;
+		g->v[i] ^= x;
+	}
+}
+
+void tc_fe25519_frombytes(tc_fe25519 *h, const uint8_t *s)
+{
+	h->v[0] = load_le64(s) & MASK51;
+	h->v[1] = (load_le64(s + 6) >> 3) & MASK51;
+	h->v[2] = (load_le64(s + 12) >> 6) & MASK51;
+	h->v[3] = (load_le64(s + 19) >> 1) & MASK51;
+	h->v[4] = (load_le64(s + 24) >> 12) & MASK51;
+}
+
+void tc_fe25519_tobytes(uint8_t *s, const tc_fe25519 *f)
+{
+	uint64_t t[TC_FE25519_LIMBS], q;
+	unsigned int i, round;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		t[i] = f->v[i];
+	}
+
+	/* three carry rounds leave every limb below 2^51 */
+	for (round = 0; round < 3; ++round) {
+		for (i = 0; i < TC_FE25519_LIMBS - 1; ++i) {
+			t[i + 1] += t[i] >> 51;
+			t[i] &= MASK51;
+		}
+		t[0] += (t[4] >> 51) * 19;
+		t[4] &= MASK51;
+	}
+
+	/* q = 1 if t >= p; t - q * p = t + 19 q - q 2^255 */
+	q = (t[0] + 19) >> 51;
+	for (i = 1; i < TC_FE25519_LIMBS; ++i) {
+		q = (t[i] + q) >> 51;
+	}
+
+	t[0] += 19 * q;
+	for (i = 0; i < TC_FE25519_LIMBS - 1; ++i) {
+		t[i + 1] += t[i] >> 51;
+		t[i] &= MASK51;
+	}
+	t[4] &= MASK51;
+
+	store_le64(s, t[0] | (t[1] << 51));
+	store_le64(s + 8, (t[1] >> 13) | (t[2] << 38));
+	store_le64(s + 16, (t[2] >> 26) | (t[3] << 25));
+	store_le64(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+#else /* no 128-bit integer type */
+
+/* radix 2^16: f = sum v[i] 2^(16 i), limbs may be negative between carries */
+
+static void fe_carry(tc_fe25519 *h)
+{
+	int64_t c;
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		h->v[i] += (int64_t) 1 << 16;
+		c = h->v[i] >> 16;
+		if (i < 15) {
+			h->v[i + 1] += c - 1;
+		} else {
+			/* 2^256 = 38 mod p */
+			h->v[0] += 38 * (c - 1);
+		}
+		h->v[i] -= c * 65536;
+	}
+}
+
+void tc_fe25519_0(tc_fe25519 *h)
+{
+	_set(h, 0, sizeof(*h));
+}
+
+void tc_fe25519_1(tc_fe25519 *h)
+{
+	_set(h, 0, sizeof(*h));
+	h->v[0] = 1;
+}
+
+void tc_fe25519_add(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g)
+{
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		h->v[i] = f->v[i] + g->v[i];
+	}
+}
+
+void tc_fe25519_sub(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g)
+{
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		h->v[i] = f->v[i] - g->v[i];
+	}
+}
+
+void tc_fe25519_mul(tc_fe25519 *h, const tc_fe25519 *f, const tc_fe25519 *g)
+{
+	int64_t t[2 * TC_FE25519_LIMBS - 1];
+	unsigned int i, j;
+
+	for (i = 0; i < 2 * TC_FE25519_LIMBS - 1; ++i) {
+		t[i] = 0;
+	}
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		for (j = 0; j < TC_FE25519_LIMBS; ++j) {
+			t[i + j] += f->v[i] * g->v[j];
+		}
+	}
+	for (i = 0; i < TC_FE25519_LIMBS - 1; ++i) {
+		t[i] += 38 * t[i + 16];
+	}
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		h->v[i] = t[i];
+	}
+
+	fe_carry(h);
+	fe_carry(h);
+}
+
+void tc_fe25519_sq(tc_fe25519 *h, const tc_fe25519 *f)
+{
+	tc_fe25519_mul(h, f, f);
+}
+
+void tc_fe25519_mul_small(tc_fe25519 *h, const tc_fe25519 *f, uint32_t n)
+{
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		h->v[i] = f->v[i] * (int64_t) n;
+	}
+
+	fe_carry(h);
+	fe_carry(h);
+}
+
+void tc_fe25519_cswap(tc_fe25519 *f, tc_fe25519 *g, unsigned int b)
+{
+	const int64_t mask = ~((int64_t) b - 1);
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		int64_t x = mask & (f->v[i] ^ g->v[i]);
+
+		f->v[i] ^= x;
+		g->v[i] ^= x;
+	}
+}
+
+void tc_fe25519_frombytes(tc_fe25519 *h, const uint8_t *s)
+{
+	unsigned int i;
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		h->v[i] = s[2 * i] + ((int64_t) s[2 * i + 1] << 8);
+	}
+	h->v[15] &= 0x7fff;
+}
+
+void tc_fe25519_tobytes(uint8_t *s, const tc_fe25519 *f)
+{
+	tc_fe25519 m, t;
+	unsigned int i, j;
+	int64_t b;
+
+	t = *f;
+	fe_carry(&t);
+	fe_carry(&t);
+	fe_carry(&t);
+
+	/* subtract p twice, keeping the result only when it does not borrow */
+	for (j = 0; j < 2; ++j) {
+		m.v[0] = t.v[0] - 0xffed;
+		for (i = 1; i < 15; ++i) {
+			m.v[i] = t.v[i] - 0xffff - ((m.v[i - 1] >> 16) & 1);
+			m.v[i - 1] &= 0xffff;
+		}
+		m.v[15] = t.v[15] - 0x7fff - ((m.v[14] >> 16) & 1);
+		b = (m.v[15] >> 16) & 1;
+		m.v[14] &= 0xffff;
+		tc_fe25519_cswap(&t, &m, (unsigned int)(1 - b));
+	}
+
+	for (i = 0; i < TC_FE25519_LIMBS; ++i) {
+		s[2 * i] = (uint8_t)(t.v[i] & 0xff);
+		s[2 * i + 1] = (uint8_t)(t.v[i] >> 8);
+	}
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+void tc_fe25519_neg(tc_fe25519 *h, const tc_fe25519 *f)
+{
+	tc_fe25519 zero;
+
+	tc_fe25519_0(&zero);
+	tc_fe25519_sub(h, &zero, f);
+}
+
+int tc_fe25519_iszero(const tc_fe25519 *f)
+{
+	uint8_t s[TC_FE25519_BYTES];
+	uint8_t acc = 0;
+	unsigned int i;
+
+	tc_fe25519_tobytes(s, f);
+	for (i = 0; i < TC_FE25519_BYTES; ++i) {
+		acc |= s[i];
+	}
+
+	return (int)(1 & (((unsigned int) acc - 1) >> 8));
+}
+
+int tc_fe25519_isnegative(const tc_fe25519 *f)
+{
+	uint8_t s[TC_FE25519_BYTES];
+
+	tc_fe25519_tobytes(s, f);
+
+	return s[0] & 1;
+}
+
+/* h = f^(2^n) */
+static void fe_sqn(tc_fe25519 *h, const tc_fe25519 *f, unsigned int n)
+{
+	tc_fe25519_sq(h, f);
+	while (--n > 0) {
+		tc_fe25519_sq(h, h);
+	}
+}
+
+void tc_fe25519_invert(tc_fe25519 *h, const tc_fe25519 *f)
+{
+	tc_fe25519 t0, t1, t2, t3;
+
+	/* addition chain for p - 2 = 2^255 - 21 */
+	tc_fe25519_sq(&t0, f);
+	fe_sqn(&t1, &t0, 2);
+	tc_fe25519_mul(&t1, f, &t1);
+	tc_fe25519_mul(&t0, &t0, &t1);
+	tc_fe25519_sq(&t2, &t0);
+	tc_fe25519_mul(&t1, &t1, &t2);		/* f^(2^5 - 1) */
+	fe_sqn(&t2, &t1, 5);
+	tc_fe25519_mul(&t1, &t2, &t1);		/* f^(2^10 - 1) */
+	fe_sqn(&t2, &t1, 10);
+	tc_fe25519_mul(&t2, &t2, &t1);		/* f^(2^20 - 1) */
+	fe_sqn(&t3, &t2, 20);
+	tc_fe25519_mul(&t2, &t3, &t2);		/* f^(2^40 - 1) */
+	fe_sqn(&t2, &t2, 10);
+	tc_fe25519_mul(&t1, &t2, &t1);		/* f^(2^50 - 1) */
+	fe_sqn(&t2, &t1, 50);
+	tc_fe25519_mul(&t2, &t2, &t1);		/* f^(2^100 - 1) */
+	fe_sqn(&t3, &t2, 100);
+	tc_fe25519_mul(&t2, &t3, &t2);		/* f^(2^200 - 1) */
+	fe_sqn(&t2, &t2, 50);
+	tc_fe25519_mul(&t1, &t2, &t1);		/* f^(2^250 - 1) */
+	fe_sqn(&t1, &t1, 5);
+	tc_fe25519_mul(h, &t1, &t0);		/* f^(2^255 - 21) */
+
+	_set_secure(&t0, 0, sizeof(t0));
+	_set_secure(&t1, 0, sizeof(t1));
+	_set_secure(&t2, 0, sizeof(t2));
+	_set_secure(&t3, 0, sizeof(t3));
+}
+
+void tc_fe25519_pow22523(tc_fe25519 *h, const tc_fe25519 *f)
+{
+	tc_fe25519 t0, t1, t2;
+
+	/* addition chain for (p - 5) / 8 = 2^252 - 3 */
+	tc_fe25519_sq(&t0, f);
+	fe_sqn(&t1, &t0, 2);
+	tc_fe25519_mul(&t1, f, &t1);
+	tc_fe25519_mul(&t0, &t0, &t1);
+	tc_fe25519_sq(&t0, &t0);
+	tc_fe25519_mul(&t0, &t1, &t0);		/* f^(2^5 - 1) */
+	fe_sqn(&t1, &t0, 5);
+	tc_fe25519_mul(&t0, &t1, &t0);		/* f^(2^10 - 1) */
+	fe_sqn(&t1, &t0, 10);
+	tc_fe25519_mul(&t1, &t1, &t0);		/* f^(2^20 - 1) */
+	fe_sqn(&t2, &t1, 20);
+	tc_fe25519_mul(&t1, &t2, &t1);		/* f^(2^40 - 1) */
+	fe_sqn(&t1, &t1, 10);
+	tc_fe25519_mul(&t0, &t1, &t0);		/* f^(2^50 - 1) */
+	fe_sqn(&t1, &t0, 50);
+	tc_fe25519_mul(&t1, &t1, &t0);		/* f^(2^100 - 1) */
+	fe_sqn(&t2, &t1, 100);
+	tc_fe25519_mul(&t1, &t2, &t1);		/* f^(2^200 - 1) */
+	fe_sqn(&t1, &t1, 50);
+	tc_fe25519_mul(&t0, &t1, &t0);		/* f^(2^250 - 1) */
+	fe_sqn(&t0, &t0, 2);
+	tc_fe25519_mul(h, &t0, f);		/* f^(2^252 - 3) */
+
+	_set_secure(&t0, 0, sizeof(t0));
+	_set_secure(&t1, 0, sizeof(t1));
+	_set_secure(&t2, 0, sizeof(t2));
+}
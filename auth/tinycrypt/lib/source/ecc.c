@@ -54,6 +54,7 @@
 
 #include <tinycrypt/ecc.h>
 #include <tinycrypt/ecc_platform_specific.h>
+#include <tinycrypt/utils.h>
 #include <string.h>
 
 /* IMPORTANT: Make sure a cryptographically-secure PRNG is set and the platform
@@ -370,6 +371,75 @@ void uECC_vli_modMult(uECC_word_t *result, const uECC_word_t *left,
 	uECC_vli_mmod(result, product, mod, num_words);
 }
 
+/*
+ * Barrett reduction (HAC 14.42) with base 2^32 and k = num_words: the
+ * quotient estimate is the top k + 1 words of x times mu_n, it is at most 2
+ * below the real quotient so two conditional subtractions finish the job.
+ */
+void uECC_vli_mmod_n(uECC_word_t *result, const uECC_word_t *product,
+		     uECC_Curve curve)
+{
+	wordcount_t num_words = BITS_TO_WORDS(curve->num_n_bits);
+	uECC_word_t q3[NUM_ECC_WORDS + 1];
+	uECC_word_t r[NUM_ECC_WORDS + 1];
+	uECC_word_t t[NUM_ECC_WORDS + 1];
+	uECC_word_t n[NUM_ECC_WORDS + 1];
+	const uECC_word_t *q1 = product + num_words - 1;
+	uECC_word_t r0 = 0, r1 = 0, r2 = 0;
+	uECC_word_t borrow;
+	wordcount_t i, k;
+
+	/* q3 = floor(q1 * mu / b^(k + 1)), only the high half is kept */
+	for (k = 0; k < 2 * num_words + 1; ++k) {
+		for (i = (k > num_words) ? k - num_words : 0;
+		     i <= k && i <= num_words; ++i) {
+			muladd(q1[i], curve->mu_n[k - i], &r0, &r1, &r2);
+		}
+		if (k > num_words) {
+			q3[k - num_words - 1] = r0;
+		}
+		r0 = r1;
+		r1 = r2;
+		r2 = 0;
+	}
+	q3[num_words] = r0;
+
+	/* t = q3 * n mod b^(k + 1) */
+	uECC_vli_set(n, curve->n, num_words);
+	n[num_words] = 0;
+	r0 = r1 = r2 = 0;
+	for (k = 0; k <= num_words; ++k) {
+		for (i = 0; i <= k; ++i) {
+			muladd(q3[i], n[k - i], &r0, &r1, &r2);
+		}
+		t[k] = r0;
+		r0 = r1;
+		r1 = r2;
+		r2 = 0;
+	}
+
+	/* r = x - t mod b^(k + 1), r < 3n */
+	uECC_vli_sub(r, product, t, num_words + 1);
+
+	/* subtract n up to twice */
+	for (k = 0; k < 2; ++k) {
+		borrow = uECC_vli_sub(t, r, n, num_words + 1);
+		for (i = 0; i <= num_words; ++i) {
+			r[i] = cond_set(r[i], t[i], borrow);
+		}
+	}
+
+	uECC_vli_set(result, r, num_words);
+}
+
+void uECC_vli_modMult_n(uECC_word_t *result, const uECC_word_t *left,
+			const uECC_word_t *right, uECC_Curve curve)
+{
+	uECC_word_t product[2 * NUM_ECC_WORDS];
+	uECC_vli_mult(product, left, right, BITS_TO_WORDS(curve->num_n_bits));
+	uECC_vli_mmod_n(result, product, curve);
+}
+
 void uECC_vli_modMult_fast(uECC_word_t *result, const uECC_word_t *left,
 			   const uECC_word_t *right, uECC_Curve curve)
 {
@@ -386,6 +456,277 @@ static void uECC_vli_modSquare_fast(uECC_word_t *result,
 	uECC_vli_modMult_fast(result, left, left, curve);
 }
 
+void uECC_vli_modMult_mont(uECC_word_t *result, const uECC_word_t *left,
+			   const uECC_word_t *right, uECC_Curve curve)
+{
+	curve->mont_mult(result, left, right);
+}
+
+static void uECC_vli_modSquare_mont(uECC_word_t *result,
+				    const uECC_word_t *left,
+				    uECC_Curve curve)
+{
+	curve->mont_square(result, left);
+}
+
+void uECC_vli_toMont(uECC_word_t *result, const uECC_word_t *x,
+		     uECC_Curve curve)
+{
+	curve->mont_mult(result, x, curve->R2);
+}
+
+void uECC_vli_fromMont(uECC_word_t *result, const uECC_word_t *x,
+		       uECC_Curve curve)
+{
+	uECC_word_t one[NUM_ECC_WORDS] = {1};
+
+	curve->mont_mult(result, x, one);
+}
+
+
+#if defined(__SIZEOF_INT128__)
+
+/*
+ * Constant-time inversion with the Bernstein-Yang "safegcd" divsteps
+ * (https://gcd.cr.yp.to/safegcd-20190413.pdf) on signed 62-bit limbs, as
+ * in libsecp256k1's modinv64. 10 batches of 59 divsteps cover the 590
+ * divsteps a 256-bit modulus needs, every batch is a 2x2 matrix applied to
+ * (f, g) and (d, e) with 64x64->128 bit products.
+ */
+
+#define MODINV_LIMBS 5
+#define MODINV_M62 (UINT64_MAX >> 2)
+
+typedef struct {
+	int64_t v[MODINV_LIMBS];
+} modinv_signed62;
+
+typedef struct {
+	int64_t u, v, q, r;
+} modinv_trans2x2;
+
+typedef __int128 modinv_int128;
+
+static void modinv_from_vli(modinv_signed62 *r, const uECC_word_t *vli,
+			    wordcount_t num_words)
+{
+	unsigned int i, bit, limb, shift;
+
+	memset(r, 0, sizeof(*r));
+	for (i = 0; i < (unsigned int)num_words; ++i) {
+		bit = i * uECC_WORD_BITS;
+		limb = bit / 62;
+		shift = bit % 62;
+		r->v[limb] |= (int64_t)(((uint64_t)vli[i] << shift) & MODINV_M62);
+		if (shift + uECC_WORD_BITS > 62) {
+			r->v[limb + 1] |= (int64_t)((uint64_t)vli[i] >> (62 - shift));
+		}
+	}
+}
+
+/* r must be normalized, all limbs in [0, 2^62) */
+static void modinv_to_vli(uECC_word_t *vli, const modinv_signed62 *r,
+			  wordcount_t num_words)
+{
+	unsigned int i, bit, limb, shift;
+	uint64_t w;
+
+	for (i = 0; i < (unsigned int)num_words; ++i) {
+		bit = i * uECC_WORD_BITS;
+		limb = bit / 62;
+		shift = bit % 62;
+		w = (uint64_t)r->v[limb] >> shift;
+		if (shift + uECC_WORD_BITS > 62) {
+			w |= (uint64_t)r->v[limb + 1] << (62 - shift);
+		}
+		vli[i] = (uECC_word_t)w;
+	}
+}
+
+/*
+ * 59 divsteps on the low bits of f and g. The matrix is scaled by 2^62,
+ * zeta is -(delta + 1/2).
+ */
+static int64_t modinv_divsteps_59(int64_t zeta, uint64_t f0, uint64_t g0,
+				  modinv_trans2x2 *t)
+{
+	uint64_t u = 8, v = 0, q = 0, r = 8;
+	volatile uint64_t c1, c2;
+	uint64_t mask1, mask2, f = f0, g = g0, x, y, z;
+	int i;
+
+	for (i = 3; i < 62; ++i) {
+		c1 = zeta >> 63;
+		mask1 = c1;
+		c2 = g & 1;
+		mask2 = -c2;
+		/* if zeta < 0 the step is g = (g - f) / 2, else g = (g + f) / 2 */
+		x = (f ^ mask1) - mask1;
+		y = (u ^ mask1) - mask1;
+		z = (v ^ mask1) - mask1;
+		g += x & mask2;
+		q += y & mask2;
+		r += z & mask2;
+		/* swap roles when zeta < 0 and g was odd */
+		mask1 &= mask2;
+		zeta = (zeta ^ (int64_t)mask1) - 1;
+		f += g & mask1;
+		u += q & mask1;
+		v += r & mask1;
+		g >>= 1;
+		u <<= 1;
+		v <<= 1;
+	}
+
+	t->u = (int64_t)u;
+	t->v = (int64_t)v;
+	t->q = (int64_t)q;
+	t->r = (int64_t)r;
+	return zeta;
+}
+
+/* (d, e) = t (d, e) / 2^62 mod modulus, keeps d and e in (-2 modulus, modulus) */
+static void modinv_update_de(modinv_signed62 *d, modinv_signed62 *e,
+			     const modinv_trans2x2 *t,
+			     const modinv_signed62 *modulus,
+			     uint64_t modulus_inv62)
+{
+	const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+	int64_t md, me, sd, se, di, ei;
+	modinv_int128 cd, ce;
+	int i;
+
+	/* start with a multiple of the modulus that undoes negative inputs */
+	sd = d->v[MODINV_LIMBS - 1] >> 63;
+	se = e->v[MODINV_LIMBS - 1] >> 63;
+	md = (u & sd) + (v & se);
+	me = (q & sd) + (r & se);
+
+	cd = (modinv_int128)u * d->v[0] + (modinv_int128)v * e->v[0];
+	ce = (modinv_int128)q * d->v[0] + (modinv_int128)r * e->v[0];
+
+	/* pick md and me so the low 62 bits of the sums cancel */
+	md -= (modulus_inv62 * (uint64_t)cd + md) & MODINV_M62;
+	me -= (modulus_inv62 * (uint64_t)ce + me) & MODINV_M62;
+	cd += (modinv_int128)modulus->v[0] * md;
+	ce += (modinv_int128)modulus->v[0] * me;
+	cd >>= 62;
+	ce >>= 62;
+
+	for (i = 1; i < MODINV_LIMBS; ++i) {
+		di = d->v[i];
+		ei = e->v[i];
+		cd += (modinv_int128)u * di + (modinv_int128)v * ei;
+		ce += (modinv_int128)q * di + (modinv_int128)r * ei;
+		cd += (modinv_int128)modulus->v[i] * md;
+		ce += (modinv_int128)modulus->v[i] * me;
+		d->v[i - 1] = (int64_t)((uint64_t)cd & MODINV_M62);
+		e->v[i - 1] = (int64_t)((uint64_t)ce & MODINV_M62);
+		cd >>= 62;
+		ce >>= 62;
+	}
+	d->v[MODINV_LIMBS - 1] = (int64_t)cd;
+	e->v[MODINV_LIMBS - 1] = (int64_t)ce;
+}
+
+/* (f, g) = t (f, g) / 2^62, the division is exact */
+static void modinv_update_fg(modinv_signed62 *f, modinv_signed62 *g,
+			     const modinv_trans2x2 *t)
+{
+	const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+	int64_t fi, gi;
+	modinv_int128 cf, cg;
+	int i;
+
+	cf = (modinv_int128)u * f->v[0] + (modinv_int128)v * g->v[0];
+	cg = (modinv_int128)q * f->v[0] + (modinv_int128)r * g->v[0];
+	cf >>= 62;
+	cg >>= 62;
+
+	for (i = 1; i < MODINV_LIMBS; ++i) {
+		fi = f->v[i];
+		gi = g->v[i];
+		cf += (modinv_int128)u * fi + (modinv_int128)v * gi;
+		cg += (modinv_int128)q * fi + (modinv_int128)r * gi;
+		f->v[i - 1] = (int64_t)((uint64_t)cf & MODINV_M62);
+		g->v[i - 1] = (int64_t)((uint64_t)cg & MODINV_M62);
+		cf >>= 62;
+		cg >>= 62;
+	}
+	f->v[MODINV_LIMBS - 1] = (int64_t)cf;
+	g->v[MODINV_LIMBS - 1] = (int64_t)cg;
+}
+
+/* r = sign(f) r mod modulus in [0, modulus), r is in (-2 modulus, modulus) */
+static void modinv_normalize(modinv_signed62 *r, int64_t sign,
+			     const modinv_signed62 *modulus)
+{
+	volatile int64_t cond_add, cond_negate;
+	int i;
+
+	cond_add = r->v[MODINV_LIMBS - 1] >> 63;
+	for (i = 0; i < MODINV_LIMBS; ++i) {
+		r->v[i] += modulus->v[i] & cond_add;
+	}
+	cond_negate = sign >> 63;
+	for (i = 0; i < MODINV_LIMBS; ++i) {
+		r->v[i] = (r->v[i] ^ cond_negate) - cond_negate;
+	}
+	for (i = 0; i < MODINV_LIMBS - 1; ++i) {
+		r->v[i + 1] += r->v[i] >> 62;
+		r->v[i] &= (int64_t)MODINV_M62;
+	}
+
+	cond_add = r->v[MODINV_LIMBS - 1] >> 63;
+	for (i = 0; i < MODINV_LIMBS; ++i) {
+		r->v[i] += modulus->v[i] & cond_add;
+	}
+	for (i = 0; i < MODINV_LIMBS - 1; ++i) {
+		r->v[i + 1] += r->v[i] >> 62;
+		r->v[i] &= (int64_t)MODINV_M62;
+	}
+}
+
+void uECC_vli_modInv(uECC_word_t *result, const uECC_word_t *input,
+		     const uECC_word_t *mod, wordcount_t num_words)
+{
+	modinv_signed62 d, e, f, g, modulus;
+	modinv_trans2x2 t;
+	uint64_t modulus_inv62;
+	int64_t zeta = -1;
+	int i;
+
+	modinv_from_vli(&modulus, mod, num_words);
+	modinv_from_vli(&g, input, num_words);
+	f = modulus;
+	memset(&d, 0, sizeof(d));
+	memset(&e, 0, sizeof(e));
+	e.v[0] = 1;
+
+	/* modulus^-1 mod 2^64 by Newton iteration, mod is odd */
+	modulus_inv62 = (uint64_t)modulus.v[0];
+	for (i = 0; i < 5; ++i) {
+		modulus_inv62 *= 2 - (uint64_t)modulus.v[0] * modulus_inv62;
+	}
+
+	for (i = 0; i < 10; ++i) {
+		zeta = modinv_divsteps_59(zeta, (uint64_t)f.v[0], (uint64_t)g.v[0],
+					  &t);
+		modinv_update_de(&d, &e, &t, &modulus, modulus_inv62);
+		modinv_update_fg(&f, &g, &t);
+	}
+
+	/* f = +/-1 now and d = +/-1 / input, input = 0 gives d = 0 */
+	modinv_normalize(&d, f.v[MODINV_LIMBS - 1], &modulus);
+	modinv_to_vli(result, &d, num_words);
+
+	_set_secure(&d, 0, sizeof(d));
+	_set_secure(&e, 0, sizeof(e));
+	_set_secure(&g, 0, sizeof(g));
+	_set_secure(&t, 0, sizeof(t));
+}
+
+#else
 
 #define EVEN(vli) (!(vli[0] & 1))
 
@@ -450,6 +791,17 @@ void uECC_vli_modInv(uECC_word_t *result, const uECC_word_t *input,
   	uECC_vli_set(result, u, num_words);
 }
 
+#endif
+
+void uECC_vli_modInv_mont(uECC_word_t *result, const uECC_word_t *x,
+			  uECC_Curve curve)
+{
+	/* (x R)^-1 = x^-1 R^-1, two multiplications by R^2 bring it to x^-1 R */
+	uECC_vli_modInv(result, x, curve->p, curve->num_words);
+	curve->mont_mult(result, result, curve->R2);
+	curve->mont_mult(result, result, curve->R2);
+}
+
 /* ------ Point operations ------ */
 
 void double_jacobian_default(uECC_word_t * X1, uECC_word_t * Y1,
@@ -464,16 +816,16 @@ void double_jacobian_default(uECC_word_t * X1, uECC_word_t * Y1,
 		return;
 	}
 
-	uECC_vli_modSquare_fast(t4, Y1, curve);   /* t4 = y1^2 */
-	uECC_vli_modMult_fast(t5, X1, t4, curve); /* t5 = x1*y1^2 = A */
-	uECC_vli_modSquare_fast(t4, t4, curve);   /* t4 = y1^4 */
-	uECC_vli_modMult_fast(Y1, Y1, Z1, curve); /* t2 = y1*z1 = z3 */
-	uECC_vli_modSquare_fast(Z1, Z1, curve);   /* t3 = z1^2 */
+	uECC_vli_modSquare_mont(t4, Y1, curve);   /* t4 = y1^2 */
+	uECC_vli_modMult_mont(t5, X1, t4, curve); /* t5 = x1*y1^2 = A */
+	uECC_vli_modSquare_mont(t4, t4, curve);   /* t4 = y1^4 */
+	uECC_vli_modMult_mont(Y1, Y1, Z1, curve); /* t2 = y1*z1 = z3 */
+	uECC_vli_modSquare_mont(Z1, Z1, curve);   /* t3 = z1^2 */
 
 	uECC_vli_modAdd(X1, X1, Z1, curve->p, num_words); /* t1 = x1 + z1^2 */
 	uECC_vli_modAdd(Z1, Z1, Z1, curve->p, num_words); /* t3 = 2*z1^2 */
 	uECC_vli_modSub(Z1, X1, Z1, curve->p, num_words); /* t3 = x1 - z1^2 */
-	uECC_vli_modMult_fast(X1, X1, Z1, curve); /* t1 = x1^2 - z1^4 */
+	uECC_vli_modMult_mont(X1, X1, Z1, curve); /* t1 = x1^2 - z1^4 */
 
 	uECC_vli_modAdd(Z1, X1, X1, curve->p, num_words); /* t3 = 2*(x1^2 - z1^4) */
 	uECC_vli_modAdd(X1, X1, Z1, curve->p, num_words); /* t1 = 3*(x1^2 - z1^4) */
@@ -486,11 +838,11 @@ void double_jacobian_default(uECC_word_t * X1, uECC_word_t * Y1,
 	}
 
 	/* t1 = 3/2*(x1^2 - z1^4) = B */
-	uECC_vli_modSquare_fast(Z1, X1, curve); /* t3 = B^2 */
+	uECC_vli_modSquare_mont(Z1, X1, curve); /* t3 = B^2 */
 	uECC_vli_modSub(Z1, Z1, t5, curve->p, num_words); /* t3 = B^2 - A */
 	uECC_vli_modSub(Z1, Z1, t5, curve->p, num_words); /* t3 = B^2 - 2A = x3 */
 	uECC_vli_modSub(t5, t5, Z1, curve->p, num_words); /* t5 = A - x3 */
-	uECC_vli_modMult_fast(X1, X1, t5, curve); /* t1 = B * (A - x3) */
+	uECC_vli_modMult_mont(X1, X1, t5, curve); /* t1 = B * (A - x3) */
 	/* t4 = B * (A - x3) - y1^4 = y3: */
 	uECC_vli_modSub(t4, X1, t4, curve->p, num_words);
 
@@ -619,6 +971,198 @@ void vli_mmod_fast_secp256r1(unsigned int *result, unsigned int*product)
 	}
 }
 
+#if defined(__SIZEOF_INT128__)
+
+/*
+ * Montgomery arithmetic modulo p-256 on four 64-bit limbs. -1/p mod 2^64 is
+ * 1 because p = -1 mod 2^96, so the reduction factor of each step is simply
+ * the low limb.
+ */
+
+typedef unsigned __int128 mont_uint128;
+
+static const uint64_t p256_p64[4] = {
+	0xFFFFFFFFFFFFFFFFull, 0x00000000FFFFFFFFull,
+	0x0000000000000000ull, 0xFFFFFFFF00000001ull
+};
+
+static void p256_to_u64(uint64_t *r, const unsigned int *w)
+{
+	int i;
+
+	for (i = 0; i < 4; ++i) {
+		r[i] = (uint64_t)w[2 * i] | ((uint64_t)w[2 * i + 1] << 32);
+	}
+}
+
+/* result = t mod p for t = t[0..4] < 2p, in constant time */
+static void p256_final_sub(unsigned int *result, const uint64_t *t)
+{
+	uint64_t d[4], borrow = 0, keep;
+	mont_uint128 acc;
+	int i;
+
+	for (i = 0; i < 4; ++i) {
+		acc = (mont_uint128)t[i] - p256_p64[i] - borrow;
+		d[i] = (uint64_t)acc;
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+	/* keep t if t - p went negative */
+	keep = -((uint64_t)(((mont_uint128)t[4] - borrow) >> 64) & 1);
+
+	for (i = 0; i < 4; ++i) {
+		d[i] = (t[i] & keep) | (d[i] & ~keep);
+		result[2 * i] = (unsigned int)d[i];
+		result[2 * i + 1] = (unsigned int)(d[i] >> 32);
+	}
+}
+
+void vli_mont_mult_secp256r1(unsigned int *result, const unsigned int *left,
+			     const unsigned int *right)
+{
+	uint64_t a[4], b[4], t[6] = {0}, m;
+	mont_uint128 acc;
+	int i, j;
+
+	p256_to_u64(a, left);
+	p256_to_u64(b, right);
+
+	for (i = 0; i < 4; ++i) {
+		/* t += a * b[i] */
+		acc = 0;
+		for (j = 0; j < 4; ++j) {
+			acc += (mont_uint128)a[j] * b[i] + t[j];
+			t[j] = (uint64_t)acc;
+			acc >>= 64;
+		}
+		acc += t[4];
+		t[4] = (uint64_t)acc;
+		t[5] = (uint64_t)(acc >> 64);
+
+		/* t = (t + m p) / 2^64 */
+		m = t[0];
+		acc = (mont_uint128)m * p256_p64[0] + t[0];
+		acc >>= 64;
+		for (j = 1; j < 4; ++j) {
+			acc += (mont_uint128)m * p256_p64[j] + t[j];
+			t[j - 1] = (uint64_t)acc;
+			acc >>= 64;
+		}
+		acc += t[4];
+		t[3] = (uint64_t)acc;
+		t[4] = t[5] + (uint64_t)(acc >> 64);
+	}
+
+	p256_final_sub(result, t);
+}
+
+void vli_mont_square_secp256r1(unsigned int *result, const unsigned int *left)
+{
+	uint64_t a[4], t[9] = {0}, c, m;
+	mont_uint128 acc;
+	int i, j;
+
+	p256_to_u64(a, left);
+
+	/* cross products a[i] * a[j], i < j, counted once */
+	for (i = 0; i < 3; ++i) {
+		acc = 0;
+		for (j = i + 1; j < 4; ++j) {
+			acc += (mont_uint128)a[i] * a[j] + t[i + j];
+			t[i + j] = (uint64_t)acc;
+			acc >>= 64;
+		}
+		t[i + 4] = (uint64_t)acc;
+	}
+
+	/* double them and add the squares */
+	c = 0;
+	for (i = 0; i < 8; ++i) {
+		m = t[i] >> 63;
+		t[i] = (t[i] << 1) | c;
+		c = m;
+	}
+	acc = 0;
+	for (i = 0; i < 4; ++i) {
+		acc += (mont_uint128)a[i] * a[i] + t[2 * i];
+		t[2 * i] = (uint64_t)acc;
+		acc >>= 64;
+		acc += t[2 * i + 1];
+		t[2 * i + 1] = (uint64_t)acc;
+		acc >>= 64;
+	}
+
+	/* t = t / 2^256 mod p, one limb at a time */
+	for (i = 0; i < 4; ++i) {
+		m = t[i];
+		acc = 0;
+		for (j = 0; j < 4; ++j) {
+			acc += (mont_uint128)m * p256_p64[j] + t[i + j];
+			t[i + j] = (uint64_t)acc;
+			acc >>= 64;
+		}
+		for (j = i + 4; j < 9; ++j) {
+			acc += t[j];
+			t[j] = (uint64_t)acc;
+			acc >>= 64;
+		}
+	}
+
+	p256_final_sub(result, t + 4);
+}
+
+#else
+
+/* Montgomery arithmetic modulo p-256 on 32-bit words, -1/p mod 2^32 is 1. */
+void vli_mont_mult_secp256r1(unsigned int *result, const unsigned int *left,
+			     const unsigned int *right)
+{
+	uECC_word_t t[NUM_ECC_WORDS + 2] = {0};
+	uECC_word_t d[NUM_ECC_WORDS];
+	uECC_dword_t acc;
+	uECC_word_t m, borrow;
+	int i, j;
+
+	for (i = 0; i < NUM_ECC_WORDS; ++i) {
+		acc = 0;
+		for (j = 0; j < NUM_ECC_WORDS; ++j) {
+			acc += (uECC_dword_t)left[j] * right[i] + t[j];
+			t[j] = (uECC_word_t)acc;
+			acc >>= uECC_WORD_BITS;
+		}
+		acc += t[NUM_ECC_WORDS];
+		t[NUM_ECC_WORDS] = (uECC_word_t)acc;
+		t[NUM_ECC_WORDS + 1] = (uECC_word_t)(acc >> uECC_WORD_BITS);
+
+		m = t[0];
+		acc = (uECC_dword_t)m * curve_secp256r1.p[0] + t[0];
+		acc >>= uECC_WORD_BITS;
+		for (j = 1; j < NUM_ECC_WORDS; ++j) {
+			acc += (uECC_dword_t)m * curve_secp256r1.p[j] + t[j];
+			t[j - 1] = (uECC_word_t)acc;
+			acc >>= uECC_WORD_BITS;
+		}
+		acc += t[NUM_ECC_WORDS];
+		t[NUM_ECC_WORDS - 1] = (uECC_word_t)acc;
+		t[NUM_ECC_WORDS] = t[NUM_ECC_WORDS + 1] +
+				   (uECC_word_t)(acc >> uECC_WORD_BITS);
+	}
+
+	/* t < 2p, subtract p unless it goes negative */
+	borrow = uECC_vli_sub(d, t, curve_secp256r1.p, NUM_ECC_WORDS);
+	borrow = (t[NUM_ECC_WORDS] < borrow);
+	for (i = 0; i < NUM_ECC_WORDS; ++i) {
+		result[i] = cond_set(t[i], d[i], borrow);
+	}
+}
+
+void vli_mont_square_secp256r1(unsigned int *result, const unsigned int *left)
+{
+	vli_mont_mult_secp256r1(result, left, left);
+}
+
+#endif
+
 uECC_word_t EccPoint_isZero(const uECC_word_t *point, uECC_Curve curve)
 {
 	return uECC_vli_isZero(point, curve->num_words * 2);
@@ -629,10 +1173,10 @@ void apply_z(uECC_word_t * X1, uECC_word_t * Y1, const uECC_word_t * const Z,
 {
 	uECC_word_t t1[NUM_ECC_WORDS];
 
-	uECC_vli_modSquare_fast(t1, Z, curve);    /* z^2 */
-	uECC_vli_modMult_fast(X1, X1, t1, curve); /* x1 * z^2 */
-	uECC_vli_modMult_fast(t1, t1, Z, curve);  /* z^3 */
-	uECC_vli_modMult_fast(Y1, Y1, t1, curve); /* y1 * z^3 */
+	uECC_vli_modSquare_mont(t1, Z, curve);    /* z^2 */
+	uECC_vli_modMult_mont(X1, X1, t1, curve); /* x1 * z^2 */
+	uECC_vli_modMult_mont(t1, t1, Z, curve);  /* z^3 */
+	uECC_vli_modMult_mont(Y1, Y1, t1, curve); /* y1 * z^3 */
 }
 
 /* P = (x1, y1) => 2P, (x2, y2) => P' */
@@ -648,6 +1192,7 @@ static void XYcZ_initial_double(uECC_word_t * X1, uECC_word_t * Y1,
 	} else {
 		uECC_vli_clear(z, num_words);
 		z[0] = 1;
+		uECC_vli_toMont(z, z, curve);
 	}
 
 	uECC_vli_set(X2, X1, num_words);
@@ -667,18 +1212,18 @@ void XYcZ_add(uECC_word_t * X1, uECC_word_t * Y1,
 	wordcount_t num_words = curve->num_words;
 
 	uECC_vli_modSub(t5, X2, X1, curve->p, num_words); /* t5 = x2 - x1 */
-	uECC_vli_modSquare_fast(t5, t5, curve); /* t5 = (x2 - x1)^2 = A */
-	uECC_vli_modMult_fast(X1, X1, t5, curve); /* t1 = x1*A = B */
-	uECC_vli_modMult_fast(X2, X2, t5, curve); /* t3 = x2*A = C */
+	uECC_vli_modSquare_mont(t5, t5, curve); /* t5 = (x2 - x1)^2 = A */
+	uECC_vli_modMult_mont(X1, X1, t5, curve); /* t1 = x1*A = B */
+	uECC_vli_modMult_mont(X2, X2, t5, curve); /* t3 = x2*A = C */
 	uECC_vli_modSub(Y2, Y2, Y1, curve->p, num_words); /* t4 = y2 - y1 */
-	uECC_vli_modSquare_fast(t5, Y2, curve); /* t5 = (y2 - y1)^2 = D */
+	uECC_vli_modSquare_mont(t5, Y2, curve); /* t5 = (y2 - y1)^2 = D */
 
 	uECC_vli_modSub(t5, t5, X1, curve->p, num_words); /* t5 = D - B */
 	uECC_vli_modSub(t5, t5, X2, curve->p, num_words); /* t5 = D - B - C = x3 */
 	uECC_vli_modSub(X2, X2, X1, curve->p, num_words); /* t3 = C - B */
-	uECC_vli_modMult_fast(Y1, Y1, X2, curve); /* t2 = y1*(C - B) */
+	uECC_vli_modMult_mont(Y1, Y1, X2, curve); /* t2 = y1*(C - B) */
 	uECC_vli_modSub(X2, X1, t5, curve->p, num_words); /* t3 = B - x3 */
-	uECC_vli_modMult_fast(Y2, Y2, X2, curve); /* t4 = (y2 - y1)*(B - x3) */
+	uECC_vli_modMult_mont(Y2, Y2, X2, curve); /* t4 = (y2 - y1)*(B - x3) */
 	uECC_vli_modSub(Y2, Y2, Y1, curve->p, num_words); /* t4 = y3 */
 
 	uECC_vli_set(X2, t5, num_words);
@@ -699,27 +1244,27 @@ static void XYcZ_addC(uECC_word_t * X1, uECC_word_t * Y1,
 	wordcount_t num_words = curve->num_words;
 
 	uECC_vli_modSub(t5, X2, X1, curve->p, num_words); /* t5 = x2 - x1 */
-	uECC_vli_modSquare_fast(t5, t5, curve); /* t5 = (x2 - x1)^2 = A */
-	uECC_vli_modMult_fast(X1, X1, t5, curve); /* t1 = x1*A = B */
-	uECC_vli_modMult_fast(X2, X2, t5, curve); /* t3 = x2*A = C */
+	uECC_vli_modSquare_mont(t5, t5, curve); /* t5 = (x2 - x1)^2 = A */
+	uECC_vli_modMult_mont(X1, X1, t5, curve); /* t1 = x1*A = B */
+	uECC_vli_modMult_mont(X2, X2, t5, curve); /* t3 = x2*A = C */
 	uECC_vli_modAdd(t5, Y2, Y1, curve->p, num_words); /* t5 = y2 + y1 */
 	uECC_vli_modSub(Y2, Y2, Y1, curve->p, num_words); /* t4 = y2 - y1 */
 
 	uECC_vli_modSub(t6, X2, X1, curve->p, num_words); /* t6 = C - B */
-	uECC_vli_modMult_fast(Y1, Y1, t6, curve); /* t2 = y1 * (C - B) = E */
+	uECC_vli_modMult_mont(Y1, Y1, t6, curve); /* t2 = y1 * (C - B) = E */
 	uECC_vli_modAdd(t6, X1, X2, curve->p, num_words); /* t6 = B + C */
-	uECC_vli_modSquare_fast(X2, Y2, curve); /* t3 = (y2 - y1)^2 = D */
+	uECC_vli_modSquare_mont(X2, Y2, curve); /* t3 = (y2 - y1)^2 = D */
 	uECC_vli_modSub(X2, X2, t6, curve->p, num_words); /* t3 = D - (B + C) = x3 */
 
 	uECC_vli_modSub(t7, X1, X2, curve->p, num_words); /* t7 = B - x3 */
-	uECC_vli_modMult_fast(Y2, Y2, t7, curve); /* t4 = (y2 - y1)*(B - x3) */
+	uECC_vli_modMult_mont(Y2, Y2, t7, curve); /* t4 = (y2 - y1)*(B - x3) */
 	/* t4 = (y2 - y1)*(B - x3) - E = y3: */
 	uECC_vli_modSub(Y2, Y2, Y1, curve->p, num_words);
 
-	uECC_vli_modSquare_fast(t7, t5, curve); /* t7 = (y2 + y1)^2 = F */
+	uECC_vli_modSquare_mont(t7, t5, curve); /* t7 = (y2 + y1)^2 = F */
 	uECC_vli_modSub(t7, t7, t6, curve->p, num_words); /* t7 = F - (B + C) = x3' */
 	uECC_vli_modSub(t6, t7, X1, curve->p, num_words); /* t6 = x3' - B */
-	uECC_vli_modMult_fast(t6, t6, t5, curve); /* t6 = (y2+y1)*(x3' - B) */
+	uECC_vli_modMult_mont(t6, t6, t5, curve); /* t6 = (y2+y1)*(x3' - B) */
 	/* t2 = (y2+y1)*(x3' - B) - E = y3': */
 	uECC_vli_modSub(Y1, t6, Y1, curve->p, num_words);
 
@@ -734,13 +1279,18 @@ void EccPoint_mult(uECC_word_t * result, const uECC_word_t * point,
 	/* R0 and R1 */
 	uECC_word_t Rx[2][NUM_ECC_WORDS];
 	uECC_word_t Ry[2][NUM_ECC_WORDS];
+	uECC_word_t px[NUM_ECC_WORDS];
+	uECC_word_t py[NUM_ECC_WORDS];
 	uECC_word_t z[NUM_ECC_WORDS];
 	bitcount_t i;
 	uECC_word_t nb;
 	wordcount_t num_words = curve->num_words;
 
-	uECC_vli_set(Rx[1], point, num_words);
-  	uECC_vli_set(Ry[1], point + num_words, num_words);
+	/* The ladder runs in the Montgomery domain. */
+	uECC_vli_toMont(px, point, curve);
+	uECC_vli_toMont(py, point + num_words, curve);
+	uECC_vli_set(Rx[1], px, num_words);
+  	uECC_vli_set(Ry[1], py, num_words);
 
 	XYcZ_initial_double(Rx[1], Ry[1], Rx[0], Ry[0], initial_Z, curve);
 
@@ -755,20 +1305,20 @@ void EccPoint_mult(uECC_word_t * result, const uECC_word_t * point,
 
 	/* Find final 1/Z value. */
 	uECC_vli_modSub(z, Rx[1], Rx[0], curve->p, num_words); /* X1 - X0 */
-	uECC_vli_modMult_fast(z, z, Ry[1 - nb], curve); /* Yb * (X1 - X0) */
-	uECC_vli_modMult_fast(z, z, point, curve); /* xP * Yb * (X1 - X0) */
-	uECC_vli_modInv(z, z, curve->p, num_words); /* 1 / (xP * Yb * (X1 - X0))*/
+	uECC_vli_modMult_mont(z, z, Ry[1 - nb], curve); /* Yb * (X1 - X0) */
+	uECC_vli_modMult_mont(z, z, px, curve); /* xP * Yb * (X1 - X0) */
+	uECC_vli_modInv_mont(z, z, curve); /* 1 / (xP * Yb * (X1 - X0))*/
 	/* yP / (xP * Yb * (X1 - X0)) */
-	uECC_vli_modMult_fast(z, z, point + num_words, curve);
+	uECC_vli_modMult_mont(z, z, py, curve);
 	/* Xb * yP / (xP * Yb * (X1 - X0)) */
-	uECC_vli_modMult_fast(z, z, Rx[1 - nb], curve);
+	uECC_vli_modMult_mont(z, z, Rx[1 - nb], curve);
 	/* End 1/Z calculation */
 
 	XYcZ_add(Rx[nb], Ry[nb], Rx[1 - nb], Ry[1 - nb], curve);
 	apply_z(Rx[0], Ry[0], z, curve);
 
-	uECC_vli_set(result, Rx[0], num_words);
-	uECC_vli_set(result + num_words, Ry[0], num_words);
+	uECC_vli_fromMont(result, Rx[0], curve);
+	uECC_vli_fromMont(result + num_words, Ry[0], curve);
 }
 
 uECC_word_t regularize_k(const uECC_word_t * const k, uECC_word_t *k0,
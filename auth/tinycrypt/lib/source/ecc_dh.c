@@ -111,7 +111,7 @@ int uECC_make_key(uint8_t *public_key, uint8_t *private_key, uECC_Curve curve)
 		}
 
 		/* computing modular reduction of _random (see FIPS 186.4 B.4.1): */
-		uECC_vli_mmod(_private, _random, curve->n, BITS_TO_WORDS(curve->num_n_bits));
+		uECC_vli_mmod_n(_private, _random, curve);
 
 		/* Computing public-key from private: */
 		if (EccPoint_compute_public_key(_public, _private, curve)) {
@@ -190,3 +190,103 @@ clear_and_out:
 
 	return r;
 }
+
+void uECC_ephemeral_pool_init(struct uECC_ephemeral_pool *pool,
+			      uECC_Curve curve, uECC_pool_lock_fn lock,
+			      uECC_pool_lock_fn unlock, void *lock_ctx)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->curve = curve;
+	pool->lock = lock;
+	pool->unlock = unlock;
+	pool->lock_ctx = lock_ctx;
+}
+
+static void pool_lock(struct uECC_ephemeral_pool *pool)
+{
+	if (pool->lock) {
+		pool->lock(pool->lock_ctx);
+	}
+}
+
+static void pool_unlock(struct uECC_ephemeral_pool *pool)
+{
+	if (pool->unlock) {
+		pool->unlock(pool->lock_ctx);
+	}
+}
+
+unsigned int uECC_ephemeral_pool_count(struct uECC_ephemeral_pool *pool)
+{
+	unsigned int count;
+
+	pool_lock(pool);
+	count = pool->count;
+	pool_unlock(pool);
+
+	return count;
+}
+
+unsigned int uECC_ephemeral_pool_fill(struct uECC_ephemeral_pool *pool,
+				      unsigned int max)
+{
+	struct uECC_ephemeral_key key;
+	unsigned int added = 0;
+	int stored;
+
+	while (added < max &&
+	       uECC_ephemeral_pool_count(pool) < uECC_EPHEMERAL_POOL_SIZE) {
+		/* the scalar multiplication runs without holding the lock */
+		if (!uECC_make_key(key.public_key, key.private_key, pool->curve)) {
+			break;
+		}
+
+		pool_lock(pool);
+		stored = pool->count < uECC_EPHEMERAL_POOL_SIZE;
+		if (stored) {
+			pool->entries[pool->count++] = key;
+		}
+		pool_unlock(pool);
+
+		if (!stored) {
+			break;
+		}
+		++added;
+	}
+
+	_set_secure(&key, 0, sizeof(key));
+	return added;
+}
+
+int uECC_ephemeral_pool_take(struct uECC_ephemeral_pool *pool,
+			     uint8_t *public_key, uint8_t *private_key)
+{
+	struct uECC_ephemeral_key *entry;
+	int have_key = 0;
+
+	pool_lock(pool);
+	if (pool->count > 0) {
+		entry = &pool->entries[--pool->count];
+		memcpy(public_key, entry->public_key, 2 * pool->curve->num_bytes);
+		memcpy(private_key, entry->private_key,
+		       BITS_TO_BYTES(pool->curve->num_n_bits));
+		_set_secure(entry, 0, sizeof(*entry));
+		have_key = 1;
+	}
+	pool_unlock(pool);
+
+	if (!have_key) {
+		/* pool ran dry, pay for the key generation now */
+		return uECC_make_key(public_key, private_key, pool->curve);
+	}
+
+	return 1;
+}
+
+void uECC_ephemeral_pool_clear(struct uECC_ephemeral_pool *pool)
+{
+	pool_lock(pool);
+	_set_secure(pool->entries, 0, sizeof(pool->entries));
+	pool->count = 0;
+	pool_unlock(pool);
+}
@@ -56,6 +56,7 @@
 #include <tinycrypt/constants.h>
 #include <tinycrypt/ecc.h>
 #include <tinycrypt/ecc_dsa.h>
+#include <tinycrypt/utils.h>
 
 
 static void bits2int(uECC_word_t *native, const uint8_t *bits,
@@ -91,9 +92,12 @@ static void bits2int(uECC_word_t *native, const uint8_t *bits,
 	}
 }
 
-int uECC_sign_with_k(const uint8_t *private_key, const uint8_t *message_hash,
-		     unsigned hash_size, uECC_word_t *k, uint8_t *signature,
-		     uECC_Curve curve)
+/*
+ * Offline half of a signature: r = x(kG) and k^-1 mod n. k is overwritten
+ * with k^-1.
+ */
+static int presign_with_k(uECC_word_t *k, struct uECC_presignature *presig,
+			  uECC_Curve curve)
 {
 
 	uECC_word_t tmp[NUM_ECC_WORDS];
@@ -129,28 +133,67 @@ int uECC_sign_with_k(const uint8_t *private_key, const uint8_t *message_hash,
 
 	/* Prevent side channel analysis of uECC_vli_modInv() to determine
 	bits of k / the private key by premultiplying by a random number */
-	uECC_vli_modMult(k, k, tmp, curve->n, num_n_words); /* k' = rand * k */
+	uECC_vli_modMult_n(k, k, tmp, curve); /* k' = rand * k */
 	uECC_vli_modInv(k, k, curve->n, num_n_words);       /* k = 1 / k' */
-	uECC_vli_modMult(k, k, tmp, curve->n, num_n_words); /* k = 1 / k */
+	uECC_vli_modMult_n(k, k, tmp, curve); /* k = 1 / k */
+
+	uECC_vli_set(presig->r, p, num_words);
+	uECC_vli_set(presig->k_inv, k, num_n_words);
+
+	_set_secure(tmp, 0, sizeof(tmp));
+	_set_secure(s, 0, sizeof(s));
+	_set_secure(p, 0, sizeof(p));
+	return 1;
+}
+
+/* Online half of a signature: s = (e + r*d) / k. */
+static int sign_presigned(const uint8_t *private_key,
+			  const uint8_t *message_hash, unsigned hash_size,
+			  const struct uECC_presignature *presig,
+			  uint8_t *signature, uECC_Curve curve)
+{
+	uECC_word_t tmp[NUM_ECC_WORDS];
+	uECC_word_t s[NUM_ECC_WORDS];
+	wordcount_t num_words = curve->num_words;
+	wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+	int result = 1;
 
-	uECC_vli_nativeToBytes(signature, curve->num_bytes, p); /* store r */
+	uECC_vli_nativeToBytes(signature, curve->num_bytes, presig->r); /* store r */
 
 	/* tmp = d: */
 	uECC_vli_bytesToNative(tmp, private_key, BITS_TO_BYTES(curve->num_n_bits));
 
 	s[num_n_words - 1] = 0;
-	uECC_vli_set(s, p, num_words);
-	uECC_vli_modMult(s, tmp, s, curve->n, num_n_words); /* s = r*d */
+	uECC_vli_set(s, presig->r, num_words);
+	uECC_vli_modMult_n(s, tmp, s, curve); /* s = r*d */
 
 	bits2int(tmp, message_hash, hash_size, curve);
 	uECC_vli_modAdd(s, tmp, s, curve->n, num_n_words); /* s = e + r*d */
-	uECC_vli_modMult(s, s, k, curve->n, num_n_words);  /* s = (e + r*d) / k */
+	uECC_vli_modMult_n(s, s, presig->k_inv, curve); /* s = (e + r*d) / k */
 	if (uECC_vli_numBits(s, num_n_words) > (bitcount_t)curve->num_bytes * 8) {
-		return 0;
+		result = 0;
+	} else {
+		uECC_vli_nativeToBytes(signature + curve->num_bytes, curve->num_bytes, s);
 	}
 
-	uECC_vli_nativeToBytes(signature + curve->num_bytes, curve->num_bytes, s);
-	return 1;
+	_set_secure(tmp, 0, sizeof(tmp));
+	_set_secure(s, 0, sizeof(s));
+	return result;
+}
+
+int uECC_sign_with_k(const uint8_t *private_key, const uint8_t *message_hash,
+		     unsigned hash_size, uECC_word_t *k, uint8_t *signature,
+		     uECC_Curve curve)
+{
+	struct uECC_presignature presig;
+	int result;
+
+	result = presign_with_k(k, &presig, curve) &&
+		 sign_presigned(private_key, message_hash, hash_size, &presig,
+				signature, curve);
+
+	_set_secure(&presig, 0, sizeof(presig));
+	return result;
 }
 
 int uECC_sign(const uint8_t *private_key, const uint8_t *message_hash,
@@ -169,7 +212,7 @@ int uECC_sign(const uint8_t *private_key, const uint8_t *message_hash,
 		}
 
 		// computing k as modular reduction of _random (see FIPS 186.4 B.5.1):
-		uECC_vli_mmod(k, _random, curve->n, BITS_TO_WORDS(curve->num_n_bits));
+		uECC_vli_mmod_n(k, _random, curve);
 
 		if (uECC_sign_with_k(private_key, message_hash, hash_size, k, signature, 
 		    curve)) {
@@ -179,19 +222,190 @@ int uECC_sign(const uint8_t *private_key, const uint8_t *message_hash,
 	return 0;
 }
 
+int uECC_presign(struct uECC_presignature *presig, uECC_Curve curve)
+{
+	uECC_word_t _random[2*NUM_ECC_WORDS];
+	uECC_word_t k[NUM_ECC_WORDS];
+	uECC_word_t tries;
+	int result = 0;
+
+	for (tries = 0; tries < uECC_RNG_MAX_TRIES && !result; ++tries) {
+		uECC_RNG_Function rng_function = uECC_get_rng();
+		if (!rng_function ||
+		    !rng_function((uint8_t *)_random, 2*NUM_ECC_WORDS*uECC_WORD_SIZE)) {
+			break;
+		}
+
+		uECC_vli_mmod_n(k, _random, curve);
+		result = presign_with_k(k, presig, curve);
+	}
+
+	_set_secure(_random, 0, sizeof(_random));
+	_set_secure(k, 0, sizeof(k));
+	return result;
+}
+
+int uECC_sign_presigned(const uint8_t *private_key, const uint8_t *message_hash,
+			unsigned hash_size, struct uECC_presignature *presig,
+			uint8_t *signature, uECC_Curve curve)
+{
+	int result;
+
+	result = sign_presigned(private_key, message_hash, hash_size, presig,
+				signature, curve);
+
+	/* a presignature must never be used twice, it would reveal the key */
+	_set_secure(presig, 0, sizeof(*presig));
+	return result;
+}
+
+void uECC_presign_pool_init(struct uECC_presign_pool *pool, uECC_Curve curve,
+			    uECC_pool_lock_fn lock, uECC_pool_lock_fn unlock,
+			    void *lock_ctx)
+{
+	_set(pool, 0, sizeof(*pool));
+	pool->curve = curve;
+	pool->lock = lock;
+	pool->unlock = unlock;
+	pool->lock_ctx = lock_ctx;
+}
+
+static void pool_lock(struct uECC_presign_pool *pool)
+{
+	if (pool->lock) {
+		pool->lock(pool->lock_ctx);
+	}
+}
+
+static void pool_unlock(struct uECC_presign_pool *pool)
+{
+	if (pool->unlock) {
+		pool->unlock(pool->lock_ctx);
+	}
+}
+
+unsigned int uECC_presign_pool_count(struct uECC_presign_pool *pool)
+{
+	unsigned int count;
+
+	pool_lock(pool);
+	count = pool->count;
+	pool_unlock(pool);
+
+	return count;
+}
+
+unsigned int uECC_presign_pool_fill(struct uECC_presign_pool *pool,
+				    unsigned int max)
+{
+	struct uECC_presignature presig;
+	unsigned int added = 0;
+	int stored;
+
+	while (added < max && uECC_presign_pool_count(pool) < uECC_PRESIGN_POOL_SIZE) {
+		/* the scalar multiplication runs without holding the lock */
+		if (!uECC_presign(&presig, pool->curve)) {
+			break;
+		}
+
+		pool_lock(pool);
+		stored = pool->count < uECC_PRESIGN_POOL_SIZE;
+		if (stored) {
+			pool->entries[pool->count++] = presig;
+		}
+		pool_unlock(pool);
+
+		if (!stored) {
+			break;
+		}
+		++added;
+	}
+
+	_set_secure(&presig, 0, sizeof(presig));
+	return added;
+}
+
+int uECC_sign_pooled(struct uECC_presign_pool *pool, const uint8_t *private_key,
+		     const uint8_t *message_hash, unsigned hash_size,
+		     uint8_t *signature)
+{
+	struct uECC_presignature presig;
+	int have_presig = 0;
+
+	pool_lock(pool);
+	if (pool->count > 0) {
+		--pool->count;
+		presig = pool->entries[pool->count];
+		_set_secure(&pool->entries[pool->count], 0, sizeof(presig));
+		have_presig = 1;
+	}
+	pool_unlock(pool);
+
+	if (!have_presig) {
+		/* pool ran dry, pay for the scalar multiplication now */
+		return uECC_sign(private_key, message_hash, hash_size, signature,
+				 pool->curve);
+	}
+
+	return uECC_sign_presigned(private_key, message_hash, hash_size, &presig,
+				   signature, pool->curve);
+}
+
+void uECC_presign_pool_clear(struct uECC_presign_pool *pool)
+{
+	pool_lock(pool);
+	_set_secure(pool->entries, 0, sizeof(pool->entries));
+	pool->count = 0;
+	pool_unlock(pool);
+}
+
 static bitcount_t smax(bitcount_t a, bitcount_t b)
 {
 	return (a > b ? a : b);
 }
 
-int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
-		unsigned hash_size, const uint8_t *signature,
-	        uECC_Curve curve)
+/*
+ * Converts the public key and the generator to the Montgomery domain and
+ * computes their affine sum for Shamir's trick. _public holds the native
+ * public key on entry.
+ */
+static void verify_precompute(struct uECC_verify_table *table,
+			      uECC_Curve curve)
 {
+	uECC_word_t tx[NUM_ECC_WORDS];
+	uECC_word_t ty[NUM_ECC_WORDS];
+	uECC_word_t z[NUM_ECC_WORDS];
+	wordcount_t num_words = curve->num_words;
+	uECC_word_t *_public = table->public_key;
+	uECC_word_t *G = table->G;
+	uECC_word_t *sum = table->sum;
+
+	/* The point arithmetic runs in the Montgomery domain. */
+	uECC_vli_toMont(_public, _public, curve);
+	uECC_vli_toMont(_public + num_words, _public + num_words, curve);
+	uECC_vli_toMont(G, curve->G, curve);
+	uECC_vli_toMont(G + num_words, curve->G + num_words, curve);
+
+	/* Calculate sum = G + Q. */
+	uECC_vli_set(sum, _public, num_words);
+	uECC_vli_set(sum + num_words, _public + num_words, num_words);
+	uECC_vli_set(tx, G, num_words);
+	uECC_vli_set(ty, G + num_words, num_words);
+	uECC_vli_modSub(z, sum, tx, curve->p, num_words); /* z = x2 - x1 */
+	XYcZ_add(tx, ty, sum, sum + num_words, curve);
+	uECC_vli_modInv_mont(z, z, curve); /* z = 1/z */
+	apply_z(sum, sum + num_words, z, curve);
+
+	table->curve = curve;
+}
 
+static int verify_with_table(const struct uECC_verify_table *table,
+			     const uint8_t *message_hash, unsigned hash_size,
+			     const uint8_t *signature)
+{
+	uECC_Curve curve = table->curve;
 	uECC_word_t u1[NUM_ECC_WORDS], u2[NUM_ECC_WORDS];
 	uECC_word_t z[NUM_ECC_WORDS];
-	uECC_word_t sum[NUM_ECC_WORDS * 2];
 	uECC_word_t rx[NUM_ECC_WORDS];
 	uECC_word_t ry[NUM_ECC_WORDS];
 	uECC_word_t tx[NUM_ECC_WORDS];
@@ -202,7 +416,6 @@ int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
 	bitcount_t num_bits;
 	bitcount_t i;
 
-	uECC_word_t _public[NUM_ECC_WORDS * 2];
 	uECC_word_t r[NUM_ECC_WORDS], s[NUM_ECC_WORDS];
 	wordcount_t num_words = curve->num_words;
 	wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
@@ -211,9 +424,6 @@ int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
 	r[num_n_words - 1] = 0;
 	s[num_n_words - 1] = 0;
 
-	uECC_vli_bytesToNative(_public, public_key, curve->num_bytes);
-	uECC_vli_bytesToNative(_public + num_words, public_key + curve->num_bytes,
-			       curve->num_bytes);
 	uECC_vli_bytesToNative(r, signature, curve->num_bytes);
 	uECC_vli_bytesToNative(s, signature + curve->num_bytes, curve->num_bytes);
 
@@ -232,24 +442,14 @@ int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
 	uECC_vli_modInv(z, s, curve->n, num_n_words); /* z = 1/s */
 	u1[num_n_words - 1] = 0;
 	bits2int(u1, message_hash, hash_size, curve);
-	uECC_vli_modMult(u1, u1, z, curve->n, num_n_words); /* u1 = e/s */
-	uECC_vli_modMult(u2, r, z, curve->n, num_n_words); /* u2 = r/s */
-
-	/* Calculate sum = G + Q. */
-	uECC_vli_set(sum, _public, num_words);
-	uECC_vli_set(sum + num_words, _public + num_words, num_words);
-	uECC_vli_set(tx, curve->G, num_words);
-	uECC_vli_set(ty, curve->G + num_words, num_words);
-	uECC_vli_modSub(z, sum, tx, curve->p, num_words); /* z = x2 - x1 */
-	XYcZ_add(tx, ty, sum, sum + num_words, curve);
-	uECC_vli_modInv(z, z, curve->p, num_words); /* z = 1/z */
-	apply_z(sum, sum + num_words, z, curve);
+	uECC_vli_modMult_n(u1, u1, z, curve); /* u1 = e/s */
+	uECC_vli_modMult_n(u2, r, z, curve); /* u2 = r/s */
 
 	/* Use Shamir's trick to calculate u1*G + u2*Q */
 	points[0] = 0;
-	points[1] = curve->G;
-	points[2] = _public;
-	points[3] = sum;
+	points[1] = table->G;
+	points[2] = table->public_key;
+	points[3] = table->sum;
 	num_bits = smax(uECC_vli_numBits(u1, num_n_words),
 	uECC_vli_numBits(u2, num_n_words));
 
@@ -259,6 +459,7 @@ int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
 	uECC_vli_set(ry, point + num_words, num_words);
 	uECC_vli_clear(z, num_words);
 	z[0] = 1;
+	uECC_vli_toMont(z, z, curve);
 
 	for (i = num_bits - 2; i >= 0; --i) {
 		uECC_word_t index;
@@ -272,12 +473,13 @@ int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
 			apply_z(tx, ty, z, curve);
 			uECC_vli_modSub(tz, rx, tx, curve->p, num_words); /* Z = x2 - x1 */
 			XYcZ_add(tx, ty, rx, ry, curve);
-			uECC_vli_modMult_fast(z, z, tz, curve);
+			uECC_vli_modMult_mont(z, z, tz, curve);
 		}
   	}
 
-	uECC_vli_modInv(z, z, curve->p, num_words); /* Z = 1/Z */
+	uECC_vli_modInv_mont(z, z, curve); /* Z = 1/Z */
 	apply_z(rx, ry, z, curve);
+	uECC_vli_fromMont(rx, rx, curve);
 
 	/* v = x1 (mod n) */
 	if (uECC_vli_cmp_unsafe(curve->n, rx, num_n_words) != 1) {
@@ -288,3 +490,40 @@ int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
 	return (int)(uECC_vli_equal(rx, r, num_words) == 0);
 }
 
+int uECC_verify(const uint8_t *public_key, const uint8_t *message_hash,
+		unsigned hash_size, const uint8_t *signature,
+	        uECC_Curve curve)
+{
+	struct uECC_verify_table table;
+
+	uECC_vli_bytesToNative(table.public_key, public_key, curve->num_bytes);
+	uECC_vli_bytesToNative(table.public_key + curve->num_words,
+			       public_key + curve->num_bytes, curve->num_bytes);
+	verify_precompute(&table, curve);
+
+	return verify_with_table(&table, message_hash, hash_size, signature);
+}
+
+int uECC_verify_table_init(struct uECC_verify_table *table,
+			   const uint8_t *public_key, uECC_Curve curve)
+{
+	/* the table outlives the call, only accept points on the curve */
+	if (uECC_valid_public_key(public_key, curve) != 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	uECC_vli_bytesToNative(table->public_key, public_key, curve->num_bytes);
+	uECC_vli_bytesToNative(table->public_key + curve->num_words,
+			       public_key + curve->num_bytes, curve->num_bytes);
+	verify_precompute(table, curve);
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int uECC_verify_with_table(const struct uECC_verify_table *table,
+			   const uint8_t *message_hash, unsigned hash_size,
+			   const uint8_t *signature)
+{
+	return verify_with_table(table, message_hash, hash_size, signature);
+}
+
@@ -0,0 +1,692 @@
+/* ed25519.c - TinyCrypt implementation of Ed25519 signatures */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <tinycrypt/ed25519.h>
+#include <tinycrypt/curve25519.h>
+#include <tinycrypt/sha512.h>
+#include <tinycrypt/ecc.h>
+#include <tinycrypt/constants.h>
+#include <tinycrypt/utils.h>
+
+#define SCALAR_BYTES 32
+
+/* number of 4-bit windows in a scalar */
+#define SCALAR_WINDOWS 64
+
+/* edwards25519 constants, little-endian */
+static const uint8_t ed25519_d[TC_FE25519_BYTES] = {
+	0xa3, 0x78, 0x59, 0x13, 0xca, 0x4d, 0xeb, 0x75,
+	0xab, 0xd8, 0x41, 0x41, 0x4d, 0x0a, 0x70, 0x00,
+	0x98, 0xe8, 0x79, 0x77, 0x79, 0x40, 0xc7, 0x8c,
+	0x73, 0xfe, 0x6f, 0x2b, 0xee, 0x6c, 0x03, 0x52
+};
+
+static const uint8_t ed25519_d2[TC_FE25519_BYTES] = {
+	0x59, 0xf1, 0xb2, 0x26, 0x94, 0x9b, 0xd6, 0xeb,
+	0x56, 0xb1, 0x83, 0x82, 0x9a, 0x14, 0xe0, 0x00,
+	0x30, 0xd1, 0xf3, 0xee, 0xf2, 0x80, 0x8e, 0x19,
+	0xe7, 0xfc, 0xdf, 0x56, 0xdc, 0xd9, 0x06, 0x24
+};
+
+static const uint8_t ed25519_sqrtm1[TC_FE25519_BYTES] = {
+	0xb0, 0xa0, 0x0e, 0x4a, 0x27, 0x1b, 0xee, 0xc4,
+	0x78, 0xe4, 0x2f, 0xad, 0x06, 0x18, 0x43, 0x2f,
+	0xa7, 0xd7, 0xfb, 0x3d, 0x99, 0x00, 0x4d, 0x2b,
+	0x0b, 0xdf, 0xc1, 0x4f, 0x80, 0x24, 0x83, 0x2b
+};
+
+/* base point B = (x, 4/5) */
+static const uint8_t ed25519_bx[TC_FE25519_BYTES] = {
+	0x1a, 0xd5, 0x25, 0x8f, 0x60, 0x2d, 0x56, 0xc9,
+	0xb2, 0xa7, 0x25, 0x95, 0x60, 0xc7, 0x2c, 0x69,
+	0x5c, 0xdc, 0xd6, 0xfd, 0x31, 0xe2, 0xa4, 0xc0,
+	0xfe, 0x53, 0x6e, 0xcd, 0xd3, 0x36, 0x69, 0x21
+};
+
+static const uint8_t ed25519_by[TC_FE25519_BYTES] = {
+	0x58, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+	0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+	0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+	0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66
+};
+
+/* group order L = 2^252 + 27742317777372353535851937790883648493 */
+static const int64_t ed25519_l[SCALAR_BYTES] = {
+	0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+	0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+static const uint8_t sc_zero[SCALAR_BYTES] = { 0 };
+
+/* point in extended coordinates: x = X/Z, y = Y/Z, x y = T/Z */
+typedef struct {
+	tc_fe25519 X, Y, Z, T;
+} ge_p3;
+
+/* point prepared as an addend: (Y + X, Y - X, Z, 2 d T) */
+typedef struct {
+	tc_fe25519 YpX, YmX, Z, T2d;
+} ge_cached;
+
+/*
+ * Scalar arithmetic modulo L on little-endian bytes, x holds 64 signed
+ * byte-sized limbs which are folded back with 2^252 = -(L - 2^252).
+ */
+static void sc_reduce_limbs(uint8_t *r, int64_t *x)
+{
+	int64_t carry;
+	int i, j;
+
+	for (i = 63; i >= 32; --i) {
+		carry = 0;
+		for (j = i - 32; j < i - 12; ++j) {
+			x[j] += carry - 16 * x[i] * ed25519_l[j - (i - 32)];
+			carry = (x[j] + 128) >> 8;
+			x[j] -= carry * 256;
+		}
+		x[j] += carry;
+		x[i] = 0;
+	}
+
+	carry = 0;
+	for (j = 0; j < 32; ++j) {
+		x[j] += carry - (x[31] >> 4) * ed25519_l[j];
+		carry = x[j] >> 8;
+		x[j] &= 255;
+	}
+	for (j = 0; j < 32; ++j) {
+		x[j] -= carry * ed25519_l[j];
+	}
+	for (i = 0; i < 32; ++i) {
+		x[i + 1] += x[i] >> 8;
+		r[i] = (uint8_t)(x[i] & 255);
+	}
+}
+
+/* r = s mod L for a 64 byte s, r may alias s */
+static void sc_reduce(uint8_t *r, const uint8_t *s)
+{
+	int64_t x[64];
+	unsigned int i;
+
+	for (i = 0; i < 64; ++i) {
+		x[i] = s[i];
+	}
+	sc_reduce_limbs(r, x);
+	_set_secure(x, 0, sizeof(x));
+}
+
+/* r = (a * b + c) mod L */
+static void sc_muladd(uint8_t *r, const uint8_t *a, const uint8_t *b,
+		      const uint8_t *c)
+{
+	int64_t x[64];
+	unsigned int i, j;
+
+	for (i = 0; i < 64; ++i) {
+		x[i] = (i < SCALAR_BYTES) ? c[i] : 0;
+	}
+	for (i = 0; i < SCALAR_BYTES; ++i) {
+		for (j = 0; j < SCALAR_BYTES; ++j) {
+			x[i + j] += (int64_t) a[i] * b[j];
+		}
+	}
+	sc_reduce_limbs(r, x);
+	_set_secure(x, 0, sizeof(x));
+}
+
+/* returns 1 if s < L */
+static int sc_is_canonical(const uint8_t *s)
+{
+	int i;
+
+	for (i = SCALAR_BYTES - 1; i >= 0; --i) {
+		if (s[i] < ed25519_l[i]) {
+			return 1;
+		} else if (s[i] > ed25519_l[i]) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+static void ge_identity(ge_p3 *p)
+{
+	tc_fe25519_0(&p->X);
+	tc_fe25519_1(&p->Y);
+	tc_fe25519_1(&p->Z);
+	tc_fe25519_0(&p->T);
+}
+
+static void ge_base(ge_p3 *p)
+{
+	tc_fe25519_frombytes(&p->X, ed25519_bx);
+	tc_fe25519_frombytes(&p->Y, ed25519_by);
+	tc_fe25519_1(&p->Z);
+	tc_fe25519_mul(&p->T, &p->X, &p->Y);
+}
+
+static void ge_to_cached(ge_cached *c, const ge_p3 *p)
+{
+	tc_fe25519 d2;
+
+	tc_fe25519_frombytes(&d2, ed25519_d2);
+	tc_fe25519_add(&c->YpX, &p->Y, &p->X);
+	tc_fe25519_sub(&c->YmX, &p->Y, &p->X);
+	c->Z = p->Z;
+	tc_fe25519_mul(&c->T2d, &p->T, &d2);
+}
+
+/* r = p + q, or p - q when neg is set (add-2008-hwcd-3) */
+static void ge_add(ge_p3 *r, const ge_p3 *p, const ge_cached *q, int neg)
+{
+	tc_fe25519 a, b, c, d, e, f, g, h;
+
+	tc_fe25519_sub(&a, &p->Y, &p->X);
+	tc_fe25519_add(&b, &p->Y, &p->X);
+	if (neg) {
+		/* -q swaps Y + X and Y - X and negates T */
+		tc_fe25519_mul(&a, &a, &q->YpX);
+		tc_fe25519_mul(&b, &b, &q->YmX);
+	} else {
+		tc_fe25519_mul(&a, &a, &q->YmX);
+		tc_fe25519_mul(&b, &b, &q->YpX);
+	}
+	tc_fe25519_mul(&c, &p->T, &q->T2d);
+	tc_fe25519_mul(&d, &p->Z, &q->Z);
+	tc_fe25519_add(&d, &d, &d);
+
+	tc_fe25519_sub(&e, &b, &a);
+	tc_fe25519_add(&h, &b, &a);
+	if (neg) {
+		tc_fe25519_add(&f, &d, &c);
+		tc_fe25519_sub(&g, &d, &c);
+	} else {
+		tc_fe25519_sub(&f, &d, &c);
+		tc_fe25519_add(&g, &d, &c);
+	}
+
+	tc_fe25519_mul(&r->X, &e, &f);
+	tc_fe25519_mul(&r->Y, &g, &h);
+	tc_fe25519_mul(&r->T, &e, &h);
+	tc_fe25519_mul(&r->Z, &f, &g);
+}
+
+/* r = 2 p (dbl-2008-hwcd with a = -1) */
+static void ge_dbl(ge_p3 *r, const ge_p3 *p)
+{
+	tc_fe25519 a, b, c, e, f, g, h;
+
+	tc_fe25519_sq(&a, &p->X);
+	tc_fe25519_sq(&b, &p->Y);
+	tc_fe25519_sq(&c, &p->Z);
+	tc_fe25519_add(&c, &c, &c);
+	tc_fe25519_add(&h, &a, &b);
+	tc_fe25519_add(&e, &p->X, &p->Y);
+	tc_fe25519_sq(&e, &e);
+	tc_fe25519_sub(&e, &h, &e);
+	tc_fe25519_sub(&g, &a, &b);
+	tc_fe25519_add(&f, &c, &g);
+
+	tc_fe25519_mul(&r->X, &e, &f);
+	tc_fe25519_mul(&r->Y, &g, &h);
+	tc_fe25519_mul(&r->T, &e, &h);
+	tc_fe25519_mul(&r->Z, &f, &g);
+}
+
+static void ge_tobytes(uint8_t *s, const ge_p3 *p)
+{
+	tc_fe25519 zi, x, y;
+
+	tc_fe25519_invert(&zi, &p->Z);
+	tc_fe25519_mul(&x, &p->X, &zi);
+	tc_fe25519_mul(&y, &p->Y, &zi);
+	tc_fe25519_tobytes(s, &y);
+	s[31] ^= (uint8_t)(tc_fe25519_isnegative(&x) << 7);
+}
+
+/*
+ * Decodes a point, RFC 8032 section 5.1.3. Runs in variable time, it is
+ * only used on public keys and signatures.
+ */
+static int ge_frombytes(ge_p3 *p, const uint8_t *s)
+{
+	tc_fe25519 u, v, v3, vxx, check, d;
+	uint8_t canonical[TC_FE25519_BYTES];
+	unsigned int i;
+
+	tc_fe25519_frombytes(&p->Y, s);
+
+	/* reject y >= p */
+	tc_fe25519_tobytes(canonical, &p->Y);
+	canonical[31] |= s[31] & 0x80;
+	for (i = 0; i < TC_FE25519_BYTES; ++i) {
+		if (canonical[i] != s[i]) {
+			return 0;
+		}
+	}
+
+	/* x^2 = u / v = (y^2 - 1) / (d y^2 + 1) */
+	tc_fe25519_frombytes(&d, ed25519_d);
+	tc_fe25519_1(&p->Z);
+	tc_fe25519_sq(&u, &p->Y);
+	tc_fe25519_mul(&v, &u, &d);
+	tc_fe25519_sub(&u, &u, &p->Z);
+	tc_fe25519_add(&v, &v, &p->Z);
+
+	/* x = u v^3 (u v^7)^((p - 5) / 8) */
+	tc_fe25519_sq(&v3, &v);
+	tc_fe25519_mul(&v3, &v3, &v);
+	tc_fe25519_sq(&p->X, &v3);
+	tc_fe25519_mul(&p->X, &p->X, &v);
+	tc_fe25519_mul(&p->X, &p->X, &u);
+	tc_fe25519_pow22523(&p->X, &p->X);
+	tc_fe25519_mul(&p->X, &p->X, &v3);
+	tc_fe25519_mul(&p->X, &p->X, &u);
+
+	tc_fe25519_sq(&vxx, &p->X);
+	tc_fe25519_mul(&vxx, &vxx, &v);
+	tc_fe25519_sub(&check, &vxx, &u);
+	if (!tc_fe25519_iszero(&check)) {
+		tc_fe25519_add(&check, &vxx, &u);
+		if (!tc_fe25519_iszero(&check)) {
+			return 0;
+		}
+		tc_fe25519_frombytes(&d, ed25519_sqrtm1);
+		tc_fe25519_mul(&p->X, &p->X, &d);
+	}
+
+	if (tc_fe25519_iszero(&p->X) && (s[31] >> 7)) {
+		return 0;
+	}
+	if (tc_fe25519_isnegative(&p->X) != (s[31] >> 7)) {
+		tc_fe25519_neg(&p->X, &p->X);
+	}
+
+	tc_fe25519_mul(&p->T, &p->X, &p->Y);
+	return 1;
+}
+
+/* r = a if b == 1, unchanged if b == 0 */
+static void ge_cached_cmov(ge_cached *r, const ge_cached *a, unsigned int b)
+{
+	ge_cached t = *a;
+
+	tc_fe25519_cswap(&r->YpX, &t.YpX, b);
+	tc_fe25519_cswap(&r->YmX, &t.YmX, b);
+	tc_fe25519_cswap(&r->Z, &t.Z, b);
+	tc_fe25519_cswap(&r->T2d, &t.T2d, b);
+}
+
+/*
+ * r = a B in constant time: fixed 4-bit windows, the table entry is picked
+ * by scanning the whole table so the memory access pattern does not depend
+ * on the secret scalar.
+ */
+static void ge_scalarmult_base(ge_p3 *r, const uint8_t *a)
+{
+	ge_cached table[16], sel;
+	ge_p3 p;
+	unsigned int i, j, nibble;
+	int w;
+
+	ge_identity(&p);
+	ge_to_cached(&table[0], &p);
+	ge_base(&p);
+	ge_to_cached(&table[1], &p);
+	for (i = 2; i < 16; ++i) {
+		ge_add(&p, &p, &table[1], 0);
+		ge_to_cached(&table[i], &p);
+	}
+
+	ge_identity(r);
+	for (w = SCALAR_WINDOWS - 1; w >= 0; --w) {
+		ge_dbl(r, r);
+		ge_dbl(r, r);
+		ge_dbl(r, r);
+		ge_dbl(r, r);
+
+		nibble = (a[w >> 1] >> (4 * (w & 1))) & 0x0f;
+		sel = table[0];
+		for (j = 1; j < 16; ++j) {
+			ge_cached_cmov(&sel, &table[j],
+				       1 & (((j ^ nibble) - 1) >> 31));
+		}
+		ge_add(r, r, &sel, 0);
+	}
+
+	_set_secure(&sel, 0, sizeof(sel));
+	_set_secure(table, 0, sizeof(table));
+}
+
+/* recodes a scalar below 2^255 into 64 signed digits in [-8, 8] */
+static void sc_signed_digits(int8_t *e, const uint8_t *a)
+{
+	int carry = 0;
+	unsigned int i;
+
+	for (i = 0; i < SCALAR_BYTES; ++i) {
+		e[2 * i] = (int8_t)(a[i] & 15);
+		e[2 * i + 1] = (int8_t)((a[i] >> 4) & 15);
+	}
+	for (i = 0; i < SCALAR_WINDOWS - 1; ++i) {
+		e[i] = (int8_t)(e[i] + carry);
+		carry = (e[i] + 8) >> 4;
+		e[i] = (int8_t)(e[i] - carry * 16);
+	}
+	e[SCALAR_WINDOWS - 1] = (int8_t)(e[SCALAR_WINDOWS - 1] + carry);
+}
+
+/*
+ * r = sum scalars[i] points[i], Straus' method with signed 4-bit windows:
+ * each point gets a table of 1..8 multiples and the doublings are shared.
+ * Variable time, only used on public data.
+ */
+static void ge_multi_scalarmult_vartime(ge_p3 *r, const uint8_t *scalars,
+					const ge_p3 *points, unsigned int n,
+					ge_cached *tables, int8_t *digits)
+{
+	ge_p3 t;
+	unsigned int i, j;
+	int w, top = -1;
+
+	for (i = 0; i < n; ++i) {
+		ge_cached *tab = tables + 8 * i;
+		int8_t *e = digits + SCALAR_WINDOWS * i;
+
+		/* tab[j] = (j + 1) P */
+		ge_to_cached(&tab[0], &points[i]);
+		ge_dbl(&t, &points[i]);
+		ge_to_cached(&tab[1], &t);
+		for (j = 2; j < 8; ++j) {
+			ge_add(&t, &t, &tab[0], 0);
+			ge_to_cached(&tab[j], &t);
+		}
+
+		sc_signed_digits(e, scalars + SCALAR_BYTES * i);
+		for (w = SCALAR_WINDOWS - 1; w > top; --w) {
+			if (e[w] != 0) {
+				top = w;
+				break;
+			}
+		}
+	}
+
+	ge_identity(r);
+	for (w = top; w >= 0; --w) {
+		if (w != top) {
+			ge_dbl(r, r);
+			ge_dbl(r, r);
+			ge_dbl(r, r);
+			ge_dbl(r, r);
+		}
+		for (i = 0; i < n; ++i) {
+			int8_t d = digits[SCALAR_WINDOWS * i + w];
+
+			if (d > 0) {
+				ge_add(r, r, &tables[8 * i + d - 1], 0);
+			} else if (d < 0) {
+				ge_add(r, r, &tables[8 * i - d - 1], 1);
+			}
+		}
+	}
+}
+
+/* k = SHA-512(R || A || M) mod L */
+static void ed25519_challenge(uint8_t *k, const uint8_t *r,
+			      const uint8_t *public_key,
+			      const uint8_t *message, unsigned int mlen)
+{
+	struct tc_sha512_state_struct s;
+	uint8_t h[TC_SHA512_DIGEST_SIZE];
+
+	(void)tc_sha512_init(&s);
+	(void)tc_sha512_update(&s, r, TC_FE25519_BYTES);
+	(void)tc_sha512_update(&s, public_key, TC_ED25519_KEY_SIZE);
+	if (mlen > 0) {
+		(void)tc_sha512_update(&s, message, mlen);
+	}
+	(void)tc_sha512_final(h, &s);
+
+	sc_reduce(h, h);
+	(void)_copy(k, SCALAR_BYTES, h, SCALAR_BYTES);
+}
+
+/* expands the private key into the clamped scalar a and the nonce prefix */
+static void ed25519_expand(uint8_t *az, const uint8_t *private_key)
+{
+	struct tc_sha512_state_struct s;
+
+	(void)tc_sha512_init(&s);
+	(void)tc_sha512_update(&s, private_key, TC_ED25519_KEY_SIZE);
+	(void)tc_sha512_final(az, &s);
+
+	az[0] &= 248;
+	az[31] &= 127;
+	az[31] |= 64;
+}
+
+int tc_ed25519_public_key(uint8_t *public_key, const uint8_t *private_key)
+{
+	uint8_t az[TC_SHA512_DIGEST_SIZE];
+	ge_p3 a;
+
+	if (public_key == (uint8_t *) 0 || private_key == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	ed25519_expand(az, private_key);
+	ge_scalarmult_base(&a, az);
+	ge_tobytes(public_key, &a);
+
+	_set_secure(az, 0, sizeof(az));
+	_set_secure(&a, 0, sizeof(a));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_ed25519_make_key(uint8_t *public_key, uint8_t *private_key)
+{
+	uECC_RNG_Function rng_function = uECC_get_rng();
+
+	if (public_key == (uint8_t *) 0 ||
+	    private_key == (uint8_t *) 0 ||
+	    !rng_function ||
+	    !rng_function(private_key, TC_ED25519_KEY_SIZE)) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	return tc_ed25519_public_key(public_key, private_key);
+}
+
+int tc_ed25519_sign(const uint8_t *private_key, const uint8_t *public_key,
+		    const uint8_t *message, unsigned int mlen,
+		    uint8_t *signature)
+{
+	struct tc_sha512_state_struct s;
+	uint8_t az[TC_SHA512_DIGEST_SIZE];
+	uint8_t nonce[TC_SHA512_DIGEST_SIZE];
+	uint8_t k[SCALAR_BYTES];
+	ge_p3 r;
+
+	if (private_key == (const uint8_t *) 0 ||
+	    public_key == (const uint8_t *) 0 ||
+	    signature == (uint8_t *) 0 ||
+	    (mlen > 0 && message == (const uint8_t *) 0)) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	ed25519_expand(az, private_key);
+
+	/* r = SHA-512(prefix || M) mod L, R = r B */
+	(void)tc_sha512_init(&s);
+	(void)tc_sha512_update(&s, az + SCALAR_BYTES, SCALAR_BYTES);
+	if (mlen > 0) {
+		(void)tc_sha512_update(&s, message, mlen);
+	}
+	(void)tc_sha512_final(nonce, &s);
+	sc_reduce(nonce, nonce);
+
+	ge_scalarmult_base(&r, nonce);
+	ge_tobytes(signature, &r);
+
+	/* S = (r + k a) mod L */
+	ed25519_challenge(k, signature, public_key, message, mlen);
+	sc_muladd(signature + SCALAR_BYTES, k, az, nonce);
+
+	/* erasing temporary buffers that stored secrets: */
+	_set_secure(az, 0, sizeof(az));
+	_set_secure(nonce, 0, sizeof(nonce));
+	_set_secure(&r, 0, sizeof(r));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_ed25519_verify(const uint8_t *public_key, const uint8_t *message,
+		      unsigned int mlen, const uint8_t *signature)
+{
+	ge_cached tables[2 * 8];
+	int8_t digits[2 * SCALAR_WINDOWS];
+	uint8_t scalars[2 * SCALAR_BYTES];
+	uint8_t check[TC_FE25519_BYTES];
+	ge_p3 points[2], r;
+
+	if (public_key == (const uint8_t *) 0 ||
+	    signature == (const uint8_t *) 0 ||
+	    (mlen > 0 && message == (const uint8_t *) 0) ||
+	    !sc_is_canonical(signature + SCALAR_BYTES) ||
+	    !ge_frombytes(&points[1], public_key)) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* R' = S B - k A */
+	ge_base(&points[0]);
+	tc_fe25519_neg(&points[1].X, &points[1].X);
+	tc_fe25519_neg(&points[1].T, &points[1].T);
+	(void)_copy(scalars, SCALAR_BYTES, signature + SCALAR_BYTES,
+		    SCALAR_BYTES);
+	ed25519_challenge(scalars + SCALAR_BYTES, signature, public_key,
+			  message, mlen);
+
+	ge_multi_scalarmult_vartime(&r, scalars, points, 2, tables, digits);
+	ge_tobytes(check, &r);
+
+	return (_compare(check, signature, TC_FE25519_BYTES) == 0) ?
+		TC_CRYPTO_SUCCESS : TC_CRYPTO_FAIL;
+}
+
+/*
+ * Verifies up to TC_ED25519_BATCH_MAX signatures:
+ * [8]([sum z_i S_i] B - sum [z_i] R_i - sum [z_i k_i] A_i) == identity
+ */
+static int ed25519_verify_chunk(const uint8_t *const *public_keys,
+				const uint8_t *const *messages,
+				const unsigned int *mlens,
+				const uint8_t *const *signatures,
+				unsigned int n)
+{
+	ge_cached tables[(2 * TC_ED25519_BATCH_MAX + 1) * 8];
+	int8_t digits[(2 * TC_ED25519_BATCH_MAX + 1) * SCALAR_WINDOWS];
+	uint8_t scalars[(2 * TC_ED25519_BATCH_MAX + 1) * SCALAR_BYTES];
+	ge_p3 points[2 * TC_ED25519_BATCH_MAX + 1], r;
+	uint8_t z[SCALAR_BYTES], k[SCALAR_BYTES];
+	uint8_t check[TC_FE25519_BYTES];
+	uECC_RNG_Function rng_function = uECC_get_rng();
+	unsigned int i;
+
+	if (!rng_function) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	_set(scalars, 0, SCALAR_BYTES);
+	ge_base(&points[0]);
+
+	for (i = 0; i < n; ++i) {
+		ge_p3 *rp = &points[1 + i];
+		ge_p3 *ap = &points[1 + n + i];
+
+		if (public_keys[i] == (const uint8_t *) 0 ||
+		    signatures[i] == (const uint8_t *) 0 ||
+		    (mlens[i] > 0 && messages[i] == (const uint8_t *) 0) ||
+		    !sc_is_canonical(signatures[i] + SCALAR_BYTES) ||
+		    !ge_frombytes(rp, signatures[i]) ||
+		    !ge_frombytes(ap, public_keys[i])) {
+			return TC_CRYPTO_FAIL;
+		}
+		tc_fe25519_neg(&rp->X, &rp->X);
+		tc_fe25519_neg(&rp->T, &rp->T);
+		tc_fe25519_neg(&ap->X, &ap->X);
+		tc_fe25519_neg(&ap->T, &ap->T);
+
+		/* random 128-bit coefficient z_i */
+		_set(z, 0, sizeof(z));
+		if (!rng_function(z, 16)) {
+			return TC_CRYPTO_FAIL;
+		}
+
+		ed25519_challenge(k, signatures[i], public_keys[i],
+				  messages[i], mlens[i]);
+
+		/* scalar of B accumulates z_i S_i */
+		sc_muladd(scalars, z, signatures[i] + SCALAR_BYTES, scalars);
+		(void)_copy(scalars + SCALAR_BYTES * (1 + i), SCALAR_BYTES,
+			    z, SCALAR_BYTES);
+		sc_muladd(scalars + SCALAR_BYTES * (1 + n + i), z, k,
+			  sc_zero);
+	}
+
+	ge_multi_scalarmult_vartime(&r, scalars, points, 2 * n + 1, tables,
+				    digits);
+
+	/* multiply by the cofactor */
+	ge_dbl(&r, &r);
+	ge_dbl(&r, &r);
+	ge_dbl(&r, &r);
+
+	ge_tobytes(check, &r);
+	check[0] ^= 1;
+	for (i = 1; i < TC_FE25519_BYTES; ++i) {
+		check[0] |= check[i];
+	}
+
+	return (check[0] == 0) ? TC_CRYPTO_SUCCESS : TC_CRYPTO_FAIL;
+}
+
+int tc_ed25519_verify_batch(const uint8_t *const *public_keys,
+			    const uint8_t *const *messages,
+			    const unsigned int *mlens,
+			    const uint8_t *const *signatures, unsigned int n)
+{
+	unsigned int chunk;
+
+	if (public_keys == (const uint8_t *const *) 0 ||
+	    messages == (const uint8_t *const *) 0 ||
+	    mlens == (const unsigned int *) 0 ||
+	    signatures == (const uint8_t *const *) 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	while (n > 0) {
+		chunk = (n < TC_ED25519_BATCH_MAX) ? n : TC_ED25519_BATCH_MAX;
+
+		if (ed25519_verify_chunk(public_keys, messages, mlens,
+					 signatures, chunk) != TC_CRYPTO_SUCCESS) {
+			return TC_CRYPTO_FAIL;
+		}
+
+		public_keys += chunk;
+		messages += chunk;
+		mlens += chunk;
+		signatures += chunk;
+		n -= chunk;
+	}
+
+	return TC_CRYPTO_SUCCESS;
+}
@@ -0,0 +1,381 @@
+/* gcm_mode.c - TinyCrypt implementation of GCM mode */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <tinycrypt/gcm_mode.h>
+#include <tinycrypt/constants.h>
+#include <tinycrypt/utils.h>
+
+#if defined(__PCLMUL__) && defined(__SSSE3__)
+#define TC_GCM_USE_PCLMUL
+#include <wmmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+static inline uint64_t gcm_get_be64(const uint8_t *p)
+{
+	return ((uint64_t) p[0] << 56) | ((uint64_t) p[1] << 48) |
+	       ((uint64_t) p[2] << 40) | ((uint64_t) p[3] << 32) |
+	       ((uint64_t) p[4] << 24) | ((uint64_t) p[5] << 16) |
+	       ((uint64_t) p[6] << 8) | ((uint64_t) p[7]);
+}
+
+static inline void gcm_put_be64(uint8_t *p, uint64_t v)
+{
+	p[0] = (uint8_t)(v >> 56); p[1] = (uint8_t)(v >> 48);
+	p[2] = (uint8_t)(v >> 40); p[3] = (uint8_t)(v >> 32);
+	p[4] = (uint8_t)(v >> 24); p[5] = (uint8_t)(v >> 16);
+	p[6] = (uint8_t)(v >> 8); p[7] = (uint8_t)(v);
+}
+
+#if defined(TC_GCM_USE_PCLMUL)
+
+/*
+ * Multiplies x by H in GF(2^128) with carry-less multiplication. GCM uses
+ * a bit reflected representation, the operands are byte reversed so the
+ * product only needs a one bit shift before the reduction modulo
+ * x^128 + x^7 + x^2 + x + 1.
+ */
+static void gcm_mult(uint8_t *x, const TCGcmMode_t c)
+{
+	const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+					   8, 9, 10, 11, 12, 13, 14, 15);
+	__m128i a, b, t0, t1, t2, t3, t4, t5;
+
+	a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) x), bswap);
+	b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) c->h), bswap);
+
+	/* 256-bit carry-less product t3:t0 */
+	t0 = _mm_clmulepi64_si128(a, b, 0x00);
+	t1 = _mm_clmulepi64_si128(a, b, 0x10);
+	t2 = _mm_clmulepi64_si128(a, b, 0x01);
+	t3 = _mm_clmulepi64_si128(a, b, 0x11);
+	t1 = _mm_xor_si128(t1, t2);
+	t2 = _mm_slli_si128(t1, 8);
+	t1 = _mm_srli_si128(t1, 8);
+	t0 = _mm_xor_si128(t0, t2);
+	t3 = _mm_xor_si128(t3, t1);
+
+	/* shift the product left by one bit for the reflected order */
+	t4 = _mm_srli_epi32(t0, 31);
+	t5 = _mm_srli_epi32(t3, 31);
+	t0 = _mm_slli_epi32(t0, 1);
+	t3 = _mm_slli_epi32(t3, 1);
+	t2 = _mm_srli_si128(t4, 12);
+	t5 = _mm_slli_si128(t5, 4);
+	t4 = _mm_slli_si128(t4, 4);
+	t0 = _mm_or_si128(t0, t4);
+	t3 = _mm_or_si128(t3, t5);
+	t3 = _mm_or_si128(t3, t2);
+
+	/* reduce modulo the GCM polynomial */
+	t4 = _mm_slli_epi32(t0, 31);
+	t5 = _mm_slli_epi32(t0, 30);
+	t2 = _mm_slli_epi32(t0, 25);
+	t4 = _mm_xor_si128(t4, t5);
+	t4 = _mm_xor_si128(t4, t2);
+	t5 = _mm_srli_si128(t4, 4);
+	t4 = _mm_slli_si128(t4, 12);
+	t0 = _mm_xor_si128(t0, t4);
+	t2 = _mm_srli_epi32(t0, 1);
+	t1 = _mm_srli_epi32(t0, 2);
+	t4 = _mm_srli_epi32(t0, 7);
+	t2 = _mm_xor_si128(t2, t1);
+	t2 = _mm_xor_si128(t2, t4);
+	t2 = _mm_xor_si128(t2, t5);
+	t0 = _mm_xor_si128(t0, t2);
+	t3 = _mm_xor_si128(t3, t0);
+
+	_mm_storeu_si128((__m128i *) x, _mm_shuffle_epi8(t3, bswap));
+}
+
+static void gcm_gen_table(TCGcmMode_t c)
+{
+	/* the carry-less multiply works on H directly */
+	_set(c->hl, TC_ZERO_BYTE, sizeof(c->hl));
+	_set(c->hh, TC_ZERO_BYTE, sizeof(c->hh));
+}
+
+#else /* portable */
+
+/*
+ * Reduction constants for the four bits shifted out of the low end of the
+ * accumulator, see "The Galois/Counter Mode of Operation" section 4.1.
+ */
+static const uint64_t last4[16] = {
+	0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+	0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/*
+ * Precomputes i * H for all 4-bit values i, in the bit reflected order used
+ * by GCM.
+ */
+static void gcm_gen_table(TCGcmMode_t c)
+{
+	uint64_t vh, vl;
+	unsigned int i, j;
+
+	vh = gcm_get_be64(c->h);
+	vl = gcm_get_be64(c->h + 8);
+
+	c->hl[8] = vl;
+	c->hh[8] = vh;
+	c->hl[0] = 0;
+	c->hh[0] = 0;
+
+	for (i = 4; i > 0; i >>= 1) {
+		uint64_t t = (vl & 1) * 0xe1000000u;
+
+		vl = (vh << 63) | (vl >> 1);
+		vh = (vh >> 1) ^ (t << 32);
+		c->hl[i] = vl;
+		c->hh[i] = vh;
+	}
+
+	for (i = 2; i <= 8; i *= 2) {
+		vh = c->hh[i];
+		vl = c->hl[i];
+		for (j = 1; j < i; ++j) {
+			c->hh[i + j] = vh ^ c->hh[j];
+			c->hl[i + j] = vl ^ c->hl[j];
+		}
+	}
+}
+
+/*
+ * Multiplies x by H in GF(2^128), four bits at a time using the table.
+ */
+static void gcm_mult(uint8_t *x, const TCGcmMode_t c)
+{
+	uint64_t zh, zl;
+	uint8_t lo, hi, rem;
+	int i;
+
+	lo = x[15] & 0x0f;
+	zh = c->hh[lo];
+	zl = c->hl[lo];
+
+	for (i = 15; i >= 0; --i) {
+		lo = x[i] & 0x0f;
+		hi = (x[i] >> 4) & 0x0f;
+
+		if (i != 15) {
+			rem = (uint8_t) zl & 0x0f;
+			zl = (zh << 60) | (zl >> 4);
+			zh = (zh >> 4) ^ (last4[rem] << 48);
+			zh ^= c->hh[lo];
+			zl ^= c->hl[lo];
+		}
+
+		rem = (uint8_t) zl & 0x0f;
+		zl = (zh << 60) | (zl >> 4);
+		zh = (zh >> 4) ^ (last4[rem] << 48);
+		zh ^= c->hh[hi];
+		zl ^= c->hl[hi];
+	}
+
+	gcm_put_be64(x, zh);
+	gcm_put_be64(x + 8, zl);
+}
+
+#endif /* TC_GCM_USE_PCLMUL */
+
+/**
+ * Absorbs data into the GHASH accumulator x, the last partial block is
+ * zero padded.
+ */
+static void gcm_ghash(uint8_t *x, const uint8_t *data, unsigned int dlen,
+		      const TCGcmMode_t c)
+{
+	unsigned int i;
+
+	while (dlen > 0) {
+		unsigned int n = (dlen < TC_AES_BLOCK_SIZE) ? dlen : TC_AES_BLOCK_SIZE;
+
+		for (i = 0; i < n; ++i) {
+			x[i] ^= data[i];
+		}
+		gcm_mult(x, c);
+
+		data += n;
+		dlen -= n;
+	}
+}
+
+/**
+ * Computes the tag over the associated data and the ciphertext.
+ */
+static void gcm_compute_tag(uint8_t *tag, const uint8_t *associated_data,
+			    unsigned int alen, const uint8_t *ciphertext,
+			    unsigned int clen, const TCGcmMode_t c)
+{
+	uint8_t x[TC_AES_BLOCK_SIZE];
+	uint8_t j0[TC_AES_BLOCK_SIZE];
+	unsigned int i;
+
+	_set(x, TC_ZERO_BYTE, sizeof(x));
+	gcm_ghash(x, associated_data, alen, c);
+	gcm_ghash(x, ciphertext, clen, c);
+
+	/* the lengths block: bit lengths of the associated data and ciphertext */
+	gcm_put_be64(j0, (uint64_t) alen * 8);
+	gcm_put_be64(j0 + 8, (uint64_t) clen * 8);
+	gcm_ghash(x, j0, sizeof(j0), c);
+
+	/* T = E(K, J0) ^ GHASH */
+	(void)_copy(j0, sizeof(j0), c->nonce, TC_GCM_NONCE_SIZE);
+	j0[12] = j0[13] = j0[14] = TC_ZERO_BYTE;
+	j0[15] = 1;
+	(void)tc_aes_encrypt(j0, j0, c->sched);
+
+	for (i = 0; i < TC_AES_BLOCK_SIZE; ++i) {
+		tag[i] = x[i] ^ j0[i];
+	}
+}
+
+/**
+ * GCM counter mode, the first counter block is J0 + 1 and only the low
+ * 32 bits of the counter are incremented.
+ */
+static void gcm_ctr_mode(uint8_t *out, const uint8_t *in, unsigned int len,
+			 const TCGcmMode_t c)
+{
+	uint8_t ctr[TC_AES_PARALLEL_BLOCKS * TC_AES_BLOCK_SIZE];
+	uint8_t keystream[TC_AES_PARALLEL_BLOCKS * TC_AES_BLOCK_SIZE];
+	uint32_t counter = 1;
+	unsigned int i, n, nblocks;
+
+	while (len > 0) {
+		n = (len < sizeof(keystream)) ? len : sizeof(keystream);
+		nblocks = (n + TC_AES_BLOCK_SIZE - 1) / TC_AES_BLOCK_SIZE;
+
+		/* build the counter blocks for this batch */
+		for (i = 0; i < nblocks; ++i) {
+			uint8_t *cb = ctr + i * TC_AES_BLOCK_SIZE;
+
+			++counter;
+			(void)_copy(cb, TC_AES_BLOCK_SIZE, c->nonce, TC_GCM_NONCE_SIZE);
+			cb[12] = (uint8_t)(counter >> 24);
+			cb[13] = (uint8_t)(counter >> 16);
+			cb[14] = (uint8_t)(counter >> 8);
+			cb[15] = (uint8_t)(counter);
+		}
+
+		(void)tc_aes_encrypt_blocks(keystream, ctr, nblocks, c->sched);
+
+		for (i = 0; i < n; ++i) {
+			out[i] = in[i] ^ keystream[i];
+		}
+
+		in += n;
+		out += n;
+		len -= n;
+	}
+
+	/* zeroing out the keystream */
+	_set(keystream, TC_ZERO_BYTE, sizeof(keystream));
+}
+
+int tc_gcm_config(TCGcmMode_t c, TCAesKeySched_t sched, const uint8_t *nonce,
+		  unsigned int nlen, unsigned int mlen)
+{
+	/* input sanity check: */
+	if (c == (TCGcmMode_t) 0 ||
+	    sched == (TCAesKeySched_t) 0 ||
+	    nonce == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	} else if (nlen != TC_GCM_NONCE_SIZE) {
+		return TC_CRYPTO_FAIL; /* The allowed nonce size is: 12. */
+	} else if ((mlen < 12) || (mlen > TC_GCM_TAG_MAX_BYTES)) {
+		return TC_CRYPTO_FAIL; /* The allowed tag sizes are: 12 to 16. */
+	}
+
+	c->mlen = mlen;
+	c->sched = sched;
+	c->nonce = nonce;
+
+	/* hash subkey H = E(K, 0^128) */
+	_set(c->h, TC_ZERO_BYTE, sizeof(c->h));
+	(void)tc_aes_encrypt(c->h, c->h, sched);
+	gcm_gen_table(c);
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_gcm_set_nonce(TCGcmMode_t c, const uint8_t *nonce, unsigned int nlen)
+{
+	if (c == (TCGcmMode_t) 0 ||
+	    nonce == (const uint8_t *) 0 ||
+	    nlen != TC_GCM_NONCE_SIZE) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	c->nonce = nonce;
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_gcm_generation_encryption(uint8_t *out, unsigned int olen,
+				 const uint8_t *associated_data,
+				 unsigned int alen, const uint8_t *payload,
+				 unsigned int plen, TCGcmMode_t c)
+{
+	uint8_t tag[TC_AES_BLOCK_SIZE];
+
+	/* input sanity check: */
+	if ((out == (uint8_t *) 0) ||
+	    (c == (TCGcmMode_t) 0) ||
+	    ((plen > 0) && (payload == (uint8_t *) 0)) ||
+	    ((alen > 0) && (associated_data == (uint8_t *) 0)) ||
+	    (plen > TC_GCM_PAYLOAD_MAX_BYTES) || /* payload size unsupported */
+	    (olen < (plen + c->mlen))) { /* invalid output buffer size */
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* ENCRYPTION: */
+	gcm_ctr_mode(out, payload, plen, c);
+
+	/* GENERATING THE AUTHENTICATION TAG over the ciphertext: */
+	gcm_compute_tag(tag, associated_data, alen, out, plen, c);
+	(void)_copy(out + plen, c->mlen, tag, c->mlen);
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_gcm_decryption_verification(uint8_t *out, unsigned int olen,
+				   const uint8_t *associated_data,
+				   unsigned int alen, const uint8_t *payload,
+				   unsigned int plen, TCGcmMode_t c)
+{
+	uint8_t tag[TC_AES_BLOCK_SIZE];
+	unsigned int clen;
+
+	/* input sanity check: */
+	if ((out == (uint8_t *) 0) ||
+	    (c == (TCGcmMode_t) 0) ||
+	    (payload == (const uint8_t *) 0) ||
+	    ((alen > 0) && (associated_data == (uint8_t *) 0)) ||
+	    (plen < c->mlen) ||
+	    (olen < plen - c->mlen)) { /* invalid output buffer size */
+		return TC_CRYPTO_FAIL;
+	}
+
+	clen = plen - c->mlen;
+
+	/* VERIFYING THE AUTHENTICATION TAG before decrypting: */
+	gcm_compute_tag(tag, associated_data, alen, payload, clen, c);
+
+	if (_compare(tag, payload + clen, c->mlen) != 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* DECRYPTION: */
+	gcm_ctr_mode(out, payload, clen, c);
+
+	return TC_CRYPTO_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/* hkdf.c - TinyCrypt implementation of HKDF-SHA256 (RFC 5869) */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <tinycrypt/hkdf.h>
+#include <tinycrypt/hmac.h>
+#include <tinycrypt/constants.h>
+#include <tinycrypt/utils.h>
+
+int tc_hkdf_extract(uint8_t *prk, const uint8_t *salt, unsigned int salt_len,
+		    const uint8_t *ikm, unsigned int ikm_len)
+{
+	const uint8_t zero_salt[TC_SHA256_DIGEST_SIZE] = {0};
+	struct tc_hmac_state_struct h;
+
+	/* input sanity check: */
+	if (prk == (uint8_t *) 0 ||
+	    (ikm == (const uint8_t *) 0 && ikm_len != 0) ||
+	    (salt == (const uint8_t *) 0 && salt_len != 0)) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	if (salt_len == 0) {
+		salt = zero_salt;
+		salt_len = sizeof(zero_salt);
+	}
+
+	(void)tc_hmac_set_key(&h, salt, salt_len);
+	(void)tc_hmac_init(&h);
+	if (ikm_len != 0) {
+		(void)tc_hmac_update(&h, ikm, ikm_len);
+	}
+	(void)tc_hmac_final(prk, TC_HKDF_PRK_SIZE, &h);
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_hkdf_expand(uint8_t *okm, unsigned int okm_len, const uint8_t *prk,
+		   const uint8_t *info, unsigned int info_len)
+{
+	struct tc_hmac_state_struct keyed;
+	struct tc_hmac_state_struct h;
+	uint8_t t[TC_SHA256_DIGEST_SIZE];
+	uint8_t counter = 1;
+	unsigned int n;
+
+	/* input sanity check: */
+	if (okm == (uint8_t *) 0 || prk == (const uint8_t *) 0 ||
+	    (info == (const uint8_t *) 0 && info_len != 0) ||
+	    okm_len == 0 || okm_len > TC_HKDF_MAX_OKM_SIZE) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* the key is processed once, tc_hmac_final erases the state it uses */
+	(void)tc_hmac_set_key(&keyed, prk, TC_HKDF_PRK_SIZE);
+
+	while (okm_len > 0) {
+		/* T(i) = HMAC(PRK, T(i - 1) | info | i) */
+		(void)_copy((uint8_t *) &h, sizeof(h), (const uint8_t *) &keyed,
+			    sizeof(keyed));
+		(void)tc_hmac_init(&h);
+		if (counter > 1) {
+			(void)tc_hmac_update(&h, t, sizeof(t));
+		}
+		if (info_len != 0) {
+			(void)tc_hmac_update(&h, info, info_len);
+		}
+		(void)tc_hmac_update(&h, &counter, sizeof(counter));
+		(void)tc_hmac_final(t, sizeof(t), &h);
+
+		n = (okm_len < sizeof(t)) ? okm_len : sizeof(t);
+		(void)_copy(okm, n, t, n);
+		okm += n;
+		okm_len -= n;
+		counter++;
+	}
+
+	/* zeroing out the key and the last block */
+	_set_secure(&keyed, TC_ZERO_BYTE, sizeof(keyed));
+	_set_secure(t, TC_ZERO_BYTE, sizeof(t));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_hkdf(uint8_t *okm, unsigned int okm_len,
+	    const uint8_t *salt, unsigned int salt_len,
+	    const uint8_t *ikm, unsigned int ikm_len,
+	    const uint8_t *info, unsigned int info_len)
+{
+	uint8_t prk[TC_HKDF_PRK_SIZE];
+	int ret;
+
+	ret = tc_hkdf_extract(prk, salt, salt_len, ikm, ikm_len);
+	if (ret == TC_CRYPTO_SUCCESS) {
+		ret = tc_hkdf_expand(okm, okm_len, prk, info, info_len);
+	}
+
+	_set_secure(prk, TC_ZERO_BYTE, sizeof(prk));
+
+	return ret;
+}
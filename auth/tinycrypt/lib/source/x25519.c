@@ -0,0 +1,120 @@
+/* x25519.c - TinyCrypt implementation of X25519 key agreement */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <tinycrypt/x25519.h>
+#include <tinycrypt/curve25519.h>
+#include <tinycrypt/ecc.h>
+#include <tinycrypt/constants.h>
+#include <tinycrypt/utils.h>
+
+/* (A - 2) / 4 for Curve25519 */
+#define X25519_A24 121665
+
+static const uint8_t x25519_base_point[TC_X25519_KEY_SIZE] = { 9 };
+
+int tc_x25519(uint8_t *out, const uint8_t *scalar, const uint8_t *u)
+{
+	tc_fe25519 x1, x2, z2, x3, z3, a, aa, b, bb, e, c, d;
+	uint8_t k[TC_X25519_KEY_SIZE];
+	unsigned int swap = 0, bit;
+	int t;
+
+	if (out == (uint8_t *) 0 ||
+	    scalar == (const uint8_t *) 0 ||
+	    u == (const uint8_t *) 0) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* clamp the scalar: multiple of the cofactor 8, top bit 254 set */
+	(void)_copy(k, sizeof(k), scalar, TC_X25519_KEY_SIZE);
+	k[0] &= 248;
+	k[31] &= 127;
+	k[31] |= 64;
+
+	tc_fe25519_frombytes(&x1, u);
+	tc_fe25519_1(&x2);
+	tc_fe25519_0(&z2);
+	x3 = x1;
+	tc_fe25519_1(&z3);
+
+	/* Montgomery ladder, RFC 7748 section 5 */
+	for (t = 254; t >= 0; --t) {
+		bit = (k[t >> 3] >> (t & 7)) & 1;
+		swap ^= bit;
+		tc_fe25519_cswap(&x2, &x3, swap);
+		tc_fe25519_cswap(&z2, &z3, swap);
+		swap = bit;
+
+		tc_fe25519_add(&a, &x2, &z2);
+		tc_fe25519_sq(&aa, &a);
+		tc_fe25519_sub(&b, &x2, &z2);
+		tc_fe25519_sq(&bb, &b);
+		tc_fe25519_sub(&e, &aa, &bb);
+		tc_fe25519_add(&c, &x3, &z3);
+		tc_fe25519_sub(&d, &x3, &z3);
+		tc_fe25519_mul(&d, &d, &a);		/* DA */
+		tc_fe25519_mul(&c, &c, &b);		/* CB */
+
+		tc_fe25519_add(&x3, &d, &c);
+		tc_fe25519_sq(&x3, &x3);
+		tc_fe25519_sub(&z3, &d, &c);
+		tc_fe25519_sq(&z3, &z3);
+		tc_fe25519_mul(&z3, &z3, &x1);
+		tc_fe25519_mul(&x2, &aa, &bb);
+		tc_fe25519_mul_small(&z2, &e, X25519_A24);
+		tc_fe25519_add(&z2, &z2, &aa);
+		tc_fe25519_mul(&z2, &z2, &e);
+	}
+	tc_fe25519_cswap(&x2, &x3, swap);
+	tc_fe25519_cswap(&z2, &z3, swap);
+
+	tc_fe25519_invert(&z2, &z2);
+	tc_fe25519_mul(&x2, &x2, &z2);
+	tc_fe25519_tobytes(out, &x2);
+
+	/* erasing temporary buffers that depend on the secret scalar: */
+	_set_secure(k, 0, sizeof(k));
+	_set_secure(&x2, 0, sizeof(x2));
+	_set_secure(&z2, 0, sizeof(z2));
+	_set_secure(&x3, 0, sizeof(x3));
+	_set_secure(&z3, 0, sizeof(z3));
+
+	return TC_CRYPTO_SUCCESS;
+}
+
+int tc_x25519_make_key(uint8_t *public_key, uint8_t *private_key)
+{
+	uECC_RNG_Function rng_function = uECC_get_rng();
+
+	if (public_key == (uint8_t *) 0 ||
+	    private_key == (uint8_t *) 0 ||
+	    !rng_function ||
+	    !rng_function(private_key, TC_X25519_KEY_SIZE)) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	return tc_x25519(public_key, private_key, x25519_base_point);
+}
+
+int tc_x25519_shared_secret(const uint8_t *public_key,
+			    const uint8_t *private_key, uint8_t *secret)
+{
+	uint8_t zero = 0;
+	unsigned int i;
+
+	if (tc_x25519(secret, private_key, public_key) != TC_CRYPTO_SUCCESS) {
+		return TC_CRYPTO_FAIL;
+	}
+
+	/* reject low order points, the or over all bytes keeps the time constant */
+	for (i = 0; i < TC_X25519_KEY_SIZE; ++i) {
+		zero |= secret[i];
+	}
+
+	return (zero != 0) ? TC_CRYPTO_SUCCESS : TC_CRYPTO_FAIL;
+}
@@ -84,7 +84,7 @@ int test_1(void)
 			0xead27321, 0xb58dbad2, 0x312bf560, 0x7f8d292f,
 			0xac7766f3, 0x19fadc21, 0x28d12941, 0x575c006e,
 			0xd014f9a8, 0xc9ee2589, 0xe13f0cc8, 0xb6630ca6
-		}
+		}, Nr
 	};
 	struct tc_aes_key_sched_struct s;
 
@@ -2036,6 +2036,159 @@ int test_4(void)
 	return result;
 }
 
+/*
+ * FIPS 197 appendix A.3 key schedule and appendix C.3 AES-256 encryption,
+ * the multi-block routines are checked against the single block ones.
+ */
+int test_5(void)
+{
+	int result = TC_PASS;
+	const uint8_t a3_key[TC_AES256_KEY_SIZE] = {
+		0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe,
+		0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+		0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7,
+		0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+	};
+	const unsigned int a3_last[Nb] = {
+		0xfe4890d1, 0xe6188d0b, 0x046df344, 0x706c631e
+	};
+	const uint8_t c3_key[TC_AES256_KEY_SIZE] = {
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+		0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+		0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+	};
+	const uint8_t c3_input[NUM_OF_NIST_KEYS] = {
+		0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+		0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+	};
+	const uint8_t c3_expected[NUM_OF_NIST_KEYS] = {
+		0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+		0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+	};
+	struct tc_aes_key_sched_struct s;
+	uint8_t blocks[9 * TC_AES_BLOCK_SIZE];
+	uint8_t ciphertext[9 * TC_AES_BLOCK_SIZE];
+	uint8_t expected[TC_AES_BLOCK_SIZE];
+	unsigned int i;
+
+	TC_PRINT("AES256 %s (FIPS 197 AES-256 test):\n", __func__);
+
+	(void)tc_aes256_set_encrypt_key(&s, a3_key);
+	result = check_result(5, a3_last, sizeof(a3_last),
+			      s.words + Nb * TC_AES256_NR, sizeof(a3_last));
+	if (result == TC_FAIL) {
+		goto exitTest5;
+	}
+
+	(void)tc_aes256_set_encrypt_key(&s, c3_key);
+	(void)tc_aes_encrypt(ciphertext, c3_input, &s);
+	result = check_result(5, c3_expected, sizeof(c3_expected), ciphertext,
+			      sizeof(c3_expected));
+	if (result == TC_FAIL) {
+		goto exitTest5;
+	}
+
+	(void)tc_aes_decrypt(ciphertext, c3_expected, &s);
+	result = check_result(5, c3_input, sizeof(c3_input), ciphertext,
+			      sizeof(c3_input));
+	if (result == TC_FAIL) {
+		goto exitTest5;
+	}
+
+	for (i = 0; i < sizeof(blocks); ++i) {
+		blocks[i] = (uint8_t) i;
+	}
+	(void)tc_aes_encrypt_blocks(ciphertext, blocks, 9, &s);
+	for (i = 0; i < 9; ++i) {
+		(void)tc_aes_encrypt(expected, blocks + i * TC_AES_BLOCK_SIZE,
+				     &s);
+		result = check_result(5, expected, sizeof(expected),
+				      ciphertext + i * TC_AES_BLOCK_SIZE,
+				      sizeof(expected));
+		if (result == TC_FAIL) {
+			goto exitTest5;
+		}
+	}
+
+	(void)tc_aes_decrypt_blocks(ciphertext, ciphertext, 9, &s);
+	result = check_result(5, blocks, sizeof(blocks), ciphertext,
+			      sizeof(blocks));
+
+exitTest5:
+	TC_END_RESULT(result);
+
+	return result;
+}
+
+/*
+ * Key schedule cache: hits return the schedule of the same key, keys of
+ * both sizes share the cache and the least recently used key is evicted.
+ */
+int test_6(void)
+{
+	int result = TC_PASS;
+	struct tc_aes_sched_cache cache;
+	struct tc_aes_key_sched_struct s;
+	struct tc_aes_key_sched_struct expected;
+	uint8_t key[TC_AES256_KEY_SIZE];
+	unsigned int i, j, keylen;
+
+	TC_PRINT("AES %s (key schedule cache test):\n", __func__);
+
+	tc_aes_sched_cache_init(&cache, NULL, NULL, NULL);
+
+	/* twice as many keys as entries, each looked up several times */
+	for (j = 0; j < 3; ++j) {
+		for (i = 0; i < 2 * TC_AES_SCHED_CACHE_SIZE; ++i) {
+			memset(key, (int) i, sizeof(key));
+			keylen = (i & 1) ? TC_AES256_KEY_SIZE : TC_AES_KEY_SIZE;
+			if (keylen == TC_AES256_KEY_SIZE) {
+				(void)tc_aes256_set_encrypt_key(&expected, key);
+			} else {
+				(void)tc_aes128_set_encrypt_key(&expected, key);
+			}
+
+			if (tc_aes_sched_cache_get(&cache, &s, key, keylen) !=
+			    TC_CRYPTO_SUCCESS ||
+			    memcmp(&s, &expected, sizeof(s)) != 0) {
+				TC_ERROR("cached schedule of key %u differs\n", i);
+				result = TC_FAIL;
+				goto exitTest6;
+			}
+		}
+	}
+
+	/* the most recently used keys are the ones still cached */
+	for (i = 0; i < TC_AES_SCHED_CACHE_SIZE; ++i) {
+		if (cache.entries[i].key[0] < TC_AES_SCHED_CACHE_SIZE) {
+			TC_ERROR("least recently used key was not evicted\n");
+			result = TC_FAIL;
+			goto exitTest6;
+		}
+	}
+
+	if (tc_aes_sched_cache_get(&cache, &s, key, 24) != TC_CRYPTO_FAIL) {
+		TC_ERROR("unsupported key length accepted\n");
+		result = TC_FAIL;
+		goto exitTest6;
+	}
+
+	tc_aes_sched_cache_clear(&cache);
+	for (i = 0; i < TC_AES_SCHED_CACHE_SIZE; ++i) {
+		if (cache.entries[i].keylen != 0) {
+			TC_ERROR("cache not cleared\n");
+			result = TC_FAIL;
+			goto exitTest6;
+		}
+	}
+
+exitTest6:
+	TC_END_RESULT(result);
+
+	return result;
+}
+
 /*
  * Main task to test AES
  */
@@ -2043,7 +2196,7 @@ int main(void)
 {
 	int result = TC_PASS;
 
-	TC_START("Performing AES128 tests:");
+	TC_START("Performing AES tests:");
 
 	result = test_1();
 	if (result == TC_FAIL) { /* terminate test */
@@ -2068,7 +2221,18 @@ int main(void)
 		goto exitTest;
 	}
 
-	TC_PRINT("All AES128 tests succeeded!\n");
+	result = test_5();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("AES256 test #5 (FIPS 197 AES-256 test) failed.\n");
+		goto exitTest;
+	}
+	result = test_6();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("AES test #6 (key schedule cache test) failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("All AES tests succeeded!\n");
 
  exitTest:
 	TC_END_RESULT(result);
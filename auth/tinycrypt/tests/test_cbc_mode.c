@@ -35,6 +35,7 @@
  *
  * Scenarios tested include:
  * - AES128 CBC mode encryption SP 800-38a tests
+ * - AES128 CBC mode multi-block decryption round trip
  */
 
 #include <tinycrypt/cbc_mode.h>
@@ -149,6 +150,54 @@ exitTest1:
 	return result;
 }
 
+/*
+ * CBC round trip over enough blocks to exercise both a full and a partial
+ * batch of the multi-block decrypt path.
+ */
+#define MULTI_BLOCKS (TC_AES_PARALLEL_BLOCKS + 3)
+
+int test_3(void)
+{
+	struct tc_aes_key_sched_struct a;
+	uint8_t msg[MULTI_BLOCKS * TC_AES_BLOCK_SIZE];
+	uint8_t encrypted[(MULTI_BLOCKS + 1) * TC_AES_BLOCK_SIZE];
+	uint8_t decrypted[MULTI_BLOCKS * TC_AES_BLOCK_SIZE];
+	unsigned int i;
+	int result = TC_PASS;
+
+	for (i = 0; i < sizeof(msg); ++i) {
+		msg[i] = (uint8_t)(i * 7 + 3);
+	}
+
+	TC_PRINT("CBC test #3 (multi-block decryption round trip):\n");
+	(void)tc_aes128_set_encrypt_key(&a, key);
+
+	if (tc_cbc_mode_encrypt(encrypted, sizeof(encrypted), msg, sizeof(msg),
+				iv, &a) == 0) {
+		TC_ERROR("CBC test #3 (multi-block encryption) failed in %s.\n",
+			 __func__);
+		result = TC_FAIL;
+		goto exitTest3;
+	}
+
+	(void)tc_aes128_set_decrypt_key(&a, key);
+
+	if (tc_cbc_mode_decrypt(decrypted, sizeof(decrypted),
+				&encrypted[TC_AES_BLOCK_SIZE], sizeof(decrypted),
+				encrypted, &a) == 0) {
+		TC_ERROR("CBC test #3 (multi-block decryption) failed in %s.\n",
+			 __func__);
+		result = TC_FAIL;
+		goto exitTest3;
+	}
+
+	result = check_result(3, msg, sizeof(msg), decrypted, sizeof(decrypted));
+
+exitTest3:
+	TC_END_RESULT(result);
+	return result;
+}
+
 /*
  * Main task to test AES
  */
@@ -166,6 +215,13 @@ int main(void)
 		goto exitTest;
 	}
 
+	result = test_3();
+	if (result == TC_FAIL) {
+		/* terminate test */
+		TC_ERROR("CBC test #3 failed.\n");
+		goto exitTest;
+	}
+
 	TC_PRINT("All CBC tests succeeded!\n");
 
 exitTest:
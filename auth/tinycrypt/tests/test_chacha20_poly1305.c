@@ -0,0 +1,274 @@
+/* test_chacha20_poly1305.c - TinyCrypt ChaCha20-Poly1305 tests */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ *  DESCRIPTION
+ * This module tests the following ChaCha20-Poly1305 routines:
+ *
+ *  Scenarios tested include:
+ *  - ChaCha20-Poly1305 AEAD encryption RFC 8439 section 2.8.2 test vector
+ *  - ChaCha20-Poly1305 AEAD encryption, payload spanning the 8, 4 and
+ *    single block keystream paths
+ *  - ChaCha20-Poly1305 AEAD decryption rejects a modified ciphertext or tag
+ */
+
+#include <tinycrypt/chacha20_poly1305.h>
+#include <tinycrypt/constants.h>
+#include <test_utils.h>
+
+#include <string.h>
+
+#define TC_CHACHAPOLY_MAX_PT_SIZE 777
+#define TC_CHACHAPOLY_MAX_CT_SIZE \
+	(TC_CHACHAPOLY_MAX_PT_SIZE + TC_POLY1305_TAG_SIZE)
+#define DATA_BUF_LEN114 114
+#define HEADER_LEN7 7
+#define HEADER_LEN12 12
+
+/*
+ * Encrypts data, compares ciphertext and tag against the expected values
+ * (when expected is not NULL) and checks the decryption round trip.
+ */
+int do_test(const uint8_t *key, const uint8_t *nonce,
+	    const uint8_t *hdr, size_t hlen,
+	    const uint8_t *data, size_t dlen,
+	    const uint8_t *expected, const uint8_t *tag)
+{
+	int result = TC_PASS;
+
+	uint8_t ciphertext[TC_CHACHAPOLY_MAX_CT_SIZE];
+	uint8_t decrypted[TC_CHACHAPOLY_MAX_PT_SIZE];
+	struct tc_chacha20_poly1305_struct c;
+
+	result = tc_chacha20_poly1305_config(&c, key, nonce,
+					     TC_CHACHA20_NONCE_SIZE);
+	if (result == 0) {
+		TC_ERROR("ChaCha20-Poly1305 config failed in %s.\n", __func__);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	result = tc_chacha20_poly1305_generation_encryption(ciphertext,
+							    sizeof(ciphertext),
+							    hdr, hlen, data,
+							    dlen, &c);
+	if (result == 0) {
+		TC_ERROR("chachapoly_encrypt failed in %s.\n", __func__);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	if (expected != NULL && memcmp(expected, ciphertext, dlen) != 0) {
+		TC_ERROR("chachapoly_encrypt produced wrong ciphertext in %s.\n",
+			 __func__);
+		show_str("\t\tExpected", expected, dlen);
+		show_str("\t\tComputed", ciphertext, dlen);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	if (memcmp(tag, ciphertext + dlen, TC_POLY1305_TAG_SIZE) != 0) {
+		TC_ERROR("chachapoly_encrypt produced wrong tag in %s.\n",
+			 __func__);
+		show_str("\t\tExpected", tag, TC_POLY1305_TAG_SIZE);
+		show_str("\t\tComputed", ciphertext + dlen,
+			 TC_POLY1305_TAG_SIZE);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	result = tc_chacha20_poly1305_decryption_verification(decrypted,
+							      sizeof(decrypted),
+							      hdr, hlen,
+							      ciphertext,
+							      dlen + TC_POLY1305_TAG_SIZE,
+							      &c);
+	if (result == 0 || memcmp(data, decrypted, dlen) != 0) {
+		TC_ERROR("chachapoly_decrypt failed in %s.\n", __func__);
+		show_str("\t\tExpected", data, dlen);
+		show_str("\t\tComputed", decrypted, dlen);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	result = TC_PASS;
+
+exitTest1:
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_1(void)
+{
+	/* RFC 8439 section 2.8.2 */
+	const char data[DATA_BUF_LEN114 + 1] =
+		"Ladies and Gentlemen of the class of '99: If I could offer "
+		"you only one tip for the future, sunscreen would be it.";
+	const uint8_t nonce[TC_CHACHA20_NONCE_SIZE] = {
+		0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43,
+		0x44, 0x45, 0x46, 0x47
+	};
+	const uint8_t hdr[HEADER_LEN12] = {
+		0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3,
+		0xc4, 0xc5, 0xc6, 0xc7
+	};
+	const uint8_t expected[DATA_BUF_LEN114] = {
+		0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb,
+		0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+		0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe,
+		0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+		0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12,
+		0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+		0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29,
+		0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+		0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c,
+		0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+		0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94,
+		0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+		0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d,
+		0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+		0x61, 0x16
+	};
+	const uint8_t tag[TC_POLY1305_TAG_SIZE] = {
+		0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a,
+		0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91
+	};
+	uint8_t key[TC_CHACHA20_KEY_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(key); i++) {
+		key[i] = (uint8_t)(0x80 + i);
+	}
+
+	TC_PRINT("%s: Performing ChaCha20-Poly1305 test #1 (RFC 8439):\n",
+		 __func__);
+
+	return do_test(key, nonce, hdr, sizeof(hdr), (const uint8_t *) data,
+		       DATA_BUF_LEN114, expected, tag);
+}
+
+int test_vector_2(void)
+{
+	/*
+	 * 777 byte payload: one 8 block batch, one 4 block batch and a partial
+	 * block, tag computed with an independent implementation.
+	 */
+	const uint8_t tag[TC_POLY1305_TAG_SIZE] = {
+		0xfd, 0x93, 0x5a, 0x5f, 0xd0, 0xc9, 0xf2, 0xa2,
+		0xc9, 0x3d, 0x8f, 0x3e, 0xa4, 0x80, 0xe3, 0x7c
+	};
+	uint8_t key[TC_CHACHA20_KEY_SIZE];
+	uint8_t nonce[TC_CHACHA20_NONCE_SIZE];
+	uint8_t hdr[HEADER_LEN7];
+	uint8_t data[TC_CHACHAPOLY_MAX_PT_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(key); i++) {
+		key[i] = (uint8_t)(i * 3);
+	}
+	for (i = 0; i < sizeof(nonce); i++) {
+		nonce[i] = (uint8_t) i;
+	}
+	for (i = 0; i < sizeof(hdr); i++) {
+		hdr[i] = (uint8_t) i;
+	}
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)(i * 7);
+	}
+
+	TC_PRINT("%s: Performing ChaCha20-Poly1305 test #2 (long payload):\n",
+		 __func__);
+
+	return do_test(key, nonce, hdr, sizeof(hdr), data, sizeof(data),
+		       NULL, tag);
+}
+
+int test_vector_3(void)
+{
+	int result = TC_PASS;
+	const uint8_t key[TC_CHACHA20_KEY_SIZE] = { 0x01 };
+	const uint8_t nonce[TC_CHACHA20_NONCE_SIZE] = { 0x02 };
+	const uint8_t hdr[HEADER_LEN7] = { 0x03 };
+	uint8_t data[DATA_BUF_LEN114] = { 0x04 };
+	uint8_t ciphertext[DATA_BUF_LEN114 + TC_POLY1305_TAG_SIZE];
+	uint8_t decrypted[DATA_BUF_LEN114];
+	struct tc_chacha20_poly1305_struct c;
+	unsigned int i;
+
+	TC_PRINT("%s: Performing ChaCha20-Poly1305 test #3 (tampered data):\n",
+		 __func__);
+
+	(void)tc_chacha20_poly1305_config(&c, key, nonce,
+					  TC_CHACHA20_NONCE_SIZE);
+	(void)tc_chacha20_poly1305_generation_encryption(ciphertext,
+							 sizeof(ciphertext),
+							 hdr, sizeof(hdr),
+							 data, sizeof(data),
+							 &c);
+
+	/* flip one bit in each ciphertext and tag byte in turn */
+	for (i = 0; i < sizeof(ciphertext); i++) {
+		ciphertext[i] ^= 0x80;
+
+		if (tc_chacha20_poly1305_decryption_verification(decrypted,
+								 sizeof(decrypted),
+								 hdr, sizeof(hdr),
+								 ciphertext,
+								 sizeof(ciphertext),
+								 &c) != 0) {
+			TC_ERROR("chachapoly_decrypt accepted modified byte %u in %s.\n",
+				 i, __func__);
+			result = TC_FAIL;
+			break;
+		}
+
+		ciphertext[i] ^= 0x80;
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+/*
+ * Main task to test ChaCha20-Poly1305
+ */
+int main(void)
+{
+	int result = TC_PASS;
+
+	TC_START("Performing ChaCha20-Poly1305 tests:");
+
+	result = test_vector_1();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("ChaCha20-Poly1305 test #1 (RFC 8439) failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_2();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("ChaCha20-Poly1305 test #2 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_3();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("ChaCha20-Poly1305 test #3 (tampered data) failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("All ChaCha20-Poly1305 tests succeeded!\n");
+
+exitTest:
+	TC_END_RESULT(result);
+	TC_END_REPORT(result);
+
+	return result;
+}
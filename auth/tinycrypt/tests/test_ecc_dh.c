@@ -477,6 +477,78 @@ int montecarlo_ecdh(int num_tests, bool verbose)
         return result;
 }
 
+int ephemeral_pool_ecdh(int num_tests, bool verbose)
+{
+	int i;
+	uint8_t private1[NUM_ECC_BYTES] = {0};
+	uint8_t private2[NUM_ECC_BYTES] = {0};
+	uint8_t public1[2*NUM_ECC_BYTES] = {0};
+	uint8_t public2[2*NUM_ECC_BYTES] = {0};
+	uint8_t secret1[NUM_ECC_BYTES] = {0};
+	uint8_t secret2[NUM_ECC_BYTES] = {0};
+	struct uECC_ephemeral_pool pool;
+        unsigned int result = TC_PASS;
+
+	const struct uECC_Curve_t * curve = uECC_secp256r1();
+
+	TC_PRINT("Test #5: Ephemeral key pool (%d pooled EC-DH key-exchange) ", num_tests);
+	TC_PRINT("NIST-p256\n  ");
+
+	uECC_ephemeral_pool_init(&pool, curve, NULL, NULL, NULL);
+	if (uECC_ephemeral_pool_fill(&pool, uECC_EPHEMERAL_POOL_SIZE + 2) !=
+	    uECC_EPHEMERAL_POOL_SIZE ||
+	    uECC_ephemeral_pool_count(&pool) != uECC_EPHEMERAL_POOL_SIZE) {
+		TC_ERROR("uECC_ephemeral_pool_fill() did not fill the pool\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	/* the last exchanges run with an empty pool and fall back to make_key */
+	for (i = 0; i < num_tests; ++i) {
+		if (verbose) {
+			TC_PRINT(".");
+			fflush(stdout);
+		}
+
+		if (!uECC_ephemeral_pool_take(&pool, public1, private1) ||
+		    !uECC_ephemeral_pool_take(&pool, public2, private2)) {
+			TC_ERROR("uECC_ephemeral_pool_take() failed\n");
+			result = TC_FAIL;
+			goto exitTest1;
+		}
+
+		/* strict single use: two takes never return the same key */
+		if (memcmp(public1, public2, sizeof(public1)) == 0 ||
+		    uECC_valid_public_key(public1, curve) != 0 ||
+		    uECC_valid_public_key(public2, curve) != 0) {
+			TC_ERROR("uECC_ephemeral_pool_take() returned a bad key\n");
+			result = TC_FAIL;
+			goto exitTest1;
+		}
+
+		if (!uECC_shared_secret(public2, private1, secret1, curve) ||
+		    !uECC_shared_secret(public1, private2, secret2, curve) ||
+		    memcmp(secret1, secret2, sizeof(secret1)) != 0) {
+			TC_ERROR("pooled keys did not agree on a shared secret\n");
+			result = TC_FAIL;
+			goto exitTest1;
+		}
+	}
+
+	uECC_ephemeral_pool_clear(&pool);
+	if (uECC_ephemeral_pool_count(&pool) != 0) {
+		TC_ERROR("uECC_ephemeral_pool_clear() left keys in the pool\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	TC_PRINT("\n");
+
+ exitTest1:
+        TC_END_RESULT(result);
+        return result;
+}
+
 int main()
 {
         unsigned int result = TC_PASS;
@@ -512,6 +584,12 @@ int main()
                 TC_ERROR("montecarlo_ecdh test failed.\n");
                 goto exitTest;
         }
+	TC_PRINT("Performing ephemeral_pool_ecdh test:\n");
+	result = ephemeral_pool_ecdh(uECC_EPHEMERAL_POOL_SIZE / 2 + 1, verbose);
+        if (result == TC_FAIL) { /* terminate test */
+                TC_ERROR("ephemeral_pool_ecdh test failed.\n");
+                goto exitTest;
+        }
 
         TC_PRINT("All EC-DH tests succeeded!\n");
 
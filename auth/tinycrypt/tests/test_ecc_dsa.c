@@ -351,6 +351,7 @@ int vrfy_vectors(TCSha256State_t hash, char **msg_vec, char **qx_vec, char **qy_
 	uint8_t sig_bytes[2 * NUM_ECC_BYTES];
 	uint8_t  digest_bytes[TC_SHA256_DIGEST_SIZE];
 	unsigned int digest[TC_SHA256_DIGEST_SIZE / 4];
+	struct uECC_verify_table table;
 	unsigned int result = TC_PASS;
 
 	int rc;
@@ -412,6 +413,15 @@ int vrfy_vectors(TCSha256State_t hash, char **msg_vec, char **qx_vec, char **qy_
 
 			rc = uECC_verify(pub_bytes, digest_bytes, sizeof(digest_bytes), sig_bytes,
 									 uECC_secp256r1());
+
+			/* the cached table must give the same answer */
+			if (!uECC_verify_table_init(&table, pub_bytes, curve) ||
+			    uECC_verify_with_table(&table, digest_bytes, sizeof(digest_bytes),
+						   sig_bytes) != rc) {
+				TC_ERROR("uECC_verify_with_table() disagrees with uECC_verify()\n");
+				result = TC_FAIL;
+				goto exitTest1;
+			}
 			/* CAVP expects 0 for success, others for fail */
 			rc = !rc; 
 			if (exp_rc != 0 && rc != 0) {
@@ -632,6 +642,146 @@ int montecarlo_signverify(int num_tests, bool verbose)
 	return TC_PASS;
 }
 
+static unsigned int pool_lock_depth;
+
+static void pool_lock(void *ctx)
+{
+	(void)ctx;
+	++pool_lock_depth;
+}
+
+static void pool_unlock(void *ctx)
+{
+	(void)ctx;
+	--pool_lock_depth;
+}
+
+int presign_pool_signverify(int num_tests, bool verbose)
+{
+	printf("Test #4: Presignature pool (%d pooled EC-DSA signatures) ", num_tests);
+	printf("NIST-p256, SHA2-256\n  ");
+	int i;
+	uint8_t private[NUM_ECC_BYTES];
+	uint8_t public[2*NUM_ECC_BYTES];
+	uint8_t hash[NUM_ECC_BYTES];
+	uint8_t sig[2*NUM_ECC_BYTES];
+	uint8_t prev_r[NUM_ECC_BYTES];
+	struct uECC_presign_pool pool;
+
+	const struct uECC_Curve_t * curve = uECC_secp256r1();
+
+	uECC_presign_pool_init(&pool, curve, pool_lock, pool_unlock, NULL);
+	memset(hash, 0x5a, sizeof(hash));
+	memset(prev_r, 0, sizeof(prev_r));
+
+	if (!uECC_make_key(public, private, curve)) {
+		TC_ERROR("uECC_make_key() failed\n");
+		return TC_FAIL;
+	}
+
+	if (uECC_presign_pool_fill(&pool, uECC_PRESIGN_POOL_SIZE + 2) !=
+	    uECC_PRESIGN_POOL_SIZE ||
+	    uECC_presign_pool_count(&pool) != uECC_PRESIGN_POOL_SIZE) {
+		TC_ERROR("uECC_presign_pool_fill() did not fill the pool\n");
+		return TC_FAIL;
+	}
+
+	/* the last signatures run with an empty pool and fall back to uECC_sign */
+	for (i = 0; i < num_tests; ++i) {
+		if (verbose) {
+			TC_PRINT(".");
+			fflush(stdout);
+		}
+
+		if (!uECC_sign_pooled(&pool, private, hash, sizeof(hash), sig)) {
+			TC_ERROR("uECC_sign_pooled() failed\n");
+			return TC_FAIL;
+		}
+
+		if (!uECC_verify(public, hash, sizeof(hash), sig, curve)) {
+			TC_ERROR("uECC_verify() failed on a pooled signature\n");
+			return TC_FAIL;
+		}
+
+		/* every signature must use a fresh nonce */
+		if (memcmp(prev_r, sig, sizeof(prev_r)) == 0) {
+			TC_ERROR("uECC_sign_pooled() reused a presignature\n");
+			return TC_FAIL;
+		}
+		memcpy(prev_r, sig, sizeof(prev_r));
+	}
+
+	if (uECC_presign_pool_fill(&pool, 1) != 1 ||
+	    uECC_presign_pool_count(&pool) != 1) {
+		TC_ERROR("uECC_presign_pool_fill() did not honor max\n");
+		return TC_FAIL;
+	}
+	uECC_presign_pool_clear(&pool);
+	if (uECC_presign_pool_count(&pool) != 0 || pool_lock_depth != 0) {
+		TC_ERROR("uECC_presign_pool_clear() left the pool inconsistent\n");
+		return TC_FAIL;
+	}
+
+	TC_PRINT("\n");
+	return TC_PASS;
+}
+
+int verify_table_signverify(int num_tests, bool verbose)
+{
+	printf("Test #5: Verify table (%d signatures with one key) ", num_tests);
+	printf("NIST-p256, SHA2-256\n  ");
+	int i;
+	uint8_t private[NUM_ECC_BYTES];
+	uint8_t public[2*NUM_ECC_BYTES];
+	uint8_t hash[NUM_ECC_BYTES];
+	uint8_t sig[2*NUM_ECC_BYTES];
+	struct uECC_verify_table table;
+
+	const struct uECC_Curve_t * curve = uECC_secp256r1();
+
+	if (!uECC_make_key(public, private, curve) ||
+	    !uECC_verify_table_init(&table, public, curve)) {
+		TC_ERROR("uECC_verify_table_init() failed\n");
+		return TC_FAIL;
+	}
+
+	for (i = 0; i < num_tests; ++i) {
+		if (verbose) {
+			TC_PRINT(".");
+			fflush(stdout);
+		}
+
+		hash[0] = (uint8_t)i;
+		memset(hash + 1, 0xa5, sizeof(hash) - 1);
+
+		if (!uECC_sign(private, hash, sizeof(hash), sig, curve)) {
+			TC_ERROR("uECC_sign() failed\n");
+			return TC_FAIL;
+		}
+
+		if (!uECC_verify_with_table(&table, hash, sizeof(hash), sig)) {
+			TC_ERROR("uECC_verify_with_table() failed\n");
+			return TC_FAIL;
+		}
+
+		hash[1] ^= 1;
+		if (uECC_verify_with_table(&table, hash, sizeof(hash), sig)) {
+			TC_ERROR("uECC_verify_with_table() accepted a wrong hash\n");
+			return TC_FAIL;
+		}
+	}
+
+	/* a point off the curve must be rejected */
+	public[0] ^= 1;
+	if (uECC_verify_table_init(&table, public, curve)) {
+		TC_ERROR("uECC_verify_table_init() accepted an invalid key\n");
+		return TC_FAIL;
+	}
+
+	TC_PRINT("\n");
+	return TC_PASS;
+}
+
 int main()
 {
 	unsigned int result = TC_PASS;
@@ -660,6 +810,19 @@ int main()
 		TC_ERROR("montecarlo_signverify test failed.\n");
 	goto exitTest;
 	}
+	TC_PRINT("Performing presign_pool_signverify test:\n");
+	result = presign_pool_signverify(uECC_PRESIGN_POOL_SIZE + 2, verbose);
+	if (result == TC_FAIL) {
+		TC_ERROR("presign_pool_signverify test failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("Performing verify_table_signverify test:\n");
+	result = verify_table_signverify(10, verbose);
+	if (result == TC_FAIL) {
+		TC_ERROR("verify_table_signverify test failed.\n");
+		goto exitTest;
+	}
 
 	TC_PRINT("\nAll ECC-DSA tests succeeded.\n");
 
@@ -0,0 +1,382 @@
+/* test_ed25519.c - TinyCrypt Ed25519 tests (RFC 8032 tests) */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ *  DESCRIPTION
+ * This module tests the following Ed25519 routines:
+ *
+ *  Scenarios tested include:
+ *  - Ed25519 RFC 8032 section 7.1 tests 1, 2 and 3: public key, signature
+ *    and verification
+ *  - Ed25519 verification rejects a modified message, R, S and a
+ *    non-canonical S
+ *  - Ed25519 batch verification of generated key pairs, larger than one chunk
+ *  - Ed25519 batch verification rejects a batch with one bad signature
+ */
+
+#include <tinycrypt/ed25519.h>
+#include <tinycrypt/ecc.h>
+#include <tinycrypt/ecc_platform_specific.h>
+#include <tinycrypt/constants.h>
+#include <test_utils.h>
+
+#include <string.h>
+
+#define BATCH_SIZE (TC_ED25519_BATCH_MAX + 3)
+
+struct rfc8032_vector {
+	uint8_t private_key[TC_ED25519_KEY_SIZE];
+	uint8_t public_key[TC_ED25519_KEY_SIZE];
+	uint8_t message[2];
+	unsigned int mlen;
+	uint8_t signature[TC_ED25519_SIGNATURE_SIZE];
+};
+
+/* RFC 8032 section 7.1, TEST 1, TEST 2 and TEST 3 */
+static const struct rfc8032_vector vectors[] = {
+	{
+		{
+		0x9d, 0x61, 0xb1, 0x9d, 0xef, 0xfd, 0x5a, 0x60,
+		0xba, 0x84, 0x4a, 0xf4, 0x92, 0xec, 0x2c, 0xc4,
+		0x44, 0x49, 0xc5, 0x69, 0x7b, 0x32, 0x69, 0x19,
+		0x70, 0x3b, 0xac, 0x03, 0x1c, 0xae, 0x7f, 0x60
+		},
+		{
+		0xd7, 0x5a, 0x98, 0x01, 0x82, 0xb1, 0x0a, 0xb7,
+		0xd5, 0x4b, 0xfe, 0xd3, 0xc9, 0x64, 0x07, 0x3a,
+		0x0e, 0xe1, 0x72, 0xf3, 0xda, 0xa6, 0x23, 0x25,
+		0xaf, 0x02, 0x1a, 0x68, 0xf7, 0x07, 0x51, 0x1a
+		},
+		{ 0 }, 0,
+		{
+		0xe5, 0x56, 0x43, 0x00, 0xc3, 0x60, 0xac, 0x72,
+		0x90, 0x86, 0xe2, 0xcc, 0x80, 0x6e, 0x82, 0x8a,
+		0x84, 0x87, 0x7f, 0x1e, 0xb8, 0xe5, 0xd9, 0x74,
+		0xd8, 0x73, 0xe0, 0x65, 0x22, 0x49, 0x01, 0x55,
+		0x5f, 0xb8, 0x82, 0x15, 0x90, 0xa3, 0x3b, 0xac,
+		0xc6, 0x1e, 0x39, 0x70, 0x1c, 0xf9, 0xb4, 0x6b,
+		0xd2, 0x5b, 0xf5, 0xf0, 0x59, 0x5b, 0xbe, 0x24,
+		0x65, 0x51, 0x41, 0x43, 0x8e, 0x7a, 0x10, 0x0b
+		}
+	},
+	{
+		{
+		0x4c, 0xcd, 0x08, 0x9b, 0x28, 0xff, 0x96, 0xda,
+		0x9d, 0xb6, 0xc3, 0x46, 0xec, 0x11, 0x4e, 0x0f,
+		0x5b, 0x8a, 0x31, 0x9f, 0x35, 0xab, 0xa6, 0x24,
+		0xda, 0x8c, 0xf6, 0xed, 0x4f, 0xb8, 0xa6, 0xfb
+		},
+		{
+		0x3d, 0x40, 0x17, 0xc3, 0xe8, 0x43, 0x89, 0x5a,
+		0x92, 0xb7, 0x0a, 0xa7, 0x4d, 0x1b, 0x7e, 0xbc,
+		0x9c, 0x98, 0x2c, 0xcf, 0x2e, 0xc4, 0x96, 0x8c,
+		0xc0, 0xcd, 0x55, 0xf1, 0x2a, 0xf4, 0x66, 0x0c
+		},
+		{ 0x72 }, 1,
+		{
+		0x92, 0xa0, 0x09, 0xa9, 0xf0, 0xd4, 0xca, 0xb8,
+		0x72, 0x0e, 0x82, 0x0b, 0x5f, 0x64, 0x25, 0x40,
+		0xa2, 0xb2, 0x7b, 0x54, 0x16, 0x50, 0x3f, 0x8f,
+		0xb3, 0x76, 0x22, 0x23, 0xeb, 0xdb, 0x69, 0xda,
+		0x08, 0x5a, 0xc1, 0xe4, 0x3e, 0x15, 0x99, 0x6e,
+		0x45, 0x8f, 0x36, 0x13, 0xd0, 0xf1, 0x1d, 0x8c,
+		0x38, 0x7b, 0x2e, 0xae, 0xb4, 0x30, 0x2a, 0xee,
+		0xb0, 0x0d, 0x29, 0x16, 0x12, 0xbb, 0x0c, 0x00
+		}
+	},
+	{
+		{
+		0xc5, 0xaa, 0x8d, 0xf4, 0x3f, 0x9f, 0x83, 0x7b,
+		0xed, 0xb7, 0x44, 0x2f, 0x31, 0xdc, 0xb7, 0xb1,
+		0x66, 0xd3, 0x85, 0x35, 0x07, 0x6f, 0x09, 0x4b,
+		0x85, 0xce, 0x3a, 0x2e, 0x0b, 0x44, 0x58, 0xf7
+		},
+		{
+		0xfc, 0x51, 0xcd, 0x8e, 0x62, 0x18, 0xa1, 0xa3,
+		0x8d, 0xa4, 0x7e, 0xd0, 0x02, 0x30, 0xf0, 0x58,
+		0x08, 0x16, 0xed, 0x13, 0xba, 0x33, 0x03, 0xac,
+		0x5d, 0xeb, 0x91, 0x15, 0x48, 0x90, 0x80, 0x25
+		},
+		{ 0xaf, 0x82 }, 2,
+		{
+		0x62, 0x91, 0xd6, 0x57, 0xde, 0xec, 0x24, 0x02,
+		0x48, 0x27, 0xe6, 0x9c, 0x3a, 0xbe, 0x01, 0xa3,
+		0x0c, 0xe5, 0x48, 0xa2, 0x84, 0x74, 0x3a, 0x44,
+		0x5e, 0x36, 0x80, 0xd7, 0xdb, 0x5a, 0xc3, 0xac,
+		0x18, 0xff, 0x9b, 0x53, 0x8d, 0x16, 0xf2, 0x90,
+		0xae, 0x67, 0xf7, 0x60, 0x98, 0x4d, 0xc6, 0x59,
+		0x4a, 0x7c, 0x15, 0xe9, 0x71, 0x6e, 0xd2, 0x8d,
+		0xc0, 0x27, 0xbe, 0xce, 0xea, 0x1e, 0xc4, 0x0a
+		}
+	}
+};
+
+static int check(const char *what, const uint8_t *expected,
+		 const uint8_t *computed, unsigned int len)
+{
+	if (memcmp(expected, computed, len) != 0) {
+		TC_ERROR("%s produced a wrong result.\n", what);
+		show_str("\t\tExpected", expected, len);
+		show_str("\t\tComputed", computed, len);
+		return TC_FAIL;
+	}
+	return TC_PASS;
+}
+
+int test_vector_1(void)
+{
+	int result = TC_PASS;
+	uint8_t public_key[TC_ED25519_KEY_SIZE];
+	uint8_t signature[TC_ED25519_SIGNATURE_SIZE];
+	const struct rfc8032_vector *v;
+	unsigned int i;
+
+	TC_PRINT("%s: Performing Ed25519 test #1 (RFC 8032 vectors):\n",
+		 __func__);
+
+	for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i) {
+		v = &vectors[i];
+
+		(void)tc_ed25519_public_key(public_key, v->private_key);
+		result = check("ed25519 public key", v->public_key, public_key,
+			       sizeof(public_key));
+		if (result == TC_FAIL) {
+			break;
+		}
+
+		if (!tc_ed25519_sign(v->private_key, v->public_key, v->message,
+				     v->mlen, signature)) {
+			TC_ERROR("tc_ed25519_sign failed.\n");
+			result = TC_FAIL;
+			break;
+		}
+		result = check("ed25519 signature", v->signature, signature,
+			       sizeof(signature));
+		if (result == TC_FAIL) {
+			break;
+		}
+
+		if (!tc_ed25519_verify(v->public_key, v->message, v->mlen,
+				       v->signature)) {
+			TC_ERROR("tc_ed25519_verify rejected vector %u.\n", i + 1);
+			result = TC_FAIL;
+			break;
+		}
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_2(void)
+{
+	int result = TC_PASS;
+	const struct rfc8032_vector *v = &vectors[2];
+	uint8_t message[2];
+	uint8_t signature[TC_ED25519_SIGNATURE_SIZE];
+	/* S + L, the same scalar modulo L */
+	static const uint8_t l[32] = {
+		0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+		0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+	};
+	unsigned int i, carry;
+
+	TC_PRINT("%s: Performing Ed25519 test #2 (tampering):\n", __func__);
+
+	memcpy(message, v->message, sizeof(message));
+	message[1] ^= 0x01;
+	if (tc_ed25519_verify(v->public_key, message, v->mlen, v->signature)) {
+		TC_ERROR("tc_ed25519_verify accepted a modified message.\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	memcpy(signature, v->signature, sizeof(signature));
+	signature[5] ^= 0x10;
+	if (tc_ed25519_verify(v->public_key, v->message, v->mlen, signature)) {
+		TC_ERROR("tc_ed25519_verify accepted a modified R.\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	memcpy(signature, v->signature, sizeof(signature));
+	signature[40] ^= 0x01;
+	if (tc_ed25519_verify(v->public_key, v->message, v->mlen, signature)) {
+		TC_ERROR("tc_ed25519_verify accepted a modified S.\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	memcpy(signature, v->signature, sizeof(signature));
+	for (i = 0, carry = 0; i < 32; ++i) {
+		carry += signature[32 + i] + l[i];
+		signature[32 + i] = (uint8_t) carry;
+		carry >>= 8;
+	}
+	if (tc_ed25519_verify(v->public_key, v->message, v->mlen, signature)) {
+		TC_ERROR("tc_ed25519_verify accepted a non-canonical S.\n");
+		result = TC_FAIL;
+	}
+
+exitTest1:
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_3(void)
+{
+	int result = TC_PASS;
+	uint8_t public_keys[BATCH_SIZE][TC_ED25519_KEY_SIZE];
+	uint8_t private_key[TC_ED25519_KEY_SIZE];
+	uint8_t messages[BATCH_SIZE][48];
+	uint8_t signatures[BATCH_SIZE][TC_ED25519_SIGNATURE_SIZE];
+	const uint8_t *pk[BATCH_SIZE], *m[BATCH_SIZE], *sig[BATCH_SIZE];
+	unsigned int mlens[BATCH_SIZE];
+	unsigned int i;
+
+	TC_PRINT("%s: Performing Ed25519 test #3 (batch verification):\n",
+		 __func__);
+
+	for (i = 0; i < BATCH_SIZE; ++i) {
+		if (!tc_ed25519_make_key(public_keys[i], private_key)) {
+			TC_ERROR("tc_ed25519_make_key failed.\n");
+			result = TC_FAIL;
+			goto exitTest1;
+		}
+		memset(messages[i], (int) i, sizeof(messages[i]));
+		mlens[i] = i * 4;
+		(void)tc_ed25519_sign(private_key, public_keys[i], messages[i],
+				      mlens[i], signatures[i]);
+		if (!tc_ed25519_verify(public_keys[i], messages[i], mlens[i],
+				       signatures[i])) {
+			TC_ERROR("tc_ed25519_verify rejected signature %u.\n", i);
+			result = TC_FAIL;
+			goto exitTest1;
+		}
+		pk[i] = public_keys[i];
+		m[i] = messages[i];
+		sig[i] = signatures[i];
+	}
+
+	if (!tc_ed25519_verify_batch(pk, m, mlens, sig, BATCH_SIZE)) {
+		TC_ERROR("tc_ed25519_verify_batch rejected a valid batch.\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	/* the RFC 8032 vectors in a batch of their own */
+	for (i = 0; i < 3; ++i) {
+		pk[i] = vectors[i].public_key;
+		m[i] = vectors[i].message;
+		mlens[i] = vectors[i].mlen;
+		sig[i] = vectors[i].signature;
+	}
+	if (!tc_ed25519_verify_batch(pk, m, mlens, sig, 3)) {
+		TC_ERROR("tc_ed25519_verify_batch rejected the RFC 8032 vectors.\n");
+		result = TC_FAIL;
+	}
+
+exitTest1:
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_4(void)
+{
+	int result = TC_PASS;
+	uint8_t public_keys[BATCH_SIZE][TC_ED25519_KEY_SIZE];
+	uint8_t private_key[TC_ED25519_KEY_SIZE];
+	uint8_t messages[BATCH_SIZE][16];
+	uint8_t signatures[BATCH_SIZE][TC_ED25519_SIGNATURE_SIZE];
+	const uint8_t *pk[BATCH_SIZE], *m[BATCH_SIZE], *sig[BATCH_SIZE];
+	unsigned int mlens[BATCH_SIZE];
+	unsigned int i;
+
+	TC_PRINT("%s: Performing Ed25519 test #4 (batch with a bad signature):\n",
+		 __func__);
+
+	for (i = 0; i < BATCH_SIZE; ++i) {
+		if (!tc_ed25519_make_key(public_keys[i], private_key)) {
+			TC_ERROR("tc_ed25519_make_key failed.\n");
+			result = TC_FAIL;
+			goto exitTest1;
+		}
+		memset(messages[i], 0xa5, sizeof(messages[i]));
+		mlens[i] = sizeof(messages[i]);
+		(void)tc_ed25519_sign(private_key, public_keys[i], messages[i],
+				      mlens[i], signatures[i]);
+		pk[i] = public_keys[i];
+		m[i] = messages[i];
+		sig[i] = signatures[i];
+	}
+
+	/* a signature over a different message, in the second chunk */
+	messages[BATCH_SIZE - 1][3] ^= 0x80;
+	if (tc_ed25519_verify_batch(pk, m, mlens, sig, BATCH_SIZE)) {
+		TC_ERROR("tc_ed25519_verify_batch accepted a bad message.\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+	messages[BATCH_SIZE - 1][3] ^= 0x80;
+
+	/* two signatures swapped between their keys, in the first chunk */
+	sig[0] = signatures[1];
+	sig[1] = signatures[0];
+	if (tc_ed25519_verify_batch(pk, m, mlens, sig, BATCH_SIZE)) {
+		TC_ERROR("tc_ed25519_verify_batch accepted swapped signatures.\n");
+		result = TC_FAIL;
+	}
+
+exitTest1:
+	TC_END_RESULT(result);
+	return result;
+}
+
+/*
+ * Main task to test Ed25519
+ */
+int main(void)
+{
+	int result = TC_PASS;
+
+	TC_START("Performing Ed25519 tests:");
+
+	/* Setup of the Cryptographically Secure PRNG. */
+	uECC_set_rng(&default_CSPRNG);
+
+	result = test_vector_1();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("Ed25519 test #1 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_2();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("Ed25519 test #2 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_3();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("Ed25519 test #3 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_4();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("Ed25519 test #4 failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("All Ed25519 tests succeeded!\n");
+
+exitTest:
+	TC_END_RESULT(result);
+	TC_END_REPORT(result);
+
+	return result;
+}
@@ -0,0 +1,319 @@
+/* test_gcm_mode.c - TinyCrypt AES-GCM tests */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ *  DESCRIPTION
+ * This module tests the following AES-GCM Mode routines:
+ *
+ *  Scenarios tested include:
+ *  - AES128 GCM mode encryption, GCM specification test case #2
+ *  - AES128 GCM mode encryption, GCM specification test case #3
+ *  - AES128 GCM mode encryption, GCM specification test case #4
+ *  - AES128 GCM mode encryption, payload longer than one counter batch
+ *  - AES128 GCM mode decryption rejects a modified ciphertext or tag
+ */
+
+#include <tinycrypt/gcm_mode.h>
+#include <tinycrypt/constants.h>
+#include <test_utils.h>
+
+#include <string.h>
+
+#define TC_GCM_MAX_PT_SIZE 200
+#define TC_GCM_MAX_CT_SIZE (TC_GCM_MAX_PT_SIZE + TC_GCM_TAG_MAX_BYTES)
+#define NUM_NIST_KEYS 16
+#define M_LEN16 16
+#define DATA_BUF_LEN16 16
+#define DATA_BUF_LEN60 60
+#define DATA_BUF_LEN64 64
+#define HEADER_LEN20 20
+#define HEADER_LEN33 33
+
+static const uint8_t tc3_key[NUM_NIST_KEYS] = {
+	0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+	0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+};
+
+static const uint8_t tc3_nonce[TC_GCM_NONCE_SIZE] = {
+	0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad,
+	0xde, 0xca, 0xf8, 0x88
+};
+
+static const uint8_t tc3_data[DATA_BUF_LEN64] = {
+	0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5,
+	0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+	0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda,
+	0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+	0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53,
+	0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+	0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57,
+	0xba, 0x63, 0x7b, 0x39, 0x1a, 0xaf, 0xd2, 0x55
+};
+
+static const uint8_t tc3_ciphertext[DATA_BUF_LEN64] = {
+	0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24,
+	0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+	0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0,
+	0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+	0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c,
+	0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+	0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97,
+	0x3d, 0x58, 0xe0, 0x91, 0x47, 0x3f, 0x59, 0x85
+};
+
+/*
+ * Encrypts data, compares ciphertext and tag against the expected values
+ * (when expected is not NULL) and checks the decryption round trip.
+ */
+int do_test(const uint8_t *key, const uint8_t *nonce,
+	    const uint8_t *hdr, size_t hlen,
+	    const uint8_t *data, size_t dlen,
+	    const uint8_t *expected, const uint8_t *tag,
+	    const unsigned int mlen)
+{
+	int result = TC_PASS;
+
+	uint8_t ciphertext[TC_GCM_MAX_CT_SIZE];
+	uint8_t decrypted[TC_GCM_MAX_PT_SIZE];
+	struct tc_gcm_mode_struct c;
+	struct tc_aes_key_sched_struct sched;
+
+	tc_aes128_set_encrypt_key(&sched, key);
+
+	result = tc_gcm_config(&c, &sched, nonce, TC_GCM_NONCE_SIZE, mlen);
+	if (result == 0) {
+		TC_ERROR("GCM config failed in %s.\n", __func__);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	result = tc_gcm_generation_encryption(ciphertext, sizeof(ciphertext),
+					      hdr, hlen, data, dlen, &c);
+	if (result == 0) {
+		TC_ERROR("gcm_encrypt failed in %s.\n", __func__);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	if (expected != NULL && memcmp(expected, ciphertext, dlen) != 0) {
+		TC_ERROR("gcm_encrypt produced wrong ciphertext in %s.\n",
+			 __func__);
+		show_str("\t\tExpected", expected, dlen);
+		show_str("\t\tComputed", ciphertext, dlen);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	if (memcmp(tag, ciphertext + dlen, mlen) != 0) {
+		TC_ERROR("gcm_encrypt produced wrong tag in %s.\n", __func__);
+		show_str("\t\tExpected", tag, mlen);
+		show_str("\t\tComputed", ciphertext + dlen, mlen);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	result = tc_gcm_decryption_verification(decrypted, sizeof(decrypted),
+						hdr, hlen, ciphertext,
+						dlen + mlen, &c);
+	if (result == 0 || memcmp(data, decrypted, dlen) != 0) {
+		TC_ERROR("gcm_decrypt failed in %s.\n", __func__);
+		show_str("\t\tExpected", data, dlen);
+		show_str("\t\tComputed", decrypted, dlen);
+
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	result = TC_PASS;
+
+exitTest1:
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_1(void)
+{
+	/* GCM specification test case #2: zero key, nonce and payload */
+	const uint8_t key[NUM_NIST_KEYS] = { 0 };
+	const uint8_t nonce[TC_GCM_NONCE_SIZE] = { 0 };
+	const uint8_t data[DATA_BUF_LEN16] = { 0 };
+	const uint8_t expected[DATA_BUF_LEN16] = {
+		0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92,
+		0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78
+	};
+	const uint8_t tag[M_LEN16] = {
+		0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd,
+		0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf
+	};
+
+	TC_PRINT("%s: Performing GCM test #1 (GCM test case #2):\n",
+		 __func__);
+
+	return do_test(key, nonce, NULL, 0, data, sizeof(data),
+		       expected, tag, M_LEN16);
+}
+
+int test_vector_2(void)
+{
+	/* GCM specification test case #3: four blocks, no associated data */
+	const uint8_t tag[M_LEN16] = {
+		0x4d, 0x5c, 0x2a, 0xf3, 0x27, 0xcd, 0x64, 0xa6,
+		0x2c, 0xf3, 0x5a, 0xbd, 0x2b, 0xa6, 0xfa, 0xb4
+	};
+
+	TC_PRINT("%s: Performing GCM test #2 (GCM test case #3):\n",
+		 __func__);
+
+	return do_test(tc3_key, tc3_nonce, NULL, 0, tc3_data, sizeof(tc3_data),
+		       tc3_ciphertext, tag, M_LEN16);
+}
+
+int test_vector_3(void)
+{
+	/* GCM specification test case #4: partial block and associated data */
+	const uint8_t hdr[HEADER_LEN20] = {
+		0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+		0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+		0xab, 0xad, 0xda, 0xd2
+	};
+	const uint8_t tag[M_LEN16] = {
+		0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb,
+		0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47
+	};
+
+	TC_PRINT("%s: Performing GCM test #3 (GCM test case #4):\n",
+		 __func__);
+
+	return do_test(tc3_key, tc3_nonce, hdr, sizeof(hdr), tc3_data,
+		       DATA_BUF_LEN60, tc3_ciphertext, tag, M_LEN16);
+}
+
+int test_vector_4(void)
+{
+	/*
+	 * 200 byte payload, more than TC_AES_PARALLEL_BLOCKS counter blocks,
+	 * tag computed with an independent implementation.
+	 */
+	const uint8_t tag[M_LEN16] = {
+		0xe1, 0x0d, 0x96, 0x5a, 0x47, 0xfd, 0x10, 0x51,
+		0xc4, 0xe1, 0x69, 0xe6, 0x1f, 0x1a, 0x81, 0xf7
+	};
+	uint8_t key[NUM_NIST_KEYS];
+	uint8_t nonce[TC_GCM_NONCE_SIZE];
+	uint8_t hdr[HEADER_LEN33];
+	uint8_t data[TC_GCM_MAX_PT_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(key); i++) {
+		key[i] = (uint8_t) i;
+	}
+	for (i = 0; i < sizeof(nonce); i++) {
+		nonce[i] = (uint8_t) i;
+	}
+	for (i = 0; i < sizeof(hdr); i++) {
+		hdr[i] = (uint8_t) i;
+	}
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)(i * 7);
+	}
+
+	TC_PRINT("%s: Performing GCM test #4 (multiple counter batches):\n",
+		 __func__);
+
+	return do_test(key, nonce, hdr, sizeof(hdr), data, sizeof(data),
+		       NULL, tag, M_LEN16);
+}
+
+int test_vector_5(void)
+{
+	int result = TC_PASS;
+	uint8_t ciphertext[DATA_BUF_LEN64 + M_LEN16];
+	uint8_t decrypted[DATA_BUF_LEN64];
+	struct tc_gcm_mode_struct c;
+	struct tc_aes_key_sched_struct sched;
+	unsigned int i;
+
+	TC_PRINT("%s: Performing GCM test #5 (tampered data rejected):\n",
+		 __func__);
+
+	tc_aes128_set_encrypt_key(&sched, tc3_key);
+	(void)tc_gcm_config(&c, &sched, tc3_nonce, TC_GCM_NONCE_SIZE, M_LEN16);
+	(void)tc_gcm_generation_encryption(ciphertext, sizeof(ciphertext),
+					   NULL, 0, tc3_data,
+					   sizeof(tc3_data), &c);
+
+	/* flip one bit in each ciphertext and tag byte in turn */
+	for (i = 0; i < sizeof(ciphertext); i++) {
+		ciphertext[i] ^= 0x01;
+		memset(decrypted, 0, sizeof(decrypted));
+
+		if (tc_gcm_decryption_verification(decrypted,
+						   sizeof(decrypted), NULL, 0,
+						   ciphertext,
+						   sizeof(ciphertext),
+						   &c) != 0) {
+			TC_ERROR("gcm_decrypt accepted modified byte %u in %s.\n",
+				 i, __func__);
+			result = TC_FAIL;
+			break;
+		}
+
+		ciphertext[i] ^= 0x01;
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+/*
+ * Main task to test GCM
+ */
+int main(void)
+{
+	int result = TC_PASS;
+
+	TC_START("Performing GCM tests:");
+
+	result = test_vector_1();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("GCM test #1 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_2();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("GCM test #2 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_3();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("GCM test #3 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_4();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("GCM test #4 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_5();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("GCM test #5 (tampered data) failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("All GCM tests succeeded!\n");
+
+exitTest:
+	TC_END_RESULT(result);
+	TC_END_REPORT(result);
+
+	return result;
+}
@@ -0,0 +1,224 @@
+/* test_hkdf.c - TinyCrypt HKDF-SHA256 tests (RFC 5869 test vectors) */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ *  DESCRIPTION
+ * This module tests the following HKDF routines:
+ *
+ *  Scenarios tested include:
+ *  - RFC 5869 test case 1, basic test case
+ *  - RFC 5869 test case 2, longer inputs and outputs
+ *  - RFC 5869 test case 3, zero length salt and info
+ *  - invalid output lengths
+ */
+
+#include <tinycrypt/hkdf.h>
+#include <tinycrypt/constants.h>
+#include <test_utils.h>
+
+#include <string.h>
+
+static int check(const char *what, const uint8_t *salt, unsigned int salt_len,
+		 const uint8_t *ikm, unsigned int ikm_len,
+		 const uint8_t *info, unsigned int info_len,
+		 const uint8_t *expected_prk, const uint8_t *expected_okm,
+		 unsigned int okm_len)
+{
+	uint8_t prk[TC_HKDF_PRK_SIZE];
+	uint8_t okm[128];
+
+	(void)tc_hkdf_extract(prk, salt, salt_len, ikm, ikm_len);
+	if (memcmp(expected_prk, prk, sizeof(prk)) != 0) {
+		TC_ERROR("%s produced a wrong PRK.\n", what);
+		show_str("\t\tExpected", expected_prk, sizeof(prk));
+		show_str("\t\tComputed", prk, sizeof(prk));
+		return TC_FAIL;
+	}
+
+	(void)tc_hkdf_expand(okm, okm_len, prk, info, info_len);
+	if (memcmp(expected_okm, okm, okm_len) != 0) {
+		TC_ERROR("%s produced a wrong OKM.\n", what);
+		show_str("\t\tExpected", expected_okm, okm_len);
+		show_str("\t\tComputed", okm, okm_len);
+		return TC_FAIL;
+	}
+
+	memset(okm, 0, sizeof(okm));
+	(void)tc_hkdf(okm, okm_len, salt, salt_len, ikm, ikm_len, info, info_len);
+	if (memcmp(expected_okm, okm, okm_len) != 0) {
+		TC_ERROR("%s produced a wrong OKM with tc_hkdf.\n", what);
+		return TC_FAIL;
+	}
+
+	return TC_PASS;
+}
+
+int test_vector_1(void)
+{
+	int result;
+	const uint8_t salt[13] = {
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		0x08, 0x09, 0x0a, 0x0b, 0x0c
+	};
+	const uint8_t info[10] = {
+		0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+		0xf8, 0xf9
+	};
+	const uint8_t prk[TC_HKDF_PRK_SIZE] = {
+		0x07, 0x77, 0x09, 0x36, 0x2c, 0x2e, 0x32, 0xdf,
+		0x0d, 0xdc, 0x3f, 0x0d, 0xc4, 0x7b, 0xba, 0x63,
+		0x90, 0xb6, 0xc7, 0x3b, 0xb5, 0x0f, 0x9c, 0x31,
+		0x22, 0xec, 0x84, 0x4a, 0xd7, 0xc2, 0xb3, 0xe5
+	};
+	const uint8_t okm[42] = {
+		0x3c, 0xb2, 0x5f, 0x25, 0xfa, 0xac, 0xd5, 0x7a,
+		0x90, 0x43, 0x4f, 0x64, 0xd0, 0x36, 0x2f, 0x2a,
+		0x2d, 0x2d, 0x0a, 0x90, 0xcf, 0x1a, 0x5a, 0x4c,
+		0x5d, 0xb0, 0x2d, 0x56, 0xec, 0xc4, 0xc5, 0xbf,
+		0x34, 0x00, 0x72, 0x08, 0xd5, 0xb8, 0x87, 0x18,
+		0x58, 0x65
+	};
+	uint8_t ikm[22];
+
+	TC_PRINT("%s: Performing HKDF test #1 (basic):\n", __func__);
+
+	memset(ikm, 0x0b, sizeof(ikm));
+	result = check("hkdf vector 1", salt, sizeof(salt), ikm, sizeof(ikm),
+		       info, sizeof(info), prk, okm, sizeof(okm));
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_2(void)
+{
+	int result;
+	const uint8_t prk[TC_HKDF_PRK_SIZE] = {
+		0x06, 0xa6, 0xb8, 0x8c, 0x58, 0x53, 0x36, 0x1a,
+		0x06, 0x10, 0x4c, 0x9c, 0xeb, 0x35, 0xb4, 0x5c,
+		0xef, 0x76, 0x00, 0x14, 0x90, 0x46, 0x71, 0x01,
+		0x4a, 0x19, 0x3f, 0x40, 0xc1, 0x5f, 0xc2, 0x44
+	};
+	const uint8_t okm[82] = {
+		0xb1, 0x1e, 0x39, 0x8d, 0xc8, 0x03, 0x27, 0xa1,
+		0xc8, 0xe7, 0xf7, 0x8c, 0x59, 0x6a, 0x49, 0x34,
+		0x4f, 0x01, 0x2e, 0xda, 0x2d, 0x4e, 0xfa, 0xd8,
+		0xa0, 0x50, 0xcc, 0x4c, 0x19, 0xaf, 0xa9, 0x7c,
+		0x59, 0x04, 0x5a, 0x99, 0xca, 0xc7, 0x82, 0x72,
+		0x71, 0xcb, 0x41, 0xc6, 0x5e, 0x59, 0x0e, 0x09,
+		0xda, 0x32, 0x75, 0x60, 0x0c, 0x2f, 0x09, 0xb8,
+		0x36, 0x77, 0x93, 0xa9, 0xac, 0xa3, 0xdb, 0x71,
+		0xcc, 0x30, 0xc5, 0x81, 0x79, 0xec, 0x3e, 0x87,
+		0xc1, 0x4c, 0x01, 0xd5, 0xc1, 0xf3, 0x43, 0x4f,
+		0x1d, 0x87
+	};
+	uint8_t ikm[80];
+	uint8_t salt[80];
+	uint8_t info[80];
+	unsigned int i;
+
+	TC_PRINT("%s: Performing HKDF test #2 (long inputs):\n", __func__);
+
+	for (i = 0; i < 80; ++i) {
+		ikm[i] = (uint8_t) i;
+		salt[i] = (uint8_t) (0x60 + i);
+		info[i] = (uint8_t) (0xb0 + i);
+	}
+	result = check("hkdf vector 2", salt, sizeof(salt), ikm, sizeof(ikm),
+		       info, sizeof(info), prk, okm, sizeof(okm));
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_3(void)
+{
+	int result;
+	const uint8_t prk[TC_HKDF_PRK_SIZE] = {
+		0x19, 0xef, 0x24, 0xa3, 0x2c, 0x71, 0x7b, 0x16,
+		0x7f, 0x33, 0xa9, 0x1d, 0x6f, 0x64, 0x8b, 0xdf,
+		0x96, 0x59, 0x67, 0x76, 0xaf, 0xdb, 0x63, 0x77,
+		0xac, 0x43, 0x4c, 0x1c, 0x29, 0x3c, 0xcb, 0x04
+	};
+	const uint8_t okm[42] = {
+		0x8d, 0xa4, 0xe7, 0x75, 0xa5, 0x63, 0xc1, 0x8f,
+		0x71, 0x5f, 0x80, 0x2a, 0x06, 0x3c, 0x5a, 0x31,
+		0xb8, 0xa1, 0x1f, 0x5c, 0x5e, 0xe1, 0x87, 0x9e,
+		0xc3, 0x45, 0x4e, 0x5f, 0x3c, 0x73, 0x8d, 0x2d,
+		0x9d, 0x20, 0x13, 0x95, 0xfa, 0xa4, 0xb6, 0x1a,
+		0x96, 0xc8
+	};
+	uint8_t ikm[22];
+
+	TC_PRINT("%s: Performing HKDF test #3 (no salt or info):\n", __func__);
+
+	memset(ikm, 0x0b, sizeof(ikm));
+	result = check("hkdf vector 3", NULL, 0, ikm, sizeof(ikm), NULL, 0,
+		       prk, okm, sizeof(okm));
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_4(void)
+{
+	int result = TC_PASS;
+	uint8_t prk[TC_HKDF_PRK_SIZE] = {0};
+	uint8_t okm[1];
+
+	TC_PRINT("%s: Performing HKDF test #4 (invalid lengths):\n", __func__);
+
+	if (tc_hkdf_expand(okm, 0, prk, NULL, 0) != TC_CRYPTO_FAIL ||
+	    tc_hkdf_expand(okm, TC_HKDF_MAX_OKM_SIZE + 1, prk, NULL, 0) !=
+	    TC_CRYPTO_FAIL) {
+		TC_ERROR("invalid output length accepted.\n");
+		result = TC_FAIL;
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+/*
+ * Main task to test HKDF
+ */
+int main(void)
+{
+	int result = TC_PASS;
+
+	TC_START("Performing HKDF-SHA256 tests (RFC 5869 test vectors):");
+
+	result = test_vector_1();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("HKDF test #1 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_2();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("HKDF test #2 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_3();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("HKDF test #3 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_4();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("HKDF test #4 failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("All HKDF tests succeeded!\n");
+
+exitTest:
+	TC_END_RESULT(result);
+	TC_END_REPORT(result);
+
+	return result;
+}
@@ -0,0 +1,197 @@
+/* test_sha512.c - TinyCrypt SHA-512 tests (FIPS 180-4 examples) */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ *  DESCRIPTION
+ * This module tests the following SHA-512 routines:
+ *
+ *  Scenarios tested include:
+ *  - SHA-512 of "abc" (one block)
+ *  - SHA-512 of the empty string
+ *  - SHA-512 of the 896-bit two block message
+ *  - SHA-512 of one million 'a' hashed in uneven pieces
+ */
+
+#include <tinycrypt/sha512.h>
+#include <tinycrypt/constants.h>
+#include <test_utils.h>
+
+#include <string.h>
+
+static int check(const char *what, const uint8_t *expected,
+		 const uint8_t *data, size_t datalen)
+{
+	struct tc_sha512_state_struct s;
+	uint8_t digest[TC_SHA512_DIGEST_SIZE];
+
+	(void)tc_sha512_init(&s);
+	(void)tc_sha512_update(&s, data, datalen);
+	(void)tc_sha512_final(digest, &s);
+
+	if (memcmp(expected, digest, sizeof(digest)) != 0) {
+		TC_ERROR("%s produced a wrong digest.\n", what);
+		show_str("\t\tExpected", expected, sizeof(digest));
+		show_str("\t\tComputed", digest, sizeof(digest));
+		return TC_FAIL;
+	}
+	return TC_PASS;
+}
+
+int test_vector_1(void)
+{
+	int result;
+	const char *m = "abc";
+	const uint8_t expected[TC_SHA512_DIGEST_SIZE] = {
+		0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba,
+		0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31,
+		0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2,
+		0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a,
+		0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8,
+		0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+		0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e,
+		0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f
+	};
+
+	TC_PRINT("%s: Performing SHA-512 test #1 (abc):\n", __func__);
+
+	result = check("sha512 vector 1", expected, (const uint8_t *) m,
+		       strlen(m));
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_2(void)
+{
+	int result;
+	const uint8_t expected[TC_SHA512_DIGEST_SIZE] = {
+		0xcf, 0x83, 0xe1, 0x35, 0x7e, 0xef, 0xb8, 0xbd,
+		0xf1, 0x54, 0x28, 0x50, 0xd6, 0x6d, 0x80, 0x07,
+		0xd6, 0x20, 0xe4, 0x05, 0x0b, 0x57, 0x15, 0xdc,
+		0x83, 0xf4, 0xa9, 0x21, 0xd3, 0x6c, 0xe9, 0xce,
+		0x47, 0xd0, 0xd1, 0x3c, 0x5d, 0x85, 0xf2, 0xb0,
+		0xff, 0x83, 0x18, 0xd2, 0x87, 0x7e, 0xec, 0x2f,
+		0x63, 0xb9, 0x31, 0xbd, 0x47, 0x41, 0x7a, 0x81,
+		0xa5, 0x38, 0x32, 0x7a, 0xf9, 0x27, 0xda, 0x3e
+	};
+
+	TC_PRINT("%s: Performing SHA-512 test #2 (empty string):\n",
+		 __func__);
+
+	result = check("sha512 vector 2", expected, (const uint8_t *) "", 0);
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_3(void)
+{
+	int result;
+	const char *m = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+			"hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+	const uint8_t expected[TC_SHA512_DIGEST_SIZE] = {
+		0x8e, 0x95, 0x9b, 0x75, 0xda, 0xe3, 0x13, 0xda,
+		0x8c, 0xf4, 0xf7, 0x28, 0x14, 0xfc, 0x14, 0x3f,
+		0x8f, 0x77, 0x79, 0xc6, 0xeb, 0x9f, 0x7f, 0xa1,
+		0x72, 0x99, 0xae, 0xad, 0xb6, 0x88, 0x90, 0x18,
+		0x50, 0x1d, 0x28, 0x9e, 0x49, 0x00, 0xf7, 0xe4,
+		0x33, 0x1b, 0x99, 0xde, 0xc4, 0xb5, 0x43, 0x3a,
+		0xc7, 0xd3, 0x29, 0xee, 0xb6, 0xdd, 0x26, 0x54,
+		0x5e, 0x96, 0xe5, 0x5b, 0x87, 0x4b, 0xe9, 0x09
+	};
+
+	TC_PRINT("%s: Performing SHA-512 test #3 (two blocks):\n", __func__);
+
+	result = check("sha512 vector 3", expected, (const uint8_t *) m,
+		       strlen(m));
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_4(void)
+{
+	int result = TC_PASS;
+	struct tc_sha512_state_struct s;
+	uint8_t digest[TC_SHA512_DIGEST_SIZE];
+	uint8_t m[1000];
+	size_t done, n;
+	const uint8_t expected[TC_SHA512_DIGEST_SIZE] = {
+		0xe7, 0x18, 0x48, 0x3d, 0x0c, 0xe7, 0x69, 0x64,
+		0x4e, 0x2e, 0x42, 0xc7, 0xbc, 0x15, 0xb4, 0x63,
+		0x8e, 0x1f, 0x98, 0xb1, 0x3b, 0x20, 0x44, 0x28,
+		0x56, 0x32, 0xa8, 0x03, 0xaf, 0xa9, 0x73, 0xeb,
+		0xde, 0x0f, 0xf2, 0x44, 0x87, 0x7e, 0xa6, 0x0a,
+		0x4c, 0xb0, 0x43, 0x2c, 0xe5, 0x77, 0xc3, 0x1b,
+		0xeb, 0x00, 0x9c, 0x5c, 0x2c, 0x49, 0xaa, 0x2e,
+		0x4e, 0xad, 0xb2, 0x17, 0xad, 0x8c, 0xc0, 0x9b
+	};
+
+	TC_PRINT("%s: Performing SHA-512 test #4 (one million 'a'):\n",
+		 __func__);
+
+	memset(m, 'a', sizeof(m));
+	(void)tc_sha512_init(&s);
+	/* uneven pieces exercise both the leftover buffer and whole blocks */
+	for (done = 0, n = 1; done < 1000000; done += n, n = (n * 7 + 3) % 1000) {
+		if (n > 1000000 - done) {
+			n = 1000000 - done;
+		}
+		(void)tc_sha512_update(&s, m, n);
+	}
+	(void)tc_sha512_final(digest, &s);
+
+	if (memcmp(expected, digest, sizeof(digest)) != 0) {
+		TC_ERROR("sha512 vector 4 produced a wrong digest.\n");
+		show_str("\t\tExpected", expected, sizeof(digest));
+		show_str("\t\tComputed", digest, sizeof(digest));
+		result = TC_FAIL;
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+/*
+ * Main task to test SHA-512
+ */
+int main(void)
+{
+	int result = TC_PASS;
+
+	TC_START("Performing SHA-512 tests:");
+
+	result = test_vector_1();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("SHA-512 test #1 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_2();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("SHA-512 test #2 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_3();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("SHA-512 test #3 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_4();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("SHA-512 test #4 failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("All SHA-512 tests succeeded!\n");
+
+exitTest:
+	TC_END_RESULT(result);
+	TC_END_REPORT(result);
+
+	return result;
+}
@@ -0,0 +1,284 @@
+/* test_x25519.c - TinyCrypt X25519 tests (RFC 7748 tests) */
+
+/*
+ *  Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ *  DESCRIPTION
+ * This module tests the following X25519 routines:
+ *
+ *  Scenarios tested include:
+ *  - X25519 function RFC 7748 section 5.2 test vectors
+ *  - X25519 function RFC 7748 section 5.2 iterated test, 1 and 1000 rounds
+ *  - X25519 key agreement RFC 7748 section 6.1 test vector
+ *  - X25519 key agreement with generated key pairs
+ *  - X25519 key agreement rejects a low order public key
+ */
+
+#include <tinycrypt/x25519.h>
+#include <tinycrypt/ecc.h>
+#include <tinycrypt/ecc_platform_specific.h>
+#include <tinycrypt/constants.h>
+#include <test_utils.h>
+
+#include <string.h>
+
+static int check(const char *what, const uint8_t *expected,
+		 const uint8_t *computed)
+{
+	if (memcmp(expected, computed, TC_X25519_KEY_SIZE) != 0) {
+		TC_ERROR("%s produced a wrong result.\n", what);
+		show_str("\t\tExpected", expected, TC_X25519_KEY_SIZE);
+		show_str("\t\tComputed", computed, TC_X25519_KEY_SIZE);
+		return TC_FAIL;
+	}
+	return TC_PASS;
+}
+
+int test_vector_1(void)
+{
+	int result = TC_PASS;
+	/* RFC 7748 section 5.2 */
+	const uint8_t scalar1[TC_X25519_KEY_SIZE] = {
+		0xa5, 0x46, 0xe3, 0x6b, 0xf0, 0x52, 0x7c, 0x9d,
+		0x3b, 0x16, 0x15, 0x4b, 0x82, 0x46, 0x5e, 0xdd,
+		0x62, 0x14, 0x4c, 0x0a, 0xc1, 0xfc, 0x5a, 0x18,
+		0x50, 0x6a, 0x22, 0x44, 0xba, 0x44, 0x9a, 0xc4
+	};
+	const uint8_t u1[TC_X25519_KEY_SIZE] = {
+		0xe6, 0xdb, 0x68, 0x67, 0x58, 0x30, 0x30, 0xdb,
+		0x35, 0x94, 0xc1, 0xa4, 0x24, 0xb1, 0x5f, 0x7c,
+		0x72, 0x66, 0x24, 0xec, 0x26, 0xb3, 0x35, 0x3b,
+		0x10, 0xa9, 0x03, 0xa6, 0xd0, 0xab, 0x1c, 0x4c
+	};
+	const uint8_t expected1[TC_X25519_KEY_SIZE] = {
+		0xc3, 0xda, 0x55, 0x37, 0x9d, 0xe9, 0xc6, 0x90,
+		0x8e, 0x94, 0xea, 0x4d, 0xf2, 0x8d, 0x08, 0x4f,
+		0x32, 0xec, 0xcf, 0x03, 0x49, 0x1c, 0x71, 0xf7,
+		0x54, 0xb4, 0x07, 0x55, 0x77, 0xa2, 0x85, 0x52
+	};
+	const uint8_t scalar2[TC_X25519_KEY_SIZE] = {
+		0x4b, 0x66, 0xe9, 0xd4, 0xd1, 0xb4, 0x67, 0x3c,
+		0x5a, 0xd2, 0x26, 0x91, 0x95, 0x7d, 0x6a, 0xf5,
+		0xc1, 0x1b, 0x64, 0x21, 0xe0, 0xea, 0x01, 0xd4,
+		0x2c, 0xa4, 0x16, 0x9e, 0x79, 0x18, 0xba, 0x0d
+	};
+	const uint8_t u2[TC_X25519_KEY_SIZE] = {
+		0xe5, 0x21, 0x0f, 0x12, 0x78, 0x68, 0x11, 0xd3,
+		0xf4, 0xb7, 0x95, 0x9d, 0x05, 0x38, 0xae, 0x2c,
+		0x31, 0xdb, 0xe7, 0x10, 0x6f, 0xc0, 0x3c, 0x3e,
+		0xfc, 0x4c, 0xd5, 0x49, 0xc7, 0x15, 0xa4, 0x93
+	};
+	const uint8_t expected2[TC_X25519_KEY_SIZE] = {
+		0x95, 0xcb, 0xde, 0x94, 0x76, 0xe8, 0x90, 0x7d,
+		0x7a, 0xad, 0xe4, 0x5c, 0xb4, 0xb8, 0x73, 0xf8,
+		0x8b, 0x59, 0x5a, 0x68, 0x79, 0x9f, 0xa1, 0x52,
+		0xe6, 0xf8, 0xf7, 0x64, 0x7a, 0xac, 0x79, 0x57
+	};
+	uint8_t out[TC_X25519_KEY_SIZE];
+
+	TC_PRINT("%s: Performing X25519 test #1 (RFC 7748 5.2 vectors):\n",
+		 __func__);
+
+	(void)tc_x25519(out, scalar1, u1);
+	result = check("x25519 vector 1", expected1, out);
+	if (result == TC_PASS) {
+		(void)tc_x25519(out, scalar2, u2);
+		result = check("x25519 vector 2", expected2, out);
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_2(void)
+{
+	int result = TC_PASS;
+	/* RFC 7748 section 5.2, k = u = 9, then k, u = X25519(k, u), k */
+	const uint8_t expected1[TC_X25519_KEY_SIZE] = {
+		0x42, 0x2c, 0x8e, 0x7a, 0x62, 0x27, 0xd7, 0xbc,
+		0xa1, 0x35, 0x0b, 0x3e, 0x2b, 0xb7, 0x27, 0x9f,
+		0x78, 0x97, 0xb8, 0x7b, 0xb6, 0x85, 0x4b, 0x78,
+		0x3c, 0x60, 0xe8, 0x03, 0x11, 0xae, 0x30, 0x79
+	};
+	const uint8_t expected1000[TC_X25519_KEY_SIZE] = {
+		0x68, 0x4c, 0xf5, 0x9b, 0xa8, 0x33, 0x09, 0x55,
+		0x28, 0x00, 0xef, 0x56, 0x6f, 0x2f, 0x4d, 0x3c,
+		0x1c, 0x38, 0x87, 0xc4, 0x93, 0x60, 0xe3, 0x87,
+		0x5f, 0x2e, 0xb9, 0x4d, 0x99, 0x53, 0x2c, 0x51
+	};
+	uint8_t k[TC_X25519_KEY_SIZE] = { 9 };
+	uint8_t u[TC_X25519_KEY_SIZE] = { 9 };
+	uint8_t r[TC_X25519_KEY_SIZE];
+	unsigned int i;
+
+	TC_PRINT("%s: Performing X25519 test #2 (RFC 7748 iterated):\n",
+		 __func__);
+
+	for (i = 1; i <= 1000 && result == TC_PASS; ++i) {
+		(void)tc_x25519(r, k, u);
+		memcpy(u, k, sizeof(u));
+		memcpy(k, r, sizeof(k));
+
+		if (i == 1) {
+			result = check("x25519 after 1 iteration", expected1, k);
+		}
+	}
+	if (result == TC_PASS) {
+		result = check("x25519 after 1000 iterations", expected1000, k);
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_3(void)
+{
+	int result = TC_PASS;
+	/* RFC 7748 section 6.1 */
+	const uint8_t alice_private[TC_X25519_KEY_SIZE] = {
+		0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d,
+		0x3c, 0x16, 0xc1, 0x72, 0x51, 0xb2, 0x66, 0x45,
+		0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0, 0x99, 0x2a,
+		0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a
+	};
+	const uint8_t alice_public[TC_X25519_KEY_SIZE] = {
+		0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54,
+		0x74, 0x8b, 0x7d, 0xdc, 0xb4, 0x3e, 0xf7, 0x5a,
+		0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38, 0x1a, 0xf4,
+		0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a
+	};
+	const uint8_t bob_private[TC_X25519_KEY_SIZE] = {
+		0x5d, 0xab, 0x08, 0x7e, 0x62, 0x4a, 0x8a, 0x4b,
+		0x79, 0xe1, 0x7f, 0x8b, 0x83, 0x80, 0x0e, 0xe6,
+		0x6f, 0x3b, 0xb1, 0x29, 0x26, 0x18, 0xb6, 0xfd,
+		0x1c, 0x2f, 0x8b, 0x27, 0xff, 0x88, 0xe0, 0xeb
+	};
+	const uint8_t bob_public[TC_X25519_KEY_SIZE] = {
+		0xde, 0x9e, 0xdb, 0x7d, 0x7b, 0x7d, 0xc1, 0xb4,
+		0xd3, 0x5b, 0x61, 0xc2, 0xec, 0xe4, 0x35, 0x37,
+		0x3f, 0x83, 0x43, 0xc8, 0x5b, 0x78, 0x67, 0x4d,
+		0xad, 0xfc, 0x7e, 0x14, 0x6f, 0x88, 0x2b, 0x4f
+	};
+	const uint8_t shared[TC_X25519_KEY_SIZE] = {
+		0x4a, 0x5d, 0x9d, 0x5b, 0xa4, 0xce, 0x2d, 0xe1,
+		0x72, 0x8e, 0x3b, 0xf4, 0x80, 0x35, 0x0f, 0x25,
+		0xe0, 0x7e, 0x21, 0xc9, 0x47, 0xd1, 0x9e, 0x33,
+		0x76, 0xf0, 0x9b, 0x3c, 0x1e, 0x16, 0x17, 0x42
+	};
+	const uint8_t base[TC_X25519_KEY_SIZE] = { 9 };
+	uint8_t out[TC_X25519_KEY_SIZE];
+
+	TC_PRINT("%s: Performing X25519 test #3 (RFC 7748 6.1 key agreement):\n",
+		 __func__);
+
+	(void)tc_x25519(out, alice_private, base);
+	result = check("alice public key", alice_public, out);
+	if (result == TC_PASS) {
+		(void)tc_x25519(out, bob_private, base);
+		result = check("bob public key", bob_public, out);
+	}
+	if (result == TC_PASS) {
+		if (!tc_x25519_shared_secret(bob_public, alice_private, out)) {
+			result = TC_FAIL;
+		} else {
+			result = check("alice shared secret", shared, out);
+		}
+	}
+	if (result == TC_PASS) {
+		if (!tc_x25519_shared_secret(alice_public, bob_private, out)) {
+			result = TC_FAIL;
+		} else {
+			result = check("bob shared secret", shared, out);
+		}
+	}
+
+	TC_END_RESULT(result);
+	return result;
+}
+
+int test_vector_4(void)
+{
+	int result = TC_PASS;
+	uint8_t public1[TC_X25519_KEY_SIZE], private1[TC_X25519_KEY_SIZE];
+	uint8_t public2[TC_X25519_KEY_SIZE], private2[TC_X25519_KEY_SIZE];
+	uint8_t secret1[TC_X25519_KEY_SIZE], secret2[TC_X25519_KEY_SIZE];
+	const uint8_t low_order[TC_X25519_KEY_SIZE] = { 0 };
+
+	TC_PRINT("%s: Performing X25519 test #4 (generated key pairs):\n",
+		 __func__);
+
+	if (!tc_x25519_make_key(public1, private1) ||
+	    !tc_x25519_make_key(public2, private2)) {
+		TC_ERROR("tc_x25519_make_key failed.\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	if (!tc_x25519_shared_secret(public2, private1, secret1) ||
+	    !tc_x25519_shared_secret(public1, private2, secret2)) {
+		TC_ERROR("tc_x25519_shared_secret failed.\n");
+		result = TC_FAIL;
+		goto exitTest1;
+	}
+
+	result = check("generated shared secret", secret1, secret2);
+	if (result == TC_FAIL) {
+		goto exitTest1;
+	}
+
+	/* the zero u-coordinate has order 4, the shared secret is all zeros */
+	if (tc_x25519_shared_secret(low_order, private1, secret1)) {
+		TC_ERROR("tc_x25519_shared_secret accepted a low order point.\n");
+		result = TC_FAIL;
+	}
+
+exitTest1:
+	TC_END_RESULT(result);
+	return result;
+}
+
+/*
+ * Main task to test X25519
+ */
+int main(void)
+{
+	int result = TC_PASS;
+
+	TC_START("Performing X25519 tests:");
+
+	/* Setup of the Cryptographically Secure PRNG. */
+	uECC_set_rng(&default_CSPRNG);
+
+	result = test_vector_1();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("X25519 test #1 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_2();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("X25519 test #2 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_3();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("X25519 test #3 failed.\n");
+		goto exitTest;
+	}
+	result = test_vector_4();
+	if (result == TC_FAIL) { /* terminate test */
+		TC_ERROR("X25519 test #4 failed.\n");
+		goto exitTest;
+	}
+
+	TC_PRINT("All X25519 tests succeeded!\n");
+
+exitTest:
+	TC_END_RESULT(result);
+	TC_END_REPORT(result);
+
+	return result;
+}
@@ -113,6 +113,14 @@ enum auth_instance_id {
 #define AUTH_ERROR_FAILED                   (AUTH_ERROR_BASE - 11)
 /** The authentication was canceled*/
 #define AUTH_ERROR_CANCELED                 (AUTH_ERROR_BASE - 12)
+/** No session keys, authentication has not completed successfully */
+#define AUTH_ERROR_NO_SESSION               (AUTH_ERROR_BASE - 13)
+/** A secure channel record was received twice */
+#define AUTH_ERROR_REPLAY                   (AUTH_ERROR_BASE - 14)
+/** The session is already queued or running */
+#define AUTH_ERROR_SESSION_BUSY             (AUTH_ERROR_BASE - 15)
+/** The server is overloaded and shed the authentication */
+#define AUTH_ERROR_SERVER_BUSY              (AUTH_ERROR_BASE - 16)
 
 
 /*
@@ -145,11 +153,84 @@ enum auth_status {
 	/** Authentication failed */
 	AUTH_STATUS_AUTHENTICATION_FAILED,
 	/** Authentication successful */
-	AUTH_STATUS_SUCCESSFUL
+	AUTH_STATUS_SUCCESSFUL,
+	/** Server overloaded.  A server shed the authentication, a client
+	 *  should retry after auth_lib_get_retry_after() msecs. */
+	AUTH_STATUS_SERVER_BUSY
 };
 
 
 
+/** Session key length, AES-256 */
+#define AUTH_SESSION_KEY_LEN                (32u)
+/** Per direction IV, combined with a record sequence number to form a nonce */
+#define AUTH_SESSION_IV_LEN                 (12u)
+
+/**
+ * Traffic keys derived when authentication succeeds.  Each side's tx keys
+ * are the peer's rx keys.
+ */
+struct auth_session_keys {
+	uint8_t tx_key[AUTH_SESSION_KEY_LEN];
+	uint8_t tx_iv[AUTH_SESSION_IV_LEN];
+	uint8_t rx_key[AUTH_SESSION_KEY_LEN];
+	uint8_t rx_iv[AUTH_SESSION_IV_LEN];
+};
+
+
+/** Resumption ticket length, opaque to the client */
+#define AUTH_RESUME_TICKET_LEN              (64u)
+/** Resumption secret length */
+#define AUTH_RESUME_SECRET_LEN              (32u)
+
+/** Public-key Challenge-Response, P-256 private key length */
+#define AUTH_PK_PRIVATE_KEY_LEN             (32u)
+/** Public-key Challenge-Response, P-256 public key length (X | Y) */
+#define AUTH_PK_PUBLIC_KEY_LEN              (64u)
+/** Most peer public keys registered with one Challenge-Response instance */
+#define AUTH_PK_MAX_PEER_KEYS               (16u)
+
+
+/**
+ * Challenge-Response resumption ticket.  Issued by a server configured with
+ * a ticket lifetime, a client presents it to re-authenticate with a single
+ * round trip instead of the full challenge-response.  The secret must be
+ * kept as private as the shared key.
+ */
+struct auth_resume_ticket {
+	uint8_t ticket[AUTH_RESUME_TICKET_LEN];
+	uint8_t secret[AUTH_RESUME_SECRET_LEN];
+	uint32_t lifetime_sec;  /* lifetime when issued */
+};
+
+
+/**
+ * Round trip time estimate used to retransmit lost handshake messages,
+ * kept across authentications with the same peer.  Zero until the first
+ * round trip is measured.
+ */
+struct auth_rtt_estimate {
+	uint32_t srtt;    /* smoothed round trip time, msec scaled by 8 */
+	uint32_t rttvar;  /* round trip time variation, msec scaled by 4 */
+	uint32_t rto;     /* retransmission timeout, msec */
+};
+
+
+/**
+ * Server admission control.  Server authentications wait for one of
+ * max_active slots once the client's first message arrives.  When the wait
+ * stays above target_msec for interval_msec the server sheds authentications,
+ * more often the longer the overload lasts (CoDel), and tells the clients to
+ * retry later.  Zero fields use the defaults.
+ */
+struct auth_admission_param {
+	uint32_t max_active;     /* concurrent server authentications, default one per CPU */
+	uint32_t target_msec;    /* acceptable wait for a slot */
+	uint32_t interval_msec;  /* how long the wait may stay above target */
+	uint32_t max_wait_msec;  /* longest wait for a slot */
+};
+
+
 /* Forward declaration */
 struct authenticate_conn;
 
@@ -193,6 +274,26 @@ struct authenticate_conn {
 	/* cancel the authentication  */
 	volatile bool cancel_auth;
 
+	/* session keys, valid when has_session_keys is true */
+	struct auth_session_keys session_keys;
+	bool has_session_keys;
+
+	/* client resumption ticket, valid when has_resume_ticket is true */
+	struct auth_resume_ticket resume_ticket;
+	bool has_resume_ticket;
+
+	/* handshake retransmission timer */
+	struct auth_rtt_estimate rtt;
+
+	/* client: back off time requested by a busy server */
+	uint32_t retry_after_msec;
+
+	/* session manager table and run queue links, see auth_session.h */
+	struct authenticate_conn *session_next;
+	struct authenticate_conn *run_next;
+	int session_state;
+	uint64_t session_queued_msec;
+
 	/* Pointer to internal details, do not touch!!! */
 	void *internal_obj;
 };
@@ -244,7 +345,25 @@ struct auth_dtls_certs {
  * from a secure element such as a Microchip ATECC608A or NXP SE050 device.
  */
 struct auth_challenge_resp {
-	const uint8_t *shared_key; /* 32 byte random nonce */
+	const uint8_t *shared_key; /* 32 byte random nonce, NULL for the default key */
+
+	/* Client: ticket from a previous session, NULL for a full challenge-response. */
+	const struct auth_resume_ticket *ticket;
+
+	/* Public-key mode: this side's P-256 private key, each side signs the
+	 * other's ephemeral key instead of hashing it with the shared key.
+	 * NULL to use the shared key. */
+	const uint8_t *private_key;
+
+	/* Public-key mode: public keys of the peers allowed to authenticate,
+	 * the devices on a server or the server on a client.  Copied, up to
+	 * AUTH_PK_MAX_PEER_KEYS keys. */
+	const uint8_t *const *peer_public_keys;
+	uint32_t num_peer_keys;
+
+	/* Public-key mode: precompute a verify table for each peer key, trades
+	 * about 200 bytes per key for faster signature verification. */
+	bool cache_verify_tables;
 };
 
 /**
@@ -337,6 +456,72 @@ const char *auth_lib_getstatus_str(enum auth_status status);
 int auth_lib_cancel(struct authenticate_conn *auth_conn);
 
 
+/**
+ * Returns the session keys derived by a successful authentication.  The
+ * keys are wiped by auth_lib_deinit().
+ *
+ * @param auth_conn  Authentication connection struct.
+ * @param keys       Session keys are copied here.
+ *
+ * @return AUTH_SUCCESS on success, AUTH_ERROR_NO_SESSION if authentication
+ *         has not succeeded or the method does not derive keys.
+ */
+int auth_lib_get_session_keys(struct authenticate_conn *auth_conn,
+			      struct auth_session_keys *keys);
+
+
+/**
+ * Returns the resumption ticket received by a client.  Pass it in the
+ * Challenge-Response optional param when re-connecting.
+ *
+ * @param auth_conn  Authentication connection struct.
+ * @param ticket     Ticket is copied here.
+ *
+ * @return AUTH_SUCCESS on success, AUTH_ERROR_NO_SESSION if the server did
+ *         not issue a ticket.
+ */
+int auth_lib_get_resume_ticket(struct authenticate_conn *auth_conn,
+			       struct auth_resume_ticket *ticket);
+
+
+/**
+ * Returns how long a client should wait before re-connecting, after the
+ * AUTH_STATUS_SERVER_BUSY status.
+ *
+ * @param auth_conn  Authentication connection struct.
+ *
+ * @return Time in msecs, 0 if the server did not ask the client to wait.
+ */
+uint32_t auth_lib_get_retry_after(struct authenticate_conn *auth_conn);
+
+
+/**
+ * Enables server admission control, see struct auth_admission_param.  The
+ * parameters can only be changed while no server authentication waits for
+ * or holds an admission slot.
+ *
+ * @param param  Admission parameters, NULL disables admission control.
+ *
+ * @return AUTH_SUCCESS on success, AUTH_ERROR_SESSION_BUSY if admission
+ *         slots are in use, else one of AUTH_ERROR_* values.
+ */
+int auth_lib_set_admission(const struct auth_admission_param *param);
+
+
+/**
+ * Enables Challenge-Response resumption tickets on servers.  All server
+ * connections share the ticket key, call once before any server
+ * authentication is started.
+ *
+ * @param ticket_key    32 byte key sealing the tickets, NULL for a random key.
+ *                      Servers sharing the key accept each other's tickets.
+ * @param lifetime_sec  Ticket lifetime in seconds, 0 to not issue tickets.
+ *
+ * @return AUTH_SUCCESS on success, else one of AUTH_ERROR_* values.
+ */
+int auth_lib_set_ticket_key(const uint8_t *ticket_key, uint32_t lifetime_sec);
+
+
 /**
  * Logging function signature
  */
@@ -0,0 +1,229 @@
+/**
+ * Copyright (c) 2021 Golden Bits Software, Inc.
+ *
+ * Use of this software is per the terms of the Apache 2.0 license
+ * (here: https://www.apache.org/licenses/LICENSE-2.0) plus the following;
+ *
+ *
+ *  THIS IS OPEN SOURCE SOFTWARE, THERE ARE NO WARRANTIES OF ANY KIND FOR ANY ASPECT OF THIS SOFTWARE.
+ *  BY USING THIS SOFTWARE, YOU ACCEPT ALL LIABILITIES AND RESPONSIBILITIES FOR ANY ISSUES OR
+ *  PROBLEMS ARISING OUT OF USE. YOU ARE RESPONSIBLE FOR DETERMINING THE SUITABILITY OF THIS
+ *  SOFTWARE FOR YOUR USE.
+ *
+ *  IF YOU ARE UNSURE ABOUT USING THIS SOFTWARE, DON'T USE IT.
+ *
+ *  THIS SOFTWARE IS SUPPLIED BY GOLDEN BITS SOFTWARE, INC. "AS IS". NO WARRANTIES, WHETHER
+ *  EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, ANY IMPLIED
+ *  WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT WILL GOLDEN BITS SOFTWARE BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, EXEMPLARY,
+ *  INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ *  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) COST OR EXPENSE OF ANY
+ *  KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF GOLDEN BITS SOFTWARE HAS BEEN ADVISED
+ *  OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. GOLDEN BITS SOFTWARE SHALL NOT BE HELD LIABLE UNDER
+ *  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file auth_record.h
+ *
+ * @brief  Secure channel for application data once authentication succeeds.
+ *
+ *         Application data is carried in records over the same transport used
+ *         to authenticate.  Each record is encrypted and authenticated with the
+ *         session keys, the record header is the associated data.  Records are
+ *         sealed and opened in the caller's buffer: reserve AUTH_RECORD_HDR_LEN
+ *         bytes in front of the payload and AUTH_RECORD_TAG_LEN bytes after it.
+ *
+ *         Every record carries an explicit sequence number which forms the
+ *         nonce together with the per direction IV.  The receiver keeps a
+ *         sliding window of sequence numbers and drops replayed records, records
+ *         can be lost or re-ordered by the transport.
+ *
+ *         A channel can be used by one sending thread and one receiving thread
+ *         at the same time.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef AUTH_RECORD_H_
+#define AUTH_RECORD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <tinycrypt/aes.h>
+#include <tinycrypt/ccm_mode.h>
+#include <tinycrypt/gcm_mode.h>
+#include <tinycrypt/chacha20_poly1305.h>
+
+#include "auth_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/** Record header: type, cipher, length and sequence number */
+#define AUTH_RECORD_HDR_LEN                 (12u)
+/** Authentication tag appended to the encrypted payload */
+#define AUTH_RECORD_TAG_LEN                 (16u)
+/** Bytes added to each payload */
+#define AUTH_RECORD_OVERHEAD                (AUTH_RECORD_HDR_LEN + AUTH_RECORD_TAG_LEN)
+/** Largest record, a record must fit in one transport message */
+#define AUTH_RECORD_MAX_LEN                 (1024u)
+/** Largest application payload in one record */
+#define AUTH_RECORD_MAX_PAYLOAD             (AUTH_RECORD_MAX_LEN - AUTH_RECORD_OVERHEAD)
+
+/** Number of sequence numbers tracked by the replay window */
+#define AUTH_RECORD_REPLAY_WINDOW           (64u)
+
+/** CCM uses a 13 byte nonce, the other ciphers the last 12 bytes */
+#define AUTH_RECORD_NONCE_LEN               (13u)
+
+
+/**
+ * Record ciphers, keyed with the 256 bit session keys.
+ */
+enum auth_record_cipher {
+	AUTH_RECORD_AES_CCM = 1,
+	AUTH_RECORD_AES_GCM,
+	AUTH_RECORD_CHACHA20_POLY1305
+};
+
+/**
+ * Keys and sequence number for one direction.  The aead state points at
+ * sched and nonce, auth_record_seal() and auth_record_open() re-point it so
+ * a channel may be copied or moved between records.
+ */
+struct auth_record_dir {
+	struct tc_aes_key_sched_struct sched;
+	union {
+		struct tc_ccm_mode_struct ccm;
+		struct tc_gcm_mode_struct gcm;
+		struct tc_chacha20_poly1305_struct chacha;
+	} aead;
+	uint8_t iv[AUTH_SESSION_IV_LEN];
+	uint8_t nonce[AUTH_RECORD_NONCE_LEN];
+
+	/* tx: next sequence number to send, rx: highest sequence number accepted */
+	uint64_t seq;
+};
+
+/**
+ * A secure channel over an authenticated connection.
+ */
+struct auth_record_channel {
+	auth_xport_hdl_t xport_hdl;
+	enum auth_record_cipher cipher;
+
+	struct auth_record_dir tx;
+	struct auth_record_dir rx;
+
+	/* bit n is set if record rx.seq - n was received */
+	uint64_t rx_window;
+};
+
+/**
+ * A record buffer for batched sends.
+ */
+struct auth_record_buf {
+	/* AUTH_RECORD_HDR_LEN bytes, then the payload, then AUTH_RECORD_TAG_LEN bytes */
+	uint8_t *record;
+	size_t payload_len;
+};
+
+
+/**
+ * Sets up a secure channel with the session keys of an authenticated
+ * connection.  Both peers must use the same cipher.
+ *
+ * @param chan       Channel to initialize.
+ * @param auth_conn  Connection which completed authentication.
+ * @param cipher     Record cipher.
+ *
+ * @return AUTH_SUCCESS on success, AUTH_ERROR_NO_SESSION if the connection
+ *         has no session keys, else negative error code.
+ */
+int auth_record_init(struct auth_record_channel *chan, struct authenticate_conn *auth_conn,
+		     enum auth_record_cipher cipher);
+
+/**
+ * Wipes the channel keys.
+ *
+ * @param chan  Channel to de-initialize.
+ */
+void auth_record_deinit(struct auth_record_channel *chan);
+
+/**
+ * Encrypts a record in place.  The payload starts at
+ * record + AUTH_RECORD_HDR_LEN, the header and tag are written around it.
+ *
+ * @param chan         Channel.
+ * @param record       Record buffer, at least payload_len + AUTH_RECORD_OVERHEAD bytes.
+ * @param payload_len  Payload bytes, up to AUTH_RECORD_MAX_PAYLOAD.
+ *
+ * @return Record length on success, else negative error code.
+ */
+int auth_record_seal(struct auth_record_channel *chan, uint8_t *record, size_t payload_len);
+
+/**
+ * Verifies and decrypts a record in place.
+ *
+ * @param chan        Channel.
+ * @param record      Record received from the peer.
+ * @param record_len  Record length in bytes.
+ * @param payload     Set to the decrypted payload, inside record.
+ *
+ * @return Payload length on success, AUTH_ERROR_REPLAY if the record was
+ *         already received, AUTH_ERROR_CRYPTO if it does not authenticate,
+ *         else negative error code.
+ */
+int auth_record_open(struct auth_record_channel *chan, uint8_t *record, size_t record_len,
+		     uint8_t **payload);
+
+/**
+ * Seals a record and sends it to the peer.
+ *
+ * @param chan         Channel.
+ * @param record       Record buffer, see auth_record_seal().
+ * @param payload_len  Payload bytes.
+ *
+ * @return Payload bytes sent on success, else negative error code.
+ */
+int auth_record_send(struct auth_record_channel *chan, uint8_t *record, size_t payload_len);
+
+/**
+ * Seals several records and sends them, as many records as fit are
+ * carried in each transport message.
+ *
+ * @param chan   Channel.
+ * @param recs   Records to send, see auth_record_seal().
+ * @param count  Number of records.
+ *
+ * @return Number of records sent on success, else negative error code.
+ */
+int auth_record_send_batch(struct auth_record_channel *chan, struct auth_record_buf *recs,
+			   int count);
+
+/**
+ * Receives one record from the peer and opens it in place.
+ *
+ * @param chan          Channel.
+ * @param buf           Buffer to receive the record into.
+ * @param buf_len       Buffer size, AUTH_RECORD_MAX_LEN holds any record.
+ * @param timeout_msec  Time to wait for a record.
+ * @param payload       Set to the decrypted payload, inside buf.
+ *
+ * @return Payload length on success, AUTH_ERROR_TIMEOUT if no record arrived,
+ *         see auth_record_open() for the other errors.
+ */
+int auth_record_recv(struct auth_record_channel *chan, uint8_t *buf, size_t buf_len,
+		     uint32_t timeout_msec, uint8_t **payload);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* AUTH_RECORD_H_ */
@@ -88,6 +88,13 @@ struct auth_xport_evt {
  */
 typedef void (*send_callback_t)(int err, uint16_t numbytes);
 
+/**
+ * Callback invoked when received bytes were added to the receive queue.
+ *
+ * @param xport_hdl  Transport handle.
+ */
+typedef void (*recv_callback_t)(auth_xport_hdl_t xport_hdl);
+
 
 /**
  * Function for sending data directly to the lower layer transport
@@ -104,6 +111,26 @@ typedef void (*send_callback_t)(int err, uint16_t numbytes);
 typedef int (*send_xport_t)(auth_xport_hdl_t xport_hdl, const uint8_t *data,
 			    const size_t len);
 
+/**
+ * Max number of queued frames handed to the lower transport in one call.
+ */
+#define AUTH_XPORT_TX_BATCH_MAX         (8u)
+
+struct auth_xport_iov;
+
+/**
+ * Optional function sending several frames to the lower transport in one
+ * call, each frame goes out as if sent with send_xport_t.
+ *
+ * @param  xport_hdl    Opaque transport handle.
+ * @param  frames       Frames to send, up to AUTH_XPORT_TX_BATCH_MAX.
+ * @param  count        Number of frames.
+ *
+ * @return Number of frames sent, on error negative error value.
+ */
+typedef int (*send_batch_xport_t)(auth_xport_hdl_t xport_hdl,
+				  const struct auth_xport_iov *frames, int count);
+
 
 /**
  * Initializes the lower transport layer.
@@ -139,18 +166,44 @@ int auth_xport_deinit(const auth_xport_hdl_t xporthdl);
 
 int auth_xport_event(const auth_xport_hdl_t xporthdl, struct auth_xport_evt *event);
 /**
- * Sends packet of data to peer.
+ * Sends packet of data to peer.  If the lower transport has a send
+ * function the data is queued and sent by the transport's tx thread, the
+ * caller does not wait for the lower transport.
  *
  * @param xporthdl  Transport handle
  * @param data      Buffer to send.
  * @param len       Number of bytes to send.
  *
- * @return  Number of bytes sent on success, can be less than requested.
+ * @return  Number of bytes sent or queued on success, can be less than requested.
  *          On error, negative error code.
  */
 int auth_xport_send(const auth_xport_hdl_t xporthdl, const uint8_t *data, size_t len);
 
 
+/**
+ * One buffer of a gathered send.
+ */
+struct auth_xport_iov {
+	const uint8_t *data;
+	size_t len;
+};
+
+/**
+ * Sends several buffers to the peer as one message, the buffers are
+ * gathered directly into the outgoing fragments.  Queued like
+ * auth_xport_send(), waits only if the send queue is full.
+ *
+ * @param xporthdl  Transport handle
+ * @param iov       Buffers to send, in order.
+ * @param iovcnt    Number of buffers.
+ *
+ * @return  Number of bytes sent or queued on success, AUTH_ERROR_IOBUFF_FULL
+ *          if the send queue stayed full.  On error, negative error code.
+ */
+int auth_xport_sendv(const auth_xport_hdl_t xporthdl, const struct auth_xport_iov *iov,
+		     int iovcnt);
+
+
 /**
  * Receive data from the lower transport.
  *
@@ -165,6 +218,19 @@ int auth_xport_send(const auth_xport_hdl_t xporthdl, const uint8_t *data, size_t
 int auth_xport_recv(const auth_xport_hdl_t xporthdl, uint8_t *buff, uint32_t buf_len, uint32_t timeoutMsec);
 
 
+/**
+ * Cancels receive waits.  Threads blocked in auth_xport_recv() or
+ * auth_xport_getnum_recvqueue_bytes_wait() wake up immediately and return
+ * AUTH_ERROR_CANCELED, as do later waits until the cancel is cleared.
+ *
+ * @param xporthdl  Transport handle
+ * @param cancel    True to cancel waits, false to clear a previous cancel.
+ *
+ * @return AUTH_SUCCESS, else negative error code.
+ */
+int auth_xport_cancel_recv(const auth_xport_hdl_t xporthdl, bool cancel);
+
+
 /**
  * Peeks at the contents of the receive queue used by the lower transport.  The
  * data returned is not removed from the receive queue.
@@ -230,6 +296,65 @@ int auth_xport_getnum_recvqueue_bytes_wait(const auth_xport_hdl_t xporthdl, uint
  */
 void auth_xport_set_sendfunc(auth_xport_hdl_t xporthdl, send_xport_t send_func);
 
+/**
+ * Used by a lower transport which preserves message boundaries (datagrams)
+ * and receives with auth_message_recv_datagram().  Compact frames are sent
+ * once the peer showed it accepts them.
+ *
+ * @param xporthdl   Transport handle.
+ */
+void auth_xport_set_msg_preserving(auth_xport_hdl_t xporthdl);
+
+/**
+ * Used by a byte stream lower transport (serial) to add a CRC32C trailer to
+ * each fragment sent.  A corrupted fragment is dropped on receipt instead of
+ * stalling the protocol until it times out.
+ *
+ * @param xporthdl   Transport handle.
+ * @param enable     True to send the CRC trailer.
+ */
+void auth_xport_set_frag_crc(auth_xport_hdl_t xporthdl, bool enable);
+
+/**
+ * Sets a function sending several queued frames in one call, used by the
+ * tx thread when more than one frame is queued.
+ *
+ * @param xporthdl    Transport handle.
+ * @param batch_func  Lower transport batch send function.
+ */
+void auth_xport_set_send_batchfunc(auth_xport_hdl_t xporthdl, send_batch_xport_t batch_func);
+
+/**
+ * Waits until every message queued so far was handed to the lower
+ * transport by the tx thread.  Must not be called from the tx thread.
+ *
+ * @param xporthdl      Transport handle.
+ * @param timeout_msec  Longest time to wait.
+ *
+ * @return AUTH_SUCCESS once sent, AUTH_ERROR_TIMEOUT if messages are still
+ *         queued, else one of AUTH_ERROR_* values.
+ */
+int auth_xport_flush(const auth_xport_hdl_t xporthdl, uint32_t timeout_msec);
+
+/**
+ * Sets a callback invoked from the tx thread after each queued message
+ * was handed to the lower transport.  To clear, use NULL.
+ *
+ * @param xporthdl   Transport handle.
+ * @param send_cb    Called with 0 and the message byte count, else with
+ *                   an error and 0 if a fragment failed to send.
+ */
+void auth_xport_set_send_callback(auth_xport_hdl_t xporthdl, send_callback_t send_cb);
+
+/**
+ * Sets a callback invoked from the receive path after bytes were added to
+ * the receive queue, it must not block.  To clear, use NULL.
+ *
+ * @param xporthdl  Transport handle.
+ * @param recv_cb   Called with the transport handle.
+ */
+void auth_xport_set_recv_callback(auth_xport_hdl_t xporthdl, recv_callback_t recv_cb);
+
 
 /**
  * Used by the lower transport to set a context for a given transport handle.  To